@@ -34,6 +34,9 @@ typedef enum umf_pool_create_flag_t {
          << 0), ///< Pool will own the specified provider and destroy it in umfPoolDestroy
     UMF_POOL_CREATE_FLAG_DISABLE_TRACKING =
         (1 << 1), ///< Pool will not track memory allocations
+    UMF_POOL_CREATE_FLAG_COARSE_TRACKING =
+        (1
+         << 2), ///< Pool will track only chunks its allocations are carved out of (see umfPoolCreate)
     /// @cond
     UMF_POOL_CREATE_FLAG_FORCE_UINT32 = 0x7fffffff
     /// @endcond
@@ -45,6 +48,14 @@ typedef uint32_t umf_pool_create_flags_t;
 
 ///
 /// @brief Creates new memory pool.
+/// \details
+///        With the UMF_POOL_CREATE_FLAG_COARSE_TRACKING flag, small allocations
+///        the pool makes from its memory provider (like slabs) are carved out
+///        of bigger chunks, and only the chunks are registered in the tracker,
+///        so umfPoolByPtr() and umfFree() keep working at a much lower cost
+///        of tracking. The memory of a chunk is returned to the provider only
+///        when all allocations carved out of it are freed, and such
+///        allocations cannot be split or merged by the provider.
 /// @param ops instance of umf_memory_pool_ops_t
 /// @param provider memory provider that will be used for coarse-grain allocations.
 /// @param params pointer to pool-specific parameters, or NULL for defaults
@@ -214,6 +225,77 @@ umf_result_t umfPoolGetTag(umf_memory_pool_handle_t hPool, void **tag);
 umf_result_t umfPoolTrimMemory(umf_memory_pool_handle_t hPool,
                                size_t minBytesToKeep);
 
+///
+/// @brief Allocates \p num blocks of \p size bytes of uninitialized storage
+///        from \p hPool. Pools that support it serve the whole batch with a
+///        single pass over their internal locks.
+/// @param hPool specified memory hPool
+/// @param size number of bytes to allocate for each block
+/// @param num number of blocks to allocate
+/// @param ptrs [out] array of at least \p num entries receiving the pointers
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+///         On failure no memory remains allocated.
+///
+umf_result_t umfPoolMallocBatch(umf_memory_pool_handle_t hPool, size_t size,
+                                size_t num, void **ptrs);
+
+///
+/// @brief Frees \p num blocks allocated from \p hPool. NULL entries are
+///        skipped and the entries of the freed blocks are set to NULL,
+///        so on failure \p ptrs holds the blocks which could not be freed.
+/// @param hPool specified memory hPool
+/// @param ptrs [in,out] array of \p num pointers to free
+/// @param num number of entries in \p ptrs
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+///
+umf_result_t umfPoolFreeBatch(umf_memory_pool_handle_t hPool, void **ptrs,
+                              size_t num);
+
+/// @brief A memory region allocated by a memory pool from its memory provider
+typedef struct umf_pool_region_t {
+    void *ptr;                     ///< start address of the region
+    size_t size;                   ///< size of the region
+    umf_memory_pool_handle_t pool; ///< pool that allocated the region
+} umf_pool_region_t;
+
+///
+/// @brief Retrieves a batch of memory regions that memory pools allocated
+///        from their memory providers and have not freed yet, in the order
+///        of their addresses. Only memory of pools with tracking enabled is
+///        tracked. Allocations and deallocations of other threads are not
+///        stopped, so regions allocated or freed concurrently may or may not
+///        be reported.
+/// \details
+///        To iterate over all the regions, start with \p *cursor set to NULL
+///        and call the function until it sets \p *cursor to NULL:
+///        @code
+///        void *cursor = NULL;
+///        do {
+///            size_t count = ARRAY_SIZE(regions);
+///            umfPoolGetTrackedRegions(hPool, &cursor, NULL, regions, &count);
+///            ...
+///        } while (cursor);
+///        @endcode
+/// @param hPool handle of the pool whose regions are retrieved
+///        or NULL to retrieve regions of all pools
+/// @param cursor [in,out] address the search starts at; on return, address
+///        the next batch starts at or NULL if there are no more regions
+/// @param end address the search stops at (exclusive) or NULL to search up to
+///        the end of the address space
+/// @param regions [out] array of \p *count entries receiving the regions
+/// @param count [in,out] number of entries of \p regions on input,
+///        number of retrieved regions on output
+/// @return UMF_RESULT_SUCCESS on success,
+///         UMF_RESULT_ERROR_INVALID_ARGUMENT if an argument is invalid or
+///         the batch is smaller than the number of nested regions (regions
+///         of pools created on top of other pools) starting at one address,
+///         or other appropriate error code on failure.
+///
+umf_result_t umfPoolGetTrackedRegions(umf_memory_pool_handle_t hPool,
+                                      void **cursor, const void *end,
+                                      umf_pool_region_t *regions,
+                                      size_t *count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -191,6 +191,41 @@ typedef struct umf_memory_pool_ops_t {
     ///         failure.
     ///
     umf_result_t (*ext_trim_memory)(void *pool, size_t minBytesToKeep);
+
+    ///
+    /// @brief Allocates \p num blocks of \p size bytes of uninitialized
+    ///        storage from the \p pool in a single call.
+    /// \details
+    ///        The allocation is all-or-nothing: on failure the implementation
+    ///        must release any blocks it already allocated and leave \p ptrs
+    ///        unspecified. If NULL, the framework falls back to calling
+    ///        \p malloc \p num times.
+    /// @param pool pointer to the memory pool
+    /// @param size number of bytes to allocate for each block
+    /// @param num number of blocks to allocate
+    /// @param ptrs [out] array of at least \p num entries receiving the
+    ///        allocated pointers
+    /// @return UMF_RESULT_SUCCESS on success or appropriate error code on
+    ///         failure.
+    ///
+    umf_result_t (*ext_malloc_batch)(void *pool, size_t size, size_t num,
+                                     void **ptrs);
+
+    ///
+    /// @brief Frees \p num blocks allocated from the \p pool in a single call.
+    /// \details
+    ///        NULL entries in \p ptrs are skipped. The entries of the freed
+    ///        blocks are set to NULL and a failure does not stop freeing
+    ///        the other blocks, so on failure \p ptrs holds exactly the blocks
+    ///        which are still allocated. If NULL, the framework falls back
+    ///        to calling \p free for each entry.
+    /// @param pool pointer to the memory pool
+    /// @param ptrs array of \p num pointers to free
+    /// @param num number of entries in \p ptrs
+    /// @return UMF_RESULT_SUCCESS on success or appropriate error code on
+    ///         failure.
+    ///
+    umf_result_t (*ext_free_batch)(void *pool, void **ptrs, size_t num);
 } umf_memory_pool_ops_t;
 
 #ifdef __cplusplus
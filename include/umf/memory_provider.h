@@ -34,6 +34,14 @@ typedef enum umf_mem_protection_flag_t {
     /// @endcond
 } umf_mem_protection_flag_t;
 
+/// @brief Compaction hint of a memory provider: an allocation which,
+/// if relocated, would coalesce with the free memory around it
+typedef struct umf_compaction_hint_t {
+    void *ptr;             ///< pointer to the allocation
+    size_t size;           ///< size of the allocation
+    size_t coalesced_size; ///< size of the free memory after the relocation
+} umf_compaction_hint_t;
+
 /// @brief A struct containing memory provider specific set of functions
 typedef struct umf_memory_provider_t *umf_memory_provider_handle_t;
 
@@ -14,6 +14,8 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+
 #include <umf/memory_pool.h>
 #include <umf/memory_provider.h>
 
@@ -90,6 +92,29 @@ umf_result_t
 umfDisjointPoolParamsSetMinBucketSize(umf_disjoint_pool_params_handle_t hParams,
                                       size_t minBucketSize);
 
+/// @brief Set the number of buckets (size classes) between two consecutive
+/// powers of 2 in the DisjointPool.
+/// \details More buckets per power of 2 reduce the memory wasted by rounding
+/// allocation sizes up, at the cost of more partially used slabs. Buckets are
+/// never spaced closer than 4 bytes. Default value is 2.
+/// @param hParams handle to the parameters of the disjoint pool.
+/// @param bucketsPerPowerOf2 number of buckets per power of 2. Must be a power
+///        of 2 in the range [1, 16].
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t umfDisjointPoolParamsSetBucketsPerPowerOf2(
+    umf_disjoint_pool_params_handle_t hParams, size_t bucketsPerPowerOf2);
+
+/// @brief Enable naturally aligned slabs in the DisjointPool.
+/// \details Slabs are allocated aligned to the slab minimum size, so on free
+/// the slab of a chunk is found by masking the pointer instead of searching
+/// for the closest slab. Requires the slab minimum size to be a power of 2,
+/// otherwise the option is ignored. Default value is false.
+/// @param hParams handle to the parameters of the disjoint pool.
+/// @param enable true to allocate naturally aligned slabs.
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t umfDisjointPoolParamsSetNaturallyAlignedSlabs(
+    umf_disjoint_pool_params_handle_t hParams, bool enable);
+
 /// @brief Set trace level for pool usage statistics.
 /// @details Default value for pool trace is 0 (no traces).
 /// @param hParams handle to the parameters of the disjoint pool.
@@ -118,6 +143,96 @@ umf_result_t
 umfDisjointPoolParamsSetName(umf_disjoint_pool_params_handle_t hParams,
                              const char *name);
 
+/// @brief Set the number of free chunks each thread can keep in its private
+/// cache for every cached bucket of the disjoint pool.
+/// \details Per-thread caches serve small allocations without taking the
+/// bucket lock. They are refilled from and flushed to the buckets in batches
+/// of half of their size and drained on thread exit and on umfPoolTrimMemory.
+/// Default value is 0, which disables per-thread caches.
+/// @param hParams handle to the parameters of the disjoint pool.
+/// @param numChunks number of chunks cached per thread and per bucket.
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t umfDisjointPoolParamsSetThreadCacheSize(
+    umf_disjoint_pool_params_handle_t hParams, size_t numChunks);
+
+/// @brief Set the largest bucket size served from the per-thread caches.
+/// \details Only buckets which split slabs into chunks are cached, so the
+/// effective limit is also bounded by half of the slab_min_size.
+/// Default value is 32KB.
+/// @param hParams handle to the parameters of the disjoint pool.
+/// @param maxChunkSize largest chunk size kept in the per-thread caches.
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t umfDisjointPoolParamsSetThreadCacheMaxChunkSize(
+    umf_disjoint_pool_params_handle_t hParams, size_t maxChunkSize);
+
+/// @brief Declare whether the memory provider returns zero-filled memory.
+/// \details If set, calloc does not clear chunks of newly allocated slabs
+/// which were never handed out before. Default value is false.
+/// @param hParams handle to the parameters of the disjoint pool.
+/// @param zeroed true if the memory returned by the provider is zero-filled.
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t umfDisjointPoolParamsSetProviderZeroedMemory(
+    umf_disjoint_pool_params_handle_t hParams, bool zeroed);
+
+/// @brief Enable lock-free allocation of chunks within slabs.
+/// \details In this mode chunks of buckets which split slabs into chunks are
+/// claimed and released with atomic operations on the slab bitmap. The bucket
+/// lock is taken only when a slab becomes full, available again or empty.
+/// The lock-free path is not used when pool_trace is greater than 1, because
+/// the detailed statistics are collected under the bucket lock.
+/// Default value is false.
+/// @param hParams handle to the parameters of the disjoint pool.
+/// @param enable true to enable the lock-free mode.
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t
+umfDisjointPoolParamsSetLockFreeSlabs(umf_disjoint_pool_params_handle_t hParams,
+                                      bool enable);
+
+/// @brief Enable remote-free queues in the DisjointPool.
+/// \details In this mode chunks of buckets which split slabs into chunks,
+/// freed by a thread other than the one which last allocated from their slab,
+/// are queued on the slab with atomic operations instead of taking the
+/// bucket lock. Queued chunks are returned to their slabs in batch by the
+/// next allocation which finds no available slab in the bucket and by
+/// umfPoolTrimMemory; until then they are reported as used memory.
+/// Buckets in the lock-free mode do not use the queues.
+/// Default value is false.
+/// @param hParams handle to the parameters of the disjoint pool.
+/// @param enable true to enable the remote-free queues.
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t
+umfDisjointPoolParamsSetRemoteFree(umf_disjoint_pool_params_handle_t hParams,
+                                   bool enable);
+
+/// @brief Set the decay time of the empty slabs kept in the DisjointPool.
+/// \details With the decay enabled, empty slabs are not returned to the
+/// memory provider when chunks are freed, regardless of the capacity. A slab
+/// which stays empty for decayMs is purged with umfMemoryProviderPurgeLazy
+/// and it is returned to the provider after another decayMs. The decay is
+/// applied by the background purger thread (see
+/// umfDisjointPoolParamsSetBackgroundPurge) or otherwise by the allocations
+/// which have to allocate a new slab. Without the background thread an idle
+/// pool does not release its empty slabs until it is destroyed. The decay
+/// time can be changed later with the "params.decay_ms" CTL entry of the
+/// pool.
+/// Default value is 0, which disables the decay.
+/// @param hParams handle to the parameters of the disjoint pool.
+/// @param decayMs decay time in milliseconds.
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t
+umfDisjointPoolParamsSetDecayTime(umf_disjoint_pool_params_handle_t hParams,
+                                  size_t decayMs);
+
+/// @brief Apply the decay of the empty slabs in a background thread of the
+/// DisjointPool.
+/// \details The thread is created with the pool and it wakes up every half
+/// of the decay time. Default value is false.
+/// @param hParams handle to the parameters of the disjoint pool.
+/// @param enable true to create the background purger thread.
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t umfDisjointPoolParamsSetBackgroundPurge(
+    umf_disjoint_pool_params_handle_t hParams, bool enable);
+
 const umf_memory_pool_ops_t *umfDisjointPoolOps(void);
 
 #ifdef __cplusplus
@@ -8,6 +8,8 @@
 #ifndef UMF_FILE_MEMORY_PROVIDER_H
 #define UMF_FILE_MEMORY_PROVIDER_H
 
+#include <stdbool.h>
+
 #include <umf/memory_provider.h>
 
 #ifdef __cplusplus
@@ -78,6 +80,32 @@ const umf_memory_provider_ops_t *umfFileMemoryProviderOps(void);
 umf_result_t umfFileMemoryProviderParamsSetName(
     umf_file_memory_provider_params_handle_t hParams, const char *name);
 
+/// @brief  Enable the lazy backing of the File Memory Provider.
+/// \details With the lazy backing, the file grows sparsely, so its space
+/// is allocated on the first touch of the memory, and holes are punched
+/// in the file (fallocate(FALLOC_FL_PUNCH_HOLE)) in place of the freed
+/// and force-purged memory, so the file keeps only the space of the memory
+/// in use. The contents of the freed memory are lost. Without the lazy
+/// backing, the whole increment of the file is allocated when it grows.
+/// Default value is false.
+/// @param  hParams handle to the parameters of the File Memory Provider.
+/// @param  enable true to enable the lazy backing.
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t umfFileMemoryProviderParamsSetLazyBacking(
+    umf_file_memory_provider_params_handle_t hParams, bool enable);
+
+/// @brief  Punch holes of the freed memory in a background thread
+///         of the File Memory Provider.
+/// \details Used only with the lazy backing. Holes of the freed memory
+/// are queued and punched in batches by a background thread instead of
+/// in umfMemoryProviderFree(). Holes of the force-purged memory are always
+/// punched right away. Default value is false.
+/// @param  hParams handle to the parameters of the File Memory Provider.
+/// @param  enable true to create the background thread.
+/// @return UMF_RESULT_SUCCESS on success or appropriate error code on failure.
+umf_result_t umfFileMemoryProviderParamsSetBackgroundPunch(
+    umf_file_memory_provider_params_handle_t hParams, bool enable);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,6 +36,7 @@ struct umf_ba_chunk_t {
 struct umf_ba_main_pool_meta_t {
     size_t pool_size; // size of each pool (argument of each ba_os_alloc() call)
     size_t chunk_size;         // size of all memory chunks in this pool
+    size_t chunk_alignment;    // alignment of all memory chunks in this pool
     utils_mutex_t free_lock;   // lock of free_list
     umf_ba_chunk_t *free_list; // list of free chunks
     size_t n_allocs;           // number of allocated chunks
@@ -141,7 +142,17 @@ static void *ba_os_alloc_annotated(size_t pool_size) {
 }
 
 umf_ba_pool_t *umf_ba_create(size_t size) {
-    size_t chunk_size = ALIGN_UP_SAFE(size, MEMORY_ALIGNMENT);
+    return umf_ba_create_aligned(size, MEMORY_ALIGNMENT);
+}
+
+umf_ba_pool_t *umf_ba_create_aligned(size_t size, size_t alignment) {
+    if (alignment < MEMORY_ALIGNMENT || !IS_POWER_OF_2(alignment)) {
+        return NULL;
+    }
+
+    // all chunks are aligned, because the first one is aligned
+    // and the size of each of them is a multiple of the alignment
+    size_t chunk_size = ALIGN_UP_SAFE(size, alignment);
     if (chunk_size == 0) {
         return NULL;
     }
@@ -149,6 +160,7 @@ umf_ba_pool_t *umf_ba_create(size_t size) {
 
     size_t metadata_size = sizeof(struct umf_ba_main_pool_meta_t);
     size_t pool_size = sizeof(void *) + metadata_size + mutex_size +
+                       (alignment - MEMORY_ALIGNMENT) +
                        (MINIMUM_CHUNK_COUNT * chunk_size);
     if (pool_size < MINIMUM_POOL_SIZE) {
         pool_size = MINIMUM_POOL_SIZE;
@@ -169,6 +181,7 @@ umf_ba_pool_t *umf_ba_create(size_t size) {
 
     pool->metadata.pool_size = pool_size;
     pool->metadata.chunk_size = chunk_size;
+    pool->metadata.chunk_alignment = alignment;
     pool->next_pool = NULL; // this is the only pool now
     pool->metadata.n_allocs = 0;
 #ifndef NDEBUG
@@ -181,8 +194,7 @@ umf_ba_pool_t *umf_ba_create(size_t size) {
     char *data_ptr = (char *)&pool->data;
     size_t size_left = pool_size - offsetof(umf_ba_pool_t, data);
 
-    utils_align_ptr_up_size_down((void **)&data_ptr, &size_left,
-                                 MEMORY_ALIGNMENT);
+    utils_align_ptr_up_size_down((void **)&data_ptr, &size_left, alignment);
 
     // init free_lock
     utils_mutex_t *mutex = utils_mutex_init(&pool->metadata.free_lock);
@@ -197,14 +209,13 @@ umf_ba_pool_t *umf_ba_create(size_t size) {
     return pool;
 }
 
-void *umf_ba_alloc(umf_ba_pool_t *pool) {
-    utils_mutex_lock(&pool->metadata.free_lock);
+// Allocates a chunk from the pool. Should be called under the lock.
+static void *ba_alloc_locked(umf_ba_pool_t *pool) {
     if (pool->metadata.free_list == NULL) {
         umf_ba_next_pool_t *new_pool =
             (umf_ba_next_pool_t *)ba_os_alloc_annotated(
                 pool->metadata.pool_size);
         if (!new_pool) {
-            utils_mutex_unlock(&pool->metadata.free_lock);
             return NULL;
         }
 
@@ -224,7 +235,7 @@ void *umf_ba_alloc(umf_ba_pool_t *pool) {
             pool->metadata.pool_size - offsetof(umf_ba_next_pool_t, data);
 
         utils_align_ptr_up_size_down((void **)&data_ptr, &size_left,
-                                     MEMORY_ALIGNMENT);
+                                     pool->metadata.chunk_alignment);
         ba_divide_memory_into_chunks(pool, data_ptr, size_left);
     }
 
@@ -237,7 +248,6 @@ void *umf_ba_alloc(umf_ba_pool_t *pool) {
     // check if the free list is not empty
     if (pool->metadata.free_list == NULL) {
         LOG_ERR("base_alloc: Free list should not be empty before new alloc");
-        utils_mutex_unlock(&pool->metadata.free_lock);
         return NULL;
     }
 
@@ -250,11 +260,32 @@ void *umf_ba_alloc(umf_ba_pool_t *pool) {
     VALGRIND_DO_MALLOCLIKE_BLOCK(chunk, pool->metadata.chunk_size, 0, 0);
     utils_annotate_memory_undefined(chunk, pool->metadata.chunk_size);
 
+    return chunk;
+}
+
+void *umf_ba_alloc(umf_ba_pool_t *pool) {
+    utils_mutex_lock(&pool->metadata.free_lock);
+    void *chunk = ba_alloc_locked(pool);
     utils_mutex_unlock(&pool->metadata.free_lock);
 
     return chunk;
 }
 
+size_t umf_ba_alloc_batch(umf_ba_pool_t *pool, void **ptrs, size_t num) {
+    size_t i;
+
+    utils_mutex_lock(&pool->metadata.free_lock);
+    for (i = 0; i < num; i++) {
+        ptrs[i] = ba_alloc_locked(pool);
+        if (ptrs[i] == NULL) {
+            break;
+        }
+    }
+    utils_mutex_unlock(&pool->metadata.free_lock);
+
+    return i;
+}
+
 #ifndef NDEBUG
 // Checks if given pointer belongs to the pool. Should be called
 // under the lock
@@ -278,14 +309,10 @@ static int pool_contains_pointer(umf_ba_pool_t *pool, void *ptr) {
 }
 #endif
 
-void umf_ba_free(umf_ba_pool_t *pool, void *ptr) {
-    if (ptr == NULL) {
-        return;
-    }
-
+// Returns a chunk to the pool. Should be called under the lock.
+static void ba_free_locked(umf_ba_pool_t *pool, void *ptr) {
     umf_ba_chunk_t *chunk = (umf_ba_chunk_t *)ptr;
 
-    utils_mutex_lock(&pool->metadata.free_lock);
     assert(pool_contains_pointer(pool, ptr));
     chunk->next = pool->metadata.free_list;
     pool->metadata.free_list = chunk;
@@ -296,10 +323,40 @@ void umf_ba_free(umf_ba_pool_t *pool, void *ptr) {
 
     VALGRIND_DO_FREELIKE_BLOCK(chunk, 0);
     utils_annotate_memory_inaccessible(chunk, pool->metadata.chunk_size);
+}
+
+void umf_ba_free(umf_ba_pool_t *pool, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
 
+    utils_mutex_lock(&pool->metadata.free_lock);
+    ba_free_locked(pool, ptr);
     utils_mutex_unlock(&pool->metadata.free_lock);
 }
 
+void umf_ba_free_batch(umf_ba_pool_t *pool, void **ptrs, size_t num) {
+    utils_mutex_lock(&pool->metadata.free_lock);
+    for (size_t i = 0; i < num; i++) {
+        if (ptrs[i]) {
+            ba_free_locked(pool, ptrs[i]);
+        }
+    }
+    utils_mutex_unlock(&pool->metadata.free_lock);
+}
+
+size_t umf_ba_get_n_allocs(umf_ba_pool_t *pool, size_t *chunk_size) {
+    utils_mutex_lock(&pool->metadata.free_lock);
+    size_t n_allocs = pool->metadata.n_allocs;
+    utils_mutex_unlock(&pool->metadata.free_lock);
+
+    if (chunk_size) {
+        *chunk_size = pool->metadata.chunk_size;
+    }
+
+    return n_allocs;
+}
+
 void umf_ba_destroy(umf_ba_pool_t *pool) {
     // Do not destroy if we are running in the proxy library,
     // because it may need those resources till
@@ -19,8 +19,19 @@ extern "C" {
 typedef struct umf_ba_pool_t umf_ba_pool_t;
 
 umf_ba_pool_t *umf_ba_create(size_t size);
+// creates a pool of chunks aligned to `alignment`
+// (a power of 2, not smaller than the pointer size)
+umf_ba_pool_t *umf_ba_create_aligned(size_t size, size_t alignment);
 void *umf_ba_alloc(umf_ba_pool_t *pool);
 void umf_ba_free(umf_ba_pool_t *pool, void *ptr);
+// allocates up to `num` chunks under a single lock,
+// returns the number of allocated chunks
+size_t umf_ba_alloc_batch(umf_ba_pool_t *pool, void **ptrs, size_t num);
+// frees `num` chunks (NULL entries are skipped) under a single lock
+void umf_ba_free_batch(umf_ba_pool_t *pool, void **ptrs, size_t num);
+// returns the number of allocated chunks and their size in `chunk_size`
+// (if not NULL)
+size_t umf_ba_get_n_allocs(umf_ba_pool_t *pool, size_t *chunk_size);
 void umf_ba_destroy(umf_ba_pool_t *pool);
 
 #ifdef __cplusplus
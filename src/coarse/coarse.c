@@ -21,6 +21,7 @@
 #include "utils_common.h"
 #include "utils_concurrency.h"
 #include "utils_log.h"
+#include "utils_math.h"
 
 #ifdef _WIN32
 UTIL_ONCE_FLAG Log_initialized = UTIL_ONCE_FLAG_INIT;
@@ -29,18 +30,16 @@ void __attribute__((constructor)) coarse_init(void) { utils_log_init(); }
 void __attribute__((destructor)) coarse_destroy(void) {}
 #endif /* _WIN32 */
 
-typedef struct coarse_t {
-    // handle of the memory provider
-    void *provider;
-
-    // coarse callbacks
-    coarse_callbacks_t cb;
-
-    // memory allocation strategy
-    coarse_strategy_t allocation_strategy;
+// maximum number of arenas of one coarse instance
+#define COARSE_MAX_ARENAS 64
 
-    // page size of the memory provider
-    size_t page_size;
+// An arena manages its own part of the memory of the coarse instance
+// under its own lock. Memory is moved between arenas only by stealing
+// free blocks (see arena_steal()), so blocks of different arenas
+// are never merged.
+typedef struct coarse_arena_t {
+    // the coarse instance this arena belongs to
+    struct coarse_t *coarse;
 
     // all_blocks - tree of all blocks - sorted by an address of data
     struct ravl *all_blocks;
@@ -48,15 +47,63 @@ typedef struct coarse_t {
     // free_blocks - tree of free blocks - sorted by a size of data,
     // each node contains a pointer (ravl_free_blocks_head_t)
     // to the head of the list of free blocks of the same size
+    // (NULL if the UMF_COARSE_MEMORY_STRATEGY_SEGREGATED_FIT
+    // or the UMF_COARSE_MEMORY_STRATEGY_LOWEST_ADDRESS strategy is used)
     struct ravl *free_blocks;
 
+    // seg_index - segregated-fit index of free blocks, used instead of
+    // the free_blocks tree by the UMF_COARSE_MEMORY_STRATEGY_SEGREGATED_FIT
+    // strategy (NULL otherwise)
+    struct seg_index_t *seg_index;
+
+    // free_by_addr - tree of free blocks - sorted by an address of data,
+    // used instead of the free_blocks tree
+    // by the UMF_COARSE_MEMORY_STRATEGY_LOWEST_ADDRESS strategy
+    // (NULL otherwise)
+    struct ravl *free_by_addr;
+
     struct utils_mutex_t lock;
 
     // statistics
     size_t used_size;
     size_t alloc_size;
+} coarse_arena_t;
+
+typedef struct coarse_t {
+    // handle of the memory provider
+    void *provider;
+
+    // coarse callbacks
+    coarse_callbacks_t cb;
+
+    // memory allocation strategy
+    coarse_strategy_t allocation_strategy;
+
+    // page size of the memory provider
+    size_t page_size;
+
+    // arenas - each one allocated separately, so that their locks
+    // do not share cache lines
+    size_t num_arenas;
+    coarse_arena_t *arenas[COARSE_MAX_ARENAS];
+
+    // ranges - tree of memory ranges (coarse_range_t) sorted by address,
+    // telling which arena owns which memory,
+    // used only if there is more than one arena
+    struct ravl *ranges;
+    utils_rwlock_t ranges_lock;
 } coarse_t;
 
+// A range of memory owned by one arena.
+typedef struct coarse_range_t {
+    uintptr_t start;
+    size_t size;
+    coarse_arena_t *arena;
+    // the arena the memory was added to first; a range stolen from it
+    // is given back to it when it becomes free
+    coarse_arena_t *home;
+} coarse_range_t;
+
 typedef struct ravl_node ravl_node_t;
 
 typedef enum check_free_blocks_t {
@@ -70,15 +117,15 @@ typedef struct block_t {
     bool used;
 
     // Node in the list of free blocks of the same size pointing to this block.
-    // The list is located in the (coarse->free_blocks) RAVL tree.
+    // The list is located in the (arena->free_blocks) RAVL tree.
     struct ravl_free_blocks_elem_t *free_list_ptr;
 } block_t;
 
 // A general node in a RAVL tree.
-// 1) coarse->all_blocks RAVL tree (tree of all blocks - sorted by an address of data):
+// 1) arena->all_blocks RAVL tree (tree of all blocks - sorted by an address of data):
 //    key   - pointer (block_t->data) to the beginning of the block data
 //    value - pointer (block_t) to the block of the allocation
-// 2) coarse->free_blocks RAVL tree (tree of free blocks - sorted by a size of data):
+// 2) arena->free_blocks RAVL tree (tree of free blocks - sorted by a size of data):
 //    key   - size of the allocation (block_t->size)
 //    value - pointer (ravl_free_blocks_head_t) to the head of the list of free blocks of the same size
 typedef struct ravl_data_t {
@@ -98,6 +145,24 @@ typedef struct ravl_free_blocks_elem_t {
     struct ravl_free_blocks_elem_t *prev;
 } ravl_free_blocks_elem_t;
 
+// The segregated-fit index of free blocks.
+// The first level divides sizes into ranges of powers of two,
+// the second level divides each of these ranges into SEG_SL_COUNT
+// size classes of equal width. Every size class has its own list
+// of free blocks and a bit in the bitmaps telling if the list is not empty.
+// Sizes smaller than SEG_SL_COUNT all go to the first level 0.
+#define SEG_SL_SHIFT 4
+#define SEG_SL_COUNT (1 << SEG_SL_SHIFT)
+#define SEG_FL_COUNT (64 - SEG_SL_SHIFT + 1)
+
+typedef struct seg_index_t {
+    // bit 'fl' is set if any list of the first level 'fl' is not empty
+    uint64_t fl_bitmap;
+    // bit 'sl' of sl_bitmap[fl] is set if lists[fl][sl] is not empty
+    uint32_t sl_bitmap[SEG_FL_COUNT];
+    ravl_free_blocks_head_t lists[SEG_FL_COUNT][SEG_SL_COUNT];
+} seg_index_t;
+
 // The compare function of a RAVL tree
 static int coarse_ravl_comp(const void *lhs, const void *rhs) {
     const ravl_data_t *lhs_ravl = (const ravl_data_t *)lhs;
@@ -150,7 +215,7 @@ static block_t *get_block_next(ravl_node_t *node) {
 }
 #endif /* !defined(NDEBUG) && defined(UMF_DEVELOPER_MODE) */
 
-// The functions "coarse_ravl_*" handles the coarse->all_blocks list of blocks
+// The functions "coarse_ravl_*" handles the arena->all_blocks list of blocks
 // sorted by a pointer (block_t->data) to the beginning of the block data.
 //
 // coarse_ravl_add_new - allocate and add a new block to the tree
@@ -212,9 +277,17 @@ static block_t *coarse_ravl_rm(struct ravl *rtree, void *ptr) {
     return NULL;
 }
 
+// block_fits - check if the block can hold 'size' bytes
+// at an address aligned to 'alignment'
+static inline bool block_fits(block_t *block, size_t size, size_t alignment) {
+    uintptr_t data = (uintptr_t)block->data;
+    size_t padding = alignment ? ALIGN_UP(data, alignment) - data : 0;
+    return (padding < block->size) && (block->size - padding >= size);
+}
+
 // The functions "node_list_*" handle lists of free blocks of the same size.
 // The heads (ravl_free_blocks_head_t) of those lists are stored in nodes of
-// the coarse->free_blocks RAVL tree.
+// the arena->free_blocks RAVL tree.
 //
 // node_list_add - add a free block to the list of free blocks of the same size
 static ravl_free_blocks_elem_t *
@@ -311,7 +384,7 @@ static block_t *node_list_rm_with_alignment(ravl_free_blocks_head_t *head_node,
     return NULL;
 }
 
-// The functions "free_blocks_*" handle the coarse->free_blocks RAVL tree
+// The functions "free_blocks_*" handle the arena->free_blocks RAVL tree
 // sorted by a size of the allocation (block_t->size).
 // This is a tree of heads (ravl_free_blocks_head_t) of lists of free blocks of the same size.
 //
@@ -394,7 +467,7 @@ static block_t *free_blocks_rm_ge(struct ravl *free_blocks, size_t size,
 
 // free_blocks_rm_node - remove the free block pointed by the given node.
 // If it was the last block, the head node is freed and removed from the tree.
-// It is used during merging free blocks and destroying the coarse->free_blocks tree.
+// It is used during merging free blocks and destroying the arena->free_blocks tree.
 static block_t *free_blocks_rm_node(struct ravl *free_blocks,
                                     ravl_free_blocks_elem_t *node) {
     assert(free_blocks);
@@ -422,8 +495,308 @@ static block_t *free_blocks_rm_node(struct ravl *free_blocks,
     return block;
 }
 
+// free_blocks_rm_best_fit - remove the smallest free block that can hold
+// 'size' bytes after aligning its data. Of free blocks of the same size
+// the one with the lowest address is chosen.
+// If it was the last block, the head node is freed and removed from the tree.
+static block_t *free_blocks_rm_best_fit(struct ravl *free_blocks, size_t size,
+                                        size_t alignment) {
+    ravl_data_t data = {(uintptr_t)size, NULL};
+    ravl_node_t *node;
+    node = ravl_find(free_blocks, &data, RAVL_PREDICATE_GREATER_EQUAL);
+    for (; node != NULL; node = ravl_node_successor(node)) {
+        ravl_data_t *node_data = ravl_data(node);
+        assert(node_data);
+        assert(node_data->key >= size);
+
+        ravl_free_blocks_head_t *head_node = node_data->value;
+        assert(head_node);
+
+        ravl_free_blocks_elem_t *best = NULL;
+        ravl_free_blocks_elem_t *elem;
+        for (elem = head_node->head; elem != NULL; elem = elem->next) {
+            if (block_fits(elem->block, size, alignment) &&
+                (best == NULL || elem->block->data < best->block->data)) {
+                best = elem;
+            }
+        }
+
+        if (best == NULL) {
+            continue;
+        }
+
+        block_t *block = node_list_rm(head_node, best);
+
+        if (head_node->head == NULL) {
+            umf_ba_global_free(head_node);
+            ravl_remove(free_blocks, node);
+        }
+
+        return block;
+    }
+
+    return NULL;
+}
+
+// The functions "free_by_addr_*" handle the arena->free_by_addr RAVL tree
+// of free blocks sorted by an address of data (block_t->data), used by
+// the UMF_COARSE_MEMORY_STRATEGY_LOWEST_ADDRESS strategy.
+// Values of the tree are elements (ravl_free_blocks_elem_t) pointing
+// to the free blocks, like in lists of the coarse->free_blocks tree.
+//
+// free_by_addr_add - add a free block to the tree
+static int free_by_addr_add(struct ravl *free_by_addr, block_t *block) {
+    ravl_free_blocks_elem_t *elem = umf_ba_global_alloc(sizeof(*elem));
+    if (elem == NULL) {
+        return -1;
+    }
+
+    elem->block = block;
+    elem->next = NULL;
+    elem->prev = NULL;
+
+    ravl_data_t data = {(uintptr_t)block->data, elem};
+    if (ravl_emplace_copy(free_by_addr, &data)) {
+        umf_ba_global_free(elem);
+        return -1;
+    }
+
+    block->free_list_ptr = elem;
+
+    return 0;
+}
+
+// free_by_addr_rm_node - remove the free block pointed by the given element
+static block_t *free_by_addr_rm_node(struct ravl *free_by_addr,
+                                     ravl_free_blocks_elem_t *elem) {
+    block_t *block = elem->block;
+
+    ravl_node_t *node = coarse_ravl_find_node(free_by_addr, block->data);
+    assert(node);
+    ravl_remove(free_by_addr, node);
+
+    block->free_list_ptr = NULL;
+    umf_ba_global_free(elem);
+
+    return block;
+}
+
+// free_by_addr_rm_first_fit - remove the free block with the lowest address
+// that can hold 'size' bytes after aligning its data
+static block_t *free_by_addr_rm_first_fit(struct ravl *free_by_addr,
+                                          size_t size, size_t alignment) {
+    ravl_data_t data = {0, NULL};
+    ravl_node_t *node;
+    node = ravl_find(free_by_addr, &data, RAVL_PREDICATE_GREATER_EQUAL);
+    for (; node != NULL; node = ravl_node_successor(node)) {
+        ravl_data_t *node_data = ravl_data(node);
+        assert(node_data);
+
+        ravl_free_blocks_elem_t *elem = node_data->value;
+        if (block_fits(elem->block, size, alignment)) {
+            return free_by_addr_rm_node(free_by_addr, elem);
+        }
+    }
+
+    return NULL;
+}
+
+// The functions "seg_*" handle the arena->seg_index segregated-fit index
+// of free blocks used by the UMF_COARSE_MEMORY_STRATEGY_SEGREGATED_FIT
+// strategy.
+//
+// seg_mapping - get the size class (fl, sl) the given size belongs to
+static inline void seg_mapping(size_t size, size_t *fl, size_t *sl) {
+    if (size < SEG_SL_COUNT) {
+        *fl = 0;
+        *sl = size;
+        return;
+    }
+
+    size_t msb = utils_msb64(size);
+    *fl = msb - SEG_SL_SHIFT + 1;
+    *sl = (size >> (msb - SEG_SL_SHIFT)) - SEG_SL_COUNT;
+}
+
+// seg_mapping_search - get the first size class (fl, sl) all blocks of which
+// are greater or equal to the given size (the size is rounded up
+// to the next size class). Returns false in case of an arithmetic overflow.
+static inline bool seg_mapping_search(size_t size, size_t *fl, size_t *sl) {
+    if (size >= SEG_SL_COUNT) {
+        size_t round = ((size_t)1 << (utils_msb64(size) - SEG_SL_SHIFT)) - 1;
+        if (size + round < size) {
+            return false;
+        }
+        size += round;
+    }
+
+    seg_mapping(size, fl, sl);
+    return true;
+}
+
+// seg_find_list - find the first non-empty list starting from the (fl, sl)
+// size class
+static ravl_free_blocks_head_t *seg_find_list(seg_index_t *seg, size_t fl,
+                                              size_t sl) {
+    uint32_t sl_map = seg->sl_bitmap[fl] & (~0U << sl);
+    if (!sl_map) {
+        uint64_t fl_map = 0;
+        if (fl + 1 < SEG_FL_COUNT) {
+            fl_map = seg->fl_bitmap & (~(uint64_t)0 << (fl + 1));
+        }
+
+        if (!fl_map) {
+            return NULL;
+        }
+
+        fl = utils_lsb64(fl_map);
+        sl_map = seg->sl_bitmap[fl];
+        assert(sl_map);
+    }
+
+    sl = utils_lsb64(sl_map);
+    assert(seg->lists[fl][sl].head);
+
+    return &seg->lists[fl][sl];
+}
+
+// seg_update_bitmaps - update bits of the (fl, sl) size class after
+// a block was added to or removed from its list
+static inline void seg_update_bitmaps(seg_index_t *seg, size_t fl, size_t sl) {
+    if (seg->lists[fl][sl].head) {
+        seg->sl_bitmap[fl] |= (1U << sl);
+        seg->fl_bitmap |= ((uint64_t)1 << fl);
+        return;
+    }
+
+    seg->sl_bitmap[fl] &= ~(1U << sl);
+    if (seg->sl_bitmap[fl] == 0) {
+        seg->fl_bitmap &= ~((uint64_t)1 << fl);
+    }
+}
+
+// seg_add - add a free block to the list of its size class
+static int seg_add(seg_index_t *seg, block_t *block) {
+    size_t fl, sl;
+    seg_mapping(block->size, &fl, &sl);
+
+    block->free_list_ptr = node_list_add(&seg->lists[fl][sl], block);
+    if (!block->free_list_ptr) {
+        return -1; // out of memory
+    }
+
+    seg_update_bitmaps(seg, fl, sl);
+
+    return 0;
+}
+
+// seg_rm_node - remove the free block pointed by the given node
+static block_t *seg_rm_node(seg_index_t *seg, ravl_free_blocks_elem_t *node) {
+    size_t fl, sl;
+    seg_mapping(node->block->size, &fl, &sl);
+
+    block_t *block = node_list_rm(&seg->lists[fl][sl], node);
+    seg_update_bitmaps(seg, fl, sl);
+
+    return block;
+}
+
+// seg_rm_good_fit - remove the first free block of the first non-empty list
+// of a size class that guarantees a block of at least the given size,
+// but only if it can hold 'size' bytes after aligning its data
+static block_t *seg_rm_good_fit(seg_index_t *seg, size_t size,
+                                size_t alignment) {
+    size_t fl, sl;
+    if (!seg_mapping_search(size, &fl, &sl)) {
+        return NULL;
+    }
+
+    ravl_free_blocks_head_t *head_node = seg_find_list(seg, fl, sl);
+    if (!head_node) {
+        return NULL;
+    }
+
+    if (!block_fits(head_node->head->block, size, alignment)) {
+        return NULL;
+    }
+
+    return seg_rm_node(seg, head_node->head);
+}
+
+// seg_rm_first_fit - look through the list of the size class of the given
+// size (its blocks can be smaller or greater than the size) and remove
+// the first block that can hold 'size' bytes after aligning its data
+static block_t *seg_rm_first_fit(seg_index_t *seg, size_t size,
+                                 size_t alignment) {
+    size_t fl, sl;
+    seg_mapping(size, &fl, &sl);
+
+    ravl_free_blocks_elem_t *node;
+    for (node = seg->lists[fl][sl].head; node != NULL; node = node->next) {
+        if (block_fits(node->block, size, alignment)) {
+            return seg_rm_node(seg, node);
+        }
+    }
+
+    return NULL;
+}
+
+// seg_count - count all free blocks in the index
+static size_t seg_count(seg_index_t *seg) {
+    size_t count = 0;
+    uint64_t fl_map = seg->fl_bitmap;
+    while (fl_map) {
+        size_t fl = utils_lsb64(fl_map);
+        fl_map &= fl_map - 1;
+
+        uint64_t sl_map = seg->sl_bitmap[fl];
+        while (sl_map) {
+            size_t sl = utils_lsb64(sl_map);
+            sl_map &= sl_map - 1;
+
+            ravl_free_blocks_elem_t *node;
+            for (node = seg->lists[fl][sl].head; node; node = node->next) {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+// coarse_free_blocks_add - add a free block to the structure of free blocks
+// used by the allocation strategy
+static int coarse_free_blocks_add(coarse_arena_t *arena, block_t *block) {
+    if (arena->seg_index) {
+        return seg_add(arena->seg_index, block);
+    }
+
+    if (arena->free_by_addr) {
+        return free_by_addr_add(arena->free_by_addr, block);
+    }
+
+    return free_blocks_add(arena->free_blocks, block);
+}
+
+// coarse_free_blocks_rm - remove the free block pointed by the given node
+// from the structure of free blocks used by the allocation strategy
+static block_t *coarse_free_blocks_rm(coarse_arena_t *arena,
+                                      ravl_free_blocks_elem_t *node) {
+    if (arena->seg_index) {
+        return seg_rm_node(arena->seg_index, node);
+    }
+
+    if (arena->free_by_addr) {
+        return free_by_addr_rm_node(arena->free_by_addr, node);
+    }
+
+    return free_blocks_rm_node(arena->free_blocks, node);
+}
+
+static bool coarse_ranges_same(coarse_t *coarse, void *ptr1, void *ptr2);
+
 // user_block_merge - merge two blocks from one of two lists of user blocks: all_blocks or free_blocks
-static umf_result_t user_block_merge(coarse_t *coarse, ravl_node_t *node1,
+static umf_result_t user_block_merge(coarse_arena_t *arena, ravl_node_t *node1,
                                      ravl_node_t *node2, bool used,
                                      ravl_node_t **merged_node) {
     assert(node1);
@@ -434,8 +807,7 @@ static umf_result_t user_block_merge(coarse_t *coarse, ravl_node_t *node1,
 
     *merged_node = NULL;
 
-    struct ravl *all_blocks = coarse->all_blocks;
-    struct ravl *free_blocks = coarse->free_blocks;
+    struct ravl *all_blocks = arena->all_blocks;
 
     block_t *block1 = get_node_block(node1);
     block_t *block2 = get_node_block(node2);
@@ -449,6 +821,13 @@ static umf_result_t user_block_merge(coarse_t *coarse, ravl_node_t *node1,
         return UMF_RESULT_ERROR_INVALID_ARGUMENT;
     }
 
+    // blocks of different ranges are not merged,
+    // so that a stolen range can be given back to its home arena
+    coarse_t *coarse = arena->coarse;
+    if (!coarse_ranges_same(coarse, block1->data, block2->data)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
     // check if blocks can be merged
     umf_result_t umf_result =
         coarse->cb.merge(coarse->provider, block1->data, block2->data,
@@ -461,12 +840,12 @@ static umf_result_t user_block_merge(coarse_t *coarse, ravl_node_t *node1,
     }
 
     if (block1->free_list_ptr) {
-        free_blocks_rm_node(free_blocks, block1->free_list_ptr);
+        coarse_free_blocks_rm(arena, block1->free_list_ptr);
         block1->free_list_ptr = NULL;
     }
 
     if (block2->free_list_ptr) {
-        free_blocks_rm_node(free_blocks, block2->free_list_ptr);
+        coarse_free_blocks_rm(arena, block2->free_list_ptr);
         block2->free_list_ptr = NULL;
     }
 
@@ -486,7 +865,7 @@ static umf_result_t user_block_merge(coarse_t *coarse, ravl_node_t *node1,
 // free_block_merge_with_prev - merge the given free block
 // with the previous one if both are unused and have continuous data.
 // Remove the merged block from the tree of free blocks.
-static ravl_node_t *free_block_merge_with_prev(coarse_t *coarse,
+static ravl_node_t *free_block_merge_with_prev(coarse_arena_t *arena,
                                                ravl_node_t *node) {
     ravl_node_t *node_prev = get_node_prev(node);
     if (!node_prev) {
@@ -495,7 +874,7 @@ static ravl_node_t *free_block_merge_with_prev(coarse_t *coarse,
 
     ravl_node_t *merged_node = NULL;
     umf_result_t umf_result =
-        user_block_merge(coarse, node_prev, node, false, &merged_node);
+        user_block_merge(arena, node_prev, node, false, &merged_node);
     if (umf_result != UMF_RESULT_SUCCESS) {
         return node;
     }
@@ -508,7 +887,7 @@ static ravl_node_t *free_block_merge_with_prev(coarse_t *coarse,
 // free_block_merge_with_next - merge the given free block
 // with the next one if both are unused and have continuous data.
 // Remove the merged block from the tree of free blocks.
-static ravl_node_t *free_block_merge_with_next(coarse_t *coarse,
+static ravl_node_t *free_block_merge_with_next(coarse_arena_t *arena,
                                                ravl_node_t *node) {
     ravl_node_t *node_next = get_node_next(node);
     if (!node_next) {
@@ -517,7 +896,7 @@ static ravl_node_t *free_block_merge_with_next(coarse_t *coarse,
 
     ravl_node_t *merged_node = NULL;
     umf_result_t umf_result =
-        user_block_merge(coarse, node, node_next, false, &merged_node);
+        user_block_merge(arena, node, node_next, false, &merged_node);
     if (umf_result != UMF_RESULT_SUCCESS) {
         return node;
     }
@@ -531,7 +910,7 @@ static ravl_node_t *free_block_merge_with_next(coarse_t *coarse,
 #ifdef UMF_DEVELOPER_MODE
 
 typedef struct debug_cb_args_t {
-    coarse_t *provider;
+    coarse_arena_t *arena;
     size_t sum_used;
     size_t sum_blocks_size;
     size_t num_all_blocks;
@@ -547,10 +926,10 @@ static void debug_verify_all_blocks_cb(void *data, void *arg) {
     assert(block);
 
     debug_cb_args_t *cb_args = (debug_cb_args_t *)arg;
-    coarse_t *provider = cb_args->provider;
+    coarse_arena_t *arena = cb_args->arena;
 
     ravl_node_t *node =
-        ravl_find(provider->all_blocks, data, RAVL_PREDICATE_EQUAL);
+        ravl_find(arena->all_blocks, data, RAVL_PREDICATE_EQUAL);
     assert(node);
 
     block_t *block_next = get_block_next(node);
@@ -584,64 +963,64 @@ static void debug_verify_all_blocks_cb(void *data, void *arg) {
     }
 }
 
-static umf_result_t coarse_get_stats_no_lock(coarse_t *coarse,
+static umf_result_t arena_get_stats_no_lock(coarse_arena_t *arena,
                                              coarse_stats_t *stats);
 
-static bool debug_check(coarse_t *provider) {
-    assert(provider);
+static bool debug_check(coarse_arena_t *arena) {
+    assert(arena);
 
     coarse_stats_t stats = {0};
-    coarse_get_stats_no_lock(provider, &stats);
+    arena_get_stats_no_lock(arena, &stats);
 
     debug_cb_args_t cb_args = {0};
-    cb_args.provider = provider;
+    cb_args.arena = arena;
 
     // verify the all_blocks list
-    ravl_foreach(provider->all_blocks, debug_verify_all_blocks_cb, &cb_args);
+    ravl_foreach(arena->all_blocks, debug_verify_all_blocks_cb, &cb_args);
 
     assert(cb_args.num_all_blocks == stats.num_all_blocks);
     assert(cb_args.num_free_blocks == stats.num_free_blocks);
-    assert(cb_args.sum_used == provider->used_size);
-    assert(cb_args.sum_blocks_size == provider->alloc_size);
-    assert(provider->alloc_size >= provider->used_size);
+    assert(cb_args.sum_used == arena->used_size);
+    assert(cb_args.sum_blocks_size == arena->alloc_size);
+    assert(arena->alloc_size >= arena->used_size);
 
     return true;
 }
 #else               /* !UMF_DEVELOPER_MODE */
-static inline bool debug_check(coarse_t *provider) {
-    (void)provider; // suppress unused variable warning
+static inline bool debug_check(coarse_arena_t *arena) {
+    (void)arena; // suppress unused variable warning
     return true;
 }
 #endif              /* !UMF_DEVELOPER_MODE */
 #endif /* NDEBUG */ // end of DEBUG code
 
-static umf_result_t coarse_add_used_block(coarse_t *coarse, void *addr,
+static umf_result_t coarse_add_used_block(coarse_arena_t *arena, void *addr,
                                           size_t size) {
     block_t *new_block =
-        coarse_ravl_add_new(coarse->all_blocks, addr, size, NULL);
+        coarse_ravl_add_new(arena->all_blocks, addr, size, NULL);
     if (new_block == NULL) {
         return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
     }
 
     new_block->used = true;
-    coarse->alloc_size += size;
-    coarse->used_size += size;
+    arena->alloc_size += size;
+    arena->used_size += size;
 
     return UMF_RESULT_SUCCESS;
 }
 
-static umf_result_t coarse_add_free_block(coarse_t *coarse, void *addr,
+static umf_result_t coarse_add_free_block(coarse_arena_t *arena, void *addr,
                                           size_t size, block_t **free_block) {
     *free_block = NULL;
 
     block_t *new_block =
-        coarse_ravl_add_new(coarse->all_blocks, addr, size, NULL);
+        coarse_ravl_add_new(arena->all_blocks, addr, size, NULL);
     if (new_block == NULL) {
         return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
     }
 
     new_block->used = false;
-    coarse->alloc_size += size;
+    arena->alloc_size += size;
 
     *free_block = new_block;
 
@@ -652,7 +1031,7 @@ static void coarse_ravl_cb_rm_all_blocks_node(void *data, void *arg) {
     assert(data);
     assert(arg);
 
-    coarse_t *coarse = (struct coarse_t *)arg;
+    coarse_arena_t *arena = (coarse_arena_t *)arg;
     ravl_data_t *node_data = data;
     block_t *block = node_data->value;
     assert(block);
@@ -662,27 +1041,29 @@ static void coarse_ravl_cb_rm_all_blocks_node(void *data, void *arg) {
         LOG_WARN("not freed block (addr: %p, size: %zu)", (void *)block->data,
                  block->size);
 #endif
-        assert(coarse->used_size >= block->size);
-        coarse->used_size -= block->size;
+        assert(arena->used_size >= block->size);
+        arena->used_size -= block->size;
     }
 
     if (block->free_list_ptr) {
-        free_blocks_rm_node(coarse->free_blocks, block->free_list_ptr);
+        coarse_free_blocks_rm(arena, block->free_list_ptr);
     }
 
+    coarse_t *coarse = arena->coarse;
     if (coarse->cb.free) {
         coarse->cb.free(coarse->provider, block->data, block->size);
     }
 
-    assert(coarse->alloc_size >= block->size);
-    coarse->alloc_size -= block->size;
+    assert(arena->alloc_size >= block->size);
+    arena->alloc_size -= block->size;
 
     umf_ba_global_free(block);
 }
 
-static umf_result_t can_provider_split(coarse_t *coarse, void *ptr,
+static umf_result_t can_provider_split(coarse_arena_t *arena, void *ptr,
                                        size_t totalSize, size_t firstSize) {
     // check if the block can be split
+    coarse_t *coarse = arena->coarse;
     umf_result_t umf_result =
         coarse->cb.split(coarse->provider, ptr, totalSize, firstSize);
     if (umf_result != UMF_RESULT_SUCCESS) {
@@ -694,8 +1075,9 @@ static umf_result_t can_provider_split(coarse_t *coarse, void *ptr,
     return umf_result;
 }
 
-static umf_result_t create_aligned_block(coarse_t *coarse, size_t orig_size,
-                                         size_t alignment, block_t **current) {
+static umf_result_t create_aligned_block(coarse_arena_t *arena,
+                                         size_t orig_size, size_t alignment,
+                                         block_t **current) {
     (void)orig_size; // unused in the Release version
     int rv;
 
@@ -708,13 +1090,13 @@ static umf_result_t create_aligned_block(coarse_t *coarse, size_t orig_size,
     if (alignment > 0 && padding > 0) {
         // check if block can be split by the upstream provider
         umf_result_t umf_result =
-            can_provider_split(coarse, curr->data, curr->size, padding);
+            can_provider_split(arena, curr->data, curr->size, padding);
         if (umf_result != UMF_RESULT_SUCCESS) {
             return umf_result;
         }
 
         block_t *aligned_block =
-            coarse_ravl_add_new(coarse->all_blocks, curr->data + padding,
+            coarse_ravl_add_new(arena->all_blocks, curr->data + padding,
                                 curr->size - padding, NULL);
         if (aligned_block == NULL) {
             return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
@@ -723,7 +1105,7 @@ static umf_result_t create_aligned_block(coarse_t *coarse, size_t orig_size,
         curr->used = false;
         curr->size = padding;
 
-        rv = free_blocks_add(coarse->free_blocks, curr);
+        rv = coarse_free_blocks_add(arena, curr);
         if (rv) {
             return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
         }
@@ -737,12 +1119,12 @@ static umf_result_t create_aligned_block(coarse_t *coarse, size_t orig_size,
 }
 
 // Split the current block and put the new block after the one that we use.
-static umf_result_t split_current_block(coarse_t *coarse, block_t *curr,
+static umf_result_t split_current_block(coarse_arena_t *arena, block_t *curr,
                                         size_t size) {
 
     // check if block can be split by the upstream provider
     umf_result_t umf_result =
-        can_provider_split(coarse, curr->data, curr->size, size);
+        can_provider_split(arena, curr->data, curr->size, size);
     if (umf_result != UMF_RESULT_SUCCESS) {
         return umf_result;
     }
@@ -750,14 +1132,14 @@ static umf_result_t split_current_block(coarse_t *coarse, block_t *curr,
     ravl_node_t *new_node = NULL;
 
     block_t *new_block = coarse_ravl_add_new(
-        coarse->all_blocks, curr->data + size, curr->size - size, &new_node);
+        arena->all_blocks, curr->data + size, curr->size - size, &new_node);
     if (new_block == NULL) {
         return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
     }
 
     new_block->used = false;
 
-    int rv = free_blocks_add(coarse->free_blocks, get_node_block(new_node));
+    int rv = coarse_free_blocks_add(arena, get_node_block(new_node));
     if (rv) {
         return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
     }
@@ -765,13 +1147,13 @@ static umf_result_t split_current_block(coarse_t *coarse, block_t *curr,
     return UMF_RESULT_SUCCESS;
 }
 
-static block_t *find_free_block(struct ravl *free_blocks, size_t size,
-                                size_t alignment,
-                                coarse_strategy_t allocation_strategy) {
+static block_t *find_free_block(coarse_arena_t *arena, size_t size,
+                                size_t alignment) {
+    struct ravl *free_blocks = arena->free_blocks;
     block_t *block;
     size_t new_size = size + alignment;
 
-    switch (allocation_strategy) {
+    switch (arena->coarse->allocation_strategy) {
     case UMF_COARSE_MEMORY_STRATEGY_FASTEST:
         // Always allocate a free block of the (size + alignment) size
         // and later cut out the properly aligned part leaving two remaining parts.
@@ -818,22 +1200,52 @@ static block_t *find_free_block(struct ravl *free_blocks, size_t size,
         // use the `UMF_COARSE_MEMORY_STRATEGY_FASTEST` strategy.
         return free_blocks_rm_ge(free_blocks, new_size, 0,
                                  CHECK_ONLY_THE_FIRST_BLOCK);
+
+    case UMF_COARSE_MEMORY_STRATEGY_SEGREGATED_FIT:
+        // First check if the first block of a size class guaranteeing
+        // the 'size' size can hold the aligned data.
+        block = seg_rm_good_fit(arena->seg_index, size, alignment);
+        if (block) {
+            return block;
+        }
+
+        if (new_size < size) {
+            LOG_ERR("arithmetic overflow (size + alignment)");
+            return NULL;
+        }
+
+        // If not, any block guaranteeing the (size + alignment) size will do.
+        block = seg_rm_good_fit(arena->seg_index, new_size, 0);
+        if (block) {
+            return block;
+        }
+
+        // Finally look through the blocks of the size class of 'size',
+        // which can be still big enough.
+        return seg_rm_first_fit(arena->seg_index, size, alignment);
+
+    case UMF_COARSE_MEMORY_STRATEGY_BEST_FIT:
+        return free_blocks_rm_best_fit(free_blocks, size, alignment);
+
+    case UMF_COARSE_MEMORY_STRATEGY_LOWEST_ADDRESS:
+        return free_by_addr_rm_first_fit(arena->free_by_addr, size,
+                                         alignment);
     }
 
     return NULL;
 }
 
-static int free_blocks_re_add(coarse_t *coarse, block_t *block) {
-    assert(coarse);
+static int free_blocks_re_add(coarse_arena_t *arena, block_t *block) {
+    assert(arena);
 
-    ravl_node_t *node = coarse_ravl_find_node(coarse->all_blocks, block->data);
+    ravl_node_t *node = coarse_ravl_find_node(arena->all_blocks, block->data);
     assert(node);
 
     // merge with prev and/or next block if they are unused and have continuous data
-    node = free_block_merge_with_prev(coarse, node);
-    node = free_block_merge_with_next(coarse, node);
+    node = free_block_merge_with_prev(arena, node);
+    node = free_block_merge_with_next(arena, node);
 
-    return free_blocks_add(coarse->free_blocks, get_node_block(node));
+    return coarse_free_blocks_add(arena, get_node_block(node));
 }
 
 static void ravl_cb_count(void *data, void *arg) {
@@ -844,6 +1256,26 @@ static void ravl_cb_count(void *data, void *arg) {
     (*num_all_blocks)++;
 }
 
+typedef struct count_all_blocks_args_t {
+    size_t num_all_blocks;
+    size_t max_free_block_size;
+} count_all_blocks_args_t;
+
+static void ravl_cb_count_all(void *data, void *arg) {
+    assert(data);
+    assert(arg);
+
+    ravl_data_t *node_data = data;
+    block_t *block = node_data->value;
+    assert(block);
+
+    count_all_blocks_args_t *args = arg;
+    args->num_all_blocks++;
+    if (!block->used && block->size > args->max_free_block_size) {
+        args->max_free_block_size = block->size;
+    }
+}
+
 static void ravl_cb_count_free(void *data, void *arg) {
     assert(data);
     assert(arg);
@@ -862,234 +1294,725 @@ static void ravl_cb_count_free(void *data, void *arg) {
     }
 }
 
-static umf_result_t coarse_get_stats_no_lock(coarse_t *coarse,
+static umf_result_t arena_get_stats_no_lock(coarse_arena_t *arena,
                                              coarse_stats_t *stats) {
-    assert(coarse);
+    assert(arena);
 
-    size_t num_all_blocks = 0;
-    ravl_foreach(coarse->all_blocks, ravl_cb_count, &num_all_blocks);
+    count_all_blocks_args_t all_args = {0, 0};
+    ravl_foreach(arena->all_blocks, ravl_cb_count_all, &all_args);
 
     size_t num_free_blocks = 0;
-    ravl_foreach(coarse->free_blocks, ravl_cb_count_free, &num_free_blocks);
+    if (arena->seg_index) {
+        num_free_blocks = seg_count(arena->seg_index);
+    } else if (arena->free_by_addr) {
+        ravl_foreach(arena->free_by_addr, ravl_cb_count, &num_free_blocks);
+    } else {
+        ravl_foreach(arena->free_blocks, ravl_cb_count_free, &num_free_blocks);
+    }
 
-    stats->alloc_size = coarse->alloc_size;
-    stats->used_size = coarse->used_size;
-    stats->num_all_blocks = num_all_blocks;
+    stats->alloc_size = arena->alloc_size;
+    stats->used_size = arena->used_size;
+    stats->num_all_blocks = all_args.num_all_blocks;
     stats->num_free_blocks = num_free_blocks;
+    stats->max_free_block_size = all_args.max_free_block_size;
 
     return UMF_RESULT_SUCCESS;
 }
 
-// PUBLIC API
-
-umf_result_t coarse_new(coarse_params_t *coarse_params, coarse_t **pcoarse) {
-#ifdef _WIN32
-    utils_init_once(&Log_initialized, utils_log_init);
-#endif /* _WIN32 */
+// The functions "defrag_*" collect the defragmentation report of an arena:
+// the histogram of sizes of free blocks and the compaction hints.
 
-    if (coarse_params == NULL || pcoarse == NULL) {
-        LOG_ERR("coarse parameters or handle is missing");
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
-    }
+typedef struct defrag_histogram_args_t {
+    size_t *histogram;
+    size_t num_bins;
+} defrag_histogram_args_t;
 
-    if (!coarse_params->provider) {
-        LOG_ERR("memory provider is not set");
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
-    }
+static void ravl_cb_defrag_histogram(void *data, void *arg) {
+    assert(data);
+    assert(arg);
 
-    if (!coarse_params->page_size) {
-        LOG_ERR("page size of the memory provider is not set");
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
-    }
+    ravl_data_t *node_data = data;
+    block_t *block = node_data->value;
+    assert(block);
+    assert(block->size);
 
-    if (!coarse_params->cb.split) {
-        LOG_ERR("coarse split callback is not set");
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    if (block->used) {
+        return;
     }
 
-    if (!coarse_params->cb.merge) {
-        LOG_ERR("coarse merge callback is not set");
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    defrag_histogram_args_t *args = arg;
+    size_t bin = utils_msb64(block->size);
+    if (bin >= args->num_bins) {
+        bin = args->num_bins - 1;
     }
 
-    // alloc() and free() callbacks are optional
-
-    coarse_t *coarse = umf_ba_global_alloc(sizeof(*coarse));
-    if (!coarse) {
-        LOG_ERR("out of the host memory");
-        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
-    }
+    args->histogram[bin]++;
+}
 
-    memset(coarse, 0, sizeof(*coarse));
+typedef struct defrag_hints_args_t {
+    // array of hints sorted from the best one
+    umf_compaction_hint_t *hints;
+    size_t max_hints;
+    size_t num_hints;
+
+    // the previously visited block (the blocks are visited in address order)
+    block_t *prev;
+    // size of the free block contiguous with and right before 'prev'
+    // (0 if there is no such block)
+    size_t prev_free_size;
+} defrag_hints_args_t;
+
+static inline bool blocks_contiguous(block_t *low, block_t *high) {
+    return (low->data + low->size == high->data);
+}
 
-    coarse->provider = coarse_params->provider;
-    coarse->page_size = coarse_params->page_size;
-    coarse->cb = coarse_params->cb;
-    coarse->allocation_strategy = coarse_params->allocation_strategy;
+// defrag_hints_insert - insert the hint of the given used block into
+// the array of hints sorted by the coalesced size (descending), and then
+// by the size of the block (ascending), so the first hints free up the most
+// memory by relocating the least of data. Only the best hints are kept.
+static void defrag_hints_insert(defrag_hints_args_t *args, block_t *block,
+                                size_t coalesced_size) {
+    umf_compaction_hint_t *hints = args->hints;
+    size_t i = args->num_hints;
 
-    umf_result_t umf_result = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    while (i > 0 && (hints[i - 1].coalesced_size < coalesced_size ||
+                     (hints[i - 1].coalesced_size == coalesced_size &&
+                      hints[i - 1].size > block->size))) {
+        i--;
+    }
 
-    coarse->free_blocks = ravl_new_sized(coarse_ravl_comp, sizeof(ravl_data_t));
-    if (coarse->free_blocks == NULL) {
-        LOG_ERR("out of the host memory");
-        goto err_free_coarse;
+    if (i == args->max_hints) {
+        return;
     }
 
-    coarse->all_blocks = ravl_new_sized(coarse_ravl_comp, sizeof(ravl_data_t));
-    if (coarse->all_blocks == NULL) {
-        LOG_ERR("out of the host memory");
-        goto err_delete_ravl_free_blocks;
+    if (args->num_hints < args->max_hints) {
+        args->num_hints++;
     }
 
-    coarse->alloc_size = 0;
-    coarse->used_size = 0;
+    memmove(&hints[i + 1], &hints[i],
+            (args->num_hints - 1 - i) * sizeof(*hints));
 
-    umf_result = UMF_RESULT_ERROR_UNKNOWN;
+    hints[i].ptr = block->data;
+    hints[i].size = block->size;
+    hints[i].coalesced_size = coalesced_size;
+}
 
-    if (utils_mutex_init(&coarse->lock) == NULL) {
-        LOG_ERR("lock initialization failed");
-        goto err_delete_ravl_all_blocks;
-    }
+// defrag_hints_visit - visit the next block (NULL after the last one)
+// and add the hint of the previous block if it is a used block contiguous
+// with at least one free block.
+static void defrag_hints_visit(defrag_hints_args_t *args, block_t *next) {
+    block_t *prev = args->prev;
+    bool contiguous = prev && next && blocks_contiguous(prev, next);
+
+    if (prev && prev->used) {
+        size_t free_size = args->prev_free_size;
+        if (contiguous && !next->used) {
+            free_size += next->size;
+        }
 
-    assert(coarse->used_size == 0);
-    assert(coarse->alloc_size == 0);
-    assert(debug_check(coarse));
+        if (free_size) {
+            defrag_hints_insert(args, prev, prev->size + free_size);
+        }
+    }
 
-    *pcoarse = coarse;
+    args->prev_free_size = (contiguous && !prev->used) ? prev->size : 0;
+    args->prev = next;
+}
 
-    return UMF_RESULT_SUCCESS;
+static void ravl_cb_defrag_hints(void *data, void *arg) {
+    assert(data);
+    assert(arg);
 
-err_delete_ravl_all_blocks:
-    ravl_delete(coarse->all_blocks);
-err_delete_ravl_free_blocks:
-    ravl_delete(coarse->free_blocks);
-err_free_coarse:
-    umf_ba_global_free(coarse);
-    return umf_result;
+    ravl_data_t *node_data = data;
+    block_t *block = node_data->value;
+    assert(block);
+
+    defrag_hints_visit(arg, block);
 }
 
-void coarse_delete(coarse_t *coarse) {
-    if (coarse == NULL) {
-        LOG_ERR("coarse handle is missing");
-        return;
+// The functions "ranges_*" handle the coarse->ranges tree of memory ranges
+// owned by arenas. Adjacent ranges of the same arena are always coalesced,
+// so every block (also a merged one) lies within a single range.
+//
+// The compare function of the coarse->ranges tree
+static int coarse_range_comp(const void *lhs, const void *rhs) {
+    const coarse_range_t *lhs_range = (const coarse_range_t *)lhs;
+    const coarse_range_t *rhs_range = (const coarse_range_t *)rhs;
+
+    if (lhs_range->start < rhs_range->start) {
+        return -1;
     }
 
-    utils_mutex_destroy_not_free(&coarse->lock);
+    if (lhs_range->start > rhs_range->start) {
+        return 1;
+    }
 
-    ravl_foreach(coarse->all_blocks, coarse_ravl_cb_rm_all_blocks_node, coarse);
-    assert(coarse->used_size == 0);
-    assert(coarse->alloc_size == 0);
+    return 0;
+}
 
-    ravl_delete(coarse->all_blocks);
-    ravl_delete(coarse->free_blocks);
+// ranges_find_node - find the node of the range containing the given address
+static ravl_node_t *ranges_find_node(struct ravl *ranges, uintptr_t addr) {
+    coarse_range_t data = {addr, 0, NULL, NULL};
+    ravl_node_t *node = ravl_find(ranges, &data, RAVL_PREDICATE_LESS_EQUAL);
+    if (!node) {
+        return NULL;
+    }
 
-    umf_ba_global_free(coarse);
+    coarse_range_t *range = ravl_data(node);
+    if (addr - range->start >= range->size) {
+        return NULL;
+    }
+
+    return node;
 }
 
-umf_result_t coarse_add_memory_from_provider(coarse_t *coarse, size_t size) {
-    umf_result_t umf_result;
-    void *ptr = NULL;
+// ranges_coalesce - coalesce the range of the given node with its neighbours
+// if they belong to the same arena and have the same home arena
+static void ranges_coalesce(struct ravl *ranges, ravl_node_t *node) {
+    coarse_range_t *range = ravl_data(node);
+
+    ravl_node_t *next = ravl_node_successor(node);
+    if (next) {
+        coarse_range_t *next_range = ravl_data(next);
+        if (next_range->arena == range->arena &&
+            next_range->home == range->home &&
+            range->start + range->size == next_range->start) {
+            range->size += next_range->size;
+            ravl_remove(ranges, next);
+        }
+    }
 
-    if (coarse == NULL || size == 0) {
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    ravl_node_t *prev = ravl_node_predecessor(node);
+    if (prev) {
+        coarse_range_t *prev_range = ravl_data(prev);
+        if (prev_range->arena == range->arena &&
+            prev_range->home == range->home &&
+            prev_range->start + prev_range->size == range->start) {
+            prev_range->size += range->size;
+            ravl_remove(ranges, node);
+        }
     }
+}
 
-    if (!coarse->cb.alloc) {
-        LOG_ERR("error: alloc callback is not set");
-        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+// ranges_set - make the given arena the owner of the given memory range.
+// The range has to be either a new memory (the arena becomes its home)
+// or a part of a single range of another arena (a stolen block or a block
+// given back to its home arena).
+static int ranges_set(struct ravl *ranges, uintptr_t start, size_t size,
+                      coarse_arena_t *arena) {
+    coarse_range_t new_range = {start, size, arena, arena};
+    ravl_node_t *node = ranges_find_node(ranges, start);
+    if (!node) {
+        // new memory
+        if (ravl_emplace_copy(ranges, &new_range)) {
+            return -1;
+        }
+
+        node = ravl_find(ranges, &new_range, RAVL_PREDICATE_EQUAL);
+        assert(node);
+        ranges_coalesce(ranges, node);
+        return 0;
+    }
+
+    coarse_range_t *old_range = ravl_data(node);
+    uintptr_t old_end = old_range->start + old_range->size;
+    assert(start + size <= old_end);
+    new_range.home = old_range->home;
+
+    // the part of the old range after the given range
+    coarse_range_t right = {start + size, old_end - (start + size),
+                            old_range->arena, old_range->home};
+    if (right.size && ravl_emplace_copy(ranges, &right)) {
+        return -1;
+    }
+
+    // ravl_emplace_copy() could have moved the data of nodes
+    node = ranges_find_node(ranges, start);
+    assert(node);
+    old_range = ravl_data(node);
+
+    if (old_range->start == start) {
+        // no part of the old range before the given range - reuse the node
+        old_range->size = size;
+        old_range->arena = arena;
+    } else {
+        if (ravl_emplace_copy(ranges, &new_range)) {
+            if (right.size) {
+                ravl_remove(ranges, ravl_find(ranges, &right,
+                                              RAVL_PREDICATE_EQUAL));
+            }
+            return -1;
+        }
+
+        node = ravl_find(ranges, &new_range, RAVL_PREDICATE_EQUAL);
+        assert(node);
+
+        // trim the old range
+        old_range = ravl_data(ravl_node_predecessor(node));
+        old_range->size = start - old_range->start;
+    }
+
+    ranges_coalesce(ranges, node);
+    return 0;
+}
+
+// coarse_ranges_set - make the given arena the owner of the given memory
+// (only if there is more than one arena)
+static int coarse_ranges_set(coarse_t *coarse, void *addr, size_t size,
+                             coarse_arena_t *arena) {
+    if (coarse->num_arenas == 1) {
+        return 0;
+    }
+
+    if (utils_write_lock(&coarse->ranges_lock) != 0) {
+        LOG_ERR("locking the ranges lock failed");
+        return -1;
+    }
+
+    int ret = ranges_set(coarse->ranges, (uintptr_t)addr, size, arena);
+
+    utils_write_unlock(&coarse->ranges_lock);
+
+    return ret;
+}
+
+// coarse_ranges_same - check if the given addresses belong to the same range
+// (always true if there is only one arena)
+static bool coarse_ranges_same(coarse_t *coarse, void *ptr1, void *ptr2) {
+    if (coarse->num_arenas == 1) {
+        return true;
+    }
+
+    if (utils_read_lock(&coarse->ranges_lock) != 0) {
+        LOG_ERR("locking the ranges lock failed");
+        return false;
+    }
+
+    ravl_node_t *node = ranges_find_node(coarse->ranges, (uintptr_t)ptr1);
+    bool same =
+        node && node == ranges_find_node(coarse->ranges, (uintptr_t)ptr2);
+
+    utils_read_unlock(&coarse->ranges_lock);
+
+    return same;
+}
+
+// coarse_ranges_get_home - get the home arena of the memory of the given
+// free block of the given arena, if it was stolen from it,
+// NULL if the memory is not stolen or the ranges cannot be read.
+// If 'whole' is true, the block has to cover the whole stolen range.
+static coarse_arena_t *coarse_ranges_get_home(coarse_arena_t *arena,
+                                              block_t *block, bool whole) {
+    coarse_t *coarse = arena->coarse;
+    if (coarse->num_arenas == 1) {
+        return NULL;
+    }
+
+    if (utils_read_lock(&coarse->ranges_lock) != 0) {
+        LOG_ERR("locking the ranges lock failed");
+        return NULL;
+    }
+
+    coarse_arena_t *home = NULL;
+    ravl_node_t *node =
+        ranges_find_node(coarse->ranges, (uintptr_t)block->data);
+    if (node) {
+        coarse_range_t *range = ravl_data(node);
+        assert(range->arena == arena);
+        if (range->home != arena &&
+            (!whole || (range->start == (uintptr_t)block->data &&
+                        range->size == block->size))) {
+            home = range->home;
+        }
+    }
+
+    utils_read_unlock(&coarse->ranges_lock);
+
+    return home;
+}
+
+// Index of the arena of the calling thread, 0 if not assigned yet.
+// It is shared by all coarse instances: a thread uses the arena
+// of the same index (modulo the number of arenas) in each of them.
+static __TLS size_t arena_thread_idx = 0;
+static size_t arena_thread_next = 0;
+
+// arena_of_thread - get the arena of the calling thread
+static coarse_arena_t *arena_of_thread(coarse_t *coarse) {
+    if (coarse->num_arenas == 1) {
+        return coarse->arenas[0];
+    }
+
+    size_t idx = arena_thread_idx;
+    if (idx == 0) {
+        // assign arenas to threads round-robin
+        idx = utils_atomic_increment_size_t(&arena_thread_next);
+        arena_thread_idx = idx;
+    }
+
+    return coarse->arenas[(idx - 1) % coarse->num_arenas];
+}
+
+// arena_of_ptr - get the arena owning the given memory,
+// NULL if the memory does not belong to any arena
+static coarse_arena_t *arena_of_ptr(coarse_t *coarse, void *ptr) {
+    if (coarse->num_arenas == 1) {
+        return coarse->arenas[0];
+    }
+
+    if (utils_read_lock(&coarse->ranges_lock) != 0) {
+        LOG_ERR("locking the ranges lock failed");
+        return NULL;
+    }
+
+    coarse_arena_t *arena = NULL;
+    ravl_node_t *node = ranges_find_node(coarse->ranges, (uintptr_t)ptr);
+    if (node) {
+        arena = ((coarse_range_t *)ravl_data(node))->arena;
+    }
+
+    utils_read_unlock(&coarse->ranges_lock);
+
+    return arena;
+}
+
+// arena_rm_free_block - remove the given free block (not present
+// in the structure of free blocks) from the arena and make the 'dst' arena
+// the owner of its memory
+static umf_result_t arena_rm_free_block(coarse_arena_t *arena, block_t *block,
+                                        coarse_arena_t *dst) {
+    unsigned char *data = block->data;
+    size_t size = block->size;
+
+    if (coarse_ranges_set(arena->coarse, data, size, dst)) {
+        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    block_t *block_rm = coarse_ravl_rm(arena->all_blocks, data);
+    assert(block_rm == block);
+    (void)block_rm; // WA for unused variable error
+    umf_ba_global_free(block);
+
+    assert(arena->alloc_size >= size);
+    arena->alloc_size -= size;
+
+    return UMF_RESULT_SUCCESS;
+}
+
+// arena_add_free_memory_no_lock - add the given free memory removed
+// from another arena to the given arena and merge it with its neighbours
+static umf_result_t arena_add_free_memory_no_lock(coarse_arena_t *arena,
+                                                  unsigned char *data,
+                                                  size_t size) {
+    block_t *new_block = NULL;
+    umf_result_t umf_result =
+        coarse_add_free_block(arena, data, size, &new_block);
+    if (umf_result == UMF_RESULT_SUCCESS &&
+        free_blocks_re_add(arena, new_block)) {
+        umf_result = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
     }
 
-    umf_result = coarse_alloc(coarse, size, coarse->page_size, &ptr);
     if (umf_result != UMF_RESULT_SUCCESS) {
-        return umf_result;
+        LOG_ERR("failed to add a free block (addr: %p, size: %zu) "
+                "taken from another arena, the memory was leaked",
+                (void *)data, size);
     }
 
-    assert(ptr);
+    return umf_result;
+}
 
-    return coarse_free(coarse, ptr, size);
+static umf_result_t arena_add_free_memory(coarse_arena_t *arena,
+                                          unsigned char *data, size_t size) {
+    if (utils_mutex_lock(&arena->lock) != 0) {
+        LOG_ERR("locking the lock failed");
+        return UMF_RESULT_ERROR_UNKNOWN;
+    }
+
+    umf_result_t umf_result = arena_add_free_memory_no_lock(arena, data, size);
+
+    assert(debug_check(arena));
+    utils_mutex_unlock(&arena->lock);
+
+    return umf_result;
 }
 
-umf_result_t coarse_add_memory_fixed(coarse_t *coarse, void *addr,
-                                     size_t size) {
-    umf_result_t umf_result;
+// coarse_merge_arenas - give all free blocks of stolen memory back to their
+// home arenas, where they can be merged with their neighbours.
+// It is the last resort when no arena has a free block big enough,
+// so it locks all arenas (in the order of their indexes).
+static void coarse_merge_arenas(coarse_t *coarse) {
+    size_t nlocked;
+    for (nlocked = 0; nlocked < coarse->num_arenas; nlocked++) {
+        if (utils_mutex_lock(&coarse->arenas[nlocked]->lock) != 0) {
+            LOG_ERR("locking the lock failed");
+            goto unlock;
+        }
+    }
 
-    if (coarse == NULL || addr == NULL || size == 0) {
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    size_t moved = 0;
+    for (size_t i = 0; i < coarse->num_arenas; i++) {
+        coarse_arena_t *arena = coarse->arenas[i];
+        ravl_node_t *node = ravl_first(arena->all_blocks);
+        while (node) {
+            block_t *block = get_node_block(node);
+            ravl_node_t *node_next = get_node_next(node);
+            unsigned char *data_next =
+                node_next ? get_node_block(node_next)->data : NULL;
+
+            coarse_arena_t *home = NULL;
+            if (!block->used) {
+                home = coarse_ranges_get_home(arena, block, false);
+            }
+
+            if (home) {
+                unsigned char *data = block->data;
+                size_t size = block->size;
+                if (block->free_list_ptr) {
+                    coarse_free_blocks_rm(arena, block->free_list_ptr);
+                    block->free_list_ptr = NULL;
+                }
+
+                if (arena_rm_free_block(arena, block, home) ==
+                    UMF_RESULT_SUCCESS) {
+                    (void)arena_add_free_memory_no_lock(home, data, size);
+                    moved++;
+                } else {
+                    (void)coarse_free_blocks_add(arena, block);
+                }
+            }
+
+            // removing a node can move the data of other nodes
+            node = data_next ? coarse_ravl_find_node(arena->all_blocks,
+                                                     data_next)
+                             : NULL;
+        }
     }
 
-    if (coarse->cb.alloc || coarse->cb.free) {
-        LOG_ERR("error: alloc or free callback is set");
-        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    LOG_DEBUG("coarse_MERGE_ARENAS moved %zu free blocks", moved);
+
+    for (size_t i = 0; i < coarse->num_arenas; i++) {
+        assert(debug_check(coarse->arenas[i]));
+    }
+
+unlock:
+    while (nlocked > 0) {
+        utils_mutex_unlock(&coarse->arenas[--nlocked]->lock);
     }
+}
+
+// arena_steal_from - steal a free block big enough to allocate 'size' bytes
+// aligned to 'alignment' from the victim arena and add it to the thief arena.
+// A thief takes 1/num_arenas of the found block (but not less than needed),
+// so that the memory gets partitioned between arenas after a few steals.
+static umf_result_t arena_steal_from(coarse_arena_t *victim,
+                                     coarse_arena_t *thief, size_t size,
+                                     size_t alignment) {
+    coarse_t *coarse = victim->coarse;
 
-    if (utils_mutex_lock(&coarse->lock) != 0) {
+    if (utils_mutex_lock(&victim->lock) != 0) {
         LOG_ERR("locking the lock failed");
         return UMF_RESULT_ERROR_UNKNOWN;
     }
 
-    assert(debug_check(coarse));
+    assert(debug_check(victim));
 
-    umf_result = coarse_add_used_block(coarse, addr, size);
+    block_t *block = find_free_block(victim, size, alignment);
+    if (block == NULL) {
+        utils_mutex_unlock(&victim->lock);
+        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    }
 
-    assert(debug_check(coarse));
-    utils_mutex_unlock(&coarse->lock);
+    // the aligned data has to fit in the stolen part of the block
+    uintptr_t data_aligned = ALIGN_UP((uintptr_t)block->data, alignment);
+    size_t needed = ALIGN_UP_SAFE(data_aligned - (uintptr_t)block->data + size,
+                                  coarse->page_size);
+    if (needed == 0 || needed > block->size) {
+        needed = block->size;
+    }
 
-    if (umf_result != UMF_RESULT_SUCCESS) {
-        return umf_result;
+    // leave room for the strategies looking for a block
+    // of the (size + alignment) size, if the block is big enough
+    if (block->size - needed >= alignment) {
+        needed += alignment;
     }
 
-    umf_result = coarse_free(coarse, addr, size);
+    size_t steal_size =
+        ALIGN_DOWN(block->size / coarse->num_arenas, coarse->page_size);
+    if (steal_size < needed) {
+        steal_size = needed;
+    }
+
+    umf_result_t umf_result;
+    if (steal_size < block->size) {
+        umf_result = split_current_block(victim, block, steal_size);
+        if (umf_result != UMF_RESULT_SUCCESS) {
+            (void)free_blocks_re_add(victim, block);
+            goto err_unlock;
+        }
+
+        block->size = steal_size;
+    }
+
+    steal_size = block->size;
+    unsigned char *data = block->data;
+
+    umf_result = arena_rm_free_block(victim, block, thief);
     if (umf_result != UMF_RESULT_SUCCESS) {
-        return umf_result;
+        (void)free_blocks_re_add(victim, block);
+        goto err_unlock;
     }
 
-    LOG_DEBUG("coarse_ALLOC (add_memory_block) %zu used %zu alloc %zu", size,
-              coarse->used_size, coarse->alloc_size);
+    assert(debug_check(victim));
+    utils_mutex_unlock(&victim->lock);
 
-    return UMF_RESULT_SUCCESS;
+    LOG_DEBUG("coarse_STEAL %zu bytes from arena %p to arena %p", steal_size,
+              (void *)victim, (void *)thief);
+
+    return arena_add_free_memory(thief, data, steal_size);
+
+err_unlock:
+    assert(debug_check(victim));
+    utils_mutex_unlock(&victim->lock);
+
+    return umf_result;
 }
 
-umf_result_t coarse_alloc(coarse_t *coarse, size_t size, size_t alignment,
-                          void **resultPtr) {
-    umf_result_t umf_result = UMF_RESULT_ERROR_UNKNOWN;
+// arena_steal - steal a free block big enough to allocate 'size' bytes
+// aligned to 'alignment' from any other arena
+static umf_result_t arena_steal(coarse_t *coarse, coarse_arena_t *thief,
+                                size_t size, size_t alignment) {
+    size_t thief_idx = 0;
+    while (coarse->arenas[thief_idx] != thief) {
+        thief_idx++;
+    }
 
-    if (coarse == NULL || resultPtr == NULL) {
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    for (size_t i = 1; i < coarse->num_arenas; i++) {
+        coarse_arena_t *victim =
+            coarse->arenas[(thief_idx + i) % coarse->num_arenas];
+        umf_result_t umf_result =
+            arena_steal_from(victim, thief, size, alignment);
+        if (umf_result != UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY) {
+            return umf_result;
+        }
     }
 
-    // alignment must be a power of two and a multiple or a divider of the page size
-    if (alignment == 0) {
-        alignment = coarse->page_size;
-    } else if ((alignment & (alignment - 1)) ||
-               ((alignment % coarse->page_size) &&
-                (coarse->page_size % alignment))) {
-        LOG_ERR("wrong alignment: %zu (not a power of 2 or a multiple or a "
-                "divider of the page size (%zu))",
-                alignment, coarse->page_size);
-        return UMF_RESULT_ERROR_INVALID_ALIGNMENT;
-    } else if (IS_NOT_ALIGNED(alignment, coarse->page_size)) {
-        alignment = ALIGN_UP_SAFE(alignment, coarse->page_size);
+    return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+}
+
+static coarse_arena_t *arena_new(coarse_t *coarse) {
+    coarse_arena_t *arena = umf_ba_global_alloc(sizeof(*arena));
+    if (!arena) {
+        LOG_ERR("out of the host memory");
+        return NULL;
+    }
+
+    memset(arena, 0, sizeof(*arena));
+    arena->coarse = coarse;
+
+    if (coarse->allocation_strategy ==
+        UMF_COARSE_MEMORY_STRATEGY_SEGREGATED_FIT) {
+        arena->seg_index = umf_ba_global_alloc(sizeof(*arena->seg_index));
+        if (arena->seg_index == NULL) {
+            LOG_ERR("out of the host memory");
+            goto err_free_arena;
+        }
+
+        memset(arena->seg_index, 0, sizeof(*arena->seg_index));
+    } else if (coarse->allocation_strategy ==
+               UMF_COARSE_MEMORY_STRATEGY_LOWEST_ADDRESS) {
+        arena->free_by_addr =
+            ravl_new_sized(coarse_ravl_comp, sizeof(ravl_data_t));
+        if (arena->free_by_addr == NULL) {
+            LOG_ERR("out of the host memory");
+            goto err_free_arena;
+        }
+    } else {
+        arena->free_blocks =
+            ravl_new_sized(coarse_ravl_comp, sizeof(ravl_data_t));
+        if (arena->free_blocks == NULL) {
+            LOG_ERR("out of the host memory");
+            goto err_free_arena;
+        }
+    }
+
+    arena->all_blocks = ravl_new_sized(coarse_ravl_comp, sizeof(ravl_data_t));
+    if (arena->all_blocks == NULL) {
+        LOG_ERR("out of the host memory");
+        goto err_delete_ravl_free_blocks;
+    }
+
+    arena->alloc_size = 0;
+    arena->used_size = 0;
+
+    if (utils_mutex_init(&arena->lock) == NULL) {
+        LOG_ERR("lock initialization failed");
+        goto err_delete_ravl_all_blocks;
     }
 
-    if (utils_mutex_lock(&coarse->lock) != 0) {
+    assert(arena->used_size == 0);
+    assert(arena->alloc_size == 0);
+    assert(debug_check(arena));
+
+    return arena;
+
+err_delete_ravl_all_blocks:
+    ravl_delete(arena->all_blocks);
+err_delete_ravl_free_blocks:
+    if (arena->free_blocks) {
+        ravl_delete(arena->free_blocks);
+    }
+    if (arena->free_by_addr) {
+        ravl_delete(arena->free_by_addr);
+    }
+    umf_ba_global_free(arena->seg_index);
+err_free_arena:
+    umf_ba_global_free(arena);
+    return NULL;
+}
+
+static void arena_delete(coarse_arena_t *arena) {
+    utils_mutex_destroy_not_free(&arena->lock);
+
+    ravl_foreach(arena->all_blocks, coarse_ravl_cb_rm_all_blocks_node, arena);
+    assert(arena->used_size == 0);
+    assert(arena->alloc_size == 0);
+
+    ravl_delete(arena->all_blocks);
+    if (arena->free_blocks) {
+        ravl_delete(arena->free_blocks);
+    }
+    if (arena->free_by_addr) {
+        ravl_delete(arena->free_by_addr);
+    }
+    umf_ba_global_free(arena->seg_index);
+
+    umf_ba_global_free(arena);
+}
+
+// arena_alloc - allocate memory from the given arena, getting more memory
+// from the memory provider if needed (and if possible)
+static umf_result_t arena_alloc(coarse_arena_t *arena, size_t size,
+                                size_t alignment, void **resultPtr) {
+    coarse_t *coarse = arena->coarse;
+    umf_result_t umf_result = UMF_RESULT_ERROR_UNKNOWN;
+
+    if (utils_mutex_lock(&arena->lock) != 0) {
         LOG_ERR("locking the lock failed");
         return UMF_RESULT_ERROR_UNKNOWN;
     }
 
-    assert(debug_check(coarse));
+    assert(debug_check(arena));
 
     *resultPtr = NULL;
 
     // Find a block with greater or equal size using the given memory allocation strategy
-    block_t *curr = find_free_block(coarse->free_blocks, size, alignment,
-                                    coarse->allocation_strategy);
+    block_t *curr = find_free_block(arena, size, alignment);
     if (curr == NULL) {
         // no suitable block found - try to get more memory from the upstream provider
         umf_result = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
 
         if (!coarse->cb.alloc) {
-            LOG_ERR("out of memory (the memory provider does not support "
-                    "allocating more memory)");
+            // the memory provider does not support allocating more memory
             goto err_unlock;
         }
 
@@ -1111,8 +2034,18 @@ umf_result_t coarse_alloc(coarse_t *coarse, size_t size, size_t alignment,
         ASSERT_IS_ALIGNED(((uintptr_t)(*resultPtr)), alignment);
 
         block_t *new_free_block = NULL;
-        umf_result = coarse_add_free_block(coarse, *resultPtr, size_aligned,
+        umf_result = coarse_add_free_block(arena, *resultPtr, size_aligned,
                                            &new_free_block);
+        if (umf_result == UMF_RESULT_SUCCESS &&
+            coarse_ranges_set(coarse, *resultPtr, size_aligned, arena)) {
+            block_t *block_rm = coarse_ravl_rm(arena->all_blocks, *resultPtr);
+            assert(block_rm == new_free_block);
+            (void)block_rm; // WA for unused variable error
+            umf_ba_global_free(new_free_block);
+            arena->alloc_size -= size_aligned;
+            umf_result = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+        }
+
         if (umf_result != UMF_RESULT_SUCCESS) {
             LOG_ERR("failed to add a newly allocated block from the memory "
                     "provider");
@@ -1124,11 +2057,12 @@ umf_result_t coarse_alloc(coarse_t *coarse, size_t size, size_t alignment,
                          "address %p, size %zu",
                          *resultPtr, size_aligned);
             }
+            *resultPtr = NULL;
             goto err_unlock;
         }
 
         LOG_DEBUG("coarse_ALLOC (memory_provider) %zu used %zu alloc %zu",
-                  size_aligned, coarse->used_size, coarse->alloc_size);
+                  size_aligned, arena->used_size, arena->alloc_size);
 
         curr = new_free_block;
     }
@@ -1152,40 +2086,289 @@ umf_result_t coarse_alloc(coarse_t *coarse, size_t size, size_t alignment,
 
     // In case of non-zero alignment create an aligned block what would be further used.
     if (alignment > 0) {
-        umf_result = create_aligned_block(coarse, size, alignment, &curr);
+        umf_result = create_aligned_block(arena, size, alignment, &curr);
         if (umf_result != UMF_RESULT_SUCCESS) {
-            (void)free_blocks_re_add(coarse, curr);
+            (void)free_blocks_re_add(arena, curr);
             goto err_unlock;
         }
     }
 
     if (action == ACTION_SPLIT) {
         // Split the current block and put the new block after the one that we use.
-        umf_result = split_current_block(coarse, curr, size);
+        umf_result = split_current_block(arena, curr, size);
         if (umf_result != UMF_RESULT_SUCCESS) {
-            (void)free_blocks_re_add(coarse, curr);
+            (void)free_blocks_re_add(arena, curr);
             goto err_unlock;
         }
 
         curr->size = size;
 
         LOG_DEBUG("coarse_ALLOC (split_block) %zu used %zu alloc %zu", size,
-                  coarse->used_size, coarse->alloc_size);
+                  arena->used_size, arena->alloc_size);
 
     } else { // action == ACTION_USE
         LOG_DEBUG("coarse_ALLOC (same_block) %zu used %zu alloc %zu", size,
-                  coarse->used_size, coarse->alloc_size);
+                  arena->used_size, arena->alloc_size);
     }
 
     curr->used = true;
     *resultPtr = curr->data;
-    coarse->used_size += size;
+    arena->used_size += size;
 
     umf_result = UMF_RESULT_SUCCESS;
 
 err_unlock:
-    assert(debug_check(coarse));
-    utils_mutex_unlock(&coarse->lock);
+    assert(debug_check(arena));
+    utils_mutex_unlock(&arena->lock);
+
+    return umf_result;
+}
+
+// PUBLIC API
+
+umf_result_t coarse_new(coarse_params_t *coarse_params, coarse_t **pcoarse) {
+#ifdef _WIN32
+    utils_init_once(&Log_initialized, utils_log_init);
+#endif /* _WIN32 */
+
+    if (coarse_params == NULL || pcoarse == NULL) {
+        LOG_ERR("coarse parameters or handle is missing");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!coarse_params->provider) {
+        LOG_ERR("memory provider is not set");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!coarse_params->page_size) {
+        LOG_ERR("page size of the memory provider is not set");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!coarse_params->cb.split) {
+        LOG_ERR("coarse split callback is not set");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!coarse_params->cb.merge) {
+        LOG_ERR("coarse merge callback is not set");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (coarse_params->num_arenas > COARSE_MAX_ARENAS) {
+        LOG_ERR("too many arenas: %zu (max: %d)", coarse_params->num_arenas,
+                COARSE_MAX_ARENAS);
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    // alloc() and free() callbacks are optional
+
+    coarse_t *coarse = umf_ba_global_alloc(sizeof(*coarse));
+    if (!coarse) {
+        LOG_ERR("out of the host memory");
+        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    memset(coarse, 0, sizeof(*coarse));
+
+    coarse->provider = coarse_params->provider;
+    coarse->page_size = coarse_params->page_size;
+    coarse->cb = coarse_params->cb;
+    coarse->allocation_strategy = coarse_params->allocation_strategy;
+
+    umf_result_t umf_result = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+
+    coarse->num_arenas = coarse_params->num_arenas;
+    if (coarse->num_arenas == 0) {
+        coarse->num_arenas = 1;
+    }
+
+    if (coarse->num_arenas > 1) {
+        coarse->ranges =
+            ravl_new_sized(coarse_range_comp, sizeof(coarse_range_t));
+        if (coarse->ranges == NULL) {
+            LOG_ERR("out of the host memory");
+            goto err_free_coarse;
+        }
+
+        if (utils_rwlock_init(&coarse->ranges_lock) == NULL) {
+            LOG_ERR("lock initialization failed");
+            umf_result = UMF_RESULT_ERROR_UNKNOWN;
+            goto err_delete_ravl_ranges;
+        }
+    }
+
+    size_t n = 0;
+    for (n = 0; n < coarse->num_arenas; n++) {
+        coarse->arenas[n] = arena_new(coarse);
+        if (coarse->arenas[n] == NULL) {
+            goto err_delete_arenas;
+        }
+    }
+
+    *pcoarse = coarse;
+
+    return UMF_RESULT_SUCCESS;
+
+err_delete_arenas:
+    while (n > 0) {
+        arena_delete(coarse->arenas[--n]);
+    }
+    if (coarse->ranges) {
+        utils_rwlock_destroy_not_free(&coarse->ranges_lock);
+    }
+err_delete_ravl_ranges:
+    if (coarse->ranges) {
+        ravl_delete(coarse->ranges);
+    }
+err_free_coarse:
+    umf_ba_global_free(coarse);
+    return umf_result;
+}
+
+void coarse_delete(coarse_t *coarse) {
+    if (coarse == NULL) {
+        LOG_ERR("coarse handle is missing");
+        return;
+    }
+
+    for (size_t i = 0; i < coarse->num_arenas; i++) {
+        arena_delete(coarse->arenas[i]);
+    }
+
+    if (coarse->ranges) {
+        utils_rwlock_destroy_not_free(&coarse->ranges_lock);
+        ravl_delete(coarse->ranges);
+    }
+
+    umf_ba_global_free(coarse);
+}
+
+umf_result_t coarse_add_memory_from_provider(coarse_t *coarse, size_t size) {
+    umf_result_t umf_result;
+    void *ptr = NULL;
+
+    if (coarse == NULL || size == 0) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!coarse->cb.alloc) {
+        LOG_ERR("error: alloc callback is not set");
+        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    }
+
+    umf_result = coarse_alloc(coarse, size, coarse->page_size, &ptr);
+    if (umf_result != UMF_RESULT_SUCCESS) {
+        return umf_result;
+    }
+
+    assert(ptr);
+
+    return coarse_free(coarse, ptr, size);
+}
+
+umf_result_t coarse_add_memory_fixed(coarse_t *coarse, void *addr,
+                                     size_t size) {
+    umf_result_t umf_result;
+
+    if (coarse == NULL || addr == NULL || size == 0) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (coarse->cb.alloc || coarse->cb.free) {
+        LOG_ERR("error: alloc or free callback is set");
+        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    }
+
+    // the memory is added to the arena of the calling thread,
+    // other arenas will steal it when they need it
+    coarse_arena_t *arena = arena_of_thread(coarse);
+
+    if (coarse_ranges_set(coarse, addr, size, arena)) {
+        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    if (utils_mutex_lock(&arena->lock) != 0) {
+        LOG_ERR("locking the lock failed");
+        return UMF_RESULT_ERROR_UNKNOWN;
+    }
+
+    assert(debug_check(arena));
+
+    umf_result = coarse_add_used_block(arena, addr, size);
+
+    assert(debug_check(arena));
+    utils_mutex_unlock(&arena->lock);
+
+    if (umf_result != UMF_RESULT_SUCCESS) {
+        return umf_result;
+    }
+
+    umf_result = coarse_free(coarse, addr, size);
+    if (umf_result != UMF_RESULT_SUCCESS) {
+        return umf_result;
+    }
+
+    LOG_DEBUG("coarse_ALLOC (add_memory_block) %zu used %zu alloc %zu", size,
+              arena->used_size, arena->alloc_size);
+
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t coarse_alloc(coarse_t *coarse, size_t size, size_t alignment,
+                          void **resultPtr) {
+    umf_result_t umf_result = UMF_RESULT_ERROR_UNKNOWN;
+
+    if (coarse == NULL || resultPtr == NULL) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    // alignment must be a power of two and a multiple or a divider of the page size
+    if (alignment == 0) {
+        alignment = coarse->page_size;
+    } else if ((alignment & (alignment - 1)) ||
+               ((alignment % coarse->page_size) &&
+                (coarse->page_size % alignment))) {
+        LOG_ERR("wrong alignment: %zu (not a power of 2 or a multiple or a "
+                "divider of the page size (%zu))",
+                alignment, coarse->page_size);
+        return UMF_RESULT_ERROR_INVALID_ALIGNMENT;
+    } else if (IS_NOT_ALIGNED(alignment, coarse->page_size)) {
+        alignment = ALIGN_UP_SAFE(alignment, coarse->page_size);
+    }
+
+    coarse_arena_t *arena = arena_of_thread(coarse);
+
+    umf_result = arena_alloc(arena, size, alignment, resultPtr);
+    if (umf_result != UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY ||
+        coarse->cb.alloc) {
+        return umf_result;
+    }
+
+    // The arena ran dry and it cannot get more memory from the provider,
+    // so try to steal a free block from another arena.
+    if (coarse->num_arenas > 1 &&
+        arena_steal(coarse, arena, size, alignment) == UMF_RESULT_SUCCESS) {
+        umf_result = arena_alloc(arena, size, alignment, resultPtr);
+    }
+
+    // No arena has a free block big enough, but the free memory
+    // of all arenas merged together can still have one.
+    if (coarse->num_arenas > 1 &&
+        umf_result == UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY) {
+        coarse_merge_arenas(coarse);
+        umf_result = arena_alloc(arena, size, alignment, resultPtr);
+        if (umf_result == UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY &&
+            arena_steal(coarse, arena, size, alignment) == UMF_RESULT_SUCCESS) {
+            umf_result = arena_alloc(arena, size, alignment, resultPtr);
+        }
+    }
+
+    if (umf_result == UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY) {
+        LOG_ERR("out of memory (the memory provider does not support "
+                "allocating more memory)");
+    }
 
     return umf_result;
 }
@@ -1199,54 +2382,88 @@ umf_result_t coarse_free(coarse_t *coarse, void *ptr, size_t bytes) {
         return UMF_RESULT_SUCCESS;
     }
 
-    if (utils_mutex_lock(&coarse->lock) != 0) {
+    coarse_arena_t *arena = arena_of_ptr(coarse, ptr);
+    if (arena == NULL) {
+        LOG_ERR("memory block not found (ptr = %p, size = %zu)", ptr, bytes);
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (utils_mutex_lock(&arena->lock) != 0) {
         LOG_ERR("locking the lock failed");
         return UMF_RESULT_ERROR_UNKNOWN;
     }
 
-    assert(debug_check(coarse));
+    assert(debug_check(arena));
 
-    ravl_node_t *node = coarse_ravl_find_node(coarse->all_blocks, ptr);
+    ravl_node_t *node = coarse_ravl_find_node(arena->all_blocks, ptr);
     if (node == NULL) {
         // the block was not found
         LOG_ERR("memory block not found (ptr = %p, size = %zu)", ptr, bytes);
-        utils_mutex_unlock(&coarse->lock);
+        utils_mutex_unlock(&arena->lock);
         return UMF_RESULT_ERROR_INVALID_ARGUMENT;
     }
 
     block_t *block = get_node_block(node);
     if (!block->used) {
         LOG_ERR("double free");
-        utils_mutex_unlock(&coarse->lock);
+        utils_mutex_unlock(&arena->lock);
         return UMF_RESULT_ERROR_INVALID_ARGUMENT;
     }
 
     if (bytes > 0 && bytes != block->size) {
         LOG_ERR("wrong size of allocation");
-        utils_mutex_unlock(&coarse->lock);
+        utils_mutex_unlock(&arena->lock);
         return UMF_RESULT_ERROR_INVALID_ARGUMENT;
     }
 
+    if (coarse->cb.discard) {
+        // the block is still used, so it cannot be allocated in the meantime
+        umf_result_t umf_result =
+            coarse->cb.discard(coarse->provider, block->data, block->size);
+        if (umf_result != UMF_RESULT_SUCCESS) {
+            LOG_DEBUG("discarding the block failed (ptr = %p, size = %zu)",
+                      (void *)block->data, block->size);
+        }
+    }
+
     LOG_DEBUG("coarse_FREE (return_block_to_pool) %zu used %zu alloc %zu",
-              block->size, coarse->used_size - block->size, coarse->alloc_size);
+              block->size, arena->used_size - block->size, arena->alloc_size);
 
-    assert(coarse->used_size >= block->size);
-    coarse->used_size -= block->size;
+    assert(arena->used_size >= block->size);
+    arena->used_size -= block->size;
 
     block->used = false;
 
     // Merge with prev and/or next block if they are unused and have continuous data.
-    node = free_block_merge_with_prev(coarse, node);
-    node = free_block_merge_with_next(coarse, node);
+    node = free_block_merge_with_prev(arena, node);
+    node = free_block_merge_with_next(arena, node);
+    block = get_node_block(node);
+
+    // A whole stolen range that got free is given back to its home arena,
+    // where it can be merged with its neighbours again.
+    coarse_arena_t *home = coarse_ranges_get_home(arena, block, true);
+    if (home) {
+        unsigned char *data = block->data;
+        size_t size = block->size;
+        if (arena_rm_free_block(arena, block, home) == UMF_RESULT_SUCCESS) {
+            assert(debug_check(arena));
+            utils_mutex_unlock(&arena->lock);
+
+            LOG_DEBUG("coarse_GIVE_BACK %zu bytes from arena %p to arena %p",
+                      size, (void *)arena, (void *)home);
+
+            return arena_add_free_memory(home, data, size);
+        }
+    }
 
-    int rv = free_blocks_add(coarse->free_blocks, get_node_block(node));
+    int rv = coarse_free_blocks_add(arena, block);
     if (rv) {
-        utils_mutex_unlock(&coarse->lock);
+        utils_mutex_unlock(&arena->lock);
         return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
     }
 
-    assert(debug_check(coarse));
-    utils_mutex_unlock(&coarse->lock);
+    assert(debug_check(arena));
+    utils_mutex_unlock(&arena->lock);
 
     return UMF_RESULT_SUCCESS;
 }
@@ -1261,16 +2478,28 @@ umf_result_t coarse_merge(coarse_t *coarse, void *lowPtr, void *highPtr,
         return UMF_RESULT_ERROR_INVALID_ARGUMENT;
     }
 
-    if (utils_mutex_lock(&coarse->lock) != 0) {
+    coarse_arena_t *arena = arena_of_ptr(coarse, lowPtr);
+    if (arena == NULL) {
+        LOG_ERR("the lowPtr memory block not found");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (arena_of_ptr(coarse, highPtr) != arena) {
+        // blocks of different arenas are never merged
+        LOG_ERR("the highPtr memory block not found in the arena of lowPtr");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (utils_mutex_lock(&arena->lock) != 0) {
         LOG_ERR("locking the lock failed");
         return UMF_RESULT_ERROR_UNKNOWN;
     }
 
-    assert(debug_check(coarse));
+    assert(debug_check(arena));
 
     umf_result = UMF_RESULT_ERROR_INVALID_ARGUMENT;
 
-    ravl_node_t *low_node = coarse_ravl_find_node(coarse->all_blocks, lowPtr);
+    ravl_node_t *low_node = coarse_ravl_find_node(arena->all_blocks, lowPtr);
     if (low_node == NULL) {
         LOG_ERR("the lowPtr memory block not found");
         goto err_mutex_unlock;
@@ -1282,7 +2511,7 @@ umf_result_t coarse_merge(coarse_t *coarse, void *lowPtr, void *highPtr,
         goto err_mutex_unlock;
     }
 
-    ravl_node_t *high_node = coarse_ravl_find_node(coarse->all_blocks, highPtr);
+    ravl_node_t *high_node = coarse_ravl_find_node(arena->all_blocks, highPtr);
     if (high_node == NULL) {
         LOG_ERR("the highPtr memory block not found");
         goto err_mutex_unlock;
@@ -1311,7 +2540,7 @@ umf_result_t coarse_merge(coarse_t *coarse, void *lowPtr, void *highPtr,
     ravl_node_t *merged_node = NULL;
 
     umf_result =
-        user_block_merge(coarse, low_node, high_node, true, &merged_node);
+        user_block_merge(arena, low_node, high_node, true, &merged_node);
     if (umf_result != UMF_RESULT_SUCCESS) {
         LOG_ERR("merging a block failed");
         goto err_mutex_unlock;
@@ -1323,8 +2552,8 @@ umf_result_t coarse_merge(coarse_t *coarse, void *lowPtr, void *highPtr,
     umf_result = UMF_RESULT_SUCCESS;
 
 err_mutex_unlock:
-    assert(debug_check(coarse));
-    utils_mutex_unlock(&coarse->lock);
+    assert(debug_check(arena));
+    utils_mutex_unlock(&arena->lock);
 
     return umf_result;
 }
@@ -1338,16 +2567,22 @@ umf_result_t coarse_split(coarse_t *coarse, void *ptr, size_t totalSize,
         return UMF_RESULT_ERROR_INVALID_ARGUMENT;
     }
 
-    if (utils_mutex_lock(&coarse->lock) != 0) {
+    coarse_arena_t *arena = arena_of_ptr(coarse, ptr);
+    if (arena == NULL) {
+        LOG_ERR("memory block not found");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (utils_mutex_lock(&arena->lock) != 0) {
         LOG_ERR("locking the lock failed");
         return UMF_RESULT_ERROR_UNKNOWN;
     }
 
-    assert(debug_check(coarse));
+    assert(debug_check(arena));
 
     umf_result = UMF_RESULT_ERROR_INVALID_ARGUMENT;
 
-    ravl_node_t *node = coarse_ravl_find_node(coarse->all_blocks, ptr);
+    ravl_node_t *node = coarse_ravl_find_node(arena->all_blocks, ptr);
     if (node == NULL) {
         LOG_ERR("memory block not found");
         goto err_mutex_unlock;
@@ -1366,7 +2601,7 @@ umf_result_t coarse_split(coarse_t *coarse, void *ptr, size_t totalSize,
     }
 
     // check if block can be split by the memory provider
-    umf_result = can_provider_split(coarse, ptr, totalSize, firstSize);
+    umf_result = can_provider_split(arena, ptr, totalSize, firstSize);
     if (umf_result != UMF_RESULT_SUCCESS) {
         LOG_ERR("memory provider cannot split a memory block");
         goto err_mutex_unlock;
@@ -1375,7 +2610,7 @@ umf_result_t coarse_split(coarse_t *coarse, void *ptr, size_t totalSize,
     umf_result = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
 
     block_t *new_block =
-        coarse_ravl_add_new(coarse->all_blocks, block->data + firstSize,
+        coarse_ravl_add_new(arena->all_blocks, block->data + firstSize,
                             block->size - firstSize, NULL);
     if (new_block == NULL) {
         goto err_mutex_unlock;
@@ -1389,8 +2624,8 @@ umf_result_t coarse_split(coarse_t *coarse, void *ptr, size_t totalSize,
     umf_result = UMF_RESULT_SUCCESS;
 
 err_mutex_unlock:
-    assert(debug_check(coarse));
-    utils_mutex_unlock(&coarse->lock);
+    assert(debug_check(arena));
+    utils_mutex_unlock(&arena->lock);
 
     return umf_result;
 }
@@ -1402,14 +2637,90 @@ coarse_stats_t coarse_get_stats(coarse_t *coarse) {
         return stats;
     }
 
-    if (utils_mutex_lock(&coarse->lock) != 0) {
-        LOG_ERR("locking the lock failed");
-        return stats;
-    }
+    for (size_t i = 0; i < coarse->num_arenas; i++) {
+        coarse_arena_t *arena = coarse->arenas[i];
+        coarse_stats_t arena_stats = {0};
+
+        if (utils_mutex_lock(&arena->lock) != 0) {
+            LOG_ERR("locking the lock failed");
+            return stats;
+        }
+
+        arena_get_stats_no_lock(arena, &arena_stats);
 
-    coarse_get_stats_no_lock(coarse, &stats);
+        utils_mutex_unlock(&arena->lock);
 
-    utils_mutex_unlock(&coarse->lock);
+        stats.alloc_size += arena_stats.alloc_size;
+        stats.used_size += arena_stats.used_size;
+        stats.num_all_blocks += arena_stats.num_all_blocks;
+        stats.num_free_blocks += arena_stats.num_free_blocks;
+        if (arena_stats.max_free_block_size > stats.max_free_block_size) {
+            stats.max_free_block_size = arena_stats.max_free_block_size;
+        }
+    }
+
+    size_t free_size = stats.alloc_size - stats.used_size;
+    stats.max_free_block_ratio =
+        free_size ? (double)stats.max_free_block_size / (double)free_size
+                  : 1.0;
 
     return stats;
 }
+
+umf_result_t coarse_get_free_histogram(coarse_t *coarse, size_t *histogram,
+                                       size_t num_bins) {
+    if (coarse == NULL || histogram == NULL || num_bins == 0) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(histogram, 0, num_bins * sizeof(*histogram));
+
+    defrag_histogram_args_t args = {histogram, num_bins};
+
+    for (size_t i = 0; i < coarse->num_arenas; i++) {
+        coarse_arena_t *arena = coarse->arenas[i];
+
+        if (utils_mutex_lock(&arena->lock) != 0) {
+            LOG_ERR("locking the lock failed");
+            return UMF_RESULT_ERROR_UNKNOWN;
+        }
+
+        ravl_foreach(arena->all_blocks, ravl_cb_defrag_histogram, &args);
+
+        utils_mutex_unlock(&arena->lock);
+    }
+
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t coarse_get_compaction_hints(coarse_t *coarse,
+                                         umf_compaction_hint_t *hints,
+                                         size_t max_hints, size_t *num_hints) {
+    if (coarse == NULL || num_hints == NULL ||
+        (hints == NULL && max_hints > 0)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    // hints of all arenas are gathered in one array
+    defrag_hints_args_t args = {hints, max_hints, 0, NULL, 0};
+
+    for (size_t i = 0; i < coarse->num_arenas; i++) {
+        coarse_arena_t *arena = coarse->arenas[i];
+
+        if (utils_mutex_lock(&arena->lock) != 0) {
+            LOG_ERR("locking the lock failed");
+            return UMF_RESULT_ERROR_UNKNOWN;
+        }
+
+        args.prev = NULL;
+        args.prev_free_size = 0;
+        ravl_foreach(arena->all_blocks, ravl_cb_defrag_hints, &args);
+        defrag_hints_visit(&args, NULL);
+
+        utils_mutex_unlock(&arena->lock);
+    }
+
+    *num_hints = args.num_hints;
+
+    return UMF_RESULT_SUCCESS;
+}
@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include <umf/base.h>
+#include <umf/memory_provider.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,6 +20,11 @@ extern "C" {
 
 typedef struct coarse_t coarse_t;
 
+// number of arenas used by the coarse-based memory providers
+// (more arenas scale better with threads, but the free memory split
+// between them is merged only when an allocation cannot be served)
+#define COARSE_PROVIDER_NUM_ARENAS 1
+
 // coarse callbacks implement provider-specific actions
 typedef struct coarse_callbacks_t {
     // alloc() is optional (can be NULL for the fixed-size memory provider)
@@ -30,6 +36,10 @@ typedef struct coarse_callbacks_t {
                           size_t firstSize);
     umf_result_t (*merge)(void *provider, void *lowPtr, void *highPtr,
                           size_t totalSize);
+    // discard() is optional, it is called by coarse_free() before the freed
+    // block can be allocated again, so the provider can release the physical
+    // memory of the block (its contents do not have to be preserved)
+    umf_result_t (*discard)(void *provider, void *ptr, size_t size);
 } coarse_callbacks_t;
 
 // coarse library allocation strategy
@@ -50,6 +60,31 @@ typedef enum coarse_strategy_t {
     // If none of them had the correct alignment,
     // use the `UMF_COARSE_MEMORY_STRATEGY_FASTEST` strategy.
     UMF_COARSE_MEMORY_STRATEGY_CHECK_ALL_SIZE,
+
+    // Keep free blocks in a two-level segregated-fit (TLSF-like) index
+    // instead of the tree sorted by size. A free block is found in O(1)
+    // using bitmaps: it is the first block of the first non-empty list
+    // of a size class that guarantees a fit (a good fit, not a best fit).
+    // If there is no such block, the list of the size class of 'size'
+    // is searched for the first block that fits.
+    UMF_COARSE_MEMORY_STRATEGY_SEGREGATED_FIT,
+
+    // Choose the smallest free block that can hold the aligned data
+    // and the one with the lowest address of free blocks of the same size.
+    // It is slower than the above strategies: the whole list of free blocks
+    // of the chosen size is looked through, so an allocation costs
+    // O(log n + k), where k is the number of free blocks of that size.
+    // It leaves big free blocks intact for big allocations.
+    UMF_COARSE_MEMORY_STRATEGY_BEST_FIT,
+
+    // Choose the free block with the lowest address that can hold
+    // the aligned data. Free blocks are kept sorted by address
+    // and looked through from the lowest one, so an allocation costs O(n)
+    // in the number of free blocks when the low ones are too small.
+    // It is the slowest strategy, not meant for fragmented memory with many
+    // free blocks, but it packs allocations at the beginning of the memory,
+    // leaving the end of it free for big allocations.
+    UMF_COARSE_MEMORY_STRATEGY_LOWEST_ADDRESS,
 } coarse_strategy_t;
 
 // coarse library settings structure
@@ -66,6 +101,16 @@ typedef struct coarse_params_t {
 
     // page size of the memory provider
     size_t page_size;
+
+    // number of independently locked arenas the memory is partitioned into
+    // (0 means 1). Threads are assigned arenas round-robin. If the alloc
+    // callback is not set, an arena that ran dry steals free memory from
+    // other arenas. A stolen range is given back to its home arena when
+    // it gets free as a whole, and all free stolen blocks are given back
+    // when no arena can serve an allocation. Blocks of different ranges
+    // are never merged, so coarse_merge() fails for allocations from
+    // different arenas or ranges.
+    size_t num_arenas;
 } coarse_params_t;
 
 // coarse library statistics
@@ -81,6 +126,14 @@ typedef struct coarse_stats_t {
 
     // number of free memory blocks
     size_t num_free_blocks;
+
+    // size of the largest free memory block
+    size_t max_free_block_size;
+
+    // size of the largest free memory block divided by the size of all free
+    // memory (alloc_size - used_size); the lower it is, the more fragmented
+    // the free memory is (1.0 if there is no free memory)
+    double max_free_block_ratio;
 } coarse_stats_t;
 
 umf_result_t coarse_new(coarse_params_t *coarse_params, coarse_t **pcoarse);
@@ -105,6 +158,21 @@ umf_result_t coarse_add_memory_fixed(coarse_t *coarse, void *addr, size_t size);
 
 coarse_stats_t coarse_get_stats(coarse_t *coarse);
 
+// Get the histogram of sizes of free blocks: histogram[i] is the number
+// of free blocks of size in the range [2^i, 2^(i+1)), the last bin
+// counts also all bigger free blocks.
+umf_result_t coarse_get_free_histogram(coarse_t *coarse, size_t *histogram,
+                                       size_t num_bins);
+
+// Get up to 'max_hints' compaction hints: used blocks contiguous with free
+// blocks, which if relocated, would coalesce with them into the biggest
+// free blocks. Hints are sorted by the coalesced size (descending)
+// and then by the size of the used block (ascending).
+// The number of returned hints is stored in 'num_hints'.
+umf_result_t coarse_get_compaction_hints(coarse_t *coarse,
+                                         umf_compaction_hint_t *hints,
+                                         size_t max_hints, size_t *num_hints);
+
 #ifdef __cplusplus
 }
 #endif
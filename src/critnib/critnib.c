@@ -23,7 +23,8 @@
  * Critnib is a hybrid between a radix tree and DJ Bernstein's critbit:
  * it skips nodes for uninteresting radix nodes (ie, ones that would have
  * exactly one child), this requires adding to every node a field that
- * describes the slice (4-bit in our case) that this radix level is for.
+ * describes the slice (4-bit by default, see CRITNIB_SLICE) that this radix
+ * level is for.
  *
  * This implementation also stores each node's path (ie, bits that are
  * common to every key in that subtree) -- this doesn't help with lookups
@@ -40,18 +41,39 @@
  * notice the data being stale and restart the work.  In usual cases,
  * the structure having been modified does _not_ cause a restart.
  *
- * Writes could be easily made lock-free as well (with only a cmpxchg
- * sync), but this leads to problems with removes.  A possible solution
- * would be doing removes by overwriting by NULL w/o freeing -- yet this
- * would lead to the structure growing without bounds.  Complex per-node
- * locks would increase concurrency but they slow down individual writes
- * enough that in practice a simple global write lock works faster.
+ * Inserts are lock-free as well: a new leaf (or a new node holding the
+ * new leaf and the subtree it displaces) is published with a single cmpxchg
+ * on the slot that pointed to the subtree, and the insert restarts if the
+ * slot changed meanwhile.  The cmpxchg compares the whole slot, including
+ * its FROZEN tag, with the value the insert has seen, thus it also fails
+ * if the slot has been frozen (see below).
+ *
+ * Removes are serialized by a lock, but they do not block inserts.  The
+ * problem with concurrent removes is collapsing a node left with a single
+ * child -- an insert could add a child to the node just before it's
+ * dropped from the tree.  Thus, before collapsing a node, a remove freezes
+ * all its child slots by setting the FROZEN bit in them.  Frozen slots
+ * cannot be changed by inserts (their cmpxchg fails), and an insert which
+ * finds a frozen slot restarts from the root.  Nodes stay frozen after
+ * they are detached from the tree, until they are reused.
  *
  * Removes are the only operation that can break reads.  The structure
  * can do local RCU well -- the problem being knowing when it's safe to
  * free.  Any synchronization with reads would kill their speed, thus
  * instead we have a remove count.  The grace period is DELETED_LIFE,
  * after which any read will notice staleness and restart its work.
+ * An insert cannot validate its cmpxchg that way, as it could be stalled
+ * between the check and the cmpxchg, so inserts hold an epoch instead
+ * (see EPOCH RECLAMATION) and removed nodes and leaves are not reused
+ * until every insert that could have seen them has finished.  Until then
+ * a slot of a removed node stays frozen and a slot of a removed leaf
+ * never holds the leaf again, so the cmpxchg of a stale insert fails.
+ *
+ * When cb_free_leaf() is set, a value returned by a read has to stay valid
+ * until the caller releases its reference, for longer than the grace period
+ * above.  Counting references in the leaf would make every read write to a
+ * cache line shared by all threads looking up the same key, thus values
+ * are reclaimed with epochs instead (see EPOCH RECLAMATION below).
  */
 #include <errno.h>
 #include <stdbool.h>
@@ -85,12 +107,29 @@
  */
 #define DELETED_LIFE 16
 
-#define SLICE 4
+/*
+ * Width (in bits) of the slice of a key that indexes the children of a node.
+ * 4-bit slices keep nodes small (16 children), 8-bit slices halve the depth
+ * of the tree at the cost of 256 children per node, what pays off only for
+ * big and dense sets of keys.
+ */
+#ifndef CRITNIB_SLICE
+#define CRITNIB_SLICE 4
+#endif
+
+#if CRITNIB_SLICE != 4 && CRITNIB_SLICE != 8
+#error "CRITNIB_SLICE has to be 4 or 8"
+#endif
+
+#define SLICE CRITNIB_SLICE
 #define NIB ((1ULL << SLICE) - 1)
 #define SLNODES (1 << SLICE)
 
-// it has to be >= 2
-#define LEAF_VALID (2ULL)
+/*
+ * Tag of a frozen child slot (see CONCURRENCY ISSUES); bit 0 tags leaves
+ * and both nodes and leaves are at least 8-byte aligned.
+ */
+#define FROZEN (2ULL)
 
 typedef uintptr_t word;
 typedef uint8_t sh_t;
@@ -101,7 +140,7 @@ struct critnib_node {
 	 * explicit nodes or collapsed links) -- ie, any subtree below has all
 	 * those bits set to this value.
 	 *
-	 * nib is a 4-bit slice that's an index into the node's children.
+	 * nib is a SLICE-bit slice that's an index into the node's children.
 	 *
 	 * shift is the length (in bits) of the part of the key below this node.
 	 *
@@ -111,9 +150,11 @@ struct critnib_node {
 	 *              +-----+
 	 *               shift
 	 */
-    struct critnib_node *child[SLNODES];
     word path;
     sh_t shift;
+    /* the global epoch after the node was removed, see retire_node() */
+    uint64_t retire_epoch;
+    struct critnib_node *child[SLNODES];
 };
 
 struct critnib_leaf {
@@ -124,24 +165,21 @@ struct critnib_leaf {
      * critnib_remove() sets 'to_be_freed' to the 'value' of the leaf
      * and sets 'value' to NULL, because the 'value' of a removed leaf
      * is not valid anymore and should not be returned to a user.
-     * The 'value' of the leaf saved in 'to_be_freed' is freed in critnib_release()
-     * when the reference count of the leaf drops to 0.
+     * The 'value' of the leaf saved in 'to_be_freed' is freed when
+     * the global epoch has advanced twice since 'retire_epoch'.
      */
     void *to_be_freed;
-    /*
-     * 'pending_deleted_leaf' is set when critnib_release() should add this leaf
-     * to the 'c->deleted_leaf' list when the reference count drops to 0.
-     */
-    uint8_t pending_deleted_leaf;
-    // the 'next' pointer in the 'c->deleted_leaf' list
+    uint64_t retire_epoch;
+    // the 'next' pointer in the 'c->deleted_leaf' or 'c->limbo_leaf' list
     void *next;
-    uint64_t ref_count;
 };
 
 struct critnib {
     struct critnib_node *root;
     free_leaf_t cb_free_leaf; // callback for freeing a leaf
     void *leaf_allocator;     // handle of allocator for leaves
+    size_t n_nodes;  // number of nodes taken from critnib_node_pool
+    size_t n_leaves; // number of leaves taken from critnib_leaf_pool
 
     /* pool of freed nodes: singly linked list, next at child[0] */
     struct critnib_node *deleted_node;
@@ -151,9 +189,19 @@ struct critnib {
     struct critnib_node *pending_del_nodes[DELETED_LIFE];
     struct critnib_leaf *pending_del_leaves[DELETED_LIFE];
 
+    /*
+     * nodes and leaves past the grace period, which may still be seen by
+     * inserts or whose values are not reclaimed yet (see EPOCH RECLAMATION);
+     * nodes are linked by child[0]
+     */
+    struct critnib_node *limbo_node;
+    struct critnib_leaf *limbo_leaf;
+    size_t limbo_count;
+    size_t limbo_limit; /* the next synchronous reclaim (0 - LIMBO_MAX) */
+
     uint64_t remove_count;
 
-    struct utils_mutex_t mutex; /* writes/removes */
+    struct utils_mutex_t mutex; /* removes and updates */
 };
 
 /*
@@ -168,6 +216,47 @@ static inline struct critnib_leaf *to_leaf(struct critnib_node *n) {
     return (void *)((word)n & ~1ULL);
 }
 
+/*
+ * internal: is_frozen -- check if a child slot is frozen
+ */
+static inline bool is_frozen(struct critnib_node *n) {
+    return (word)n & FROZEN;
+}
+
+/*
+ * internal: unfrozen -- untag a frozen child pointer
+ */
+static inline struct critnib_node *unfrozen(struct critnib_node *n) {
+    return (void *)((word)n & ~FROZEN);
+}
+
+/*
+ * internal: load_slot -- load a child slot, including its FROZEN tag
+ */
+static inline struct critnib_node *load_slot(struct critnib_node **slot) {
+    struct critnib_node *n;
+    utils_atomic_load_acquire_ptr((void **)slot, (void **)&n);
+    return n;
+}
+
+/*
+ * internal: load_child -- load a child pointer, ignoring the FROZEN tag
+ */
+static inline struct critnib_node *load_child(struct critnib_node **slot) {
+    return unfrozen(load_slot(slot));
+}
+
+/*
+ * internal: cas_slot -- replace the content of a child slot if it's
+ * still the expected one
+ */
+static inline bool cas_slot(struct critnib_node **slot,
+                            struct critnib_node *expected,
+                            struct critnib_node *desired) {
+    return utils_compare_exchange_u64((uint64_t *)slot, (uint64_t *)&expected,
+                                      (uint64_t *)&desired);
+}
+
 /*
  * internal: path_mask -- return bit mask of a path above a subtree [shift]
  * bits tall
@@ -181,6 +270,292 @@ static inline unsigned slice_index(word key, sh_t shift) {
     return (unsigned)((key >> shift) & NIB);
 }
 
+/*
+ * EPOCH RECLAMATION
+ *
+ * A thread taking its first reference (an insert, or a read or a remove
+ * when cb_free_leaf() is set) announces the global epoch in its own slot,
+ * and clears the slot when it releases its last reference, so reads touch
+ * no shared cache line.  A remove tags the removed leaf (and the node it
+ * collapsed) with the global epoch read after they were detached.  The
+ * global epoch is advanced (by removes) only when all announced epochs are
+ * equal to it, thus once it has advanced twice since the tag, every thread
+ * that could have seen the leaf or its value has released its references.
+ * Then the value can be freed and the leaf and the node can be reused.
+ *
+ * The value of a leaf is freed by the first remove which finds it eligible,
+ * while the leaf waits in pending_del_leaves[] anyway.  A leaf or a node
+ * still not eligible when its grace period ends is moved to the limbo list
+ * instead of the pool of freed leaves or nodes.
+ *
+ * A slot is given back on the exit of its thread (by the destructor of
+ * a thread-local storage key) and reused by the next thread, so advancing
+ * the epoch scans only as many slots as there were threads at once.
+ * Threads that come when all EPOCH_SLOTS slots are taken share a counter
+ * of readers instead, which blocks advancing the epoch while it is non-zero.
+ *
+ * The epoch is shared by all critnibs, so a reference held long in one of
+ * them delays reclaiming values in all of them.  The limbo list of a critnib
+ * is kept at LIMBO_MAX items: when it grows over the limit, a remove
+ * tries for a while to advance the epoch and reclaim the values at once;
+ * if references held by other threads do not let it, it tries again when
+ * the list doubles.
+ *
+ * A reference has to be released by the thread that took it.
+ */
+#define EPOCH_SLOTS 1024
+#define LIMBO_MAX 64
+#define LIMBO_SYNC_ATTEMPTS 100
+
+typedef struct epoch_slot_t {
+    uint64_t epoch; // announced global epoch, 0 when no references are held
+    char padding[64 - sizeof(uint64_t)]; // avoid false sharing
+} epoch_slot_t;
+
+static epoch_slot_t epoch_slots[EPOCH_SLOTS];
+static epoch_slot_t epoch_overflow_slot; // marks threads with no slot
+static uint64_t epoch_slots_used;        // the highest slot ever taken + 1
+static uint64_t epoch_overflow_readers;
+static uint64_t epoch_global = 1;
+
+// slots given back by exited threads
+static uint32_t epoch_slots_free[EPOCH_SLOTS];
+static size_t epoch_slots_nfree;
+static utils_mutex_t epoch_slots_lock;
+static bool epoch_slots_lock_initialized;
+static utils_tls_key_t epoch_slot_key;
+static bool epoch_slot_key_created;
+static UTIL_ONCE_FLAG epoch_slot_key_once = UTIL_ONCE_FLAG_INIT;
+
+static __TLS epoch_slot_t *epoch_slot;
+static __TLS uint64_t epoch_nesting; // number of references held
+
+/*
+ * Nodes and leaves of all critnibs come from two slabs shared by them,
+ * because the minimal slab of 128 cache-line aligned nodes and 128 leaves
+ * takes about 32 KB, which a critnib of a few keys would waste. Nodes and
+ * leaves are given back to the slabs only when their critnib is deleted,
+ * and the slabs live as long as the process.
+ */
+static umf_ba_pool_t *critnib_node_pool; // slab of cache-line aligned nodes
+static umf_ba_pool_t *critnib_leaf_pool; // slab of leaves
+static size_t critnib_node_size;
+static size_t critnib_leaf_size;
+static UTIL_ONCE_FLAG critnib_pools_once = UTIL_ONCE_FLAG_INIT;
+
+/*
+ * internal: epoch_slot_release -- give the slot of an exiting thread back
+ */
+static void epoch_slot_release(void *arg) {
+    epoch_slot_t *slot = arg;
+
+    utils_mutex_lock(&epoch_slots_lock);
+
+    // the key is being deleted (not a thread exit)
+    if (!epoch_slot_key_created) {
+        utils_mutex_unlock(&epoch_slots_lock);
+        return;
+    }
+
+    // a later destructor of this thread can still take a new slot
+    epoch_slot = NULL;
+
+    uint64_t announced;
+    utils_atomic_load_acquire_u64(&slot->epoch, &announced);
+    if (!announced) {
+        epoch_slots_free[epoch_slots_nfree++] = (uint32_t)(slot - epoch_slots);
+    }
+    // otherwise the thread exited holding a reference - the slot is lost
+
+    utils_mutex_unlock(&epoch_slots_lock);
+}
+
+static void epoch_slot_key_init(void) {
+    if (!utils_mutex_init(&epoch_slots_lock)) {
+        LOG_ERR("initializing the lock of epoch slots failed");
+        return;
+    }
+
+    epoch_slots_lock_initialized = true;
+    epoch_slot_key_created =
+        (utils_tls_key_create(&epoch_slot_key, epoch_slot_release) == 0);
+}
+
+/*
+ * internal: epoch_slot_new -- take a never used slot
+ */
+static epoch_slot_t *epoch_slot_new(void) {
+    uint64_t idx = utils_atomic_increment_u64(&epoch_slots_used) - 1;
+    return (idx < EPOCH_SLOTS) ? &epoch_slots[idx] : &epoch_overflow_slot;
+}
+
+/*
+ * internal: epoch_slot_take -- take a slot for the calling thread,
+ * preferably one given back by an exited thread
+ */
+static epoch_slot_t *epoch_slot_take(void) {
+    utils_init_once(&epoch_slot_key_once, epoch_slot_key_init);
+
+    if (!epoch_slots_lock_initialized) {
+        return epoch_slot_new();
+    }
+
+    utils_mutex_lock(&epoch_slots_lock);
+
+    epoch_slot_t *slot;
+    if (epoch_slots_nfree) {
+        slot = &epoch_slots[epoch_slots_free[--epoch_slots_nfree]];
+    } else {
+        slot = epoch_slot_new();
+    }
+
+    // the value of the key is passed to its destructor on thread exit
+    if (epoch_slot_key_created && slot != &epoch_overflow_slot &&
+        utils_tls_set(epoch_slot_key, slot)) {
+        LOG_DEBUG("the epoch slot will not be given back on thread exit");
+    }
+
+    utils_mutex_unlock(&epoch_slots_lock);
+
+    return slot;
+}
+
+/*
+ * critnib_global_teardown -- stop giving epoch slots back on thread exit,
+ * as the destructor would not survive unloading the library
+ */
+void critnib_global_teardown(void) {
+    if (!epoch_slots_lock_initialized) {
+        return;
+    }
+
+    utils_mutex_lock(&epoch_slots_lock);
+    if (epoch_slot_key_created) {
+        epoch_slot_key_created = false;
+        utils_tls_key_delete(epoch_slot_key);
+    }
+    utils_mutex_unlock(&epoch_slots_lock);
+}
+
+/*
+ * internal: epoch_enter -- start (or nest) a read-side critical section
+ */
+static void epoch_enter(void) {
+    if (epoch_nesting++ > 0) {
+        return;
+    }
+
+    if (!epoch_slot) {
+        epoch_slot = epoch_slot_take();
+    }
+
+    if (epoch_slot == &epoch_overflow_slot) {
+        utils_atomic_increment_u64(&epoch_overflow_readers);
+    } else {
+        uint64_t epoch;
+        utils_atomic_load_acquire_u64(&epoch_global, &epoch);
+        utils_atomic_store_release_u64(&epoch_slot->epoch, epoch);
+    }
+
+    // the announcement has to be visible before the tree is read
+    utils_atomic_fence_seq_cst();
+}
+
+/*
+ * internal: epoch_exit -- end a read-side critical section
+ *
+ * Returns -1 if the thread holds no references.
+ */
+static int epoch_exit(void) {
+    if (epoch_nesting == 0) {
+        return -1;
+    }
+
+    if (--epoch_nesting > 0) {
+        return 0;
+    }
+
+    if (epoch_slot == &epoch_overflow_slot) {
+        utils_atomic_decrement_u64(&epoch_overflow_readers);
+    } else {
+        utils_atomic_store_release_u64(&epoch_slot->epoch, 0);
+    }
+
+    return 0;
+}
+
+/*
+ * internal: epoch_current -- read the global epoch after all earlier stores
+ * (ie, detaching a leaf) are visible to other threads
+ */
+static uint64_t epoch_current(void) {
+    uint64_t epoch;
+    utils_atomic_fence_seq_cst();
+    utils_atomic_load_acquire_u64(&epoch_global, &epoch);
+    return epoch;
+}
+
+/*
+ * internal: epoch_try_advance -- advance the global epoch if every thread
+ * holding references has announced the current one, returns the global epoch
+ */
+static uint64_t epoch_try_advance(void) {
+    uint64_t epoch = epoch_current();
+
+    uint64_t readers;
+    utils_atomic_load_acquire_u64(&epoch_overflow_readers, &readers);
+    if (readers) {
+        return epoch;
+    }
+
+    uint64_t used;
+    utils_atomic_load_acquire_u64(&epoch_slots_used, &used);
+    used = utils_min(used, EPOCH_SLOTS);
+    for (uint64_t i = 0; i < used; i++) {
+        uint64_t announced;
+        utils_atomic_load_acquire_u64(&epoch_slots[i].epoch, &announced);
+        if (announced && announced != epoch) {
+            return epoch;
+        }
+    }
+
+    uint64_t next = epoch + 1;
+    if (utils_compare_exchange_u64(&epoch_global, &epoch, &next)) {
+        return next;
+    }
+
+    // advanced by another thread meanwhile
+    return epoch;
+}
+
+/*
+ * internal: is_reclaimable -- check if a leaf or a node removed (or the value
+ * of a leaf retired) in retire_epoch cannot be seen by any thread anymore
+ */
+static inline bool is_reclaimable(uint64_t retire_epoch, uint64_t epoch) {
+    return retire_epoch + 2 <= epoch;
+}
+
+static void critnib_pools_init(void) {
+    // nodes are cache-line aligned, so that the header of a node
+    // and the first children share one cache line
+    critnib_node_pool =
+        umf_ba_create_aligned(sizeof(struct critnib_node), CACHE_LINE_SIZE);
+    if (!critnib_node_pool) {
+        return;
+    }
+
+    critnib_leaf_pool = umf_ba_create(sizeof(struct critnib_leaf));
+    if (!critnib_leaf_pool) {
+        umf_ba_destroy(critnib_node_pool);
+        critnib_node_pool = NULL;
+        return;
+    }
+
+    umf_ba_get_n_allocs(critnib_node_pool, &critnib_node_size);
+    umf_ba_get_n_allocs(critnib_leaf_pool, &critnib_leaf_size);
+}
+
 /*
  * critnib_new -- allocates a new critnib structure
  *
@@ -189,6 +564,11 @@ static inline unsigned slice_index(word key, sh_t shift) {
  * - leaf_allocator - handle of allocator for leaves (can be NULL)
  */
 struct critnib *critnib_new(free_leaf_t cb_free_leaf, void *leaf_allocator) {
+    utils_init_once(&critnib_pools_once, critnib_pools_init);
+    if (!critnib_node_pool) {
+        return NULL;
+    }
+
     struct critnib *c = umf_ba_global_alloc(sizeof(struct critnib));
     if (!c) {
         return NULL;
@@ -226,15 +606,16 @@ static void delete_node(struct critnib *c, struct critnib_node *__restrict n) {
                                 (void *)to_leaf(n)->to_be_freed);
             }
         }
-        umf_ba_global_free(to_leaf(n));
+        umf_ba_free(critnib_leaf_pool, to_leaf(n));
     } else {
         for (int i = 0; i < SLNODES; i++) {
-            if (n->child[i]) {
-                delete_node(c, n->child[i]);
+            struct critnib_node *m = unfrozen(n->child[i]);
+            if (m) {
+                delete_node(c, m);
             }
         }
 
-        umf_ba_global_free(n);
+        umf_ba_free(critnib_node_pool, n);
     }
 }
 
@@ -249,19 +630,34 @@ void critnib_delete(struct critnib *c) {
     utils_mutex_destroy_not_free(&c->mutex);
 
     for (struct critnib_node *m = c->deleted_node; m;) {
-        struct critnib_node *mm = m->child[0];
-        umf_ba_global_free(m);
+        struct critnib_node *mm = unfrozen(m->child[0]);
+        umf_ba_free(critnib_node_pool, m);
         m = mm;
     }
 
     for (struct critnib_leaf *k = c->deleted_leaf; k;) {
         struct critnib_leaf *kk = k->next;
-        umf_ba_global_free(k);
+        umf_ba_free(critnib_leaf_pool, k);
+        k = kk;
+    }
+
+    for (struct critnib_leaf *k = c->limbo_leaf; k;) {
+        struct critnib_leaf *kk = k->next;
+        if (k->to_be_freed) {
+            c->cb_free_leaf(c->leaf_allocator, k->to_be_freed);
+        }
+        umf_ba_free(critnib_leaf_pool, k);
         k = kk;
     }
 
+    for (struct critnib_node *m = c->limbo_node; m;) {
+        struct critnib_node *mm = unfrozen(m->child[0]);
+        umf_ba_free(critnib_node_pool, m);
+        m = mm;
+    }
+
     for (int i = 0; i < DELETED_LIFE; i++) {
-        umf_ba_global_free(c->pending_del_nodes[i]);
+        umf_ba_free(critnib_node_pool, c->pending_del_nodes[i]);
         if (c->cb_free_leaf && c->pending_del_leaves[i]) {
             if (c->pending_del_leaves[i]->value) {
                 c->cb_free_leaf(c->leaf_allocator,
@@ -271,12 +667,45 @@ void critnib_delete(struct critnib *c) {
                                 (void *)c->pending_del_leaves[i]->to_be_freed);
             }
         }
-        umf_ba_global_free(c->pending_del_leaves[i]);
+        umf_ba_free(critnib_leaf_pool, c->pending_del_leaves[i]);
     }
 
     umf_ba_global_free(c);
 }
 
+/*
+ * critnib_memory_usage -- return the size of the memory taken by the nodes
+ * and leaves of the critnib (including the freed ones kept for reuse)
+ */
+size_t critnib_memory_usage(struct critnib *c) {
+    size_t n_nodes, n_leaves;
+    utils_atomic_load_acquire_size_t(&c->n_nodes, &n_nodes);
+    utils_atomic_load_acquire_size_t(&c->n_leaves, &n_leaves);
+
+    return sizeof(struct critnib) + n_nodes * critnib_node_size +
+           n_leaves * critnib_leaf_size;
+}
+
+/*
+ * internal: push_nodes -- add a chain of nodes linked by child[0] to the
+ * pool of freed nodes
+ *
+ * The link is tagged FROZEN, so that all slots of a freed node stay frozen
+ * until the node is reused.
+ */
+static void push_nodes(struct critnib *__restrict c,
+                       struct critnib_node *first, struct critnib_node *last) {
+    struct critnib_node *head;
+
+    utils_atomic_load_acquire_ptr((void **)&c->deleted_node, (void **)&head);
+    do {
+        utils_atomic_store_release_ptr((void **)&last->child[0],
+                                       (void *)((word)head | FROZEN));
+    } while (!utils_compare_exchange_u64((uint64_t *)&c->deleted_node,
+                                         (uint64_t *)&head,
+                                         (uint64_t *)&first));
+}
+
 /*
  * internal: free_node -- free (to internal pool, not malloc) a node.
  *
@@ -292,21 +721,46 @@ static void free_node(struct critnib *__restrict c,
     }
 
     ASSERT(!is_leaf(n));
-    utils_atomic_store_release_ptr((void **)&n->child[0], c->deleted_node);
-    utils_atomic_store_release_ptr((void **)&c->deleted_node, n);
+    push_nodes(c, n, n);
 }
 
 /*
  * internal: alloc_node -- allocate a node from our pool or from malloc
+ *
+ * Concurrent inserts pop from the pool, and popping a single node with a
+ * cmpxchg is prone to ABA.  Thus the whole pool is detached instead, and
+ * all but the first node are given back.  An insert that finds the pool
+ * detached by another one just falls back to malloc.
  */
 static struct critnib_node *alloc_node(struct critnib *__restrict c) {
-    if (!c->deleted_node) {
-        return umf_ba_global_alloc(sizeof(struct critnib_node));
-    }
+    struct critnib_node *n;
+    struct critnib_node *empty = NULL;
 
-    struct critnib_node *n = c->deleted_node;
+    utils_atomic_load_acquire_ptr((void **)&c->deleted_node, (void **)&n);
+    do {
+        if (!n) {
+            n = umf_ba_alloc(critnib_node_pool);
+            if (n) {
+                utils_atomic_increment_size_t(&c->n_nodes);
+            }
+            return n;
+        }
+    } while (!utils_compare_exchange_u64((uint64_t *)&c->deleted_node,
+                                         (uint64_t *)&n, (uint64_t *)&empty));
+
+    struct critnib_node *rest = load_child(&n->child[0]);
+    if (rest && !utils_compare_exchange_u64((uint64_t *)&c->deleted_node,
+                                            (uint64_t *)&empty,
+                                            (uint64_t *)&rest)) {
+        // some nodes were freed meanwhile - append them to the rest
+        struct critnib_node *last = rest;
+        struct critnib_node *next;
+        while ((next = load_child(&last->child[0])) != NULL) {
+            last = next;
+        }
+        push_nodes(c, rest, last);
+    }
 
-    c->deleted_node = n->child[0];
     utils_annotate_memory_new(n, sizeof(*n));
 
     return n;
@@ -337,26 +791,153 @@ static void free_leaf(struct critnib *__restrict c,
         return;
     }
 
-    // k should be added to the c->deleted_leaf list here
-    // or in critnib_release() when the reference count drops to 0.
-    utils_atomic_store_release_u8(&k->pending_deleted_leaf, 1);
+    add_to_deleted_leaf_list(c, k);
+}
 
-    if (c->cb_free_leaf) {
-        uint64_t ref_count;
-        utils_atomic_load_acquire_u64(&k->ref_count, &ref_count);
-        if (ref_count > 0) {
-            // k will be added to the c->deleted_leaf list in critnib_release()
-            // when the reference count drops to 0.
-            return;
+/*
+ * internal: retire_leaf -- free a removed leaf past its grace period
+ *
+ * The leaf is kept in the limbo list (under the lock) while it or its value
+ * may still be seen by another thread, see EPOCH RECLAMATION.
+ */
+static void retire_leaf(struct critnib *__restrict c,
+                        struct critnib_leaf *__restrict k, uint64_t epoch) {
+    if (!k) {
+        return;
+    }
+
+    if (!is_reclaimable(k->retire_epoch, epoch)) {
+        k->next = c->limbo_leaf;
+        c->limbo_leaf = k;
+        c->limbo_count++;
+        return;
+    }
+
+    if (k->to_be_freed) {
+        c->cb_free_leaf(c->leaf_allocator, k->to_be_freed);
+        k->to_be_freed = NULL;
+    }
+
+    add_to_deleted_leaf_list(c, k);
+}
+
+/*
+ * internal: retire_node -- free a removed node past its grace period
+ *
+ * See retire_leaf().  The node is linked by child[0] tagged FROZEN, so that
+ * all its slots stay frozen.
+ */
+static void retire_node(struct critnib *__restrict c,
+                        struct critnib_node *__restrict n, uint64_t epoch) {
+    if (!n) {
+        return;
+    }
+
+    if (!is_reclaimable(n->retire_epoch, epoch)) {
+        utils_atomic_store_release_ptr((void **)&n->child[0],
+                                       (void *)((word)c->limbo_node | FROZEN));
+        c->limbo_node = n;
+        c->limbo_count++;
+        return;
+    }
+
+    free_node(c, n);
+}
+
+/*
+ * internal: reclaim_limbo -- free the leaves (and their values) and nodes
+ * in the limbo list which cannot be seen by any thread anymore
+ */
+static void reclaim_limbo(struct critnib *__restrict c, uint64_t epoch) {
+    struct critnib_leaf **prev = &c->limbo_leaf;
+    while (*prev) {
+        struct critnib_leaf *k = *prev;
+        if (!is_reclaimable(k->retire_epoch, epoch)) {
+            prev = (struct critnib_leaf **)&k->next;
+            continue;
+        }
+
+        *prev = k->next;
+        c->limbo_count--;
+        retire_leaf(c, k, epoch);
+    }
+
+    struct critnib_node *prev_node = NULL;
+    struct critnib_node *n = c->limbo_node;
+    while (n) {
+        struct critnib_node *next = load_child(&n->child[0]);
+        if (!is_reclaimable(n->retire_epoch, epoch)) {
+            prev_node = n;
+            n = next;
+            continue;
+        }
+
+        if (prev_node) {
+            utils_atomic_store_release_ptr((void **)&prev_node->child[0],
+                                           (void *)((word)next | FROZEN));
+        } else {
+            c->limbo_node = next;
+        }
+
+        c->limbo_count--;
+        free_node(c, n);
+        n = next;
+    }
+}
+
+/*
+ * internal: reclaim_limbo_sync -- try for a while to advance the epoch far
+ * enough to reclaim the limbo list, which has grown over its limit
+ *
+ * If references held by other threads do not let it, the next attempt
+ * is made when the list doubles.
+ */
+static void reclaim_limbo_sync(struct critnib *__restrict c) {
+    for (int i = 0; i < LIMBO_SYNC_ATTEMPTS && c->limbo_count > LIMBO_MAX;
+         i++) {
+        // The remove calling it holds no pointer read from the tree yet,
+        // so it can announce the current epoch again, if its reference
+        // is the only one the thread holds.
+        if (c->cb_free_leaf && epoch_nesting == 1 &&
+            epoch_slot != &epoch_overflow_slot) {
+            uint64_t epoch;
+            utils_atomic_load_acquire_u64(&epoch_global, &epoch);
+            utils_atomic_store_release_u64(&epoch_slot->epoch, epoch);
+            utils_atomic_fence_seq_cst();
+        }
+
+        reclaim_limbo(c, epoch_try_advance());
+    }
+
+    c->limbo_limit =
+        (c->limbo_count > LIMBO_MAX) ? 2 * c->limbo_count : LIMBO_MAX;
+}
+
+/*
+ * internal: reclaim_removed -- free the values of removed leaves and the
+ * leaves and nodes in the limbo list which cannot be seen by any thread
+ * anymore, returns the global epoch
+ *
+ * Called by critnib_remove() under the lock.
+ */
+static uint64_t reclaim_removed(struct critnib *__restrict c) {
+    uint64_t epoch = epoch_try_advance();
+
+    for (int i = 0; c->cb_free_leaf && i < DELETED_LIFE; i++) {
+        struct critnib_leaf *k = c->pending_del_leaves[i];
+        if (k && k->to_be_freed && is_reclaimable(k->retire_epoch, epoch)) {
+            c->cb_free_leaf(c->leaf_allocator, k->to_be_freed);
+            k->to_be_freed = NULL;
         }
     }
 
-    uint8_t expected = 1;
-    uint8_t desired = 0;
-    if (utils_compare_exchange_u8(&k->pending_deleted_leaf, &expected,
-                                  &desired)) {
-        add_to_deleted_leaf_list(c, k);
+    reclaim_limbo(c, epoch);
+
+    if (c->limbo_count > utils_max(c->limbo_limit, LIMBO_MAX)) {
+        reclaim_limbo_sync(c);
     }
+
+    return epoch;
 }
 
 /*
@@ -364,14 +945,45 @@ static void free_leaf(struct critnib *__restrict c,
  */
 static struct critnib_leaf *alloc_leaf(struct critnib *__restrict c) {
     struct critnib_leaf *k;
+    struct critnib_leaf *empty = NULL;
 
+    // detach the whole pool, the same as alloc_node() does
     utils_atomic_load_acquire_ptr((void **)&c->deleted_leaf, (void **)&k);
     do {
         if (!k) {
-            return umf_ba_global_aligned_alloc(sizeof(struct critnib_leaf), 8);
+            k = umf_ba_alloc(critnib_leaf_pool);
+            if (k) {
+                utils_atomic_increment_size_t(&c->n_leaves);
+            }
+            return k;
         }
     } while (!utils_compare_exchange_u64((uint64_t *)&c->deleted_leaf,
-                                         (uint64_t *)&k, (uint64_t *)&k->next));
+                                         (uint64_t *)&k, (uint64_t *)&empty));
+
+    struct critnib_leaf *rest;
+    utils_atomic_load_acquire_ptr(&k->next, (void **)&rest);
+    if (rest && !utils_compare_exchange_u64((uint64_t *)&c->deleted_leaf,
+                                            (uint64_t *)&empty,
+                                            (uint64_t *)&rest)) {
+        // some leaves were freed meanwhile - append them to the rest
+        struct critnib_leaf *last = rest;
+        struct critnib_leaf *next;
+        utils_atomic_load_acquire_ptr(&last->next, (void **)&next);
+        while (next) {
+            last = next;
+            utils_atomic_load_acquire_ptr(&last->next, (void **)&next);
+        }
+
+        struct critnib_leaf *head;
+        utils_atomic_load_acquire_ptr((void **)&c->deleted_leaf,
+                                      (void **)&head);
+        utils_atomic_store_release_ptr(&last->next, head);
+        while (!utils_compare_exchange_u64((uint64_t *)&c->deleted_leaf,
+                                           (uint64_t *)&last->next,
+                                           (uint64_t *)&rest)) {
+            ;
+        }
+    }
 
     utils_annotate_memory_new(k, sizeof(*k));
 
@@ -379,22 +991,13 @@ static struct critnib_leaf *alloc_leaf(struct critnib *__restrict c) {
 }
 
 /*
- * critnib_insert -- write a key:value pair to the critnib structure
- *
- * Returns:
- *  • 0 on success
- *  • EEXIST if such a key already exists
- *  • ENOMEM if we're out of memory
+ * internal: insert_leaf -- write a key:value pair to the critnib structure
  *
- * Takes a global write lock but doesn't stall any readers.
+ * An update must be called under the lock, see critnib_insert().
  */
-int critnib_insert(struct critnib *c, word key, void *value, int update) {
-    utils_mutex_lock(&c->mutex);
-
+static int insert_leaf(struct critnib *c, word key, void *value, int update) {
     struct critnib_leaf *k = alloc_leaf(c);
     if (!k) {
-        utils_mutex_unlock(&c->mutex);
-
         return ENOMEM;
     }
 
@@ -403,42 +1006,47 @@ int critnib_insert(struct critnib *c, word key, void *value, int update) {
     utils_atomic_store_release_ptr(&k->to_be_freed, 0);
     utils_atomic_store_release_ptr((void **)&k->key, (void *)key);
     utils_atomic_store_release_ptr(&k->value, value);
-    utils_atomic_store_release_u8(&k->pending_deleted_leaf, 0);
-
-    if (c->cb_free_leaf) {
-        // mark the leaf as valid (ref_count == 2)
-        utils_atomic_store_release_u64(&k->ref_count, LEAF_VALID);
-    } else {
-        // the reference counter is not used in this case
-        utils_atomic_store_release_u64(&k->ref_count, 0ULL);
-    }
 
     struct critnib_node *kn = (void *)((word)k | 1);
 
-    struct critnib_node *n = c->root;
-    if (!n) {
-        utils_atomic_store_release_ptr((void **)&c->root, kn);
-        utils_mutex_unlock(&c->mutex);
-        return 0;
-    }
+    // a new node, kept across restarts until it's published
+    struct critnib_node *m = NULL;
+    struct critnib_node **parent;
+    struct critnib_node *n;
+    int ret = 0;
+
+    // no node or leaf seen from now on is reused until the insert is done
+    epoch_enter();
+
+restart:
+    parent = &c->root;
+    n = load_slot(parent);
+
+    while (n && !is_frozen(n) && !is_leaf(n)) {
+        word n_path;
+        sh_t n_shift;
+        utils_atomic_load_acquire_u8(&n->shift, &n_shift);
+        utils_atomic_load_acquire_u64((uint64_t *)&n->path,
+                                      (uint64_t *)&n_path);
+        if ((key & path_mask(n_shift)) != n_path) {
+            break;
+        }
 
-    struct critnib_node **parent = &c->root;
-    struct critnib_node *prev = c->root;
+        parent = &n->child[slice_index(key, n_shift)];
+        n = load_slot(parent);
+    }
 
-    while (n && !is_leaf(n) && (key & path_mask(n->shift)) == n->path) {
-        prev = n;
-        parent = &n->child[slice_index(key, n->shift)];
-        n = *parent;
+    if (is_frozen(n)) {
+        // the node is being collapsed by a remove
+        goto restart;
     }
 
     if (!n) {
-        n = prev;
-        utils_atomic_store_release_ptr(
-            (void **)&n->child[slice_index(key, n->shift)], kn);
-
-        utils_mutex_unlock(&c->mutex);
+        if (!cas_slot(parent, NULL, kn)) {
+            goto restart;
+        }
 
-        return 0;
+        goto out;
     }
 
     word path;
@@ -446,44 +1054,37 @@ int critnib_insert(struct critnib *c, word key, void *value, int update) {
         utils_atomic_load_acquire_u64((uint64_t *)&to_leaf(n)->key,
                                       (uint64_t *)&path);
     } else {
-        path = n->path;
+        utils_atomic_load_acquire_u64((uint64_t *)&n->path, (uint64_t *)&path);
     }
 
     /* Find where the path differs from our key. */
     word at = path ^ key;
     if (!at) {
         ASSERT(is_leaf(n));
-        if (c->cb_free_leaf) {
-            // mark the leaf as not used (ref_count == 0)
-            utils_atomic_store_release_u64(&(to_leaf(kn))->ref_count, 0ULL);
-        }
         free_leaf(c, to_leaf(kn));
 
         if (update) {
             utils_atomic_store_release_ptr(&to_leaf(n)->value, value);
-            utils_mutex_unlock(&c->mutex);
-            return 0;
         } else {
-            utils_mutex_unlock(&c->mutex);
-            return EEXIST;
+            ret = EEXIST;
         }
+
+        goto out;
     }
 
     /* and convert that to an index. */
     sh_t sh = utils_msb64(at) & (sh_t) ~(SLICE - 1);
 
-    struct critnib_node *m = alloc_node(c);
     if (!m) {
-        if (c->cb_free_leaf) {
-            // mark the leaf as not used (ref_count == 0)
-            utils_atomic_store_release_u64(&(to_leaf(kn))->ref_count, 0ULL);
+        m = alloc_node(c);
+        if (!m) {
+            free_leaf(c, to_leaf(kn));
+            ret = ENOMEM;
+            goto out;
         }
-        free_leaf(c, to_leaf(kn));
-        utils_mutex_unlock(&c->mutex);
-        return ENOMEM;
-    }
 
-    utils_annotate_memory_no_check(m, sizeof(struct critnib_node));
+        utils_annotate_memory_no_check(m, sizeof(struct critnib_node));
+    }
 
     for (int i = 0; i < SLNODES; i++) {
         utils_atomic_store_release_ptr((void *)&m->child[i], NULL);
@@ -494,11 +1095,141 @@ int critnib_insert(struct critnib *c, word key, void *value, int update) {
     utils_atomic_store_release_u8(&m->shift, sh);
     utils_atomic_store_release_u64((uint64_t *)&m->path, key & path_mask(sh));
 
-    utils_atomic_store_release_ptr((void **)parent, m);
+    if (!cas_slot(parent, n, m)) {
+        goto restart;
+    }
+
+    m = NULL; // published
+
+out:
+    epoch_exit();
+
+    if (m) {
+        free_node(c, m);
+    }
+
+    return ret;
+}
+
+/*
+ * critnib_insert -- write a key:value pair to the critnib structure
+ *
+ * Returns:
+ *  • 0 on success
+ *  • EEXIST if such a key already exists
+ *  • ENOMEM if we're out of memory
+ *
+ * Lock-free unless update is set, doesn't stall any readers.
+ */
+int critnib_insert(struct critnib *c, word key, void *value, int update) {
+    if (!update) {
+        return insert_leaf(c, key, value, 0);
+    }
+
+    // an update of the value of a leaf must not race with its removal
+    utils_mutex_lock(&c->mutex);
+    int ret = insert_leaf(c, key, value, 1);
+    utils_mutex_unlock(&c->mutex);
+
+    return ret;
+}
+
+/*
+ * critnib_insert_batch -- write num key:value pairs to the critnib structure
+ *
+ * The pairs are inserted under a single lock, so no remove makes them
+ * restart, and the readers are not stalled.  It stops at the first failure
+ * (see critnib_insert()), whose error is returned in *err.
+ *
+ * Returns the number of inserted pairs.
+ */
+size_t critnib_insert_batch(struct critnib *c, const word *keys,
+                            void *const *values, size_t num, int *err) {
+    size_t i;
+    int ret = 0;
 
+    utils_mutex_lock(&c->mutex);
+    for (i = 0; i < num; i++) {
+        ret = insert_leaf(c, keys[i], values[i], 0);
+        if (ret) {
+            break;
+        }
+    }
     utils_mutex_unlock(&c->mutex);
 
-    return 0;
+    if (err) {
+        *err = ret;
+    }
+
+    return i;
+}
+
+/*
+ * internal: collapse_node -- replace a node left with one child by the child
+ *
+ * Called by critnib_remove() (under the lock) after it removed a child of
+ * the node n, that is pointed to by the n_parent slot.  Returns true if
+ * the node has been detached from the tree.
+ */
+static bool collapse_node(struct critnib *c, word key,
+                          struct critnib_node **n_parent,
+                          struct critnib_node *n) {
+    int nchildren = 0;
+    for (int i = 0; i < SLNODES && nchildren < 2; i++) {
+        if (load_slot(&n->child[i])) {
+            nchildren++;
+        }
+    }
+
+    if (nchildren > 1) {
+        return false;
+    }
+
+    /* Freeze all the slots, so no insert can add a child from now on. */
+    struct critnib_node *only = NULL;
+    nchildren = 0;
+    for (int i = 0; i < SLNODES; i++) {
+        struct critnib_node *m = load_slot(&n->child[i]);
+        struct critnib_node *frozen;
+        do {
+            frozen = (void *)((word)m | FROZEN);
+        } while (!utils_compare_exchange_u64((uint64_t *)&n->child[i],
+                                             (uint64_t *)&m,
+                                             (uint64_t *)&frozen));
+
+        if (m) {
+            nchildren++;
+            only = m;
+        }
+    }
+
+    ASSERT(nchildren > 0);
+
+    if (nchildren > 1) {
+        /* An insert added a child meanwhile - keep the node. */
+        for (int i = 0; i < SLNODES; i++) {
+            utils_atomic_store_release_ptr((void **)&n->child[i],
+                                           load_child(&n->child[i]));
+        }
+
+        return false;
+    }
+
+    while (!cas_slot(n_parent, n, only)) {
+        /*
+         * An insert has put a new node above n - find the new parent slot.
+         * Only removes detach nodes, so n is still reachable by the key.
+         */
+        n_parent = &c->root;
+        struct critnib_node *p = load_slot(n_parent);
+        while (p != n) {
+            ASSERT(p && !is_leaf(p) && !is_frozen(p));
+            n_parent = &p->child[slice_index(key, p->shift)];
+            p = load_slot(n_parent);
+        }
+    }
+
+    return true;
 }
 
 /*
@@ -521,9 +1252,14 @@ void *critnib_remove(struct critnib *c, word key, void **ref) {
         *ref = NULL;
     }
 
+    if (c->cb_free_leaf) {
+        // the reference to the removed value
+        epoch_enter();
+    }
+
     utils_mutex_lock(&c->mutex);
 
-    struct critnib_node *n = c->root;
+    struct critnib_node *n = load_slot(&c->root);
     if (!n) {
         goto not_found;
     }
@@ -531,16 +1267,26 @@ void *critnib_remove(struct critnib *c, word key, void **ref) {
     word del =
         (utils_atomic_increment_u64(&c->remove_count) - 1) % DELETED_LIFE;
 
-    free_node(c, c->pending_del_nodes[del]);
-    free_leaf(c, c->pending_del_leaves[del]);
+    uint64_t epoch = reclaim_removed(c);
+    retire_node(c, c->pending_del_nodes[del], epoch);
+    retire_leaf(c, c->pending_del_leaves[del], epoch);
     c->pending_del_nodes[del] = NULL;
     c->pending_del_leaves[del] = NULL;
 
+restart:
+    n = load_slot(&c->root);
+    if (!n) {
+        goto not_found;
+    }
+
     if (is_leaf(n)) {
         k = to_leaf(n);
         utils_atomic_load_acquire_u64((uint64_t *)&k->key, (uint64_t *)&kkey);
         if (kkey == key) {
-            utils_atomic_store_release_ptr((void **)&c->root, NULL);
+            if (!cas_slot(&c->root, n, NULL)) {
+                // an insert has put a node above the leaf
+                goto restart;
+            }
             goto del_leaf;
         }
 
@@ -558,7 +1304,7 @@ void *critnib_remove(struct critnib *c, word key, void **ref) {
         n_parent = k_parent;
         n = kn;
         k_parent = &kn->child[slice_index(key, kn->shift)];
-        kn = *k_parent;
+        kn = load_slot(k_parent);
 
         if (!kn) {
             goto not_found;
@@ -571,26 +1317,16 @@ void *critnib_remove(struct critnib *c, word key, void **ref) {
         goto not_found;
     }
 
-    utils_atomic_store_release_ptr(
-        (void **)&n->child[slice_index(key, n->shift)], NULL);
+    if (!cas_slot(k_parent, kn, NULL)) {
+        // an insert has put a node above the leaf
+        goto restart;
+    }
 
     /* Remove the node if there's only one remaining child. */
-    int ochild = -1;
-    for (int i = 0; i < SLNODES; i++) {
-        if (n->child[i]) {
-            if (ochild != -1) {
-                goto del_leaf;
-            }
-
-            ochild = i;
-        }
+    if (collapse_node(c, key, n_parent, n)) {
+        c->pending_del_nodes[del] = n;
     }
 
-    ASSERTne(ochild, -1);
-
-    utils_atomic_store_release_ptr((void **)n_parent, n->child[ochild]);
-    c->pending_del_nodes[del] = n;
-
 del_leaf:
     value = k->value;
     if (c->cb_free_leaf) {
@@ -598,68 +1334,58 @@ del_leaf:
         utils_atomic_store_release_ptr(&k->value, NULL);
         *ref = k;
     }
+
+    k->retire_epoch = epoch_current();
+    if (c->pending_del_nodes[del]) {
+        c->pending_del_nodes[del]->retire_epoch = k->retire_epoch;
+    }
     c->pending_del_leaves[del] = k;
 
+    utils_mutex_unlock(&c->mutex);
+    return value;
+
 not_found:
     utils_mutex_unlock(&c->mutex);
+    if (c->cb_free_leaf) {
+        epoch_exit();
+    }
     return value;
 }
 
 /*
- * critnib_release -- release a reference to a key
+ * critnib_pin -- get a reference keeping all values which are not removed
+ * yet from being freed, until it's released with critnib_release()
+ *
+ * It lets the user read the values from a cache of its own instead of
+ * looking them up. Returns NULL if the values are not freed by the critnib.
  */
-int critnib_release(struct critnib *c, void *ref) {
-    if (!c || !ref || !c->cb_free_leaf) {
-        return -1;
+void *critnib_pin(struct critnib *c) {
+    if (!c || !c->cb_free_leaf) {
+        return NULL;
     }
 
-    struct critnib_leaf *k = (struct critnib_leaf *)ref;
+    epoch_enter();
 
-    uint64_t ref_count;
-    uint64_t ref_desired;
-    /* decrement the reference count */
-    utils_atomic_load_acquire_u64(&k->ref_count, &ref_count);
-    do {
-        if (ref_count < LEAF_VALID) {
-#ifndef NDEBUG
-            LOG_FATAL("critnib_release() was called too many times (ref_count "
-                      "= %llu)\n",
-                      (unsigned long long)ref_count);
-            assert(ref_count >= LEAF_VALID);
-#endif
-            return -1;
-        }
-        ref_desired = ref_count - 1;
-    } while (
-        !utils_compare_exchange_u64(&k->ref_count, &ref_count, &ref_desired));
+    return c;
+}
 
-    if (ref_desired >= LEAF_VALID) {
-        // ref_counter was decremented and it is still valid
-        return 0;
+/*
+ * critnib_release -- release a reference to a key
+ *
+ * The value is not freed here, but by one of the following removes
+ * (see EPOCH RECLAMATION).
+ */
+int critnib_release(struct critnib *c, void *ref) {
+    if (!c || !ref || !c->cb_free_leaf) {
+        return -1;
     }
 
-    /* ref_counter == (LEAF_VALID - 1)) - the leaf will be freed */
-    void *to_be_freed = NULL;
-    utils_atomic_load_acquire_ptr(&k->to_be_freed, &to_be_freed);
-    utils_atomic_store_release_ptr(&k->to_be_freed, NULL);
+    if (epoch_exit()) {
 #ifndef NDEBUG
-    if (to_be_freed == NULL) {
-        LOG_FATAL("leaf will not be freed (to_be_freed == NULL, value = %p)\n",
-                  k->value);
-        assert(to_be_freed != NULL);
-    }
+        LOG_FATAL("critnib_release() was called too many times\n");
+        assert(0);
 #endif
-
-    // mark the leaf as not used (ref_count == 0)
-    utils_atomic_store_release_u64(&k->ref_count, 0ULL);
-
-    c->cb_free_leaf(c->leaf_allocator, to_be_freed);
-
-    uint8_t expected = 1;
-    uint8_t desired = 0;
-    if (utils_compare_exchange_u8(&k->pending_deleted_leaf, &expected,
-                                  &desired)) {
-        add_to_deleted_leaf_list(c, k);
+        return -1;
     }
 
     return 0;
@@ -680,26 +1406,6 @@ int critnib_remove_release(struct critnib *c, word key) {
     return (value) ? 0 : -1;
 }
 
-/*
- * Check if the leaf has just been removed (i.e. if ref_count == 0).
- * If so, we return -1 (failure), otherwise increment the reference
- * counter and return 0 (success).
- */
-static inline int increment_ref_count(struct critnib_leaf *k) {
-    uint64_t expected;
-    uint64_t desired;
-
-    utils_atomic_load_acquire_u64(&k->ref_count, &expected);
-    do {
-        if (expected < LEAF_VALID) {
-            return -1;
-        }
-        desired = expected + 1;
-    } while (!utils_compare_exchange_u64(&k->ref_count, &expected, &desired));
-
-    return 0;
-}
-
 /*
  * critnib_get -- query for a key ("==" match), returns value or NULL
  *
@@ -730,6 +1436,10 @@ void *critnib_get(struct critnib *c, word key, void **ref) {
         *ref = NULL;
     }
 
+    if (c->cb_free_leaf) {
+        epoch_enter();
+    }
+
     do {
         utils_atomic_load_acquire_u64(&c->remove_count, &wrs1);
         utils_atomic_load_acquire_ptr((void **)&c->root, (void **)&n);
@@ -741,8 +1451,7 @@ void *critnib_get(struct critnib *c, word key, void **ref) {
 		 */
         while (n && !is_leaf(n)) {
             utils_atomic_load_acquire_u8(&n->shift, &shift);
-            utils_atomic_load_acquire_ptr(
-                (void **)&n->child[slice_index(key, shift)], (void **)&n);
+            n = load_child(&n->child[slice_index(key, shift)]);
         }
 
         /* ... as we check it at the end. */
@@ -758,12 +1467,12 @@ void *critnib_get(struct critnib *c, word key, void **ref) {
         utils_atomic_load_acquire_u64(&c->remove_count, &wrs2);
     } while (wrs1 + DELETED_LIFE <= wrs2);
 
-    if (c->cb_free_leaf && res) {
-        if (increment_ref_count(k)) {
-            return NULL;
+    if (c->cb_free_leaf) {
+        if (res) {
+            *ref = k;
+        } else {
+            epoch_exit();
         }
-
-        *ref = k;
     }
 
     return res;
@@ -778,7 +1487,7 @@ find_predecessor(struct critnib_node *__restrict n) {
         int nib;
         for (nib = NIB; nib >= 0; nib--) {
             struct critnib_node *m;
-            utils_atomic_load_acquire_ptr((void **)&n->child[nib], (void **)&m);
+            m = load_child(&n->child[nib]);
             if (m) {
                 break;
             }
@@ -788,7 +1497,7 @@ find_predecessor(struct critnib_node *__restrict n) {
             return NULL;
         }
 
-        utils_atomic_load_acquire_ptr((void **)&n->child[nib], (void **)&n);
+        n = load_child(&n->child[nib]);
 
         if (!n) {
             return NULL;
@@ -848,7 +1557,7 @@ static struct critnib_leaf *find_le(struct critnib_node *__restrict n,
     /* recursive call: follow the path */
     {
         struct critnib_node *m;
-        utils_atomic_load_acquire_ptr((void **)&n->child[nib], (void **)&m);
+        m = load_child(&n->child[nib]);
         struct critnib_leaf *k = find_le(m, key);
         if (k) {
             return k;
@@ -862,7 +1571,7 @@ static struct critnib_leaf *find_le(struct critnib_node *__restrict n,
 	 */
     for (; nib > 0; nib--) {
         struct critnib_node *m;
-        utils_atomic_load_acquire_ptr((void **)&n->child[nib - 1], (void **)&m);
+        m = load_child(&n->child[nib - 1]);
         if (m) {
             n = m;
             if (is_leaf(n)) {
@@ -898,6 +1607,10 @@ void *critnib_find_le(struct critnib *c, word key, void **ref) {
         *ref = NULL;
     }
 
+    if (c->cb_free_leaf) {
+        epoch_enter();
+    }
+
     do {
         utils_atomic_load_acquire_u64(&c->remove_count, &wrs1);
         struct critnib_node *n; /* avoid a subtle TOCTOU */
@@ -911,12 +1624,12 @@ void *critnib_find_le(struct critnib *c, word key, void **ref) {
         utils_atomic_load_acquire_u64(&c->remove_count, &wrs2);
     } while (wrs1 + DELETED_LIFE <= wrs2);
 
-    if (c->cb_free_leaf && res) {
-        if (increment_ref_count(k)) {
-            return NULL;
+    if (c->cb_free_leaf) {
+        if (res) {
+            *ref = k;
+        } else {
+            epoch_exit();
         }
-
-        *ref = k;
     }
 
     return res;
@@ -930,7 +1643,7 @@ static struct critnib_leaf *find_successor(struct critnib_node *__restrict n) {
         unsigned nib;
         for (nib = 0; nib <= NIB; nib++) {
             struct critnib_node *m;
-            utils_atomic_load_acquire_ptr((void **)&n->child[nib], (void **)&m);
+            m = load_child(&n->child[nib]);
             if (m) {
                 break;
             }
@@ -940,7 +1653,7 @@ static struct critnib_leaf *find_successor(struct critnib_node *__restrict n) {
             return NULL;
         }
 
-        utils_atomic_load_acquire_ptr((void **)&n->child[nib], (void **)&n);
+        n = load_child(&n->child[nib]);
 
         if (!n) {
             return NULL;
@@ -980,7 +1693,7 @@ static struct critnib_leaf *find_ge(struct critnib_node *__restrict n,
     unsigned nib = slice_index(key, n->shift);
     {
         struct critnib_node *m;
-        utils_atomic_load_acquire_ptr((void **)&n->child[nib], (void **)&m);
+        m = load_child(&n->child[nib]);
         struct critnib_leaf *k = find_ge(m, key);
         if (k) {
             return k;
@@ -989,7 +1702,7 @@ static struct critnib_leaf *find_ge(struct critnib_node *__restrict n,
 
     for (; nib < NIB; nib++) {
         struct critnib_node *m;
-        utils_atomic_load_acquire_ptr((void **)&n->child[nib + 1], (void **)&m);
+        m = load_child(&n->child[nib + 1]);
         if (m) {
             n = m;
             if (is_leaf(n)) {
@@ -1038,6 +1751,10 @@ int critnib_find(struct critnib *c, uintptr_t key, enum find_dir_t dir,
         key++;
     }
 
+    if (c->cb_free_leaf) {
+        epoch_enter();
+    }
+
     do {
         utils_atomic_load_acquire_u64(&c->remove_count, &wrs1);
         struct critnib_node *n;
@@ -1049,9 +1766,7 @@ int critnib_find(struct critnib *c, uintptr_t key, enum find_dir_t dir,
             k = find_ge(n, key);
         } else {
             while (n && !is_leaf(n)) {
-                utils_atomic_load_acquire_ptr(
-                    (void **)&n->child[slice_index(key, n->shift)],
-                    (void **)&n);
+                n = load_child(&n->child[slice_index(key, n->shift)]);
             }
 
             word kkey;
@@ -1068,12 +1783,9 @@ int critnib_find(struct critnib *c, uintptr_t key, enum find_dir_t dir,
         utils_atomic_load_acquire_u64(&c->remove_count, &wrs2);
     } while (wrs1 + DELETED_LIFE <= wrs2);
 
-    if (k) {
+    // the value of a leaf that has just been removed is NULL
+    if (k && (_rvalue || !c->cb_free_leaf)) {
         if (c->cb_free_leaf) {
-            if (increment_ref_count(k)) {
-                return 0;
-            }
-
             *ref = k;
         }
 
@@ -1086,6 +1798,10 @@ int critnib_find(struct critnib *c, uintptr_t key, enum find_dir_t dir,
         return 1;
     }
 
+    if (c->cb_free_leaf) {
+        epoch_exit();
+    }
+
     return 0;
 }
 
@@ -1117,7 +1833,7 @@ static int iter(struct critnib_node *__restrict n, word min, word max,
     }
 
     for (int i = 0; i < SLNODES; i++) {
-        struct critnib_node *__restrict m = n->child[i];
+        struct critnib_node *__restrict m = load_child(&n->child[i]);
         if (m && iter(m, min, max, func, privdata)) {
             return 1;
         }
@@ -10,6 +10,7 @@
 #ifndef UMF_CRITNIB_H
 #define UMF_CRITNIB_H 1
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -30,8 +31,11 @@ enum find_dir_t {
 
 critnib *critnib_new(free_leaf_t cb_free_leaf, void *leaf_allocator);
 void critnib_delete(critnib *c);
+size_t critnib_memory_usage(critnib *c);
 
 int critnib_insert(critnib *c, uintptr_t key, void *value, int update);
+size_t critnib_insert_batch(critnib *c, const uintptr_t *keys,
+                            void *const *values, size_t num, int *err);
 void critnib_iter(critnib *c, uintptr_t min, uintptr_t max,
                   int (*func)(uintptr_t key, void *value, void *privdata),
                   void *privdata);
@@ -43,17 +47,24 @@ int critnib_remove_release(critnib *c, uintptr_t key);
  * - critnib_get(),
  * - critnib_find_le() and
  * - critnib_find()
+ * (and critnib_pin() keeping all the values not removed yet)
  * return a reference (void *ref) to the returned value,
  * that MUST be released by calling critnib_release()
  * when it is no longer used and can be freed using the cb_free_leaf() callback.
+ * The reference has to be released by the same thread that got it.
  */
 void *critnib_remove(critnib *c, uintptr_t key, void **ref);
 void *critnib_get(critnib *c, uintptr_t key, void **ref);
 void *critnib_find_le(critnib *c, uintptr_t key, void **ref);
 int critnib_find(critnib *c, uintptr_t key, enum find_dir_t dir,
                  uintptr_t *rkey, void **rvalue, void **ref);
+void *critnib_pin(critnib *c);
 int critnib_release(struct critnib *c, void *ref);
 
+// Deletes the TLS key giving epoch slots back on thread exit.
+// Called once by umfTearDown(); threads exiting later keep their slots.
+void critnib_global_teardown(void);
+
 #ifdef __cplusplus
 }
 #endif
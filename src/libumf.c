@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include "base_alloc_global.h"
+#include "critnib.h"
 #include "ctl/ctl_internal.h"
 #include "ipc_cache.h"
 #include "libumf.h"
@@ -36,7 +37,8 @@ static UTIL_ONCE_FLAG initMutexOnce = UTIL_ONCE_FLAG_INIT;
 static void initialize_init_mutex(void) { utils_mutex_init(&initMutex); }
 
 static umf_ctl_node_t CTL_NODE(umf)[] = {CTL_CHILD(provider), CTL_CHILD(pool),
-                                         CTL_CHILD(logger), CTL_NODE_END};
+                                         CTL_CHILD(logger), CTL_CHILD(tracker),
+                                         CTL_NODE_END};
 
 void initialize_ctl(void) {
     ctl_init(umf_ba_global_alloc, umf_ba_global_free);
@@ -134,6 +136,7 @@ umf_result_t umfTearDown(void) {
         LOG_DEBUG("UMF base allocator destroyed");
 
     fini_umfTearDown:
+        critnib_global_teardown();
         fini_ze_global_state();
         fini_cu_global_state();
         fini_tbb_global_state();
@@ -278,6 +278,46 @@ static umf_result_t CTL_SUBTREE_HANDLER(default)(
     return UMF_RESULT_SUCCESS;
 }
 
+// index of the statistics shard of the calling thread, 0 if not assigned yet
+static __TLS size_t stats_shard_idx = 0;
+static size_t stats_shard_next = 0;
+
+static umf_pool_stats_shard_t *
+pool_stats_shard(umf_memory_pool_handle_t hPool) {
+    size_t idx = stats_shard_idx;
+    if (idx == 0) {
+        // assign shards to threads round-robin
+        idx = utils_atomic_increment_size_t(&stats_shard_next);
+        stats_shard_idx = idx;
+    }
+
+    return &hPool->stats.shards[(idx - 1) % UMF_POOL_STATS_SHARDS];
+}
+
+static void pool_stats_add_alloc_count(umf_memory_pool_handle_t hPool,
+                                       size_t num) {
+    utils_fetch_and_add_size_t(&pool_stats_shard(hPool)->alloc_count, num);
+}
+
+static void pool_stats_sub_alloc_count(umf_memory_pool_handle_t hPool,
+                                       size_t num) {
+    utils_fetch_and_sub_size_t(&pool_stats_shard(hPool)->alloc_count, num);
+}
+
+static size_t pool_stats_get_alloc_count(umf_memory_pool_handle_t hPool) {
+    // A shard may go "below zero" if memory is allocated and freed by
+    // different threads, but the unsigned sum over all shards is exact.
+    size_t total = 0;
+    for (size_t i = 0; i < UMF_POOL_STATS_SHARDS; i++) {
+        size_t count = 0;
+        utils_atomic_load_acquire_size_t(&hPool->stats.shards[i].alloc_count,
+                                         &count);
+        total += count;
+    }
+
+    return total;
+}
+
 static umf_result_t
 CTL_READ_HANDLER(alloc_count)(void *ctx, umf_ctl_query_source_t source,
                               void *arg, size_t size,
@@ -293,7 +333,7 @@ CTL_READ_HANDLER(alloc_count)(void *ctx, umf_ctl_query_source_t source,
     assert(size == sizeof(size_t));
 
     umf_memory_pool_handle_t pool = (umf_memory_pool_handle_t)ctx;
-    utils_atomic_load_acquire_size_t(&pool->stats.alloc_count, arg_out);
+    *arg_out = pool_stats_get_alloc_count(pool);
     return UMF_RESULT_SUCCESS;
 }
 
@@ -465,7 +505,8 @@ static umf_result_t umfDefaultTrimMemory(void *provider,
 
 // logical sum (OR) of all umf_pool_create_flags_t flags
 static const umf_pool_create_flags_t UMF_POOL_CREATE_FLAG_ALL =
-    UMF_POOL_CREATE_FLAG_OWN_PROVIDER | UMF_POOL_CREATE_FLAG_DISABLE_TRACKING;
+    UMF_POOL_CREATE_FLAG_OWN_PROVIDER | UMF_POOL_CREATE_FLAG_DISABLE_TRACKING |
+    UMF_POOL_CREATE_FLAG_COARSE_TRACKING;
 
 // windows do not allow to use uninitialized va_list so this function help us to initialize it.
 static umf_result_t default_ctl_helper(const umf_memory_pool_ops_t *ops,
@@ -494,6 +535,12 @@ static umf_result_t umfPoolCreateInternal(const umf_memory_pool_ops_t *ops,
         return UMF_RESULT_ERROR_INVALID_ARGUMENT;
     }
 
+    if ((flags & UMF_POOL_CREATE_FLAG_DISABLE_TRACKING) &&
+        (flags & UMF_POOL_CREATE_FLAG_COARSE_TRACKING)) {
+        LOG_ERR("Coarse tracking cannot be enabled with tracking disabled");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
     umf_result_t ret = UMF_RESULT_SUCCESS;
 
     umf_memory_pool_ops_t compatible_ops;
@@ -516,15 +563,17 @@ static umf_result_t umfPoolCreateInternal(const umf_memory_pool_ops_t *ops,
         ops = &compatible_ops;
     }
 
-    umf_memory_pool_handle_t pool =
-        umf_ba_global_alloc(sizeof(umf_memory_pool_t));
+    umf_memory_pool_handle_t pool = umf_ba_global_aligned_alloc(
+        sizeof(umf_memory_pool_t), CACHE_LINE_SIZE);
     if (!pool) {
         return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
     }
 
     if (!(flags & UMF_POOL_CREATE_FLAG_DISABLE_TRACKING)) {
         // Wrap provider with memory tracking provider.
-        ret = umfTrackingMemoryProviderCreate(provider, pool, &pool->provider);
+        ret = umfTrackingMemoryProviderCreate(
+            provider, pool, flags & UMF_POOL_CREATE_FLAG_COARSE_TRACKING,
+            &pool->provider);
         if (ret != UMF_RESULT_SUCCESS) {
             goto err_provider_create;
         }
@@ -702,7 +751,7 @@ void *umfPoolMalloc(umf_memory_pool_handle_t hPool, size_t size) {
         return NULL;
     }
 
-    utils_atomic_increment_size_t(&hPool->stats.alloc_count);
+    pool_stats_add_alloc_count(hPool, 1);
     return ret;
 }
 
@@ -714,7 +763,7 @@ void *umfPoolAlignedMalloc(umf_memory_pool_handle_t hPool, size_t size,
         return NULL;
     }
 
-    utils_atomic_increment_size_t(&hPool->stats.alloc_count);
+    pool_stats_add_alloc_count(hPool, 1);
     return ret;
 }
 
@@ -725,7 +774,7 @@ void *umfPoolCalloc(umf_memory_pool_handle_t hPool, size_t num, size_t size) {
         return NULL;
     }
 
-    utils_atomic_increment_size_t(&hPool->stats.alloc_count);
+    pool_stats_add_alloc_count(hPool, 1);
     return ret;
 }
 
@@ -733,9 +782,9 @@ void *umfPoolRealloc(umf_memory_pool_handle_t hPool, void *ptr, size_t size) {
     UMF_CHECK((hPool != NULL), NULL);
     void *ret = hPool->ops.realloc(hPool->pool_priv, ptr, size);
     if (size == 0 && ret == NULL && ptr != NULL) { // this is free(ptr)
-        utils_atomic_decrement_size_t(&hPool->stats.alloc_count);
+        pool_stats_sub_alloc_count(hPool, 1);
     } else if (ptr == NULL && ret != NULL) { // this is malloc(size)
-        utils_atomic_increment_size_t(&hPool->stats.alloc_count);
+        pool_stats_add_alloc_count(hPool, 1);
     }
     return ret;
 }
@@ -754,7 +803,7 @@ umf_result_t umfPoolFree(umf_memory_pool_handle_t hPool, void *ptr) {
         return ret;
     }
     if (ptr != NULL) {
-        utils_atomic_decrement_size_t(&hPool->stats.alloc_count);
+        pool_stats_sub_alloc_count(hPool, 1);
     }
     return ret;
 }
@@ -792,6 +841,108 @@ umf_result_t umfPoolTrimMemory(umf_memory_pool_handle_t hPool,
     return hPool->ops.ext_trim_memory(hPool->pool_priv, minBytesToKeep);
 }
 
+umf_result_t umfPoolGetTrackedRegions(umf_memory_pool_handle_t hPool,
+                                      void **cursor, const void *end,
+                                      umf_pool_region_t *regions,
+                                      size_t *count) {
+    UMF_CHECK((cursor != NULL), UMF_RESULT_ERROR_INVALID_ARGUMENT);
+    UMF_CHECK((regions != NULL), UMF_RESULT_ERROR_INVALID_ARGUMENT);
+    UMF_CHECK((count != NULL && *count > 0),
+              UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    uintptr_t start = (uintptr_t)*cursor;
+    uintptr_t stop = end ? (uintptr_t)end : UINTPTR_MAX;
+
+    umf_result_t ret = umfMemoryTrackerGetRegions(TRACKER, hPool, &start,
+                                                  stop, regions, count);
+    if (ret != UMF_RESULT_SUCCESS) {
+        return ret;
+    }
+
+    *cursor = (void *)start;
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t umfPoolMallocBatch(umf_memory_pool_handle_t hPool, size_t size,
+                                size_t num, void **ptrs) {
+    UMF_CHECK((hPool != NULL), UMF_RESULT_ERROR_INVALID_ARGUMENT);
+    UMF_CHECK((num == 0 || ptrs != NULL), UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    if (num == 0) {
+        return UMF_RESULT_SUCCESS;
+    }
+
+    if (hPool->ops.ext_malloc_batch) {
+        umf_result_t ret =
+            hPool->ops.ext_malloc_batch(hPool->pool_priv, size, num, ptrs);
+        if (ret != UMF_RESULT_SUCCESS) {
+            return ret;
+        }
+    } else {
+        for (size_t i = 0; i < num; i++) {
+            ptrs[i] = hPool->ops.malloc(hPool->pool_priv, size);
+            if (ptrs[i] == NULL) {
+                umf_result_t ret =
+                    hPool->ops.get_last_allocation_error(hPool->pool_priv);
+                while (i-- > 0) {
+                    hPool->ops.free(hPool->pool_priv, ptrs[i]);
+                }
+                return ret != UMF_RESULT_SUCCESS
+                           ? ret
+                           : UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+            }
+        }
+    }
+
+    pool_stats_add_alloc_count(hPool, num);
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t umfPoolFreeBatch(umf_memory_pool_handle_t hPool, void **ptrs,
+                              size_t num) {
+    UMF_CHECK((hPool != NULL), UMF_RESULT_ERROR_INVALID_ARGUMENT);
+    UMF_CHECK((num == 0 || ptrs != NULL), UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    size_t freed = 0;
+    for (size_t i = 0; i < num; i++) {
+        if (ptrs[i] != NULL) {
+            freed++;
+        }
+    }
+
+    umf_result_t ret = UMF_RESULT_SUCCESS;
+    if (hPool->ops.ext_free_batch) {
+        ret = hPool->ops.ext_free_batch(hPool->pool_priv, ptrs, num);
+        if (ret != UMF_RESULT_SUCCESS) {
+            // only the blocks which could not be freed are left in ptrs
+            for (size_t i = 0; i < num; i++) {
+                if (ptrs[i] != NULL) {
+                    freed--;
+                }
+            }
+        }
+    } else {
+        for (size_t i = 0; i < num; i++) {
+            if (ptrs[i] == NULL) {
+                continue;
+            }
+            umf_result_t r = hPool->ops.free(hPool->pool_priv, ptrs[i]);
+            if (r != UMF_RESULT_SUCCESS) {
+                // keep freeing the rest, report the first error
+                ret = (ret == UMF_RESULT_SUCCESS) ? r : ret;
+                freed--;
+                continue;
+            }
+            ptrs[i] = NULL;
+        }
+    }
+
+    if (freed) {
+        pool_stats_sub_alloc_count(hPool, freed);
+    }
+    return ret;
+}
+
 void umfPoolCtlDefaultsDestroy(void) {
     utils_init_once(&mem_pool_ctl_initialized, pool_ctl_init);
 
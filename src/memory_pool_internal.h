@@ -25,8 +25,21 @@ extern "C" {
 #include "ctl/ctl_internal.h"
 #include "utils_concurrency.h"
 
-typedef struct umf_pool_stats {
+// Number of shards the pool statistics are split into. Threads are spread
+// over the shards, so the counters updated on every allocation do not
+// bounce a single cache line between all cores. The value of a statistic
+// is the sum over all shards, computed when the statistic is read.
+// Each shard takes a whole cache line, so the pool has to be allocated
+// with the CACHE_LINE_SIZE alignment.
+#define UMF_POOL_STATS_SHARDS 16
+
+typedef struct CACHE_ALIGNED umf_pool_stats_shard_t {
     size_t alloc_count;
+    char padding[CACHE_LINE_SIZE - sizeof(size_t)];
+} umf_pool_stats_shard_t;
+
+typedef struct umf_pool_stats {
+    umf_pool_stats_shard_t shards[UMF_POOL_STATS_SHARDS];
 } umf_pool_stats_t;
 
 typedef struct umf_memory_pool_t {
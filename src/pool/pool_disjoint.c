@@ -87,21 +87,21 @@ CTL_READ_HANDLER(used_memory)(void *ctx, umf_ctl_query_source_t source,
     size_t used_memory = 0;
 
     // Calculate used memory across all buckets
-    for (size_t i = 0; i < pool->buckets_num; i++) {
-        bucket_t *bucket = pool->buckets[i];
+    for (bucket_t *bucket = pool->buckets[0]; bucket != NULL;
+         bucket = bucket_next(bucket)) {
         utils_mutex_lock(&bucket->bucket_lock);
 
         // Count allocated chunks in available slabs
         slab_list_item_t *it;
         for (it = bucket->available_slabs; it != NULL; it = it->next) {
             slab_t *slab = it->val;
-            used_memory += slab->num_chunks_allocated * bucket->size;
+            used_memory += slab_get_num_allocated(slab) * bucket->size;
         }
 
         // Count allocated chunks in unavailable slabs (all chunks allocated)
         for (it = bucket->unavailable_slabs; it != NULL; it = it->next) {
             slab_t *slab = it->val;
-            used_memory += slab->num_chunks_allocated * bucket->size;
+            used_memory += slab_get_num_allocated(slab) * bucket->size;
         }
 
         utils_mutex_unlock(&bucket->bucket_lock);
@@ -125,8 +125,8 @@ CTL_READ_HANDLER(reserved_memory)(void *ctx, umf_ctl_query_source_t source,
     size_t reserved_memory = 0;
 
     // Calculate reserved memory across all buckets
-    for (size_t i = 0; i < pool->buckets_num; i++) {
-        bucket_t *bucket = pool->buckets[i];
+    for (bucket_t *bucket = pool->buckets[0]; bucket != NULL;
+         bucket = bucket_next(bucket)) {
         utils_mutex_lock(&bucket->bucket_lock);
 
         // Count all slabs (both available and unavailable)
@@ -185,8 +185,8 @@ static umf_result_t CTL_READ_HANDLER(count)(void *ctx,
         }                                                                      \
                                                                                \
         size_t total = 0;                                                      \
-        for (size_t i = 0; i < pool->buckets_num; ++i) {                       \
-            bucket_t *bucket = pool->buckets[i];                               \
+        for (bucket_t *bucket = pool->buckets[0]; bucket != NULL;              \
+             bucket = bucket_next(bucket)) {                                   \
             utils_mutex_lock(&bucket->bucket_lock);                            \
             total += bucket->MEMBER;                                           \
             utils_mutex_unlock(&bucket->bucket_lock);                          \
@@ -203,6 +203,7 @@ DEFINE_STATS_HANDLER(curr_slabs_in_use, curr_slabs_in_use)
 DEFINE_STATS_HANDLER(curr_slabs_in_pool, curr_slabs_in_pool)
 DEFINE_STATS_HANDLER(max_slabs_in_use, max_slabs_in_use)
 DEFINE_STATS_HANDLER(max_slabs_in_pool, max_slabs_in_pool)
+DEFINE_STATS_HANDLER(wasted_bytes, wasted_bytes)
 
 static const umf_ctl_node_t CTL_NODE(stats)[] = {
     CTL_LEAF_RO(used_memory),
@@ -214,6 +215,7 @@ static const umf_ctl_node_t CTL_NODE(stats)[] = {
     CTL_LEAF_RO(curr_slabs_in_pool),
     CTL_LEAF_RO(max_slabs_in_use),
     CTL_LEAF_RO(max_slabs_in_pool),
+    CTL_LEAF_RO(wasted_bytes),
 };
 
 #undef DEFINE_STATS_HANDLER
@@ -265,6 +267,7 @@ DEFINE_BUCKET_STATS_HANDLER(curr_slabs_in_use, curr_slabs_in_use)
 DEFINE_BUCKET_STATS_HANDLER(curr_slabs_in_pool, curr_slabs_in_pool)
 DEFINE_BUCKET_STATS_HANDLER(max_slabs_in_use, max_slabs_in_use)
 DEFINE_BUCKET_STATS_HANDLER(max_slabs_in_pool, max_slabs_in_pool)
+DEFINE_BUCKET_STATS_HANDLER(wasted_bytes, wasted_bytes)
 
 static const umf_ctl_node_t CTL_NODE(stats, perBucket)[] = {
     CTL_LEAF_RO(alloc_nr, perBucket),
@@ -274,6 +277,7 @@ static const umf_ctl_node_t CTL_NODE(stats, perBucket)[] = {
     CTL_LEAF_RO(curr_slabs_in_pool, perBucket),
     CTL_LEAF_RO(max_slabs_in_use, perBucket),
     CTL_LEAF_RO(max_slabs_in_pool, perBucket),
+    CTL_LEAF_RO(wasted_bytes, perBucket),
 };
 
 // Not a counter; but it is read exactly like other per-bucket stats, so we can use macro.
@@ -283,6 +287,97 @@ static const umf_ctl_node_t CTL_NODE(buckets)[] = {CTL_LEAF_RO(count),
                                                    CTL_LEAF_RO(size, perBucket),
                                                    CTL_CHILD(stats, perBucket)};
 
+static umf_result_t disjoint_pool_set_tcache_size(disjoint_pool_t *pool,
+                                                  size_t tcache_size);
+
+static umf_result_t
+CTL_READ_HANDLER(tcache_size)(void *ctx, umf_ctl_query_source_t source,
+                              void *arg, size_t size,
+                              umf_ctl_index_utlist_t *indexes) {
+    (void)source, (void)indexes;
+    disjoint_pool_t *pool = (disjoint_pool_t *)ctx;
+
+    if (arg == NULL || size != sizeof(size_t)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    utils_atomic_load_acquire_size_t(&pool->params.tcache_size, (size_t *)arg);
+    return UMF_RESULT_SUCCESS;
+}
+
+static umf_result_t
+CTL_WRITE_HANDLER(tcache_size)(void *ctx, umf_ctl_query_source_t source,
+                               void *arg, size_t size,
+                               umf_ctl_index_utlist_t *indexes) {
+    (void)source, (void)indexes;
+    disjoint_pool_t *pool = (disjoint_pool_t *)ctx;
+
+    if (arg == NULL || size != sizeof(size_t)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    return disjoint_pool_set_tcache_size(pool, *(size_t *)arg);
+}
+
+static const struct ctl_argument CTL_ARG(tcache_size) =
+    CTL_ARG_UNSIGNED_LONG_LONG;
+
+static umf_result_t
+CTL_READ_HANDLER(tcache_max_chunk_size)(void *ctx,
+                                        umf_ctl_query_source_t source,
+                                        void *arg, size_t size,
+                                        umf_ctl_index_utlist_t *indexes) {
+    (void)source, (void)indexes;
+    disjoint_pool_t *pool = (disjoint_pool_t *)ctx;
+
+    if (arg == NULL || size != sizeof(size_t)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    *(size_t *)arg = pool->params.tcache_max_chunk_size;
+    return UMF_RESULT_SUCCESS;
+}
+
+static umf_result_t disjoint_pool_set_decay_ms(disjoint_pool_t *pool,
+                                               size_t decay_ms);
+
+static umf_result_t
+CTL_READ_HANDLER(decay_ms)(void *ctx, umf_ctl_query_source_t source,
+                           void *arg, size_t size,
+                           umf_ctl_index_utlist_t *indexes) {
+    (void)source, (void)indexes;
+    disjoint_pool_t *pool = (disjoint_pool_t *)ctx;
+
+    if (arg == NULL || size != sizeof(size_t)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    utils_atomic_load_acquire_size_t(&pool->params.decay_ms, (size_t *)arg);
+    return UMF_RESULT_SUCCESS;
+}
+
+static umf_result_t
+CTL_WRITE_HANDLER(decay_ms)(void *ctx, umf_ctl_query_source_t source,
+                            void *arg, size_t size,
+                            umf_ctl_index_utlist_t *indexes) {
+    (void)source, (void)indexes;
+    disjoint_pool_t *pool = (disjoint_pool_t *)ctx;
+
+    if (arg == NULL || size != sizeof(size_t)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    return disjoint_pool_set_decay_ms(pool, *(size_t *)arg);
+}
+
+static const struct ctl_argument CTL_ARG(decay_ms) = CTL_ARG_UNSIGNED_LONG_LONG;
+
+static const umf_ctl_node_t CTL_NODE(params)[] = {
+    CTL_LEAF_RW(tcache_size),
+    CTL_LEAF_RO(tcache_max_chunk_size),
+    CTL_LEAF_RW(decay_ms),
+};
+
 static int bucket_id_parser(const void *arg, void *dest, size_t dest_size) {
     size_t *out = (size_t *)dest;
 
@@ -307,6 +402,7 @@ static const struct ctl_argument CTL_ARG(buckets) = {
 
 static void initialize_disjoint_ctl(void) {
     CTL_REGISTER_MODULE(&disjoint_ctl_root, stats);
+    CTL_REGISTER_MODULE(&disjoint_ctl_root, params);
     CTL_REGISTER_MODULE(&disjoint_ctl_root, buckets);
     // TODO: this is hack. Need some way to register module as node with argument
     disjoint_ctl_root.root[disjoint_ctl_root.first_free - 1].arg =
@@ -334,9 +430,10 @@ umf_result_t disjoint_pool_ctl(void *hPool,
 
 // Forward declarations
 static void bucket_update_stats(bucket_t *bucket, int in_use, int in_pool);
-static bool bucket_can_pool(bucket_t *bucket);
+static bool bucket_can_pool(bucket_t *bucket, slab_t *slab);
 static slab_list_item_t *bucket_get_avail_slab(bucket_t *bucket,
                                                bool *from_pool);
+static slab_t *bucket_create_slab(bucket_t *bucket);
 
 static __TLS umf_result_t TLS_last_allocation_error;
 
@@ -368,6 +465,18 @@ static size_t bucket_slab_alloc_size(bucket_t *bucket) {
     return utils_max(bucket->size, bucket_slab_min_size(bucket));
 }
 
+static size_t bucket_slab_alignment(bucket_t *bucket) {
+    // NOTE: slabs of the regular buckets are allocated without alignment
+    // unless naturally aligned slabs are enabled, the aligned buckets need
+    // their chunks to be aligned as well
+    size_t alignment = bucket->alignment;
+    if (bucket->pool->slab_addr_mask) {
+        alignment = utils_max(alignment, bucket_slab_min_size(bucket));
+    }
+
+    return alignment;
+}
+
 static slab_t *create_slab(bucket_t *bucket) {
     assert(bucket);
 
@@ -381,15 +490,33 @@ static slab_t *create_slab(bucket_t *bucket) {
     size_t num_words =
         (num_chunks_total + CHUNK_BITMAP_SIZE - 1) / CHUNK_BITMAP_SIZE;
 
-    slab_t *slab = umf_ba_global_alloc(sizeof(*slab) +
-                                       num_words * sizeof(slab->chunks[0]));
+    // the bitmap of the remotely freed chunks follows the chunk bitmap,
+    // then the waste of the chunks follows the bitmaps
+    size_t num_bitmaps = bucket->remote_free ? 2 : 1;
+    size_t bitmaps_size = num_bitmaps * num_words * sizeof(uint64_t);
+    size_t waste_size = 0;
+    if (bucket->pool->params.pool_trace > 1) {
+        waste_size = num_chunks_total * sizeof(uint32_t);
+    }
+    slab_t *slab =
+        umf_ba_global_alloc(sizeof(*slab) + bitmaps_size + waste_size);
     if (slab == NULL) {
         LOG_ERR("allocation of new slab failed!");
         return NULL;
     }
 
     slab->num_chunks_allocated = 0;
+    slab->first_untouched_chunk = 0;
     slab->bucket = bucket;
+    slab->available = false;
+    slab->pooled = false;
+    slab->removed = false;
+    slab->owner = 0;
+    slab->remote_frees = 0;
+    slab->remote_chunks = NULL;
+    slab->chunk_waste = NULL;
+    slab->empty_since = 0;
+    slab->purged = false;
 
     slab->iter.val = slab;
     slab->iter.prev = slab->iter.next = NULL;
@@ -405,17 +532,30 @@ static slab_t *create_slab(bucket_t *bucket) {
             ((1ULL << (num_chunks_total % CHUNK_BITMAP_SIZE)) - 1);
     }
 
+    if (bucket->remote_free) {
+        slab->remote_chunks = slab->chunks + num_words;
+        memset(slab->remote_chunks, 0, num_words * sizeof(slab->chunks[0]));
+    }
+
+    if (waste_size) {
+        slab->chunk_waste = (uint32_t *)((char *)slab->chunks + bitmaps_size);
+        memset(slab->chunk_waste, 0, waste_size);
+    }
+
     // if slab_min_size is not a multiple of bucket size, we would have some
     // padding at the end of the slab
     slab->slab_size = bucket_slab_alloc_size(bucket);
 
-    // TODO not true
-    // NOTE: originally slabs memory were allocated without alignment
-    // with this registering a slab is simpler and doesn't require multimap
-    res = umfMemoryProviderAlloc(provider, slab->slab_size, 0, &slab->mem_ptr);
-    if (res != UMF_RESULT_SUCCESS) {
-        LOG_ERR("allocation of slab data failed!");
-        goto free_slab;
+    if (bucket->slab_mem_stash_num) {
+        slab->mem_ptr = bucket->slab_mem_stash[--bucket->slab_mem_stash_num];
+    } else {
+        res = umfMemoryProviderAlloc(provider, slab->slab_size,
+                                     bucket_slab_alignment(bucket),
+                                     &slab->mem_ptr);
+        if (res != UMF_RESULT_SUCCESS) {
+            LOG_ERR("allocation of slab data failed!");
+            goto free_slab;
+        }
     }
 
     // raw allocation is not available for user so mark it as inaccessible
@@ -456,11 +596,21 @@ static size_t slab_find_first_available_chunk_idx(const slab_t *slab) {
     return SIZE_MAX;
 }
 
-static void *slab_get_chunk(slab_t *slab) {
+static void *slab_get_chunk(slab_t *slab, bool *untouched) {
     // free chunk must exist, otherwise we would have allocated another slab
     const size_t chunk_idx = slab_find_first_available_chunk_idx(slab);
     assert(chunk_idx != SIZE_MAX);
 
+    // chunks are always handed out starting from the lowest free index, so
+    // a chunk was never used if it is not below the high-water mark
+    bool was_untouched = chunk_idx >= slab->first_untouched_chunk;
+    if (was_untouched) {
+        slab->first_untouched_chunk = chunk_idx + 1;
+    }
+    if (untouched) {
+        *untouched = was_untouched;
+    }
+
     void *free_chunk =
         (void *)((uintptr_t)slab->mem_ptr + chunk_idx * slab->bucket->size);
 
@@ -499,6 +649,33 @@ static bool slab_has_avail(const slab_t *slab) {
     return slab->num_chunks_allocated < slab->num_chunks_total;
 }
 
+// Accounts the waste of the chunk just allocated for 'size' bytes.
+// Called only if the pool collects statistics (pool_trace > 1).
+static void bucket_add_waste(bucket_t *bucket, slab_t *slab, void *chunk,
+                             size_t size) {
+    size_t waste = bucket->size - size;
+    utils_fetch_and_add_size_t(&bucket->wasted_bytes, waste);
+
+    size_t chunk_idx = ((uintptr_t)chunk - (uintptr_t)slab->mem_ptr) /
+                       bucket->size;
+    slab->chunk_waste[chunk_idx] = (uint32_t)waste;
+}
+
+// Stops accounting the waste of the chunk being freed.
+// Called only if the pool collects statistics (pool_trace > 1).
+static void bucket_sub_waste(bucket_t *bucket, slab_t *slab, void *chunk) {
+    size_t chunk_idx = ((uintptr_t)chunk - (uintptr_t)slab->mem_ptr) /
+                       bucket->size;
+    utils_fetch_and_sub_size_t(&bucket->wasted_bytes,
+                               slab->chunk_waste[chunk_idx]);
+    slab->chunk_waste[chunk_idx] = 0;
+}
+
+static slab_t **pool_slab_table_entry(disjoint_pool_t *pool, uintptr_t addr) {
+    return &pool->slab_table[(addr >> pool->slab_table_shift) &
+                             (SLAB_TABLE_SIZE - 1)];
+}
+
 static umf_result_t pool_register_slab(disjoint_pool_t *pool, slab_t *slab) {
     critnib *slabs = pool->known_slabs;
 
@@ -510,7 +687,22 @@ static umf_result_t pool_register_slab(disjoint_pool_t *pool, slab_t *slab) {
 
     // NOTE: we don't need to lock the slabs map as the critnib already has a
     // lock inside it
+    // counted before the slab can be found, see disjoint_pool_find_slab()
+    bool big = slab->slab_size > pool->params.slab_min_size;
+    if (big) {
+        utils_atomic_increment_u64(&pool->big_slabs_num);
+    }
+
     int ret = critnib_insert(slabs, (uintptr_t)slab_addr, slab, 0);
+    if (ret && big) {
+        utils_atomic_decrement_u64(&pool->big_slabs_num);
+    }
+
+    if (ret == 0 && pool->slab_table) {
+        utils_atomic_store_release_ptr(
+            (void **)pool_slab_table_entry(pool, (uintptr_t)slab_addr), slab);
+    }
+
     umf_result_t res = UMF_RESULT_SUCCESS;
     if (ret == ENOMEM) {
         LOG_ERR("register failed because of out of memory!");
@@ -530,8 +722,24 @@ static umf_result_t pool_unregister_slab(disjoint_pool_t *pool, slab_t *slab) {
     // TODO ASSERT_IS_ALIGNED((uintptr_t)slab_addr, bucket->size);
     LOG_DEBUG("slab: %p, start: %p", (void *)slab, slab_addr);
 
+    // The slab has to leave the table before it is removed from the critnib,
+    // so that it is not freed while a pinned lookup of the table can see it,
+    // see disjoint_pool_find_slab(). It is left alone if another slab
+    // replaced it.
+    if (pool->slab_table) {
+        slab_t *expected = slab;
+        slab_t *desired = NULL;
+        utils_compare_exchange_u64(
+            (uint64_t *)pool_slab_table_entry(pool, (uintptr_t)slab_addr),
+            (uint64_t *)&expected, (uint64_t *)&desired);
+    }
+
     critnib_remove_release(slabs, (uintptr_t)slab_addr);
 
+    if (slab->slab_size > pool->params.slab_min_size) {
+        utils_atomic_decrement_u64(&pool->big_slabs_num);
+    }
+
     return UMF_RESULT_SUCCESS;
 }
 
@@ -550,6 +758,15 @@ create_bucket(size_t sz, disjoint_pool_t *pool,
     bucket->pool = pool;
     bucket->shared_limits = shared_limits;
 
+    // Buckets which use a whole slab for each allocation gain nothing from
+    // the lock-free mode.
+    bucket->lockfree = pool->params.lockfree_slabs &&
+                       sz <= pool->params.slab_min_size / 2;
+
+    // Lock-free buckets do not take the bucket lock on free anyway.
+    bucket->remote_free = pool->params.remote_free && !bucket->lockfree &&
+                          sz <= pool->params.slab_min_size / 2;
+
     utils_mutex_init(&bucket->bucket_lock);
     return bucket;
 }
@@ -575,103 +792,243 @@ static size_t slab_get_num_free_chunks(const slab_t *slab) {
     return slab->num_chunks_total - slab->num_chunks_allocated;
 }
 
-// NOTE: this function must be called under bucket->bucket_lock
-static void bucket_free_chunk(bucket_t *bucket, void *ptr, slab_t *slab,
-                              bool *to_pool) {
-    slab_free_chunk(slab, ptr);
+// Lock-free mode
+//
+// A chunk is allocated in two steps: first it is reserved by incrementing
+// slab->num_chunks_allocated (CAS, never above num_chunks_total), then a free
+// bit is claimed from the bitmap with an atomic fetch-and. Freeing sets the
+// bit with an atomic fetch-or before decrementing the counter, so there is
+// always a free bit for every reservation in flight. The bucket lock is taken
+// only when the counter reaches num_chunks_total or 0 (or leaves
+// num_chunks_total), to move the slab between the lists, pool it or destroy
+// it. The lists are then updated based on the current counter value, so
+// racing transitions settle in any order.
+
+static bool slab_reserve_chunk(slab_t *slab, bool allow_empty,
+                               size_t *prev_allocated) {
+    size_t allocated = 0;
+    utils_atomic_load_acquire_size_t(&slab->num_chunks_allocated, &allocated);
+    size_t desired;
+    do {
+        // Only the locked path can take a chunk from an empty slab, because
+        // it may have to take the slab out of the pool.
+        if (allocated >= slab->num_chunks_total ||
+            (allocated == 0 && !allow_empty)) {
+            return false;
+        }
+        desired = allocated + 1;
+    } while (!utils_compare_exchange_size_t(&slab->num_chunks_allocated,
+                                            &allocated, &desired));
 
-    // in case if the slab was previously full and now has single available
-    // chunk, it should be moved to the list of available slabs
-    if (slab_get_num_free_chunks(slab) == 1) {
-        slab_list_item_t *slab_it = &slab->iter;
-        assert(slab_it->val != NULL);
-        DL_DELETE(bucket->unavailable_slabs, slab_it);
-        DL_PREPEND(bucket->available_slabs, slab_it);
-        bucket->available_slabs_num++;
-    }
+    *prev_allocated = allocated;
+    return true;
+}
 
-    // check if slab is empty, and pool it if we can
-    if (slab->num_chunks_allocated == 0) {
-        // The slab is now empty.
-        // If the pool has capacity then put the slab in the pool.
-        // The to_pool parameter indicates whether the slab will be put in the
-        // pool or freed.
-        *to_pool = bucket_can_pool(bucket);
-        if (*to_pool == false) {
-            // remove slab
-            slab_list_item_t *slab_it = &slab->iter;
-            assert(slab_it->val != NULL);
-            destroy_slab(slab_it->val);
-            DL_DELETE(bucket->available_slabs, slab_it);
-            assert(bucket->available_slabs_num > 0);
-            bucket->available_slabs_num--;
-            pool_unregister_slab(bucket->pool, slab_it->val);
+static void *slab_claim_chunk(slab_t *slab, bool *untouched) {
+    // the chunk is already reserved, so a free bit has to be found
+    for (;;) {
+        for (size_t i = 0; i < slab->num_words; i++) {
+            uint64_t word = 0;
+            utils_atomic_load_acquire_u64(&slab->chunks[i], &word);
+            while (word) {
+                uint64_t bit = 1ULL << utils_lsb64(word);
+                uint64_t old =
+                    utils_atomic_fetch_and_u64(&slab->chunks[i], ~bit);
+                if (old & bit) {
+                    size_t chunk_idx =
+                        i * CHUNK_BITMAP_SIZE + (size_t)utils_lsb64(bit);
+
+                    // atomic max of the high-water mark
+                    size_t first_untouched = 0;
+                    utils_atomic_load_acquire_size_t(
+                        &slab->first_untouched_chunk, &first_untouched);
+                    bool was_untouched = chunk_idx >= first_untouched;
+                    size_t desired = chunk_idx + 1;
+                    while (first_untouched < desired &&
+                           !utils_compare_exchange_size_t(
+                               &slab->first_untouched_chunk, &first_untouched,
+                               &desired)) {
+                    }
+                    if (untouched) {
+                        *untouched = was_untouched;
+                    }
+
+                    return (void *)((uintptr_t)slab->mem_ptr +
+                                    chunk_idx * slab->bucket->size);
+                }
+                word = old & ~bit;
+            }
         }
-    } else {
-        // return this chunk to the pool
-        *to_pool = true;
     }
 }
 
+// Returns the number of allocated chunks before the release
+static size_t slab_release_chunk(slab_t *slab, void *ptr) {
+    assert(ptr >= slab_get(slab) && ptr < slab_get_end(slab));
+
+    uintptr_t ptr_diff = (uintptr_t)ptr - (uintptr_t)slab->mem_ptr;
+    assert((ptr_diff % slab->bucket->size) == 0);
+    size_t chunk_idx = ptr_diff / slab->bucket->size;
+
+    uint64_t bit = 1ULL << (chunk_idx % CHUNK_BITMAP_SIZE);
+    uint64_t old = utils_atomic_fetch_or_u64(
+        &slab->chunks[chunk_idx / CHUNK_BITMAP_SIZE], bit);
+    (void)old;
+    assert((old & bit) == 0 && "double free detected");
+
+    return utils_fetch_and_sub_size_t(&slab->num_chunks_allocated, 1);
+}
+
+// NOTE: this function must be called under bucket->bucket_lock
+static void bucket_publish_avail_slab(bucket_t *bucket) {
+    if (!bucket->lockfree) {
+        return;
+    }
+
+    slab_t *slab = bucket->available_slabs ? bucket->available_slabs->val
+                                           : NULL;
+    utils_atomic_store_release_ptr((void **)&bucket->lockfree_slab, slab);
+}
+
 // NOTE: this function must be called under bucket->bucket_lock
-static void *bucket_get_free_chunk(bucket_t *bucket, bool *from_pool) {
-    slab_list_item_t *slab_it = bucket_get_avail_slab(bucket, from_pool);
-    if (slab_it == NULL) {
-        return NULL;
+static void bucket_unlink_slab(bucket_t *bucket, slab_t *slab) {
+    slab_list_item_t *slab_it = &slab->iter;
+    assert(slab_it->val != NULL);
+    DL_DELETE(bucket->available_slabs, slab_it);
+    assert(bucket->available_slabs_num > 0);
+    bucket->available_slabs_num--;
+    slab->available = false;
+    slab->removed = true;
+    bucket_publish_avail_slab(bucket);
+}
+
+// Removes the empty slab from the available list and returns its memory to
+// the provider.
+// NOTE: this function must be called under bucket->bucket_lock
+static void bucket_remove_slab(bucket_t *bucket, slab_t *slab) {
+    bucket_unlink_slab(bucket, slab);
+
+    if (bucket->lockfree) {
+        // make sure no lock-free allocation still uses the slab
+        while (utils_fetch_and_add_size_t(&bucket->lockfree_users, 0) != 0) {
+        }
     }
 
-    void *free_chunk = slab_get_chunk(slab_it->val);
+    destroy_slab(slab);
+    pool_unregister_slab(bucket->pool, slab);
+}
 
-    // if we allocated last free chunk from the slab and now it is full, move
-    // it to unavailable slabs and update its iterator
-    if (!(slab_has_avail(slab_it->val))) {
-        DL_DELETE(bucket->available_slabs, slab_it);
-        bucket->available_slabs_num--;
-        slab_it->prev = NULL;
-        DL_PREPEND(bucket->unavailable_slabs, slab_it);
+// Unlinks the empty slab from the available list like bucket_unlink_slab(),
+// but if lock-free allocations, which may still read the slab, are in flight
+// it keeps the slab and returns false.
+// NOTE: this function must be called under bucket->bucket_lock
+static bool bucket_try_unlink_slab(bucket_t *bucket, slab_t *slab) {
+    if (bucket->lockfree) {
+        // unpublish the slab first, so new lock-free allocations do not
+        // see it
+        slab_t *published = NULL;
+        utils_atomic_load_acquire_ptr((void **)&bucket->lockfree_slab,
+                                      (void **)&published);
+        if (published == slab) {
+            slab_t *next = slab->iter.next ? slab->iter.next->val : NULL;
+            utils_atomic_store_release_ptr((void **)&bucket->lockfree_slab,
+                                           next);
+        }
+
+        if (utils_fetch_and_add_size_t(&bucket->lockfree_users, 0) != 0) {
+            bucket_publish_avail_slab(bucket);
+            return false;
+        }
     }
 
-    return free_chunk;
+    bucket_unlink_slab(bucket, slab);
+    return true;
 }
 
-static size_t bucket_chunk_cut_off(bucket_t *bucket) {
-    return bucket_slab_min_size(bucket) / 2;
+// Puts the empty slab unlinked by bucket_try_unlink_slab() back at the end
+// of the available list.
+// NOTE: this function must be called under bucket->bucket_lock
+static void bucket_relink_slab(bucket_t *bucket, slab_t *slab) {
+    slab->removed = false;
+    slab->available = true;
+    DL_APPEND(bucket->available_slabs, &slab->iter);
+    bucket->available_slabs_num++;
+    bucket_publish_avail_slab(bucket);
 }
 
-static slab_t *bucket_create_slab(bucket_t *bucket) {
-    slab_t *slab = create_slab(bucket);
-    if (slab == NULL) {
-        LOG_ERR("create_slab failed!")
-        return NULL;
+// Moves the slab to the list matching its current number of allocated
+// chunks and pools or destroys it if it is empty. Returns true if the slab
+// was destroyed.
+// NOTE: this function must be called under bucket->bucket_lock
+static bool bucket_update_slab_lists(bucket_t *bucket, slab_t *slab) {
+    if (slab->removed) {
+        // already destroyed by the thread which emptied the slab first
+        return true;
     }
 
-    umf_result_t res = pool_register_slab(bucket->pool, slab);
-    if (res != UMF_RESULT_SUCCESS) {
-        LOG_ERR("slab_reg failed!")
-        destroy_slab(slab);
-        return NULL;
+    size_t allocated = 0;
+    utils_atomic_load_acquire_size_t(&slab->num_chunks_allocated, &allocated);
+
+    slab_list_item_t *slab_it = &slab->iter;
+    if (allocated == slab->num_chunks_total && slab->available) {
+        DL_DELETE(bucket->available_slabs, slab_it);
+        bucket->available_slabs_num--;
+        slab_it->prev = NULL;
+        DL_PREPEND(bucket->unavailable_slabs, slab_it);
+        slab->available = false;
+    } else if (allocated < slab->num_chunks_total && !slab->available) {
+        DL_DELETE(bucket->unavailable_slabs, slab_it);
+        DL_PREPEND(bucket->available_slabs, slab_it);
+        bucket->available_slabs_num++;
+        slab->available = true;
     }
 
-    DL_PREPEND(bucket->available_slabs, &slab->iter);
-    bucket->available_slabs_num++;
-    bucket_update_stats(bucket, 1, 0);
+    bool destroyed = false;
+    if (allocated == 0 && !slab->pooled) {
+        if (bucket_can_pool(bucket, slab)) {
+            slab->pooled = true;
+        } else {
+            bucket_remove_slab(bucket, slab);
+            destroyed = true;
+        }
+    }
 
-    return slab;
+    bucket_publish_avail_slab(bucket);
+    return destroyed;
 }
 
-static slab_list_item_t *bucket_get_avail_slab(bucket_t *bucket,
-                                               bool *from_pool) {
-    if (bucket->available_slabs == NULL) {
-        bucket_create_slab(bucket);
-        *from_pool = false;
-    } else {
-        slab_t *slab = bucket->available_slabs->val;
-        // Allocation from existing slab is treated as from pool for statistics.
-        *from_pool = true;
-        if (slab->num_chunks_allocated == 0) {
+// NOTE: this function must be called under bucket->bucket_lock
+static void *bucket_get_free_chunk_lockfree_locked(bucket_t *bucket,
+                                                   slab_t **chunk_slab,
+                                                   bool *from_pool,
+                                                   bool *untouched) {
+    for (;;) {
+        slab_t *slab = NULL;
+        if (bucket->available_slabs == NULL) {
+            slab = bucket_create_slab(bucket);
+            if (slab == NULL) {
+                return NULL;
+            }
+            *from_pool = false;
+        } else {
+            slab = bucket->available_slabs->val;
+            // Allocation from existing slab is treated as from pool for
+            // statistics.
+            *from_pool = true;
+        }
+
+        size_t prev_allocated = 0;
+        if (!slab_reserve_chunk(slab, true, &prev_allocated)) {
+            // the slab was filled up by lock-free allocations in the meantime
+            bucket_update_slab_lists(bucket, slab);
+            continue;
+        }
+
+        if (prev_allocated == 0 && slab->pooled) {
+            // the slab is no longer in the pool
+            slab->pooled = false;
+            slab->purged = false;
             assert(bucket->chunked_slabs_in_pool > 0);
-            // If this was an empty slab, it was in the pool.
-            // Now it is no longer in the pool, so update count.
             --bucket->chunked_slabs_in_pool;
             uint64_t size_to_sub = bucket_slab_alloc_size(bucket);
             uint64_t old_size = utils_fetch_and_sub_u64(
@@ -680,55 +1037,445 @@ static slab_list_item_t *bucket_get_avail_slab(bucket_t *bucket,
             assert(old_size >= size_to_sub);
             bucket_update_stats(bucket, 1, -1);
         }
-    }
 
-    return bucket->available_slabs;
-}
+        void *chunk = slab_claim_chunk(slab, untouched);
+        bucket_update_slab_lists(bucket, slab);
 
-static size_t bucket_max_pooled_slabs(bucket_t *bucket) {
-    // For small buckets where slabs are split to chunks, just one pooled slab is sufficient.
-    // For larger buckets, the capacity could be more and is adjustable.
-    if (bucket->size <= bucket_chunk_cut_off(bucket)) {
-        return 1;
-    } else {
-        return bucket->pool->params.capacity;
+        if (chunk_slab) {
+            *chunk_slab = slab;
+        }
+        return chunk;
     }
 }
 
-static void bucket_update_stats(bucket_t *bucket, int in_use, int in_pool) {
-    if (bucket->pool->params.pool_trace == 0) {
-        return;
+// Allocates a chunk from the published slab without taking the bucket lock
+// in the common case. Returns NULL if the caller has to use the locked path.
+static void *bucket_get_free_chunk_lockfree(bucket_t *bucket,
+                                            bool *untouched) {
+    utils_atomic_increment_size_t(&bucket->lockfree_users);
+
+    slab_t *slab = NULL;
+    utils_atomic_load_acquire_ptr((void **)&bucket->lockfree_slab,
+                                  (void **)&slab);
+
+    size_t prev_allocated = 0;
+    bool reserved =
+        slab != NULL && slab_reserve_chunk(slab, false, &prev_allocated);
+
+    // from now on the reserved chunk keeps the slab alive
+    utils_atomic_decrement_size_t(&bucket->lockfree_users);
+
+    if (!reserved) {
+        return NULL;
     }
 
-    bucket->curr_slabs_in_use += in_use;
-    bucket->max_slabs_in_use =
-        utils_max(bucket->curr_slabs_in_use, bucket->max_slabs_in_use);
+    void *chunk = slab_claim_chunk(slab, untouched);
 
-    bucket->curr_slabs_in_pool += in_pool;
-    bucket->max_slabs_in_pool =
-        utils_max(bucket->curr_slabs_in_pool, bucket->max_slabs_in_pool);
+    if (prev_allocated + 1 == slab->num_chunks_total) {
+        utils_mutex_lock(&bucket->bucket_lock);
+        bucket_update_slab_lists(bucket, slab);
+        utils_mutex_unlock(&bucket->bucket_lock);
+    }
 
-    // Increment or decrement current pool sizes based on whether
-    // slab was added to or removed from pool.
-    bucket->pool->params.cur_pool_size +=
-        in_pool * bucket_slab_alloc_size(bucket);
+    return chunk;
 }
 
-static bool bucket_can_pool(bucket_t *bucket) {
-    size_t new_free_slabs_in_bucket;
-
-    new_free_slabs_in_bucket = bucket->chunked_slabs_in_pool + 1;
+// Frees a chunk without taking the bucket lock in the common case.
+// The caller must hold a reference to the slab from the known_slabs map.
+static void bucket_free_chunk_lockfree(bucket_t *bucket, void *ptr,
+                                       slab_t *slab) {
+    size_t prev_allocated = slab_release_chunk(slab, ptr);
 
-    // we keep at most params.capacity slabs in the pool
-    if (bucket_max_pooled_slabs(bucket) >= new_free_slabs_in_bucket) {
+    if (prev_allocated == slab->num_chunks_total || prev_allocated == 1) {
+        utils_mutex_lock(&bucket->bucket_lock);
+        bucket_update_slab_lists(bucket, slab);
+        utils_mutex_unlock(&bucket->bucket_lock);
+    }
+}
 
-        uint64_t size_to_add = bucket_slab_alloc_size(bucket);
-        size_t previous_size = utils_fetch_and_add_u64(
-            &bucket->shared_limits->total_size, size_to_add);
+static bool bucket_use_lockfree(bucket_t *bucket) {
+    // detailed statistics are collected under the bucket lock
+    return bucket->lockfree && bucket->pool->params.pool_trace <= 1;
+}
 
-        if (previous_size + size_to_add <= bucket->shared_limits->max_size) {
+// NOTE: this function must be called under bucket->bucket_lock
+static void bucket_free_chunk(bucket_t *bucket, void *ptr, slab_t *slab,
+                              bool *to_pool) {
+    if (bucket->lockfree) {
+        slab_release_chunk(slab, ptr);
+        *to_pool = !bucket_update_slab_lists(bucket, slab);
+        return;
+    }
+
+    slab_free_chunk(slab, ptr);
+
+    // in case if the slab was previously full and now has single available
+    // chunk, it should be moved to the list of available slabs
+    if (slab_get_num_free_chunks(slab) == 1) {
+        slab_list_item_t *slab_it = &slab->iter;
+        assert(slab_it->val != NULL);
+        DL_DELETE(bucket->unavailable_slabs, slab_it);
+        DL_PREPEND(bucket->available_slabs, slab_it);
+        bucket->available_slabs_num++;
+    }
+
+    // check if slab is empty, and pool it if we can
+    if (slab->num_chunks_allocated == 0) {
+        // The slab is now empty.
+        // If the pool has capacity then put the slab in the pool.
+        // The to_pool parameter indicates whether the slab will be put in the
+        // pool or freed.
+        *to_pool = bucket_can_pool(bucket, slab);
+        if (*to_pool == false) {
+            bucket_remove_slab(bucket, slab);
+        }
+    } else {
+        // return this chunk to the pool
+        *to_pool = true;
+    }
+}
+
+// Remote frees
+//
+// The thread which last allocated a chunk from a slab is the owner of the
+// slab. Other threads free chunks of the slab by setting their bits in
+// slab->remote_chunks, without taking the bucket lock. Queued chunks stay
+// allocated from the bucket point of view, which also keeps their slab
+// alive, until an allocation finds no available slab in the bucket and
+// returns all of them to their slabs at once under the bucket lock.
+
+static size_t disjoint_pool_thread_id(void) {
+    static __TLS size_t tid = 0;
+
+    if (tid == 0) {
+        tid = (size_t)utils_gettid();
+    }
+
+    return tid;
+}
+
+// NOTE: this function must be called under bucket->bucket_lock
+static void slab_set_owner(slab_t *slab) {
+    size_t tid = disjoint_pool_thread_id();
+    size_t owner = 0;
+    utils_atomic_load_acquire_size_t(&slab->owner, &owner);
+    if (owner != tid) {
+        utils_atomic_store_release_size_t(&slab->owner, tid);
+    }
+}
+
+// Queues the chunk on its slab if it is freed by a thread other than the
+// owner of the slab. Returns false if the chunk has to be freed to the bucket
+// directly.
+// The caller must hold a reference to the slab from the known_slabs map.
+static bool bucket_free_chunk_remote(bucket_t *bucket, void *ptr,
+                                     slab_t *slab) {
+    size_t owner = 0;
+    utils_atomic_load_acquire_size_t(&slab->owner, &owner);
+    if (owner == disjoint_pool_thread_id()) {
+        return false;
+    }
+
+    assert(ptr >= slab_get(slab) && ptr < slab_get_end(slab));
+
+    uintptr_t ptr_diff = (uintptr_t)ptr - (uintptr_t)slab->mem_ptr;
+    assert((ptr_diff % bucket->size) == 0);
+    size_t chunk_idx = ptr_diff / bucket->size;
+
+    // the counters are incremented first, so they are never lower than the
+    // number of queued chunks seen by the reclaiming thread
+    utils_atomic_increment_size_t(&slab->remote_frees);
+    utils_atomic_increment_size_t(&bucket->remote_frees);
+
+    uint64_t bit = 1ULL << (chunk_idx % CHUNK_BITMAP_SIZE);
+    uint64_t old = utils_atomic_fetch_or_u64(
+        &slab->remote_chunks[chunk_idx / CHUNK_BITMAP_SIZE], bit);
+    (void)old;
+    assert((old & bit) == 0 && "double free detected");
+
+    return true;
+}
+
+// Returns all chunks queued on the slab to it, the slab is pooled or
+// destroyed if it becomes empty.
+// NOTE: this function must be called under bucket->bucket_lock
+static void slab_reclaim_remote_frees(bucket_t *bucket, slab_t *slab) {
+    size_t queued = 0;
+    utils_atomic_load_acquire_size_t(&slab->remote_frees, &queued);
+    if (queued == 0) {
+        return;
+    }
+
+    bool was_full = !slab_has_avail(slab);
+    size_t reclaimed = 0;
+    for (size_t i = 0; i < slab->num_words; i++) {
+        uint64_t word = utils_atomic_fetch_and_u64(&slab->remote_chunks[i], 0);
+        assert((slab->chunks[i] & word) == 0 && "double free detected");
+        slab->chunks[i] |= word;
+        for (; word; word &= word - 1) {
+            reclaimed++;
+        }
+    }
+
+    if (reclaimed == 0) {
+        return;
+    }
+
+    utils_fetch_and_sub_size_t(&slab->remote_frees, reclaimed);
+    utils_fetch_and_sub_size_t(&bucket->remote_frees, reclaimed);
+    assert(slab->num_chunks_allocated >= reclaimed);
+    slab->num_chunks_allocated -= reclaimed;
+
+    if (bucket->pool->params.pool_trace > 1) {
+        bucket->free_count += reclaimed;
+    }
+
+    if (was_full) {
+        slab_list_item_t *slab_it = &slab->iter;
+        DL_DELETE(bucket->unavailable_slabs, slab_it);
+        DL_PREPEND(bucket->available_slabs, slab_it);
+        bucket->available_slabs_num++;
+    }
+
+    if (slab->num_chunks_allocated == 0 && !bucket_can_pool(bucket, slab)) {
+        bucket_remove_slab(bucket, slab);
+    }
+}
+
+// NOTE: this function must be called under bucket->bucket_lock
+static void bucket_reclaim_remote_frees(bucket_t *bucket) {
+    if (!bucket->remote_free) {
+        return;
+    }
+
+    size_t queued = 0;
+    utils_atomic_load_acquire_size_t(&bucket->remote_frees, &queued);
+    if (queued == 0) {
+        return;
+    }
+
+    // slabs moved to the available list are visited again, but their queues
+    // are already empty then
+    slab_list_item_t *it = NULL, *tmp = NULL;
+    DL_FOREACH_SAFE(bucket->unavailable_slabs, it, tmp) {
+        slab_reclaim_remote_frees(bucket, it->val);
+    }
+
+    DL_FOREACH_SAFE(bucket->available_slabs, it, tmp) {
+        slab_reclaim_remote_frees(bucket, it->val);
+    }
+}
+
+// NOTE: this function must be called under bucket->bucket_lock
+static void *bucket_get_free_chunk(bucket_t *bucket, slab_t **chunk_slab,
+                                   bool *from_pool, bool *untouched) {
+    if (bucket->lockfree) {
+        return bucket_get_free_chunk_lockfree_locked(bucket, chunk_slab,
+                                                     from_pool, untouched);
+    }
+
+    slab_list_item_t *slab_it = bucket_get_avail_slab(bucket, from_pool);
+    if (slab_it == NULL) {
+        return NULL;
+    }
+
+    void *free_chunk = slab_get_chunk(slab_it->val, untouched);
+    if (bucket->remote_free) {
+        slab_set_owner(slab_it->val);
+    }
+    if (chunk_slab) {
+        *chunk_slab = slab_it->val;
+    }
+
+    // if we allocated last free chunk from the slab and now it is full, move
+    // it to unavailable slabs and update its iterator
+    if (!(slab_has_avail(slab_it->val))) {
+        DL_DELETE(bucket->available_slabs, slab_it);
+        bucket->available_slabs_num--;
+        slab_it->prev = NULL;
+        DL_PREPEND(bucket->unavailable_slabs, slab_it);
+    }
+
+    return free_chunk;
+}
+
+// The maximal number of slabs allocated at once for a batch of chunks
+#define BUCKET_STASH_MAX_SLABS 64
+
+// Allocates the memory of all new slabs which a batch of `num` chunks needs
+// at once, so they are registered in the tracker together, and stashes it
+// in the `mem` array for create_slab(). If it fails, the slabs are just
+// allocated one by one.
+// NOTE: this function must be called under the bucket lock
+static void bucket_stash_slab_mem(bucket_t *bucket, size_t num, void **mem) {
+    size_t free_chunks = 0;
+    slab_list_item_t *it;
+    DL_FOREACH(bucket->available_slabs, it) {
+        size_t allocated = 0;
+        utils_atomic_load_acquire_size_t(&it->val->num_chunks_allocated,
+                                         &allocated);
+        free_chunks += it->val->num_chunks_total - allocated;
+    }
+
+    if (free_chunks >= num) {
+        return;
+    }
+
+    size_t chunks_per_slab =
+        utils_max(bucket_slab_min_size(bucket) / bucket->size, 1);
+    size_t n_slabs =
+        (num - free_chunks + chunks_per_slab - 1) / chunks_per_slab;
+    n_slabs = utils_min(n_slabs, BUCKET_STASH_MAX_SLABS);
+    if (n_slabs < 2) {
+        return;
+    }
+
+    umf_result_t ret = umfTrackingMemoryProviderAllocBatch(
+        bucket->pool->provider, bucket_slab_alloc_size(bucket),
+        bucket_slab_alignment(bucket), n_slabs, mem);
+    if (ret != UMF_RESULT_SUCCESS) {
+        LOG_DEBUG("allocation of %zu slabs at once failed", n_slabs);
+        return;
+    }
+
+    bucket->slab_mem_stash = mem;
+    bucket->slab_mem_stash_num = n_slabs;
+}
+
+// Frees the stashed memory of slabs not created
+// NOTE: this function must be called under the bucket lock
+static void bucket_unstash_slab_mem(bucket_t *bucket) {
+    if (bucket->slab_mem_stash_num) {
+        umf_result_t ret = umfTrackingMemoryProviderFreeBatch(
+            bucket->pool->provider, bucket->slab_mem_stash,
+            bucket_slab_alloc_size(bucket), bucket->slab_mem_stash_num);
+        if (ret != UMF_RESULT_SUCCESS) {
+            LOG_ERR("deallocation of slab data failed!");
+        }
+    }
+
+    bucket->slab_mem_stash = NULL;
+    bucket->slab_mem_stash_num = 0;
+}
+
+static size_t bucket_chunk_cut_off(bucket_t *bucket) {
+    return bucket_slab_min_size(bucket) / 2;
+}
+
+static slab_t *bucket_create_slab(bucket_t *bucket) {
+    slab_t *slab = create_slab(bucket);
+    if (slab == NULL) {
+        LOG_ERR("create_slab failed!")
+        return NULL;
+    }
+
+    umf_result_t res = pool_register_slab(bucket->pool, slab);
+    if (res != UMF_RESULT_SUCCESS) {
+        LOG_ERR("slab_reg failed!")
+        destroy_slab(slab);
+        return NULL;
+    }
+
+    DL_PREPEND(bucket->available_slabs, &slab->iter);
+    bucket->available_slabs_num++;
+    slab->available = true;
+    bucket_publish_avail_slab(bucket);
+    bucket_update_stats(bucket, 1, 0);
+
+    return slab;
+}
+
+static slab_list_item_t *bucket_get_avail_slab(bucket_t *bucket,
+                                               bool *from_pool) {
+    if (bucket->available_slabs == NULL) {
+        // reclaim the chunks freed by other threads before creating a new
+        // slab
+        bucket_reclaim_remote_frees(bucket);
+    }
+
+    if (bucket->available_slabs == NULL) {
+        bucket_create_slab(bucket);
+        *from_pool = false;
+    } else {
+        slab_t *slab = bucket->available_slabs->val;
+        // Allocation from existing slab is treated as from pool for statistics.
+        *from_pool = true;
+        if (slab->num_chunks_allocated == 0) {
+            assert(bucket->chunked_slabs_in_pool > 0);
+            // If this was an empty slab, it was in the pool.
+            // Now it is no longer in the pool, so update count.
+            slab->purged = false;
+            --bucket->chunked_slabs_in_pool;
+            uint64_t size_to_sub = bucket_slab_alloc_size(bucket);
+            uint64_t old_size = utils_fetch_and_sub_u64(
+                &bucket->shared_limits->total_size, size_to_sub);
+            (void)old_size;
+            assert(old_size >= size_to_sub);
+            bucket_update_stats(bucket, 1, -1);
+        }
+    }
+
+    return bucket->available_slabs;
+}
+
+static size_t disjoint_pool_get_decay_ms(disjoint_pool_t *pool) {
+    size_t decay_ms = 0;
+    utils_atomic_load_acquire_size_t(&pool->params.decay_ms, &decay_ms);
+    return decay_ms;
+}
+
+static size_t bucket_max_pooled_slabs(bucket_t *bucket) {
+    // With the decay enabled, empty slabs are released by the decay instead.
+    if (disjoint_pool_get_decay_ms(bucket->pool)) {
+        return SIZE_MAX;
+    }
+
+    // For small buckets where slabs are split to chunks, just one pooled slab is sufficient.
+    // For larger buckets, the capacity could be more and is adjustable.
+    if (bucket->size <= bucket_chunk_cut_off(bucket)) {
+        return 1;
+    } else {
+        return bucket->pool->params.capacity;
+    }
+}
+
+static void bucket_update_stats(bucket_t *bucket, int in_use, int in_pool) {
+    if (bucket->pool->params.pool_trace == 0) {
+        return;
+    }
+
+    bucket->curr_slabs_in_use += in_use;
+    bucket->max_slabs_in_use =
+        utils_max(bucket->curr_slabs_in_use, bucket->max_slabs_in_use);
+
+    bucket->curr_slabs_in_pool += in_pool;
+    bucket->max_slabs_in_pool =
+        utils_max(bucket->curr_slabs_in_pool, bucket->max_slabs_in_pool);
+
+    // Increment or decrement current pool sizes based on whether
+    // slab was added to or removed from pool.
+    bucket->pool->params.cur_pool_size +=
+        in_pool * bucket_slab_alloc_size(bucket);
+}
+
+static bool bucket_can_pool(bucket_t *bucket, slab_t *slab) {
+    size_t new_free_slabs_in_bucket;
+
+    new_free_slabs_in_bucket = bucket->chunked_slabs_in_pool + 1;
+
+    // we keep at most params.capacity slabs in the pool
+    if (bucket_max_pooled_slabs(bucket) >= new_free_slabs_in_bucket) {
+
+        uint64_t size_to_add = bucket_slab_alloc_size(bucket);
+        size_t previous_size = utils_fetch_and_add_u64(
+            &bucket->shared_limits->total_size, size_to_add);
+
+        if (previous_size + size_to_add <= bucket->shared_limits->max_size) {
             ++bucket->chunked_slabs_in_pool;
             bucket_update_stats(bucket, -1, 1);
+            if (disjoint_pool_get_decay_ms(bucket->pool)) {
+                slab->empty_since = utils_get_time_ms();
+            }
             return true;
         } else {
             uint64_t old = utils_fetch_and_sub_u64(
@@ -747,22 +1494,27 @@ static size_t size_to_idx(disjoint_pool_t *pool, size_t size) {
     assert(size > 0 && "Unexpected size");
 
     size_t min_bucket_size = (size_t)1 << pool->min_bucket_size_exp;
-    if (size < min_bucket_size) {
+    if (size <= min_bucket_size) {
         return 0;
     }
 
-    // get the position of the leftmost set bit
-    size_t position = utils_msb64(size);
+    // Buckets between 2^position (exclusive) and 2^(position + 1) (inclusive)
+    // are equally spaced, so the index within them is given by the bits of
+    // (size - 1) right below the leftmost set bit.
+    size_t x = size - 1;
+    size_t position = utils_msb64(x);
+    size_t spacing_exp = pool->pow2_bucket_spacing_exp[position];
+    size_t mask = ((size_t)1 << (position - spacing_exp)) - 1;
 
-    bool is_power_of_2 = IS_POWER_OF_2(size);
-    bool larger_than_halfway_between_powers_of_2 =
-        !is_power_of_2 &&
-        (bool)((size - 1) & ((uint64_t)(1) << (position - 1)));
-    size_t index = (position - pool->min_bucket_size_exp) * 2 +
-                   (int)(!is_power_of_2) +
-                   (int)larger_than_halfway_between_powers_of_2;
+    return pool->pow2_first_bucket[position] + ((x >> spacing_exp) & mask);
+}
 
-    return index;
+// Returns log2 of the spacing between the buckets larger than 2^position
+static size_t bucket_spacing_exp(disjoint_pool_t *pool, size_t position) {
+    size_t per_pow2 = utils_min(pool->params.buckets_per_pow2,
+                                ((size_t)1 << position) / BUCKET_MIN_SPACING);
+    per_pow2 = utils_max(per_pow2, 1);
+    return position - (size_t)utils_msb64(per_pow2);
 }
 
 static umf_disjoint_pool_shared_limits_t *
@@ -779,33 +1531,643 @@ static bucket_t *disjoint_pool_find_bucket(disjoint_pool_t *pool, size_t size) {
     return pool->buckets[calculated_idx];
 }
 
-static void disjoint_pool_print_stats(disjoint_pool_t *pool) {
-    size_t high_bucket_size = 0;
-    size_t high_peak_slabs_in_use = 0;
-    const char *name = pool->params.name;
+// Returns the bucket for allocations of the given size with slabs aligned to
+// the given alignment, which has to be a power of 2. Such buckets are created
+// on demand, as only a few alignments are used in practice.
+static bucket_t *disjoint_pool_find_aligned_bucket(disjoint_pool_t *pool,
+                                                   size_t size,
+                                                   size_t alignment) {
+    size_t idx = size_to_idx(pool, size);
+    size_t alignment_exp = (size_t)utils_msb64(alignment);
+    bucket_t **aligned_buckets = NULL;
+    bucket_t *bucket = NULL;
+
+    utils_atomic_load_acquire_ptr(
+        (void **)&pool->aligned_buckets[alignment_exp],
+        (void **)&aligned_buckets);
+    if (aligned_buckets) {
+        utils_atomic_load_acquire_ptr((void **)&aligned_buckets[idx],
+                                      (void **)&bucket);
+        if (bucket) {
+            return bucket;
+        }
+    }
 
-    LOG_DEBUG("\"%s\" pool memory statistics", name);
-    LOG_DEBUG("%14s %12s %12s %18s %20s %21s", "Bucket Size", "Allocs", "Frees",
-              "Allocs from Pool", "Peak Slabs in Use", "Peak Slabs in Pool");
+    utils_mutex_lock(&pool->aligned_buckets_lock);
 
-    for (size_t i = 0; i < pool->buckets_num; i++) {
-        bucket_t *bucket = pool->buckets[i];
-        // lock bucket before accessing its stats
-        utils_mutex_lock(&bucket->bucket_lock);
+    aligned_buckets = pool->aligned_buckets[alignment_exp];
+    if (aligned_buckets == NULL) {
+        size_t array_size = pool->buckets_num * sizeof(*aligned_buckets);
+        aligned_buckets = umf_ba_global_alloc(array_size);
+        if (aligned_buckets == NULL) {
+            LOG_ERR("allocation of aligned buckets failed!");
+            goto unlock;
+        }
 
-        if (bucket->alloc_count) {
-            LOG_DEBUG("%14zu %12zu %12zu %18zu %20zu %21zu", bucket->size,
-                      bucket->alloc_count, bucket->free_count,
-                      bucket->alloc_pool_count, bucket->max_slabs_in_use,
-                      bucket->max_slabs_in_pool);
-            high_bucket_size =
-                utils_max(bucket_slab_alloc_size(bucket), high_bucket_size);
+        memset(aligned_buckets, 0, array_size);
+        utils_atomic_store_release_ptr(
+            (void **)&pool->aligned_buckets[alignment_exp], aligned_buckets);
+    }
+
+    bucket = aligned_buckets[idx];
+    if (bucket == NULL) {
+        // chunks are aligned only if the bucket size is a multiple of the
+        // alignment
+        size_t bucket_size = ALIGN_UP(pool->buckets[idx]->size, alignment);
+        bucket =
+            create_bucket(bucket_size, pool, disjoint_pool_get_limits(pool));
+        if (bucket == NULL) {
+            goto unlock;
         }
 
-        high_peak_slabs_in_use =
-            utils_max(bucket->max_slabs_in_use, high_peak_slabs_in_use);
+        bucket->alignment = alignment;
 
-        utils_mutex_unlock(&bucket->bucket_lock);
+        // add the bucket after the last regular bucket
+        bucket_t *last = pool->buckets[pool->buckets_num - 1];
+        bucket->next = last->next;
+        utils_atomic_store_release_ptr((void **)&last->next, bucket);
+        utils_atomic_store_release_ptr((void **)&aligned_buckets[idx], bucket);
+    }
+
+unlock:
+    utils_mutex_unlock(&pool->aligned_buckets_lock);
+    return bucket;
+}
+
+// Per-thread caches keep a bounded number of free chunks of small buckets, so
+// most allocations and frees do not take the bucket lock at all. Chunks
+// stay "allocated" from the bucket point of view while they are cached, so
+// the bucket statistics (if enabled) count the chunks moved between the
+// buckets and the caches.
+
+static umf_result_t tcache_bin_init(tcache_bin_t *bin, size_t capacity) {
+    // chunks and their slabs are stored in a single allocation
+    void **arr = umf_ba_global_alloc(2 * capacity * sizeof(void *));
+    if (arr == NULL) {
+        LOG_ERR("allocation of the thread cache bin failed!");
+        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    bin->count = 0;
+    bin->chunks = arr;
+    bin->slabs = (slab_t **)(arr + capacity);
+    return UMF_RESULT_SUCCESS;
+}
+
+static size_t tcache_batch_size(tcache_t *cache) {
+    return (cache->capacity + 1) / 2;
+}
+
+// Moves up to 'num' free chunks from the bucket to the empty bin. A new slab
+// is created only if the bucket has no available slab, so a single refill
+// allocates at most one slab.
+static void tcache_bin_refill(bucket_t *bucket, tcache_bin_t *bin,
+                              size_t num) {
+    assert(bin->count == 0);
+    disjoint_pool_t *pool = bucket->pool;
+
+    utils_mutex_lock(&bucket->bucket_lock);
+
+    while (bin->count < num) {
+        if (bin->count > 0 && bucket->available_slabs == NULL) {
+            break;
+        }
+
+        bool from_pool = false;
+        slab_t *slab = NULL;
+        void *chunk = bucket_get_free_chunk(bucket, &slab, &from_pool, NULL);
+        if (chunk == NULL) {
+            break;
+        }
+
+        if (pool->params.pool_trace > 1) {
+            ++bucket->alloc_count;
+            if (from_pool) {
+                ++bucket->alloc_pool_count;
+            }
+        }
+
+        bin->chunks[bin->count] = chunk;
+        bin->slabs[bin->count] = slab;
+        bin->count++;
+    }
+
+    utils_mutex_unlock(&bucket->bucket_lock);
+
+    // chunks were handed out in address order, reverse them so the lowest
+    // address is used first
+    for (size_t i = 0; i < bin->count / 2; i++) {
+        size_t j = bin->count - 1 - i;
+        void *chunk = bin->chunks[i];
+        slab_t *slab = bin->slabs[i];
+        bin->chunks[i] = bin->chunks[j];
+        bin->slabs[i] = bin->slabs[j];
+        bin->chunks[j] = chunk;
+        bin->slabs[j] = slab;
+    }
+}
+
+// Returns the 'num' least recently cached chunks of the bin to the bucket
+static void tcache_bin_flush(bucket_t *bucket, tcache_bin_t *bin,
+                             size_t num) {
+    assert(num <= bin->count);
+    if (num == 0) {
+        return;
+    }
+
+    utils_mutex_lock(&bucket->bucket_lock);
+
+    for (size_t i = 0; i < num; i++) {
+        bool to_pool = false;
+        bucket_free_chunk(bucket, bin->chunks[i], bin->slabs[i], &to_pool);
+    }
+
+    if (bucket->pool->params.pool_trace > 1) {
+        bucket->free_count += num;
+    }
+
+    utils_mutex_unlock(&bucket->bucket_lock);
+
+    bin->count -= num;
+    memmove(bin->chunks, bin->chunks + num, bin->count * sizeof(void *));
+    memmove(bin->slabs, bin->slabs + num, bin->count * sizeof(slab_t *));
+}
+
+// NOTE: this function must be called under cache->lock
+static void tcache_drain(tcache_t *cache) {
+    disjoint_pool_t *pool = cache->pool;
+    for (size_t i = 0; i < pool->tcache_buckets_num; i++) {
+        tcache_bin_t *bin = &cache->bins[i];
+        tcache_bin_flush(pool->buckets[i], bin, bin->count);
+    }
+}
+
+// NOTE: this function must be called under pool->tcache_lock
+static void tcache_drain_all(disjoint_pool_t *pool) {
+    tcache_t *cache = NULL;
+    DL_FOREACH(pool->tcaches, cache) {
+        utils_mutex_lock(&cache->lock);
+        tcache_drain(cache);
+        utils_mutex_unlock(&cache->lock);
+    }
+}
+
+static tcache_t *tcache_create(disjoint_pool_t *pool, size_t capacity) {
+    size_t bins_size = pool->tcache_buckets_num * sizeof(tcache_bin_t);
+    tcache_t *cache = umf_ba_global_alloc(sizeof(*cache) + bins_size);
+    if (cache == NULL) {
+        LOG_ERR("allocation of the thread cache failed!");
+        return NULL;
+    }
+
+    memset(cache, 0, sizeof(*cache) + bins_size);
+    cache->pool = pool;
+    cache->capacity = capacity;
+    utils_mutex_init(&cache->lock);
+
+    return cache;
+}
+
+// The cache must be already removed from the pool->tcaches list
+static void tcache_destroy(tcache_t *cache) {
+    utils_mutex_lock(&cache->lock);
+    tcache_drain(cache);
+    utils_mutex_unlock(&cache->lock);
+
+    for (size_t i = 0; i < cache->pool->tcache_buckets_num; i++) {
+        if (cache->bins[i].chunks) {
+            umf_ba_global_free(cache->bins[i].chunks);
+        }
+    }
+
+    utils_mutex_destroy_not_free(&cache->lock);
+    umf_ba_global_free(cache);
+}
+
+static void tcache_unregister(tcache_t *cache) {
+    disjoint_pool_t *pool = cache->pool;
+    utils_mutex_lock(&pool->tcache_lock);
+    DL_DELETE(pool->tcaches, cache);
+    utils_mutex_unlock(&pool->tcache_lock);
+}
+
+// Called on thread exit for every thread which used the caches of the pool
+static void tcache_thread_exit(void *arg) {
+    tcache_t *cache = (tcache_t *)arg;
+    if (cache == NULL) {
+        return;
+    }
+
+    tcache_unregister(cache);
+    tcache_destroy(cache);
+}
+
+// Returns the cache of the calling thread or NULL if caches are disabled
+static tcache_t *tcache_get(disjoint_pool_t *pool) {
+    size_t capacity = 0;
+    utils_atomic_load_acquire_size_t(&pool->params.tcache_size, &capacity);
+    if (capacity == 0) {
+        return NULL;
+    }
+
+    tcache_t *cache = (tcache_t *)utils_tls_get(pool->tcache_key);
+    if (cache && cache->capacity == capacity) {
+        return cache;
+    }
+
+    if (cache) {
+        // the capacity was changed via CTL, recreate the cache
+        utils_tls_set(pool->tcache_key, NULL);
+        tcache_unregister(cache);
+        tcache_destroy(cache);
+    }
+
+    cache = tcache_create(pool, capacity);
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    if (utils_tls_set(pool->tcache_key, cache)) {
+        LOG_ERR("setting the thread cache of the pool failed!");
+        tcache_destroy(cache);
+        return NULL;
+    }
+
+    utils_mutex_lock(&pool->tcache_lock);
+    DL_APPEND(pool->tcaches, cache);
+    utils_mutex_unlock(&pool->tcache_lock);
+
+    return cache;
+}
+
+static void *tcache_malloc(disjoint_pool_t *pool, size_t idx,
+                           slab_t **chunk_slab) {
+    if (idx >= pool->tcache_buckets_num) {
+        return NULL;
+    }
+
+    tcache_t *cache = tcache_get(pool);
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    void *ptr = NULL;
+    tcache_bin_t *bin = &cache->bins[idx];
+
+    utils_mutex_lock(&cache->lock);
+
+    if (bin->chunks == NULL &&
+        tcache_bin_init(bin, cache->capacity) != UMF_RESULT_SUCCESS) {
+        goto unlock;
+    }
+
+    if (bin->count == 0) {
+        tcache_bin_refill(pool->buckets[idx], bin, tcache_batch_size(cache));
+    }
+
+    if (bin->count > 0) {
+        bin->count--;
+        ptr = bin->chunks[bin->count];
+        *chunk_slab = bin->slabs[bin->count];
+    }
+
+unlock:
+    utils_mutex_unlock(&cache->lock);
+    return ptr;
+}
+
+// Returns false if the chunk cannot be cached and has to be freed to the
+// bucket directly.
+static bool tcache_free(disjoint_pool_t *pool, slab_t *slab, void *chunk) {
+    bucket_t *bucket = slab->bucket;
+    size_t idx = size_to_idx(pool, bucket->size);
+    if (idx >= pool->tcache_buckets_num || pool->buckets[idx] != bucket) {
+        return false;
+    }
+
+    tcache_t *cache = tcache_get(pool);
+    if (cache == NULL) {
+        return false;
+    }
+
+    bool cached = false;
+    tcache_bin_t *bin = &cache->bins[idx];
+
+    utils_mutex_lock(&cache->lock);
+
+    if (bin->chunks == NULL &&
+        tcache_bin_init(bin, cache->capacity) != UMF_RESULT_SUCCESS) {
+        goto unlock;
+    }
+
+    if (bin->count == cache->capacity) {
+        tcache_bin_flush(bucket, bin, tcache_batch_size(cache));
+    }
+
+    bin->chunks[bin->count] = chunk;
+    bin->slabs[bin->count] = slab;
+    bin->count++;
+    cached = true;
+
+unlock:
+    utils_mutex_unlock(&cache->lock);
+    return cached;
+}
+
+static umf_result_t disjoint_pool_set_tcache_size(disjoint_pool_t *pool,
+                                                  size_t tcache_size) {
+    umf_result_t ret = UMF_RESULT_SUCCESS;
+
+    utils_mutex_lock(&pool->tcache_lock);
+
+    if (tcache_size > 0 && !pool->tcache_key_created) {
+        if (utils_tls_key_create(&pool->tcache_key, tcache_thread_exit)) {
+            LOG_ERR("creating the thread cache key failed!");
+            ret = UMF_RESULT_ERROR_UNKNOWN;
+            goto unlock;
+        }
+        pool->tcache_key_created = true;
+    }
+
+    // Caches of other threads are only emptied here; each thread recreates
+    // its cache with the new capacity on the next pool operation.
+    utils_atomic_store_release_size_t(&pool->params.tcache_size, tcache_size);
+    tcache_drain_all(pool);
+
+unlock:
+    utils_mutex_unlock(&pool->tcache_lock);
+    return ret;
+}
+
+// Decay
+//
+// With params.decay_ms set, empty slabs are kept in the pool regardless of
+// the capacity and released gradually instead: a slab which stays empty for
+// decay_ms is purged, so the OS may reclaim its pages while it is still
+// allocated from the provider, and after another decay_ms it is returned to
+// the provider. The decay is applied by the background purger thread or,
+// without it, by the allocations which had to create a new slab, so freeing
+// chunks never calls the provider to release a slab. Without the purger
+// thread the decay advances only with such allocations, so the empty slabs
+// of a pool which is not used anymore are kept until it is destroyed.
+
+// Interval of the purger thread while the decay is disabled, so it notices
+// when the decay is enabled again by CTL
+#define PURGER_IDLE_INTERVAL_MS 1000
+
+// Takes the empty slab out of the pool, the caller has to return it to
+// the memory provider. Returns false if the slab is kept, because lock-free
+// allocations are in flight.
+// NOTE: this function must be called under bucket->bucket_lock
+static bool bucket_take_pooled_slab(bucket_t *bucket, slab_t *slab) {
+    if (!bucket_try_unlink_slab(bucket, slab)) {
+        return false;
+    }
+
+    assert(bucket->chunked_slabs_in_pool > 0);
+    --bucket->chunked_slabs_in_pool;
+    uint64_t size_to_sub = bucket_slab_alloc_size(bucket);
+    uint64_t old_size = utils_fetch_and_sub_u64(
+        &bucket->shared_limits->total_size, size_to_sub);
+    (void)old_size;
+    assert(old_size >= size_to_sub);
+    bucket_update_stats(bucket, 0, -1);
+    return true;
+}
+
+// Returns the empty slab from the pool to the memory provider. Returns false
+// if the slab is kept, because lock-free allocations are in flight.
+// NOTE: this function must be called under bucket->bucket_lock
+static bool bucket_release_pooled_slab(bucket_t *bucket, slab_t *slab) {
+    if (!bucket_take_pooled_slab(bucket, slab)) {
+        return false;
+    }
+
+    destroy_slab(slab);
+    pool_unregister_slab(bucket->pool, slab);
+    return true;
+}
+
+// The expired slabs are taken out of the available list under the bucket
+// lock and purged or released after it is unlocked, so the allocations from
+// the bucket do not wait for the memory provider. The purged slabs are put
+// back at the end of the available list.
+static void bucket_decay(bucket_t *bucket, uint64_t now, uint64_t decay_ms) {
+    slab_list_item_t *to_release = NULL, *to_purge = NULL;
+    slab_list_item_t *it = NULL, *tmp = NULL;
+
+    utils_mutex_lock(&bucket->bucket_lock);
+
+    DL_FOREACH_SAFE(bucket->available_slabs, it, tmp) {
+        slab_t *slab = it->val;
+
+        // in the lock-free mode an empty slab may not be pooled yet
+        if (slab_get_num_allocated(slab) != 0 ||
+            (bucket->lockfree && !slab->pooled) || now < slab->empty_since) {
+            continue;
+        }
+
+        uint64_t idle = now - slab->empty_since;
+        if (idle >= 2 * decay_ms) {
+            if (bucket_take_pooled_slab(bucket, slab)) {
+                DL_APPEND(to_release, it);
+            }
+        } else if (idle >= decay_ms && !slab->purged) {
+            if (bucket_try_unlink_slab(bucket, slab)) {
+                // the slab is not purged again, even if it fails
+                slab->purged = true;
+                DL_APPEND(to_purge, it);
+            }
+        }
+    }
+
+    utils_mutex_unlock(&bucket->bucket_lock);
+
+    DL_FOREACH_SAFE(to_release, it, tmp) {
+        DL_DELETE(to_release, it);
+        destroy_slab(it->val);
+        pool_unregister_slab(bucket->pool, it->val);
+    }
+
+    if (to_purge == NULL) {
+        return;
+    }
+
+    DL_FOREACH(to_purge, it) {
+        slab_t *slab = it->val;
+        umf_result_t ret = umfMemoryProviderPurgeLazy(
+            bucket->pool->provider, slab->mem_ptr, slab->slab_size);
+        if (ret != UMF_RESULT_SUCCESS &&
+            ret != UMF_RESULT_ERROR_NOT_SUPPORTED) {
+            LOG_DEBUG("purging slab %p failed", slab->mem_ptr);
+        }
+    }
+
+    utils_mutex_lock(&bucket->bucket_lock);
+    DL_FOREACH_SAFE(to_purge, it, tmp) {
+        DL_DELETE(to_purge, it);
+        bucket_relink_slab(bucket, it->val);
+    }
+    utils_mutex_unlock(&bucket->bucket_lock);
+}
+
+static void disjoint_pool_decay(disjoint_pool_t *pool) {
+    size_t decay_ms = disjoint_pool_get_decay_ms(pool);
+    if (decay_ms == 0) {
+        return;
+    }
+
+    uint64_t now = utils_get_time_ms();
+    utils_atomic_store_release_u64(&pool->decay_last, now);
+
+    for (bucket_t *bucket = pool->buckets[0]; bucket != NULL;
+         bucket = bucket_next(bucket)) {
+        bucket_decay(bucket, now, decay_ms);
+    }
+}
+
+// Applies the decay from the allocation path, at most once per half of
+// decay_ms. Must not be called under any bucket lock.
+static void disjoint_pool_decay_tick(disjoint_pool_t *pool) {
+    size_t decay_ms = disjoint_pool_get_decay_ms(pool);
+    if (decay_ms == 0 || pool->purger_running) {
+        return;
+    }
+
+    uint64_t now = utils_get_time_ms();
+    uint64_t last = 0;
+    utils_atomic_load_acquire_u64(&pool->decay_last, &last);
+    if (now - last < decay_ms / 2) {
+        return;
+    }
+
+    // only one thread applies the decay
+    if (utils_compare_exchange_u64(&pool->decay_last, &last, &now)) {
+        disjoint_pool_decay(pool);
+    }
+}
+
+static void disjoint_pool_purger(void *arg) {
+    disjoint_pool_t *pool = (disjoint_pool_t *)arg;
+
+    utils_mutex_lock(&pool->purger_lock);
+    while (!pool->purger_stop) {
+        size_t decay_ms = disjoint_pool_get_decay_ms(pool);
+        uint64_t interval =
+            decay_ms ? utils_max(decay_ms / 2, 1) : PURGER_IDLE_INTERVAL_MS;
+        utils_cond_timedwait(&pool->purger_cond, &pool->purger_lock, interval);
+        if (pool->purger_stop) {
+            break;
+        }
+
+        utils_mutex_unlock(&pool->purger_lock);
+        disjoint_pool_decay(pool);
+        utils_mutex_lock(&pool->purger_lock);
+    }
+    utils_mutex_unlock(&pool->purger_lock);
+}
+
+static umf_result_t disjoint_pool_start_purger(disjoint_pool_t *pool) {
+    pool->purger_running = false;
+    pool->purger_stop = false;
+    utils_mutex_init(&pool->purger_lock);
+    utils_cond_init(&pool->purger_cond);
+
+    if (!pool->params.decay_background) {
+        return UMF_RESULT_SUCCESS;
+    }
+
+    if (utils_thread_create(&pool->purger, disjoint_pool_purger, pool)) {
+        LOG_ERR("creating the purger thread failed!");
+        utils_cond_destroy_not_free(&pool->purger_cond);
+        utils_mutex_destroy_not_free(&pool->purger_lock);
+        return UMF_RESULT_ERROR_UNKNOWN;
+    }
+
+    pool->purger_running = true;
+    return UMF_RESULT_SUCCESS;
+}
+
+static void disjoint_pool_stop_purger(disjoint_pool_t *pool) {
+    if (pool->purger_running) {
+        utils_mutex_lock(&pool->purger_lock);
+        pool->purger_stop = true;
+        utils_cond_signal(&pool->purger_cond);
+        utils_mutex_unlock(&pool->purger_lock);
+
+        utils_thread_join(&pool->purger);
+        pool->purger_running = false;
+    }
+
+    utils_cond_destroy_not_free(&pool->purger_cond);
+    utils_mutex_destroy_not_free(&pool->purger_lock);
+}
+
+// Starts the decay of the empty slabs pooled while it was disabled or, when
+// the decay is disabled, clears the times of the empty slabs.
+static void disjoint_pool_stamp_empty_slabs(disjoint_pool_t *pool,
+                                            size_t decay_ms) {
+    uint64_t now = decay_ms ? utils_get_time_ms() : 0;
+
+    for (bucket_t *bucket = pool->buckets[0]; bucket != NULL;
+         bucket = bucket_next(bucket)) {
+        utils_mutex_lock(&bucket->bucket_lock);
+        slab_list_item_t *it = NULL;
+        DL_FOREACH(bucket->available_slabs, it) {
+            slab_t *slab = it->val;
+            if (slab_get_num_allocated(slab) != 0 ||
+                (bucket->lockfree && !slab->pooled)) {
+                continue;
+            }
+
+            if (decay_ms == 0 || slab->empty_since == 0) {
+                slab->empty_since = now;
+            }
+        }
+        utils_mutex_unlock(&bucket->bucket_lock);
+    }
+}
+
+static umf_result_t disjoint_pool_set_decay_ms(disjoint_pool_t *pool,
+                                               size_t decay_ms) {
+    utils_atomic_store_release_size_t(&pool->params.decay_ms, decay_ms);
+    disjoint_pool_stamp_empty_slabs(pool, decay_ms);
+
+    // wake up the purger, so it uses the new interval
+    utils_mutex_lock(&pool->purger_lock);
+    utils_cond_signal(&pool->purger_cond);
+    utils_mutex_unlock(&pool->purger_lock);
+
+    return UMF_RESULT_SUCCESS;
+}
+
+static void disjoint_pool_print_stats(disjoint_pool_t *pool) {
+    size_t high_bucket_size = 0;
+    size_t high_peak_slabs_in_use = 0;
+    const char *name = pool->params.name;
+
+    LOG_DEBUG("\"%s\" pool memory statistics", name);
+    LOG_DEBUG("%14s %12s %12s %18s %20s %21s", "Bucket Size", "Allocs", "Frees",
+              "Allocs from Pool", "Peak Slabs in Use", "Peak Slabs in Pool");
+
+    for (bucket_t *bucket = pool->buckets[0]; bucket != NULL;
+         bucket = bucket_next(bucket)) {
+        // lock bucket before accessing its stats
+        utils_mutex_lock(&bucket->bucket_lock);
+
+        if (bucket->alloc_count) {
+            LOG_DEBUG("%14zu %12zu %12zu %18zu %20zu %21zu", bucket->size,
+                      bucket->alloc_count, bucket->free_count,
+                      bucket->alloc_pool_count, bucket->max_slabs_in_use,
+                      bucket->max_slabs_in_pool);
+            high_bucket_size =
+                utils_max(bucket_slab_alloc_size(bucket), high_bucket_size);
+        }
+
+        high_peak_slabs_in_use =
+            utils_max(bucket->max_slabs_in_use, high_peak_slabs_in_use);
+
+        utils_mutex_unlock(&bucket->bucket_lock);
     }
 
     LOG_DEBUG("current pool size: %" PRIu64,
@@ -814,436 +2176,990 @@ static void disjoint_pool_print_stats(disjoint_pool_t *pool) {
               (name + 1), high_bucket_size, high_peak_slabs_in_use);
 }
 
-static void *disjoint_pool_allocate(disjoint_pool_t *pool, size_t size) {
+// If 'zeroed' is not NULL, it is set to true if the returned memory is known
+// to be zero-filled.
+static void *disjoint_pool_allocate(disjoint_pool_t *pool, size_t size,
+                                    bool *zeroed) {
+    if (zeroed) {
+        *zeroed = false;
+    }
+
     if (size == 0) {
         return NULL;
     }
 
-    void *ptr = NULL;
-
-    if (size > pool->params.max_poolable_size) {
-        umf_result_t ret =
-            umfMemoryProviderAlloc(pool->provider, size, 0, &ptr);
+    void *ptr = NULL;
+
+    if (size > pool->params.max_poolable_size) {
+        umf_result_t ret =
+            umfMemoryProviderAlloc(pool->provider, size, 0, &ptr);
+        if (ret != UMF_RESULT_SUCCESS) {
+            TLS_last_allocation_error = ret;
+            LOG_ERR("allocation from the memory provider failed");
+            return NULL;
+        }
+
+        if (zeroed) {
+            *zeroed = pool->params.provider_zeroed_memory;
+        }
+
+        utils_annotate_memory_undefined(ptr, size);
+        return ptr;
+    }
+
+    size_t idx = size_to_idx(pool, size);
+    bucket_t *bucket = pool->buckets[idx];
+
+    slab_t *slab = NULL;
+    ptr = tcache_malloc(pool, idx, &slab);
+    if (ptr) {
+        if (pool->params.pool_trace > 1) {
+            bucket_add_waste(bucket, slab, ptr, size);
+        }
+
+        if (pool->params.pool_trace > 2) {
+            LOG_DEBUG("Allocated %8zu %s bytes from thread cache -> %p", size,
+                      pool->params.name, ptr);
+        }
+
+        VALGRIND_DO_MEMPOOL_ALLOC(pool, ptr, size);
+        utils_annotate_memory_undefined(ptr, bucket->size);
+        return ptr;
+    }
+
+    if (bucket_use_lockfree(bucket)) {
+        bool untouched = false;
+        ptr = bucket_get_free_chunk_lockfree(bucket, &untouched);
+        if (ptr) {
+            if (zeroed) {
+                *zeroed = untouched && pool->params.provider_zeroed_memory;
+            }
+
+            VALGRIND_DO_MEMPOOL_ALLOC(pool, ptr, size);
+            utils_annotate_memory_undefined(ptr, bucket->size);
+            return ptr;
+        }
+    }
+
+    utils_mutex_lock(&bucket->bucket_lock);
+
+    bool from_pool = false;
+    bool untouched = false;
+    ptr = bucket_get_free_chunk(bucket, &slab, &from_pool, &untouched);
+
+    if (ptr == NULL) {
+        TLS_last_allocation_error = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+        utils_mutex_unlock(&bucket->bucket_lock);
+        return NULL;
+    }
+
+    if (zeroed) {
+        *zeroed = untouched && pool->params.provider_zeroed_memory;
+    }
+
+    if (pool->params.pool_trace > 1) {
+        // update stats
+        ++bucket->alloc_count;
+        if (from_pool) {
+            ++bucket->alloc_pool_count;
+        }
+        bucket_add_waste(bucket, slab, ptr, size);
+    }
+
+    utils_mutex_unlock(&bucket->bucket_lock);
+
+    if (!from_pool) {
+        disjoint_pool_decay_tick(pool);
+    }
+
+    if (pool->params.pool_trace > 2) {
+        LOG_DEBUG("Allocated %8zu %s bytes from %s -> %p", size,
+                  pool->params.name, (from_pool ? "pool" : "provider"), ptr);
+    }
+
+    VALGRIND_DO_MEMPOOL_ALLOC(pool, ptr, size);
+    utils_annotate_memory_undefined(ptr, bucket->size);
+    return ptr;
+}
+
+/*
+ * free_slab - callback for freeing the slab.
+ *             It is called by critnib when the slab
+ *             is removed from the critnib.
+ */
+static void free_slab(void *unused, void *slab) {
+    (void)unused;
+    if (slab) {
+        umf_ba_global_free(slab);
+    }
+}
+
+static const umf_disjoint_pool_params_t default_params = {
+    .slab_min_size = 64 * 1024,           // 64KB default
+    .max_poolable_size = 2 * 1024 * 1024, // 2MB default
+    .capacity = 4,                        // default
+    .min_bucket_size = 8,                 // default
+    .buckets_per_pow2 = 2,                // default
+    .cur_pool_size = 0,
+    .pool_trace = 0,
+    .shared_limits = NULL,
+    .name = "disjoint",
+    .tcache_size = 0,
+    .tcache_max_chunk_size = 32 * 1024, // 32KB default
+    .provider_zeroed_memory = false,
+    .lockfree_slabs = false,
+    .naturally_aligned_slabs = false,
+    .remote_free = false,
+    .decay_ms = 0,
+    .decay_background = false};
+
+umf_result_t disjoint_pool_initialize(umf_memory_provider_handle_t provider,
+                                      const void *params, void **ppPool) {
+    if (!provider || !ppPool) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    const umf_disjoint_pool_params_t *dp_params;
+
+    // If params is NULL, use default values
+    if (!params) {
+        dp_params = &default_params;
+    } else {
+        dp_params = params;
+    }
+
+    disjoint_pool_t *disjoint_pool =
+        umf_ba_global_alloc(sizeof(*disjoint_pool));
+    if (disjoint_pool == NULL) {
+        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    VALGRIND_DO_CREATE_MEMPOOL(disjoint_pool, 0, 0);
+
+    disjoint_pool->provider = provider;
+    disjoint_pool->params = *dp_params;
+
+    disjoint_pool->known_slabs = critnib_new(free_slab, NULL);
+    if (disjoint_pool->known_slabs == NULL) {
+        goto err_free_disjoint_pool;
+    }
+
+    // Generate buckets sized such as: 64, 96, 128, 192, ..., CutOff.
+    // Powers of 2 and params.buckets_per_pow2 - 1 equally spaced values
+    // between the powers of 2 (the value halfway between them by default).
+    size_t Size1 = disjoint_pool->params.min_bucket_size;
+
+    // min_bucket_size cannot be larger than CutOff.
+    Size1 = utils_min(Size1, CutOff);
+
+    // Buckets sized smaller than the bucket default size- 8 aren't needed.
+    Size1 = utils_max(Size1, UMF_DISJOINT_POOL_MIN_BUCKET_DEFAULT_SIZE);
+
+    // Calculate the exponent for min_bucket_size used for finding buckets.
+    disjoint_pool->min_bucket_size_exp = (size_t)utils_msb64(Size1);
+    if (umfDisjointPoolSharedLimitsCreate(
+            SIZE_MAX, &disjoint_pool->default_shared_limits) !=
+        UMF_RESULT_SUCCESS) {
+        goto err_free_known_slabs;
+    }
+
+    // count number of buckets, start from 1
+    size_t cut_off_exp = (size_t)utils_msb64(CutOff);
+    size_t position;
+    disjoint_pool->buckets_num = 1;
+    for (position = disjoint_pool->min_bucket_size_exp; position < cut_off_exp;
+         position++) {
+        size_t spacing_exp = bucket_spacing_exp(disjoint_pool, position);
+        disjoint_pool->pow2_first_bucket[position] = disjoint_pool->buckets_num;
+        disjoint_pool->pow2_bucket_spacing_exp[position] =
+            (unsigned char)spacing_exp;
+        disjoint_pool->buckets_num += (size_t)1 << (position - spacing_exp);
+    }
+
+    disjoint_pool->buckets = umf_ba_global_alloc(
+        sizeof(*disjoint_pool->buckets) * disjoint_pool->buckets_num);
+    if (disjoint_pool->buckets == NULL) {
+        goto err_free_shared_limits;
+    }
+
+    size_t i = 0;
+    disjoint_pool->buckets[i++] = create_bucket(
+        Size1, disjoint_pool, disjoint_pool_get_limits(disjoint_pool));
+    for (position = disjoint_pool->min_bucket_size_exp; position < cut_off_exp;
+         position++) {
+        size_t spacing = (size_t)1
+                         << disjoint_pool->pow2_bucket_spacing_exp[position];
+        size_t pow2 = (size_t)1 << position;
+        for (size_t sz = pow2 + spacing; sz <= 2 * pow2; sz += spacing) {
+            disjoint_pool->buckets[i++] = create_bucket(
+                sz, disjoint_pool, disjoint_pool_get_limits(disjoint_pool));
+        }
+    }
+    assert(i == disjoint_pool->buckets_num);
+
+    // check if all buckets were created successfully
+    for (i = 0; i < disjoint_pool->buckets_num; i++) {
+        if (disjoint_pool->buckets[i] == NULL) {
+            goto err_free_buckets;
+        }
+    }
+
+    // link the regular buckets, the aligned ones are added after the last
+    // regular bucket when they are created
+    for (i = 0; i + 1 < disjoint_pool->buckets_num; i++) {
+        disjoint_pool->buckets[i]->next = disjoint_pool->buckets[i + 1];
+    }
+
+    memset(disjoint_pool->aligned_buckets, 0,
+           sizeof(disjoint_pool->aligned_buckets));
+    utils_mutex_init(&disjoint_pool->aligned_buckets_lock);
+
+    umf_result_t ret = umfMemoryProviderGetMinPageSize(
+        provider, NULL, &disjoint_pool->provider_min_page_size);
+    if (ret != UMF_RESULT_SUCCESS) {
+        disjoint_pool->provider_min_page_size = 0;
+    }
+
+    disjoint_pool->slab_addr_mask = 0;
+    disjoint_pool->big_slabs_num = 0;
+    disjoint_pool->slab_table = NULL;
+    disjoint_pool->slab_table_shift = 0;
+    if (disjoint_pool->params.naturally_aligned_slabs) {
+        size_t slab_min_size = disjoint_pool->params.slab_min_size;
+        if (IS_POWER_OF_2(slab_min_size)) {
+            disjoint_pool->slab_table = umf_ba_global_alloc(
+                sizeof(*disjoint_pool->slab_table) * SLAB_TABLE_SIZE);
+            if (disjoint_pool->slab_table == NULL) {
+                goto err_destroy_aligned_buckets_lock;
+            }
+            memset(disjoint_pool->slab_table, 0,
+                   sizeof(*disjoint_pool->slab_table) * SLAB_TABLE_SIZE);
+            disjoint_pool->slab_table_shift = utils_msb64(slab_min_size);
+            disjoint_pool->slab_addr_mask = ~(uintptr_t)(slab_min_size - 1);
+        } else {
+            LOG_WARN("naturally aligned slabs require slab_min_size (%zu) to "
+                     "be a power of 2, the option is ignored",
+                     slab_min_size);
+        }
+    }
+
+    // Only buckets which split slabs into chunks are served from the
+    // per-thread caches.
+    size_t tcache_max_chunk_size =
+        utils_min(disjoint_pool->params.tcache_max_chunk_size,
+                  disjoint_pool->params.slab_min_size / 2);
+    disjoint_pool->tcache_buckets_num = 0;
+    while (disjoint_pool->tcache_buckets_num < disjoint_pool->buckets_num &&
+           disjoint_pool->buckets[disjoint_pool->tcache_buckets_num]->size <=
+               tcache_max_chunk_size) {
+        disjoint_pool->tcache_buckets_num++;
+    }
+
+    disjoint_pool->tcaches = NULL;
+    disjoint_pool->tcache_key_created = false;
+    utils_mutex_init(&disjoint_pool->tcache_lock);
+
+    size_t tcache_size = disjoint_pool->params.tcache_size;
+    disjoint_pool->params.tcache_size = 0;
+    if (disjoint_pool_set_tcache_size(disjoint_pool, tcache_size) !=
+        UMF_RESULT_SUCCESS) {
+        goto err_destroy_tcache_lock;
+    }
+
+    disjoint_pool->decay_last = utils_get_time_ms();
+    if (disjoint_pool_start_purger(disjoint_pool) != UMF_RESULT_SUCCESS) {
+        goto err_delete_tcache_key;
+    }
+
+    *ppPool = (void *)disjoint_pool;
+
+    return UMF_RESULT_SUCCESS;
+
+err_delete_tcache_key:
+    if (disjoint_pool->tcache_key_created) {
+        utils_tls_key_delete(disjoint_pool->tcache_key);
+    }
+
+err_destroy_tcache_lock:
+    utils_mutex_destroy_not_free(&disjoint_pool->tcache_lock);
+    umf_ba_global_free(disjoint_pool->slab_table);
+
+err_destroy_aligned_buckets_lock:
+    utils_mutex_destroy_not_free(&disjoint_pool->aligned_buckets_lock);
+
+err_free_buckets:
+    for (i = 0; i < disjoint_pool->buckets_num; i++) {
+        if (disjoint_pool->buckets[i] != NULL) {
+            destroy_bucket(disjoint_pool->buckets[i]);
+        }
+    }
+    umf_ba_global_free(disjoint_pool->buckets);
+
+err_free_shared_limits:
+    umfDisjointPoolSharedLimitsDestroy(disjoint_pool->default_shared_limits);
+
+err_free_known_slabs:
+    critnib_delete(disjoint_pool->known_slabs);
+
+err_free_disjoint_pool:
+    umf_ba_global_free(disjoint_pool);
+
+    return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+}
+
+void *disjoint_pool_malloc(void *pool, size_t size) {
+    disjoint_pool_t *hPool = (disjoint_pool_t *)pool;
+    void *ptr = disjoint_pool_allocate(hPool, size, NULL);
+
+    return ptr;
+}
+
+void *disjoint_pool_aligned_malloc(void *pool, size_t size, size_t alignment) {
+    disjoint_pool_t *disjoint_pool = (disjoint_pool_t *)pool;
+
+    void *ptr = NULL;
+
+    if (size == 0) {
+        return NULL;
+    }
+
+    if (alignment <= 1) {
+        return disjoint_pool_allocate(pool, size, NULL);
+    }
+
+    // This allocation will be served from a Bucket which size is multiple
+    // of Alignment. Slab addresses of the regular buckets are aligned to
+    // provider_min_page_size, larger alignments are served from the aligned
+    // buckets, whose slabs are aligned to Alignment.
+    size_t aligned_size =
+        (size > 1) ? ALIGN_UP_SAFE(size, alignment) : alignment;
+
+    // Check if requested allocation size is within pooling limit.
+    // If not, just request aligned pointer from the system.
+    if (aligned_size > disjoint_pool->params.max_poolable_size) {
+
+        umf_result_t ret = umfMemoryProviderAlloc(disjoint_pool->provider, size,
+                                                  alignment, &ptr);
+        if (ret != UMF_RESULT_SUCCESS) {
+            TLS_last_allocation_error = ret;
+            LOG_ERR("allocation from the memory provider failed");
+            return NULL;
+        }
+
+        assert(ptr);
+        utils_annotate_memory_undefined(ptr, size);
+        return ptr;
+    }
+
+    bool from_pool = false;
+    bucket_t *bucket = NULL;
+    if (alignment <= disjoint_pool->provider_min_page_size) {
+        bucket = disjoint_pool_find_bucket(pool, aligned_size);
+    } else {
+        bucket = disjoint_pool_find_aligned_bucket(pool, aligned_size,
+                                                   alignment);
+        if (bucket == NULL) {
+            TLS_last_allocation_error = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+            return NULL;
+        }
+    }
+
+    utils_mutex_lock(&bucket->bucket_lock);
+
+    slab_t *slab = NULL;
+    ptr = bucket_get_free_chunk(bucket, &slab, &from_pool, NULL);
+
+    if (ptr == NULL) {
+        TLS_last_allocation_error = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+        utils_mutex_unlock(&bucket->bucket_lock);
+        return NULL;
+    }
+
+    if (disjoint_pool->params.pool_trace > 1) {
+        // update stats
+        ++bucket->alloc_count;
+        if (from_pool) {
+            ++bucket->alloc_pool_count;
+        }
+        bucket_add_waste(bucket, slab, ptr, size);
+    }
+
+    void *aligned_ptr = (void *)ALIGN_UP_SAFE((size_t)ptr, alignment);
+    size_t diff = (ptrdiff_t)aligned_ptr - (ptrdiff_t)ptr;
+    size_t real_size = bucket->size - diff;
+    VALGRIND_DO_MEMPOOL_ALLOC(disjoint_pool, aligned_ptr, real_size);
+    utils_annotate_memory_undefined(aligned_ptr, real_size);
+
+    utils_mutex_unlock(&bucket->bucket_lock);
+
+    if (!from_pool) {
+        disjoint_pool_decay_tick(disjoint_pool);
+    }
+
+    if (disjoint_pool->params.pool_trace > 2) {
+        LOG_DEBUG("Allocated %8zu %s bytes aligned at %zu from %s -> %p", size,
+                  disjoint_pool->params.name, alignment,
+                  (from_pool ? "pool" : "provider"), ptr);
+    }
+
+    return aligned_ptr;
+}
+
+// Returns the slab which the pointer was allocated from or NULL if it was
+// allocated directly from the memory provider. The returned slab reference
+// must be released with critnib_release().
+//
+// NOTE: slabs have no header in their memory, which belongs to the provider
+// (and may be device memory). With naturally aligned slabs the slab is found
+// in O(1) in the host-side slab_table instead, and the known_slabs critnib is
+// searched only for the slabs replaced in the table by other ones and for
+// the chunks of big slabs outside of their first slab_min_size bytes.
+static slab_t *disjoint_pool_find_slab(disjoint_pool_t *pool, const void *ptr,
+                                       void **ref_slab) {
+    slab_t *slab = NULL;
+    *ref_slab = NULL;
+
+    if (pool->slab_addr_mask) {
+        // Slabs are naturally aligned, so the start of the slab is found by
+        // masking the pointer and only an exact-match lookup is needed. A
+        // slab found at the masked address always contains the pointer, as
+        // slabs are never smaller than the mask.
+        uintptr_t slab_addr = (uintptr_t)ptr & pool->slab_addr_mask;
+
+        // pinning keeps the slabs seen in the table from being freed
+        void *ref = critnib_pin(pool->known_slabs);
+        utils_atomic_load_acquire_ptr(
+            (void **)pool_slab_table_entry(pool, slab_addr), (void **)&slab);
+        if (slab && (uintptr_t)slab->mem_ptr == slab_addr) {
+            *ref_slab = ref;
+            return slab;
+        }
+        critnib_release(pool->known_slabs, ref);
+
+        slab = (slab_t *)critnib_get(pool->known_slabs, slab_addr, ref_slab);
+        if (slab) {
+            return slab;
+        }
+
+        *ref_slab = NULL;
+
+        // Only a chunk of a slab larger than slab_min_size can be missed
+        // by the mask. Without such slabs the pointer is known to be
+        // a large allocation, so the closest slab is not searched for.
+        uint64_t big_slabs_num;
+        utils_atomic_load_acquire_u64(&pool->big_slabs_num, &big_slabs_num);
+        if (big_slabs_num == 0) {
+            return NULL;
+        }
+    }
+
+    slab = (slab_t *)critnib_find_le(pool->known_slabs, (uintptr_t)ptr,
+                                     ref_slab);
+    if (slab == NULL || ptr >= slab_get_end(slab)) {
+        if (*ref_slab) {
+            critnib_release(pool->known_slabs, *ref_slab);
+            *ref_slab = NULL;
+        }
+        return NULL;
+    }
+
+    return slab;
+}
+
+static size_t get_chunk_idx(const void *ptr, slab_t *slab) {
+    return (((uintptr_t)ptr - (uintptr_t)slab->mem_ptr) / slab->bucket->size);
+}
+
+static void *get_unaligned_ptr(size_t chunk_idx, slab_t *slab) {
+    return (void *)((uintptr_t)slab->mem_ptr + chunk_idx * slab->bucket->size);
+}
+
+umf_result_t disjoint_pool_malloc_usable_size(void *pool, const void *ptr,
+                                              size_t *size) {
+    disjoint_pool_t *disjoint_pool = (disjoint_pool_t *)pool;
+    if (!size || !disjoint_pool) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+    if (ptr == NULL) {
+        *size = 0;
+        return UMF_RESULT_SUCCESS;
+    }
+
+    // check if given pointer is allocated inside any Disjoint Pool slab
+    void *ref_slab = NULL;
+    slab_t *slab = disjoint_pool_find_slab(disjoint_pool, ptr, &ref_slab);
+    if (slab == NULL) {
+        // memory comes directly from the provider
+        umf_alloc_info_t allocInfo = {NULL, 0, NULL};
+        bool in_chunk = false;
+        umf_result_t ret = umfTrackingMemoryProviderGetAllocInfo(
+            disjoint_pool->provider, ptr, &allocInfo, &in_chunk);
         if (ret != UMF_RESULT_SUCCESS) {
-            TLS_last_allocation_error = ret;
-            LOG_ERR("allocation from the memory provider failed");
-            return NULL;
+            *size = 0;
+            return ret;
         }
 
-        utils_annotate_memory_undefined(ptr, size);
-        return ptr;
+        *size = allocInfo.baseSize -
+                ((uintptr_t)ptr - (uintptr_t)allocInfo.base);
+        return UMF_RESULT_SUCCESS;
     }
 
-    bucket_t *bucket = disjoint_pool_find_bucket(pool, size);
+    // Get the unaligned pointer
+    // NOTE: the base pointer slab->mem_ptr needn't to be aligned to bucket size
+    size_t chunk_idx = get_chunk_idx(ptr, slab);
+    void *unaligned_ptr = get_unaligned_ptr(chunk_idx, slab);
+
+    ptrdiff_t diff = (ptrdiff_t)ptr - (ptrdiff_t)unaligned_ptr;
 
-    utils_mutex_lock(&bucket->bucket_lock);
+    *size = slab->bucket->size - diff;
 
-    bool from_pool = false;
-    ptr = bucket_get_free_chunk(bucket, &from_pool);
+    assert(ref_slab);
+    critnib_release(disjoint_pool->known_slabs, ref_slab);
+
+    return UMF_RESULT_SUCCESS;
+}
 
+umf_result_t disjoint_pool_free(void *pool, void *ptr) {
+    disjoint_pool_t *disjoint_pool = (disjoint_pool_t *)pool;
     if (ptr == NULL) {
-        TLS_last_allocation_error = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
-        utils_mutex_unlock(&bucket->bucket_lock);
-        return NULL;
+        return UMF_RESULT_SUCCESS;
     }
 
-    if (pool->params.pool_trace > 1) {
-        // update stats
-        ++bucket->alloc_count;
-        if (from_pool) {
-            ++bucket->alloc_pool_count;
+    // check if given pointer is allocated inside any Disjoint Pool slab
+    void *ref_slab = NULL;
+    slab_t *slab = disjoint_pool_find_slab(disjoint_pool, ptr, &ref_slab);
+
+    if (slab == NULL) {
+        // regular free
+        umf_alloc_info_t allocInfo = {NULL, 0, NULL};
+        umf_result_t ret = umfMemoryTrackerGetAllocInfo(ptr, &allocInfo);
+        if (ret != UMF_RESULT_SUCCESS) {
+            TLS_last_allocation_error = ret;
+            LOG_ERR("failed to get allocation info from the memory tracker");
+            return ret;
         }
-    }
 
-    utils_mutex_unlock(&bucket->bucket_lock);
+        size_t size = allocInfo.baseSize;
+        umf_memory_provider_handle_t provider = disjoint_pool->provider;
+        ret = umfMemoryProviderFree(provider, ptr, size);
+        if (ret != UMF_RESULT_SUCCESS) {
+            TLS_last_allocation_error = ret;
+            LOG_ERR("deallocation from the memory provider failed");
+        }
 
-    if (pool->params.pool_trace > 2) {
-        LOG_DEBUG("Allocated %8zu %s bytes from %s -> %p", size,
-                  pool->params.name, (from_pool ? "pool" : "provider"), ptr);
+        return ret;
     }
 
-    VALGRIND_DO_MEMPOOL_ALLOC(pool, ptr, size);
-    utils_annotate_memory_undefined(ptr, bucket->size);
-    return ptr;
-}
+    bool to_pool = false;
 
-/*
- * free_slab - callback for freeing the slab.
- *             It is called by critnib when the slab
- *             is removed from the critnib.
- */
-static void free_slab(void *unused, void *slab) {
-    (void)unused;
-    if (slab) {
-        umf_ba_global_free(slab);
+    if (ptr < slab_get(slab) || ptr >= slab_get_end(slab)) {
+        assert(0);
+        return UMF_RESULT_ERROR_UNKNOWN;
     }
-}
 
-static const umf_disjoint_pool_params_t default_params = {
-    .slab_min_size = 64 * 1024,           // 64KB default
-    .max_poolable_size = 2 * 1024 * 1024, // 2MB default
-    .capacity = 4,                        // default
-    .min_bucket_size = 8,                 // default
-    .cur_pool_size = 0,
-    .pool_trace = 0,
-    .shared_limits = NULL,
-    .name = "disjoint"};
+    // The slab object won't be deleted until it's removed from the map which is
+    // protected by the lock, so it's safe to access it here.
 
-umf_result_t disjoint_pool_initialize(umf_memory_provider_handle_t provider,
-                                      const void *params, void **ppPool) {
-    if (!provider || !ppPool) {
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
-    }
+    bucket_t *bucket = slab->bucket;
 
-    const umf_disjoint_pool_params_t *dp_params;
+    // Get the unaligned pointer
+    // NOTE: the base pointer slab->mem_ptr needn't to be aligned to bucket size
+    size_t chunk_idx = get_chunk_idx(ptr, slab);
+    void *unaligned_ptr = get_unaligned_ptr(chunk_idx, slab);
 
-    // If params is NULL, use default values
-    if (!params) {
-        dp_params = &default_params;
-    } else {
-        dp_params = params;
-    }
+    VALGRIND_DO_MEMPOOL_FREE(pool, ptr);
+    utils_annotate_memory_inaccessible(unaligned_ptr, bucket->size);
 
-    disjoint_pool_t *disjoint_pool =
-        umf_ba_global_alloc(sizeof(*disjoint_pool));
-    if (disjoint_pool == NULL) {
-        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    if (disjoint_pool->params.pool_trace > 1) {
+        bucket_sub_waste(bucket, slab, unaligned_ptr);
     }
 
-    VALGRIND_DO_CREATE_MEMPOOL(disjoint_pool, 0, 0);
-
-    disjoint_pool->provider = provider;
-    disjoint_pool->params = *dp_params;
-
-    disjoint_pool->known_slabs = critnib_new(free_slab, NULL);
-    if (disjoint_pool->known_slabs == NULL) {
-        goto err_free_disjoint_pool;
+    if (tcache_free(disjoint_pool, slab, unaligned_ptr)) {
+        assert(ref_slab);
+        critnib_release(disjoint_pool->known_slabs, ref_slab);
+        return UMF_RESULT_SUCCESS;
     }
 
-    // Generate buckets sized such as: 64, 96, 128, 192, ..., CutOff.
-    // Powers of 2 and the value halfway between the powers of 2.
-    size_t Size1 = disjoint_pool->params.min_bucket_size;
+    if (bucket_use_lockfree(bucket)) {
+        bucket_free_chunk_lockfree(bucket, unaligned_ptr, slab);
+        assert(ref_slab);
+        critnib_release(disjoint_pool->known_slabs, ref_slab);
+        return UMF_RESULT_SUCCESS;
+    }
 
-    // min_bucket_size cannot be larger than CutOff.
-    Size1 = utils_min(Size1, CutOff);
+    if (bucket->remote_free &&
+        bucket_free_chunk_remote(bucket, unaligned_ptr, slab)) {
+        assert(ref_slab);
+        critnib_release(disjoint_pool->known_slabs, ref_slab);
+        return UMF_RESULT_SUCCESS;
+    }
 
-    // Buckets sized smaller than the bucket default size- 8 aren't needed.
-    Size1 = utils_max(Size1, UMF_DISJOINT_POOL_MIN_BUCKET_DEFAULT_SIZE);
+    utils_mutex_lock(&bucket->bucket_lock);
+    bucket_free_chunk(bucket, unaligned_ptr, slab, &to_pool);
 
-    // Calculate the exponent for min_bucket_size used for finding buckets.
-    disjoint_pool->min_bucket_size_exp = (size_t)utils_msb64(Size1);
-    if (umfDisjointPoolSharedLimitsCreate(
-            SIZE_MAX, &disjoint_pool->default_shared_limits) !=
-        UMF_RESULT_SUCCESS) {
-        goto err_free_known_slabs;
-    }
+    assert(ref_slab);
+    critnib_release(disjoint_pool->known_slabs, ref_slab);
 
-    // count number of buckets, start from 1
-    disjoint_pool->buckets_num = 1;
-    size_t Size2 = Size1 + Size1 / 2;
-    size_t ts2 = Size2, ts1 = Size1;
-    while (Size2 < CutOff) {
-        disjoint_pool->buckets_num += 2;
-        Size2 *= 2;
+    if (disjoint_pool->params.pool_trace > 1) {
+        bucket->free_count++;
     }
 
-    disjoint_pool->buckets = umf_ba_global_alloc(
-        sizeof(*disjoint_pool->buckets) * disjoint_pool->buckets_num);
-    if (disjoint_pool->buckets == NULL) {
-        goto err_free_shared_limits;
-    }
+    utils_mutex_unlock(&bucket->bucket_lock);
 
-    size_t i = 0;
-    Size1 = ts1;
-    Size2 = ts2;
-    for (; Size2 < CutOff; Size1 *= 2, Size2 *= 2, i += 2) {
-        disjoint_pool->buckets[i] = create_bucket(
-            Size1, disjoint_pool, disjoint_pool_get_limits(disjoint_pool));
-        disjoint_pool->buckets[i + 1] = create_bucket(
-            Size2, disjoint_pool, disjoint_pool_get_limits(disjoint_pool));
+    if (disjoint_pool->params.pool_trace > 2) {
+        const char *name = disjoint_pool->params.name;
+        LOG_DEBUG("freed %s %p to %s, current total pool size: %" PRIu64
+                  ", current "
+                  "pool size for %s: %zu",
+                  name, ptr, (to_pool ? "pool" : "provider"),
+                  disjoint_pool_get_limits(disjoint_pool)->total_size, name,
+                  disjoint_pool->params.cur_pool_size);
     }
-    disjoint_pool->buckets[i] = create_bucket(
-        CutOff, disjoint_pool, disjoint_pool_get_limits(disjoint_pool));
 
-    // check if all buckets were created successfully
-    for (i = 0; i < disjoint_pool->buckets_num; i++) {
-        if (disjoint_pool->buckets[i] == NULL) {
-            goto err_free_buckets;
-        }
-    }
+    return UMF_RESULT_SUCCESS;
+}
 
-    umf_result_t ret = umfMemoryProviderGetMinPageSize(
-        provider, NULL, &disjoint_pool->provider_min_page_size);
-    if (ret != UMF_RESULT_SUCCESS) {
-        disjoint_pool->provider_min_page_size = 0;
+umf_result_t disjoint_pool_malloc_batch(void *pool, size_t size, size_t num,
+                                        void **ptrs) {
+    disjoint_pool_t *disjoint_pool = (disjoint_pool_t *)pool;
+    if (size == 0 || ptrs == NULL) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
     }
 
-    *ppPool = (void *)disjoint_pool;
+    size_t i = 0;
 
-    return UMF_RESULT_SUCCESS;
+    if (size > disjoint_pool->params.max_poolable_size) {
+        // the whole batch is registered in the tracker at once
+        umf_result_t ret = umfTrackingMemoryProviderAllocBatch(
+            disjoint_pool->provider, size, 0, num, ptrs);
+        if (ret != UMF_RESULT_SUCCESS) {
+            TLS_last_allocation_error = ret;
+            LOG_ERR("allocation from the memory provider failed");
+            return ret;
+        }
 
-err_free_buckets:
-    for (i = 0; i < disjoint_pool->buckets_num; i++) {
-        if (disjoint_pool->buckets[i] != NULL) {
-            destroy_bucket(disjoint_pool->buckets[i]);
+        for (i = 0; i < num; i++) {
+            utils_annotate_memory_undefined(ptrs[i], size);
         }
+        return UMF_RESULT_SUCCESS;
     }
-    umf_ba_global_free(disjoint_pool->buckets);
 
-err_free_shared_limits:
-    umfDisjointPoolSharedLimitsDestroy(disjoint_pool->default_shared_limits);
+    // The whole batch is served from the bucket under a single lock. The
+    // thread cache is bypassed, as it would only add a copy of every chunk.
+    bucket_t *bucket = disjoint_pool_find_bucket(disjoint_pool, size);
+    bool created_slab = false;
+    void *slab_mem[BUCKET_STASH_MAX_SLABS];
 
-err_free_known_slabs:
-    critnib_delete(disjoint_pool->known_slabs);
+    utils_mutex_lock(&bucket->bucket_lock);
 
-err_free_disjoint_pool:
-    umf_ba_global_free(disjoint_pool);
+    bucket_stash_slab_mem(bucket, num, slab_mem);
 
-    return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
-}
+    for (i = 0; i < num; i++) {
+        bool from_pool = false;
+        bool untouched = false;
+        slab_t *slab = NULL;
+        ptrs[i] = bucket_get_free_chunk(bucket, &slab, &from_pool, &untouched);
+        if (ptrs[i] == NULL) {
+            break;
+        }
 
-void *disjoint_pool_malloc(void *pool, size_t size) {
-    disjoint_pool_t *hPool = (disjoint_pool_t *)pool;
-    void *ptr = disjoint_pool_allocate(hPool, size);
+        created_slab |= !from_pool;
 
-    return ptr;
-}
+        if (disjoint_pool->params.pool_trace > 1) {
+            ++bucket->alloc_count;
+            if (from_pool) {
+                ++bucket->alloc_pool_count;
+            }
+            bucket_add_waste(bucket, slab, ptrs[i], size);
+        }
+    }
 
-void *disjoint_pool_calloc(void *pool, size_t num, size_t size) {
-    (void)pool;
-    (void)num;
-    (void)size;
+    bucket_unstash_slab_mem(bucket);
 
-    // Not supported
-    TLS_last_allocation_error = UMF_RESULT_ERROR_NOT_SUPPORTED;
-    return NULL;
-}
+    if (i < num) {
+        // return the chunks allocated so far, the batch is all-or-nothing
+        while (i-- > 0) {
+            void *ref_slab = NULL;
+            slab_t *slab =
+                disjoint_pool_find_slab(disjoint_pool, ptrs[i], &ref_slab);
+            assert(slab && ref_slab);
 
-void *disjoint_pool_realloc(void *pool, void *ptr, size_t size) {
-    (void)pool;
-    (void)ptr;
-    (void)size;
+            if (disjoint_pool->params.pool_trace > 1) {
+                bucket_sub_waste(bucket, slab, ptrs[i]);
+            }
 
-    // Not supported
-    TLS_last_allocation_error = UMF_RESULT_ERROR_NOT_SUPPORTED;
-    return NULL;
-}
+            bool to_pool = false;
+            bucket_free_chunk(bucket, ptrs[i], slab, &to_pool);
+            critnib_release(disjoint_pool->known_slabs, ref_slab);
 
-void *disjoint_pool_aligned_malloc(void *pool, size_t size, size_t alignment) {
-    disjoint_pool_t *disjoint_pool = (disjoint_pool_t *)pool;
+            if (disjoint_pool->params.pool_trace > 1) {
+                bucket->free_count++;
+            }
+        }
 
-    void *ptr = NULL;
+        utils_mutex_unlock(&bucket->bucket_lock);
+        TLS_last_allocation_error = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    }
 
-    if (size == 0) {
-        return NULL;
+    utils_mutex_unlock(&bucket->bucket_lock);
+
+    if (created_slab) {
+        disjoint_pool_decay_tick(disjoint_pool);
     }
 
-    if (alignment <= 1) {
-        return disjoint_pool_allocate(pool, size);
+    for (i = 0; i < num; i++) {
+        VALGRIND_DO_MEMPOOL_ALLOC(pool, ptrs[i], size);
+        utils_annotate_memory_undefined(ptrs[i], bucket->size);
     }
 
-    size_t aligned_size;
-    if (alignment <= disjoint_pool->provider_min_page_size) {
-        // This allocation will be served from a Bucket which size is multiple
-        // of Alignment and Slab address is aligned to provider_min_page_size
-        // so the address will be properly aligned.
-        aligned_size = (size > 1) ? ALIGN_UP_SAFE(size, alignment) : alignment;
-    } else {
-        // Slabs are only aligned to provider_min_page_size, we need to compensate
-        // for that in case the allocation is within pooling limit.
-        // TODO: consider creating properly-aligned Slabs on demand
-        aligned_size = size + alignment - 1;
+    if (disjoint_pool->params.pool_trace > 2) {
+        LOG_DEBUG("Allocated batch of %zu x %8zu %s bytes", num, size,
+                  disjoint_pool->params.name);
     }
 
-    // Check if requested allocation size is within pooling limit.
-    // If not, just request aligned pointer from the system.
-    if (aligned_size > disjoint_pool->params.max_poolable_size) {
+    return UMF_RESULT_SUCCESS;
+}
 
-        umf_result_t ret = umfMemoryProviderAlloc(disjoint_pool->provider, size,
-                                                  alignment, &ptr);
-        if (ret != UMF_RESULT_SUCCESS) {
-            TLS_last_allocation_error = ret;
-            LOG_ERR("allocation from the memory provider failed");
-            return NULL;
+umf_result_t disjoint_pool_free_batch(void *pool, void **ptrs, size_t num) {
+    disjoint_pool_t *disjoint_pool = (disjoint_pool_t *)pool;
+    if (ptrs == NULL) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    umf_result_t ret = UMF_RESULT_SUCCESS;
+
+    // Consecutive chunks of the same bucket are freed under a single
+    // acquisition of the bucket lock. The thread cache and the remote-free
+    // queues are bypassed, as the lock is taken anyway.
+    bucket_t *locked_bucket = NULL;
+
+    for (size_t i = 0; i < num; i++) {
+        void *ptr = ptrs[i];
+        if (ptr == NULL) {
+            continue;
         }
 
-        assert(ptr);
-        utils_annotate_memory_undefined(ptr, size);
-        return ptr;
-    }
+        void *ref_slab = NULL;
+        slab_t *slab = disjoint_pool_find_slab(disjoint_pool, ptr, &ref_slab);
+        if (slab == NULL) {
+            // memory comes directly from the provider
+            if (locked_bucket) {
+                utils_mutex_unlock(&locked_bucket->bucket_lock);
+                locked_bucket = NULL;
+            }
 
-    bool from_pool = false;
-    bucket_t *bucket = disjoint_pool_find_bucket(pool, aligned_size);
+            umf_result_t free_ret = disjoint_pool_free(pool, ptr);
+            if (free_ret == UMF_RESULT_SUCCESS) {
+                ptrs[i] = NULL;
+            } else if (ret == UMF_RESULT_SUCCESS) {
+                ret = free_ret;
+            }
+            continue;
+        }
 
-    utils_mutex_lock(&bucket->bucket_lock);
+        bucket_t *bucket = slab->bucket;
+        size_t chunk_idx = get_chunk_idx(ptr, slab);
+        void *unaligned_ptr = get_unaligned_ptr(chunk_idx, slab);
 
-    ptr = bucket_get_free_chunk(bucket, &from_pool);
+        VALGRIND_DO_MEMPOOL_FREE(pool, ptr);
+        utils_annotate_memory_inaccessible(unaligned_ptr, bucket->size);
 
-    if (ptr == NULL) {
-        TLS_last_allocation_error = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
-        utils_mutex_unlock(&bucket->bucket_lock);
-        return NULL;
-    }
+        if (bucket != locked_bucket) {
+            if (locked_bucket) {
+                utils_mutex_unlock(&locked_bucket->bucket_lock);
+            }
+            utils_mutex_lock(&bucket->bucket_lock);
+            locked_bucket = bucket;
+        }
 
-    if (disjoint_pool->params.pool_trace > 1) {
-        // update stats
-        ++bucket->alloc_count;
-        if (from_pool) {
-            ++bucket->alloc_pool_count;
+        if (disjoint_pool->params.pool_trace > 1) {
+            bucket_sub_waste(bucket, slab, unaligned_ptr);
         }
-    }
 
-    void *aligned_ptr = (void *)ALIGN_UP_SAFE((size_t)ptr, alignment);
-    size_t diff = (ptrdiff_t)aligned_ptr - (ptrdiff_t)ptr;
-    size_t real_size = bucket->size - diff;
-    VALGRIND_DO_MEMPOOL_ALLOC(disjoint_pool, aligned_ptr, real_size);
-    utils_annotate_memory_undefined(aligned_ptr, real_size);
+        bool to_pool = false;
+        bucket_free_chunk(bucket, unaligned_ptr, slab, &to_pool);
 
-    utils_mutex_unlock(&bucket->bucket_lock);
+        assert(ref_slab);
+        critnib_release(disjoint_pool->known_slabs, ref_slab);
 
-    if (disjoint_pool->params.pool_trace > 2) {
-        LOG_DEBUG("Allocated %8zu %s bytes aligned at %zu from %s -> %p", size,
-                  disjoint_pool->params.name, alignment,
-                  (from_pool ? "pool" : "provider"), ptr);
-    }
+        if (disjoint_pool->params.pool_trace > 1) {
+            bucket->free_count++;
+        }
 
-    return aligned_ptr;
-}
+        ptrs[i] = NULL;
+    }
 
-static size_t get_chunk_idx(const void *ptr, slab_t *slab) {
-    return (((uintptr_t)ptr - (uintptr_t)slab->mem_ptr) / slab->bucket->size);
-}
+    if (locked_bucket) {
+        utils_mutex_unlock(&locked_bucket->bucket_lock);
+    }
 
-static void *get_unaligned_ptr(size_t chunk_idx, slab_t *slab) {
-    return (void *)((uintptr_t)slab->mem_ptr + chunk_idx * slab->bucket->size);
+    return ret;
 }
 
-umf_result_t disjoint_pool_malloc_usable_size(void *pool, const void *ptr,
-                                              size_t *size) {
+void *disjoint_pool_calloc(void *pool, size_t num, size_t size) {
     disjoint_pool_t *disjoint_pool = (disjoint_pool_t *)pool;
-    if (!size || !disjoint_pool) {
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+
+    if (size != 0 && num > SIZE_MAX / size) {
+        TLS_last_allocation_error = UMF_RESULT_ERROR_INVALID_ARGUMENT;
+        LOG_ERR("calloc size overflow");
+        return NULL;
     }
+
+    size_t csize = num * size;
+    bool zeroed = false;
+    void *ptr = disjoint_pool_allocate(disjoint_pool, csize, &zeroed);
     if (ptr == NULL) {
-        *size = 0;
-        return UMF_RESULT_SUCCESS;
+        // TLS_last_allocation_error is set by disjoint_pool_allocate()
+        return NULL;
     }
 
-    // check if given pointer is allocated inside any Disjoint Pool slab
-    void *ref_slab = NULL;
-    slab_t *slab = (slab_t *)critnib_find_le(disjoint_pool->known_slabs,
-                                             (uintptr_t)ptr, &ref_slab);
-    if (slab == NULL || ptr >= slab_get_end(slab)) {
-        // memory comes directly from the provider
-        if (ref_slab) {
-            critnib_release(disjoint_pool->known_slabs, ref_slab);
-        }
-
-        umf_alloc_info_t allocInfo = {NULL, 0, NULL};
-        umf_result_t ret = umfMemoryTrackerGetAllocInfo(ptr, &allocInfo);
-        if (ret != UMF_RESULT_SUCCESS) {
-            *size = 0;
-            return ret;
-        }
+    utils_annotate_memory_defined(ptr, csize);
 
-        *size = allocInfo.baseSize;
-        return UMF_RESULT_SUCCESS;
+    if (!zeroed) {
+        memset(ptr, 0, csize); // TODO: device memory is not accessible by host
     }
 
-    // Get the unaligned pointer
-    // NOTE: the base pointer slab->mem_ptr needn't to be aligned to bucket size
-    size_t chunk_idx = get_chunk_idx(ptr, slab);
-    void *unaligned_ptr = get_unaligned_ptr(chunk_idx, slab);
-
-    ptrdiff_t diff = (ptrdiff_t)ptr - (ptrdiff_t)unaligned_ptr;
+    return ptr;
+}
 
-    *size = slab->bucket->size - diff;
+static void *disjoint_pool_realloc_move(disjoint_pool_t *pool, void *ptr,
+                                        size_t old_size, size_t size) {
+    void *new_ptr = disjoint_pool_allocate(pool, size, NULL);
+    if (new_ptr == NULL) {
+        // TLS_last_allocation_error is set by disjoint_pool_allocate()
+        return NULL;
+    }
 
-    assert(ref_slab);
-    critnib_release(disjoint_pool->known_slabs, ref_slab);
+    // TODO: device memory is not accessible by host
+    memcpy(new_ptr, ptr, utils_min(old_size, size));
 
-    return UMF_RESULT_SUCCESS;
+    disjoint_pool_free(pool, ptr);
+    return new_ptr;
 }
 
-umf_result_t disjoint_pool_free(void *pool, void *ptr) {
-    disjoint_pool_t *disjoint_pool = (disjoint_pool_t *)pool;
-    if (ptr == NULL) {
-        return UMF_RESULT_SUCCESS;
+// Resizes an allocation which bypassed the buckets and came directly from
+// the memory provider. Shrinking splits off and frees the tail of the
+// allocation. Growing succeeds in place only if the provider returns the
+// memory right after the allocation, which is then merged with it.
+// Both are possible only if the allocation is tracked on its own
+// (it was not carved out of a chunk of coarse tracking).
+static void *disjoint_pool_realloc_large(disjoint_pool_t *pool, void *ptr,
+                                         size_t size) {
+    umf_alloc_info_t allocInfo = {NULL, 0, NULL};
+    bool in_chunk = false;
+    umf_result_t ret = umfTrackingMemoryProviderGetAllocInfo(
+        pool->provider, ptr, &allocInfo, &in_chunk);
+    if (ret != UMF_RESULT_SUCCESS) {
+        TLS_last_allocation_error = ret;
+        LOG_ERR("failed to get allocation info from the memory tracker");
+        return NULL;
     }
 
-    // check if given pointer is allocated inside any Disjoint Pool slab
-    void *ref_slab = NULL;
-    slab_t *slab = (slab_t *)critnib_find_le(disjoint_pool->known_slabs,
-                                             (uintptr_t)ptr, &ref_slab);
+    // the size of the allocation from 'ptr' to its end
+    size_t old_size =
+        allocInfo.baseSize - ((uintptr_t)ptr - (uintptr_t)allocInfo.base);
+    size_t page_size = pool->provider_min_page_size;
+    if (allocInfo.base != ptr || in_chunk ||
+        size <= pool->params.max_poolable_size) {
+        return disjoint_pool_realloc_move(pool, ptr, old_size, size);
+    }
 
-    if (slab == NULL || ptr >= slab_get_end(slab)) {
-        // regular free
-        if (ref_slab) {
-            critnib_release(disjoint_pool->known_slabs, ref_slab);
+    if (page_size == 0) {
+        // split and merge need the page granularity of the provider
+        if (size <= old_size) {
+            return ptr;
         }
+        return disjoint_pool_realloc_move(pool, ptr, old_size, size);
+    }
 
-        umf_alloc_info_t allocInfo = {NULL, 0, NULL};
-        umf_result_t ret = umfMemoryTrackerGetAllocInfo(ptr, &allocInfo);
+    size_t new_size = ALIGN_UP_SAFE(size, page_size);
+    if (new_size == 0) {
+        TLS_last_allocation_error = UMF_RESULT_ERROR_INVALID_ARGUMENT;
+        return NULL;
+    }
+
+    if (new_size == old_size) {
+        return ptr;
+    }
+
+    umf_memory_provider_handle_t provider = pool->provider;
+    if (new_size < old_size) {
+        ret = umfMemoryProviderAllocationSplit(provider, ptr, old_size,
+                                               new_size);
         if (ret != UMF_RESULT_SUCCESS) {
-            TLS_last_allocation_error = ret;
-            LOG_ERR("failed to get allocation info from the memory tracker");
-            return ret;
+            // the allocation stays larger than needed, but it is still valid
+            LOG_DEBUG("cannot split allocation %p, keeping its size", ptr);
+            return ptr;
         }
 
-        size_t size = allocInfo.baseSize;
-        umf_memory_provider_handle_t provider = disjoint_pool->provider;
-        ret = umfMemoryProviderFree(provider, ptr, size);
+        void *tail = (void *)((uintptr_t)ptr + new_size);
+        ret = umfMemoryProviderFree(provider, tail, old_size - new_size);
         if (ret != UMF_RESULT_SUCCESS) {
-            TLS_last_allocation_error = ret;
-            LOG_ERR("deallocation from the memory provider failed");
+            LOG_ERR("deallocation of the tail of allocation %p failed", ptr);
         }
 
-        return ret;
+        return ptr;
     }
 
-    bool to_pool = false;
+    void *tail = NULL;
+    size_t tail_size = new_size - old_size;
+    ret = umfMemoryProviderAlloc(provider, tail_size, 0, &tail);
+    if (ret == UMF_RESULT_SUCCESS) {
+        if (tail == (void *)((uintptr_t)ptr + old_size) &&
+            umfMemoryProviderAllocationMerge(provider, ptr, tail, new_size) ==
+                UMF_RESULT_SUCCESS) {
+            utils_annotate_memory_undefined(tail, tail_size);
+            return ptr;
+        }
 
-    if (ptr < slab_get(slab) || ptr >= slab_get_end(slab)) {
-        assert(0);
-        return UMF_RESULT_ERROR_UNKNOWN;
+        umfMemoryProviderFree(provider, tail, tail_size);
     }
 
-    // The slab object won't be deleted until it's removed from the map which is
-    // protected by the lock, so it's safe to access it here.
+    return disjoint_pool_realloc_move(pool, ptr, old_size, size);
+}
 
-    bucket_t *bucket = slab->bucket;
+void *disjoint_pool_realloc(void *pool, void *ptr, size_t size) {
+    disjoint_pool_t *disjoint_pool = (disjoint_pool_t *)pool;
 
-    utils_mutex_lock(&bucket->bucket_lock);
-    VALGRIND_DO_MEMPOOL_FREE(pool, ptr);
+    if (ptr == NULL) {
+        return disjoint_pool_allocate(disjoint_pool, size, NULL);
+    }
 
-    // Get the unaligned pointer
-    // NOTE: the base pointer slab->mem_ptr needn't to be aligned to bucket size
+    if (size == 0) {
+        disjoint_pool_free(pool, ptr);
+        return NULL;
+    }
+
+    void *ref_slab = NULL;
+    slab_t *slab = disjoint_pool_find_slab(disjoint_pool, ptr, &ref_slab);
+    if (slab == NULL) {
+        return disjoint_pool_realloc_large(disjoint_pool, ptr, size);
+    }
+
+    bucket_t *bucket = slab->bucket;
     size_t chunk_idx = get_chunk_idx(ptr, slab);
     void *unaligned_ptr = get_unaligned_ptr(chunk_idx, slab);
+    size_t old_size =
+        bucket->size - ((uintptr_t)ptr - (uintptr_t)unaligned_ptr);
 
-    utils_annotate_memory_inaccessible(unaligned_ptr, bucket->size);
-    bucket_free_chunk(bucket, unaligned_ptr, slab, &to_pool);
+    // Stay in the chunk if the new size fits in it and would not be served
+    // from a smaller bucket anyway.
+    bool in_place = size <= old_size &&
+                    disjoint_pool_find_bucket(disjoint_pool, size) == bucket;
+    if (in_place && disjoint_pool->params.pool_trace > 1) {
+        bucket_sub_waste(bucket, slab, unaligned_ptr);
+        bucket_add_waste(bucket, slab, unaligned_ptr, size);
+    }
 
     assert(ref_slab);
     critnib_release(disjoint_pool->known_slabs, ref_slab);
 
-    if (disjoint_pool->params.pool_trace > 1) {
-        bucket->free_count++;
-    }
-
-    utils_mutex_unlock(&bucket->bucket_lock);
-
-    if (disjoint_pool->params.pool_trace > 2) {
-        const char *name = disjoint_pool->params.name;
-        LOG_DEBUG("freed %s %p to %s, current total pool size: %" PRIu64
-                  ", current "
-                  "pool size for %s: %zu",
-                  name, ptr, (to_pool ? "pool" : "provider"),
-                  disjoint_pool_get_limits(disjoint_pool)->total_size, name,
-                  disjoint_pool->params.cur_pool_size);
+    if (in_place) {
+        return ptr;
     }
 
-    return UMF_RESULT_SUCCESS;
+    return disjoint_pool_realloc_move(disjoint_pool, ptr, old_size, size);
 }
 
 umf_result_t disjoint_pool_get_last_allocation_error(void *pool) {
@@ -1255,13 +3171,39 @@ umf_result_t disjoint_pool_get_last_allocation_error(void *pool) {
 umf_result_t disjoint_pool_finalize(void *pool) {
     disjoint_pool_t *hPool = (disjoint_pool_t *)pool;
     umf_result_t ret = UMF_RESULT_SUCCESS;
+
+    disjoint_pool_stop_purger(hPool);
+
+    // No thread exit callbacks are called after the key is deleted, so the
+    // remaining caches can be destroyed here.
+    if (hPool->tcache_key_created) {
+        utils_tls_key_delete(hPool->tcache_key);
+    }
+
+    utils_mutex_lock(&hPool->tcache_lock);
+    tcache_t *cache = NULL, *tmp = NULL;
+    DL_FOREACH_SAFE(hPool->tcaches, cache, tmp) {
+        DL_DELETE(hPool->tcaches, cache);
+        tcache_destroy(cache);
+    }
+    utils_mutex_unlock(&hPool->tcache_lock);
+    utils_mutex_destroy_not_free(&hPool->tcache_lock);
+
     if (hPool->params.pool_trace > 1) {
         disjoint_pool_print_stats(hPool);
     }
 
-    for (size_t i = 0; i < hPool->buckets_num; i++) {
-        destroy_bucket(hPool->buckets[i]);
+    bucket_t *bucket = hPool->buckets[0];
+    while (bucket != NULL) {
+        bucket_t *next = bucket->next;
+        destroy_bucket(bucket);
+        bucket = next;
+    }
+
+    for (size_t i = 0; i < 64; i++) {
+        umf_ba_global_free(hPool->aligned_buckets[i]);
     }
+    utils_mutex_destroy_not_free(&hPool->aligned_buckets_lock);
 
     umf_ba_global_free(hPool->buckets);
     VALGRIND_DO_DESTROY_MEMPOOL(hPool);
@@ -1272,6 +3214,7 @@ umf_result_t disjoint_pool_finalize(void *pool) {
     }
 
     critnib_delete(hPool->known_slabs);
+    umf_ba_global_free(hPool->slab_table);
 
     umf_ba_global_free(hPool);
     return ret;
@@ -1294,35 +3237,44 @@ umf_result_t disjoint_pool_trim_memory(void *pool, size_t minBytesToKeep) {
     assert(pool != NULL);
     disjoint_pool_t *hPool = (disjoint_pool_t *)pool;
 
-    for (size_t i = 0; i < hPool->buckets_num; i++) {
-        bucket_t *bucket = hPool->buckets[i];
+    // return all cached chunks to the buckets first, so their slabs can
+    // become empty
+    utils_mutex_lock(&hPool->tcache_lock);
+    tcache_drain_all(hPool);
+    utils_mutex_unlock(&hPool->tcache_lock);
+
+    for (bucket_t *bucket = hPool->buckets[0]; bucket != NULL;
+         bucket = bucket_next(bucket)) {
         utils_mutex_lock(&bucket->bucket_lock);
 
+        // return the chunks freed by other threads first as well
+        bucket_reclaim_remote_frees(bucket);
+
         // remove empty slabs from the pool
         slab_list_item_t *it = NULL, *tmp = NULL;
         LL_FOREACH_SAFE(bucket->available_slabs, it, tmp) {
             slab_t *slab = it->val;
-            if (slab->num_chunks_allocated == 0) {
-                if (minBytesToKeep > 0) {
-                    // if we still have bytes to keep, do not remove slab
-                    if (minBytesToKeep > slab->slab_size) {
-                        minBytesToKeep -= slab->slab_size;
-                    } else {
-                        minBytesToKeep = 0;
-                    }
-                    continue;
-                }
 
-                // remove slab
-                destroy_slab(slab);
-                DL_DELETE(bucket->available_slabs, it);
-                assert(bucket->available_slabs_num > 0);
-                bucket->available_slabs_num--;
-                pool_unregister_slab(hPool, slab);
+            // in the lock-free mode a just emptied slab is not pooled until
+            // the thread which emptied it takes the bucket lock, it may be
+            // reused right away
+            if (slab_get_num_allocated(slab) != 0 ||
+                (bucket->lockfree && !slab->pooled)) {
+                continue;
+            }
 
-                // update stats
-                bucket_update_stats(bucket, 0, -1);
+            if (minBytesToKeep > 0) {
+                // if we still have bytes to keep, do not remove slab
+                if (minBytesToKeep > slab->slab_size) {
+                    minBytesToKeep -= slab->slab_size;
+                } else {
+                    minBytesToKeep = 0;
+                }
+                continue;
             }
+
+            // slabs still read by lock-free allocations are skipped
+            bucket_release_pooled_slab(bucket, slab);
         }
 
         utils_mutex_unlock(&bucket->bucket_lock);
@@ -1345,6 +3297,8 @@ static umf_memory_pool_ops_t UMF_DISJOINT_POOL_OPS = {
     .get_name = disjoint_pool_get_name,
     .ext_ctl = disjoint_pool_ctl,
     .ext_trim_memory = disjoint_pool_trim_memory,
+    .ext_malloc_batch = disjoint_pool_malloc_batch,
+    .ext_free_batch = disjoint_pool_free_batch,
 };
 
 const umf_memory_pool_ops_t *umfDisjointPoolOps(void) {
@@ -1493,3 +3447,111 @@ umfDisjointPoolParamsSetName(umf_disjoint_pool_params_handle_t hParams,
     hParams->name[sizeof(hParams->name) - 1] = '\0';
     return UMF_RESULT_SUCCESS;
 }
+
+umf_result_t umfDisjointPoolParamsSetThreadCacheSize(
+    umf_disjoint_pool_params_handle_t hParams, size_t numChunks) {
+    if (!hParams) {
+        LOG_ERR("disjoint pool params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->tcache_size = numChunks;
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t umfDisjointPoolParamsSetThreadCacheMaxChunkSize(
+    umf_disjoint_pool_params_handle_t hParams, size_t maxChunkSize) {
+    if (!hParams) {
+        LOG_ERR("disjoint pool params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->tcache_max_chunk_size = maxChunkSize;
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t umfDisjointPoolParamsSetProviderZeroedMemory(
+    umf_disjoint_pool_params_handle_t hParams, bool zeroed) {
+    if (!hParams) {
+        LOG_ERR("disjoint pool params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->provider_zeroed_memory = zeroed;
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t
+umfDisjointPoolParamsSetLockFreeSlabs(umf_disjoint_pool_params_handle_t hParams,
+                                      bool enable) {
+    if (!hParams) {
+        LOG_ERR("disjoint pool params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->lockfree_slabs = enable;
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t umfDisjointPoolParamsSetBucketsPerPowerOf2(
+    umf_disjoint_pool_params_handle_t hParams, size_t bucketsPerPowerOf2) {
+    if (!hParams) {
+        LOG_ERR("disjoint pool params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (bucketsPerPowerOf2 == 0 || bucketsPerPowerOf2 > 16 ||
+        !IS_POWER_OF_2(bucketsPerPowerOf2)) {
+        LOG_ERR("bucketsPerPowerOf2 must be a power of 2 not larger than 16");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->buckets_per_pow2 = bucketsPerPowerOf2;
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t umfDisjointPoolParamsSetNaturallyAlignedSlabs(
+    umf_disjoint_pool_params_handle_t hParams, bool enable) {
+    if (!hParams) {
+        LOG_ERR("disjoint pool params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->naturally_aligned_slabs = enable;
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t
+umfDisjointPoolParamsSetRemoteFree(umf_disjoint_pool_params_handle_t hParams,
+                                   bool enable) {
+    if (!hParams) {
+        LOG_ERR("disjoint pool params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->remote_free = enable;
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t
+umfDisjointPoolParamsSetDecayTime(umf_disjoint_pool_params_handle_t hParams,
+                                  size_t decayMs) {
+    if (!hParams) {
+        LOG_ERR("disjoint pool params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->decay_ms = decayMs;
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t umfDisjointPoolParamsSetBackgroundPurge(
+    umf_disjoint_pool_params_handle_t hParams, bool enable) {
+    if (!hParams) {
+        LOG_ERR("disjoint pool params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->decay_background = enable;
+    return UMF_RESULT_SUCCESS;
+}
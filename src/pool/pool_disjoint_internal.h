@@ -17,14 +17,29 @@
 
 #define CHUNK_BITMAP_SIZE 64
 
+// Minimal spacing between sizes of consecutive buckets
+#define BUCKET_MIN_SPACING 4
+
+// Number of entries of the table of naturally aligned slabs
+#define SLAB_TABLE_SIZE 4096 // must be a power of 2
+
 typedef struct bucket_t bucket_t;
 typedef struct slab_t slab_t;
 typedef struct slab_list_item_t slab_list_item_t;
 typedef struct disjoint_pool_t disjoint_pool_t;
+typedef struct tcache_t tcache_t;
 
 typedef struct bucket_t {
     size_t size;
 
+    // Alignment of the slabs and chunks of the bucket. 0 for the regular
+    // buckets, whose slabs are aligned to the provider's minimum page size.
+    size_t alignment;
+
+    // Next bucket in the list of all buckets of the pool: the regular
+    // buckets followed by the aligned ones. Requires atomic access.
+    struct bucket_t *next;
+
     // Linked list of slabs which have at least 1 available chunk.
     // We always count available slabs as an optimization.
     slab_list_item_t *available_slabs;
@@ -58,6 +73,34 @@ typedef struct bucket_t {
     // checking if a slab in this bucket is already pooled.
     size_t chunked_slabs_in_pool;
 
+    // Whether chunks of this bucket are claimed and released with atomic
+    // operations on the slab bitmaps (see umf_disjoint_pool_params_t).
+    bool lockfree;
+
+    // Slab used by lock-free allocations - the head of the available_slabs
+    // list, republished under bucket_lock whenever the list changes.
+    // Requires atomic access.
+    slab_t *lockfree_slab;
+
+    // Number of lock-free allocations which may still access lockfree_slab.
+    // A slab is destroyed only when it is unpublished and this drops to 0.
+    // Requires atomic access.
+    size_t lockfree_users;
+
+    // Whether chunks freed by threads other than the owner of their slab are
+    // queued on the slab instead of taking the bucket lock
+    // (see umf_disjoint_pool_params_t).
+    bool remote_free;
+
+    // Number of queued remote frees in all slabs of the bucket, not yet
+    // reclaimed. Requires atomic access.
+    size_t remote_frees;
+
+    // Memory of the new slabs allocated at once for a batch of chunks
+    // (see disjoint_pool_malloc_batch()), taken by create_slab().
+    void **slab_mem_stash;
+    size_t slab_mem_stash_num;
+
     // Statistics
     size_t alloc_count;
     size_t alloc_pool_count;
@@ -66,6 +109,9 @@ typedef struct bucket_t {
     size_t curr_slabs_in_pool;
     size_t max_slabs_in_pool;
     size_t max_slabs_in_use;
+    // Bytes lost by rounding the requested sizes up to the bucket size
+    // in the chunks allocated at the moment. Requires atomic access.
+    size_t wasted_bytes;
 } bucket_t;
 
 typedef struct slab_list_item_t {
@@ -88,9 +134,15 @@ typedef struct slab_t {
     // Num of 64-bit words needed to store chunk state
     size_t num_words;
 
-    // Total number of allocated chunks at the moment.
+    // Total number of allocated chunks at the moment. In the lock-free mode
+    // it also counts chunks reserved but not yet claimed from the bitmap and
+    // requires atomic access.
     size_t num_chunks_allocated;
 
+    // Chunks with index >= first_untouched_chunk were never handed out, so
+    // they still hold the memory as returned by the memory provider.
+    size_t first_untouched_chunk;
+
     // The bucket which the slab belongs to
     bucket_t *bucket;
 
@@ -98,6 +150,35 @@ typedef struct slab_t {
     // to achieve O(1) removal
     slab_list_item_t iter;
 
+    // State of the slab in the lock-free mode, protected by the bucket lock:
+    // whether the slab is on the available list, whether it is empty and
+    // counted as pooled, and whether it was already removed from the bucket.
+    bool available;
+    bool pooled;
+    bool removed;
+
+    // With the decay enabled: the time (in ms) when the empty slab was put in
+    // the pool and whether its memory was already purged since then
+    uint64_t empty_since;
+    bool purged;
+
+    // Thread which last allocated a chunk from the slab, frees from other
+    // threads are remote. Requires atomic access.
+    size_t owner;
+
+    // Number of chunks in remote_chunks, requires atomic access
+    size_t remote_frees;
+
+    // Bitmap of chunks freed by other threads and not yet returned to the
+    // slab - a set bit marks a queued chunk. Stored right after 'chunks' if
+    // the bucket uses remote frees, NULL otherwise.
+    uint64_t *remote_chunks;
+
+    // Bytes lost by rounding up the requested size of each allocated chunk
+    // (less than CutOff), stored after the bitmaps if the pool collects
+    // statistics (pool_trace > 1), NULL otherwise.
+    uint32_t *chunk_waste;
+
     // Represents the current state of each chunk: if the bit is clear, the
     // chunk is allocated; otherwise, the chunk is free for allocation
     uint64_t chunks[];
@@ -122,6 +203,11 @@ typedef struct umf_disjoint_pool_params_t {
     // This value must be a power of 2.
     size_t min_bucket_size; // Default: 8
 
+    // Number of buckets between two consecutive powers of 2. This value must
+    // be a power of 2. Buckets are never spaced closer than
+    // BUCKET_MIN_SPACING bytes, so small powers of 2 may have fewer buckets.
+    size_t buckets_per_pow2; // Default: 2
+
     // Holds size of the pool managed by the allocator.
     size_t cur_pool_size; // Default: 0
 
@@ -135,8 +221,74 @@ typedef struct umf_disjoint_pool_params_t {
 
     // Name used in traces
     char name[64];
+
+    // Number of free chunks each thread can cache per bucket, 0 disables
+    // per-thread caches. Requires atomic access, as it can be changed by CTL.
+    size_t tcache_size; // Default: 0
+
+    // Largest bucket size served from the per-thread caches
+    size_t tcache_max_chunk_size; // Default: 32KB
+
+    // Whether the memory provider returns zero-filled memory. If so, calloc
+    // skips zeroing of chunks which were never used before.
+    bool provider_zeroed_memory; // Default: false
+
+    // Whether chunks of small buckets are claimed and released with atomic
+    // operations on the slab bitmaps, so only the moves of slabs between the
+    // available and unavailable lists take the bucket lock.
+    bool lockfree_slabs; // Default: false
+
+    // Whether slabs are allocated aligned to slab_min_size, so the slab of a
+    // chunk can be found by masking the pointer on free. Requires
+    // slab_min_size to be a power of 2.
+    bool naturally_aligned_slabs; // Default: false
+
+    // Whether chunks of small buckets freed by a thread other than the one
+    // allocating from their slab are queued on the slab with atomic
+    // operations, to be reclaimed in batch by the next allocation which finds
+    // no available slab in the bucket.
+    bool remote_free; // Default: false
+
+    // Time in milliseconds after which an empty slab kept in the pool is
+    // purged, it is returned to the memory provider after twice this time.
+    // While the decay is enabled, 'capacity' does not limit the number of
+    // empty slabs in the pool. 0 disables the decay. Requires atomic access,
+    // as it can be changed by CTL.
+    size_t decay_ms; // Default: 0
+
+    // Whether the decay is applied by a background thread of the pool
+    // instead of by the allocations which have to create a new slab
+    bool decay_background; // Default: false
 } umf_disjoint_pool_params_t;
 
+// Magazine of free chunks of a single bucket, owned by one thread
+typedef struct tcache_bin_t {
+    size_t count;
+    // Chunks are handed out and cached in LIFO order; the slab of each chunk
+    // is kept next to it, so flushing does not need to look it up again.
+    void **chunks;
+    slab_t **slabs;
+} tcache_bin_t;
+
+// Per-thread cache of free chunks of a single disjoint pool
+typedef struct tcache_t {
+    disjoint_pool_t *pool;
+
+    // Uncontended in the common case - taken by the owning thread on every
+    // cached operation and by other threads only to drain the cache
+    // (trim_memory, ctl, finalize).
+    utils_mutex_t lock;
+
+    // Capacity of each bin (params.tcache_size at cache creation)
+    size_t capacity;
+
+    // List of all caches of the pool, protected by pool->tcache_lock
+    struct tcache_t *prev, *next;
+
+    // One bin for each of the first pool->tcache_buckets_num buckets
+    tcache_bin_t bins[];
+} tcache_t;
+
 typedef struct disjoint_pool_t {
     // Keep the list of known slabs to quickly find required one during the
     // free()
@@ -157,8 +309,59 @@ typedef struct disjoint_pool_t {
     // Used in algorithm for finding buckets
     size_t min_bucket_size_exp;
 
+    // Lookup tables for finding buckets, indexed by the position of the
+    // leftmost set bit of (size - 1): index of the first bucket above the
+    // power of 2 and the log2 of the spacing between its buckets.
+    size_t pow2_first_bucket[64];
+    unsigned char pow2_bucket_spacing_exp[64];
+
     // Coarse-grain allocation min alignment
     size_t provider_min_page_size;
+
+    // Mask giving the start of the slab of a chunk, if slabs are naturally
+    // aligned (see umf_disjoint_pool_params_t), 0 otherwise
+    uintptr_t slab_addr_mask;
+    // number of registered slabs larger than slab_min_size, which
+    // the mask does not always find
+    uint64_t big_slabs_num;
+
+    // Direct-mapped table of the registered slabs indexed by their address
+    // divided by slab_min_size (1 << slab_table_shift), if slabs are
+    // naturally aligned. Requires atomic access. A slab is missing from it
+    // only if another one with the same index replaced it.
+    slab_t **slab_table;
+    size_t slab_table_shift;
+
+    // Buckets serving allocations aligned to more than provider_min_page_size,
+    // created on demand. aligned_buckets[n] is NULL or an array of buckets_num
+    // buckets with slabs aligned to 2^n, indexed like the 'buckets' array.
+    // Both the arrays and their elements require atomic access.
+    bucket_t **aligned_buckets[64];
+    // Protects the creation of the aligned buckets
+    utils_mutex_t aligned_buckets_lock;
+
+    // Per-thread caches. The TLS key is created when the caches are enabled
+    // for the first time and the value of the key is the cache of the
+    // calling thread.
+    utils_tls_key_t tcache_key;
+    bool tcache_key_created;
+    // Number of leading buckets served from the per-thread caches
+    size_t tcache_buckets_num;
+    // Protects the list of caches and the creation of the key
+    utils_mutex_t tcache_lock;
+    tcache_t *tcaches;
+
+    // Time (in ms) of the last decay pass. Requires atomic access.
+    uint64_t decay_last;
+
+    // Background thread applying the decay, if params.decay_background is
+    // set. The thread waits on purger_cond and exits when purger_stop is set,
+    // both protected by purger_lock.
+    utils_thread_t purger;
+    bool purger_running;
+    bool purger_stop;
+    utils_mutex_t purger_lock;
+    utils_cond_t purger_cond;
 } disjoint_pool_t;
 
 static inline void slab_set_chunk_bit(slab_t *slab, size_t index, bool value) {
@@ -181,4 +384,18 @@ static inline int slab_read_chunk_bit(const slab_t *slab, size_t index) {
     return (slab->chunks[word_index] >> bit_index) & 1;
 }
 
+static inline size_t slab_get_num_allocated(slab_t *slab) {
+    size_t allocated = 0;
+    utils_atomic_load_acquire_size_t(&slab->num_chunks_allocated, &allocated);
+    return allocated;
+}
+
+// Returns the next bucket in the list of all buckets of the pool, which starts
+// at pool->buckets[0]
+static inline bucket_t *bucket_next(bucket_t *bucket) {
+    bucket_t *next = NULL;
+    utils_atomic_load_acquire_ptr((void **)&bucket->next, (void **)&next);
+    return next;
+}
+
 #endif // UMF_POOL_DISJOINT_INTERNAL_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2025 Intel Corporation
+ *
+ * Under the Apache License v2.0 with LLVM Exceptions. See LICENSE.TXT.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+// CTL nodes of the defragmentation report of the coarse-based providers,
+// CTL_PROVIDER_TYPE has to contain the 'coarse' handle of the coarse library.
+
+#ifdef UMF_PROVIDER_CTL_DEFRAG_IMPL_H
+#error This file should not be included more than once
+#else
+#define UMF_PROVIDER_CTL_DEFRAG_IMPL_H 1
+
+#ifndef CTL_PROVIDER_TYPE
+#error "CTL_PROVIDER_TYPE must be defined"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include <umf/memory_provider.h>
+
+#include "coarse.h"
+#include "ctl/ctl_internal.h"
+
+// arg is an array of size_t of (size / sizeof(size_t)) bins,
+// see coarse_get_free_histogram() for details
+static umf_result_t
+CTL_READ_HANDLER(free_histogram)(void *ctx, umf_ctl_query_source_t source,
+                                 void *arg, size_t size,
+                                 umf_ctl_index_utlist_t *indexes) {
+    /* suppress unused-parameter errors */
+    (void)source, (void)indexes;
+
+    if (arg == NULL || size < sizeof(size_t)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    CTL_PROVIDER_TYPE *provider = (CTL_PROVIDER_TYPE *)ctx;
+    return coarse_get_free_histogram(provider->coarse, arg,
+                                     size / sizeof(size_t));
+}
+
+// arg is an array of umf_compaction_hint_t of
+// (size / sizeof(umf_compaction_hint_t)) hints, the entries after the last
+// hint are zeroed, see coarse_get_compaction_hints() for details
+static umf_result_t
+CTL_READ_HANDLER(hints)(void *ctx, umf_ctl_query_source_t source, void *arg,
+                        size_t size, umf_ctl_index_utlist_t *indexes) {
+    /* suppress unused-parameter errors */
+    (void)source, (void)indexes;
+
+    if (arg == NULL || size < sizeof(umf_compaction_hint_t)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    CTL_PROVIDER_TYPE *provider = (CTL_PROVIDER_TYPE *)ctx;
+    umf_compaction_hint_t *hints = arg;
+    size_t max_hints = size / sizeof(umf_compaction_hint_t);
+    size_t num_hints = 0;
+
+    umf_result_t ret = coarse_get_compaction_hints(provider->coarse, hints,
+                                                   max_hints, &num_hints);
+    if (ret != UMF_RESULT_SUCCESS) {
+        return ret;
+    }
+
+    memset(&hints[num_hints], 0,
+           (max_hints - num_hints) * sizeof(umf_compaction_hint_t));
+
+    return UMF_RESULT_SUCCESS;
+}
+
+static const umf_ctl_node_t CTL_NODE(defrag)[] = {
+    CTL_LEAF_RO(free_histogram), CTL_LEAF_RO(hints), CTL_NODE_END};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UMF_PROVIDER_CTL_DEFRAG_IMPL_H */
@@ -99,6 +99,7 @@ typedef struct devdax_memory_provider_t {
 } devdax_memory_provider_t;
 
 #define CTL_PROVIDER_TYPE devdax_memory_provider_t
+#include "provider_ctl_defrag_impl.h"
 #include "provider_ctl_stats_impl.h"
 
 // DevDax Memory provider settings struct
@@ -149,6 +150,7 @@ static void devdax_store_last_native_error(int32_t native_error,
 
 static void initialize_devdax_ctl(void) {
     CTL_REGISTER_MODULE(&devdax_memory_ctl_root, stats);
+    CTL_REGISTER_MODULE(&devdax_memory_ctl_root, defrag);
 }
 
 static umf_result_t
@@ -204,6 +206,7 @@ static umf_result_t devdax_initialize(const void *params, void **provider) {
     coarse_params_t coarse_params = {0};
     coarse_params.provider = devdax_provider;
     coarse_params.page_size = DEVDAX_PAGE_SIZE_2MB;
+    coarse_params.num_arenas = COARSE_PROVIDER_NUM_ARENAS;
     // The alloc callback is not available in case of the devdax provider
     // because it is a fixed-size memory provider
     // and the entire devdax memory is added as a single block
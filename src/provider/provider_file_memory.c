@@ -76,6 +76,22 @@ umf_result_t umfFileMemoryProviderParamsSetName(
     return UMF_RESULT_ERROR_NOT_SUPPORTED;
 }
 
+umf_result_t umfFileMemoryProviderParamsSetLazyBacking(
+    umf_file_memory_provider_params_handle_t hParams, bool enable) {
+    (void)hParams;
+    (void)enable;
+    LOG_ERR("File memory provider is disabled!");
+    return UMF_RESULT_ERROR_NOT_SUPPORTED;
+}
+
+umf_result_t umfFileMemoryProviderParamsSetBackgroundPunch(
+    umf_file_memory_provider_params_handle_t hParams, bool enable) {
+    (void)hParams;
+    (void)enable;
+    LOG_ERR("File memory provider is disabled!");
+    return UMF_RESULT_ERROR_NOT_SUPPORTED;
+}
+
 #else // !defined(_WIN32)
 
 #include "base_alloc_global.h"
@@ -83,6 +99,7 @@ umf_result_t umfFileMemoryProviderParamsSetName(
 #include "critnib.h"
 #include "libumf.h"
 #include "provider_ctl_stats_type.h"
+#include "ravl.h"
 #include "utils_common.h"
 #include "utils_concurrency.h"
 #include "utils_log.h"
@@ -91,6 +108,13 @@ umf_result_t umfFileMemoryProviderParamsSetName(
 
 #define TLS_MSG_BUF_LEN 1024
 
+// Interval of the background thread punching holes in the file
+#define FILE_PUNCH_INTERVAL_MS 100
+
+// Size of the pending holes which wakes up the background thread
+// before the interval elapses
+#define FILE_PUNCH_BATCH_SIZE ((size_t)(64 * 1024 * 1024)) // == 64 MB
+
 static const char *DEFAULT_NAME = "FILE";
 
 typedef struct file_memory_provider_t {
@@ -124,11 +148,42 @@ typedef struct file_memory_provider_t {
 
     coarse_t *coarse; // coarse library handle
 
+    // the file grows sparsely and holes are punched in the file
+    // in place of the freed and force-purged memory
+    bool lazy_backing;
+
+    // holes of the freed memory are queued and punched in batches
+    // by the background thread (if punch_thread_running is true)
+    // or by file_free()
+    utils_mutex_t punch_lock;        // lock for the fields below
+    utils_cond_t punch_cond;         // wakes up the background thread
+    utils_cond_t punch_flushed_cond; // signaled when a batch is punched
+    utils_thread_t punch_thread;
+    bool punch_thread_running;
+    bool punch_thread_stop;
+    // punch_ranges - tree of file ranges waiting for punching a hole
+    // (file_punch_range_t) - sorted by the offset in the file
+    struct ravl *punch_ranges;
+    // punch_flushing - the batch of ranges punched right now outside
+    // of punch_lock (if punch_flushing_busy is true), read-only until then
+    struct ravl *punch_flushing;
+    bool punch_flushing_busy;
+    uint64_t punch_flushed_count; // number of batches punched so far
+    size_t punch_pending; // total size of punch_ranges and punch_flushing
+
     ctl_stats_t stats;
     char name[64];
 } file_memory_provider_t;
 
+// a file range waiting for punching a hole
+typedef struct file_punch_range_t {
+    size_t offset_fd;
+    size_t size;
+    void *ptr; // purged before punching with UMF_MEM_MAP_PRIVATE
+} file_punch_range_t;
+
 #define CTL_PROVIDER_TYPE file_memory_provider_t
+#include "provider_ctl_defrag_impl.h"
 #include "provider_ctl_stats_impl.h"
 
 // File Memory Provider settings struct
@@ -137,6 +192,8 @@ typedef struct umf_file_memory_provider_params_t {
     unsigned protection;
     umf_memory_visibility_t visibility;
     char name[64];
+    bool lazy_backing;
+    bool background_punch;
 } umf_file_memory_provider_params_t;
 
 typedef struct file_last_native_error_t {
@@ -175,6 +232,7 @@ static void file_store_last_native_error(int32_t native_error,
 
 static void initialize_file_ctl(void) {
     CTL_REGISTER_MODULE(&file_memory_ctl_root, stats);
+    CTL_REGISTER_MODULE(&file_memory_ctl_root, defrag);
 }
 
 static umf_result_t
@@ -202,6 +260,437 @@ file_translate_params(const umf_file_memory_provider_params_t *in_params,
     return UMF_RESULT_SUCCESS;
 }
 
+// The functions "file_punch_*" punch holes in the file in place of the freed
+// memory when the lazy backing is enabled. file_discard_cb() called by
+// coarse_free() under the lock of the arena of the freed block only queues
+// the range of the hole. The queued ranges are punched in batches outside
+// of any lock, either by the background thread or by file_free() right after
+// coarse_free() returns. A block allocated from the coarse library can be
+// still queued in the meantime, so file_alloc() cancels the queued ranges
+// of the allocated block, waiting for the batch punched right now
+// if it overlaps the block.
+
+// The compare function of the file_provider->punch_ranges tree
+static int file_punch_range_comp(const void *lhs, const void *rhs) {
+    const file_punch_range_t *lhs_range = (const file_punch_range_t *)lhs;
+    const file_punch_range_t *rhs_range = (const file_punch_range_t *)rhs;
+
+    if (lhs_range->offset_fd < rhs_range->offset_fd) {
+        return -1;
+    }
+
+    if (lhs_range->offset_fd > rhs_range->offset_fd) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// file_get_offset_fd - get the offset in the file of the memory range
+// [ptr, ptr + size). It fails if the range does not lie within a single
+// memory mapping of the file.
+static int file_get_offset_fd(file_memory_provider_t *file_provider,
+                              void *ptr, size_t size, size_t *offset_fd) {
+    uintptr_t addr = (uintptr_t)ptr;
+    uintptr_t rkey = 0;
+    void *rvalue = NULL;
+
+    if (critnib_find(file_provider->mmaps, addr, FIND_LE, &rkey, &rvalue,
+                     NULL) != 1 ||
+        addr + size > rkey + (size_t)rvalue) {
+        return -1;
+    }
+
+    uintptr_t mmap_addr = rkey;
+
+    // a memory mapping is contiguous in the file, so the offset
+    // of any allocation of this mapping is enough
+    if (critnib_find(file_provider->fd_offset_map, addr, FIND_LE, &rkey,
+                     &rvalue, NULL) != 1 ||
+        rkey < mmap_addr) {
+        return -1;
+    }
+
+    *offset_fd = ((size_t)rvalue - 1) + (addr - rkey);
+
+    return 0;
+}
+
+// file_punch_get_hole - get the hole which can be punched in place
+// of the memory range [ptr, ptr + size): the whole pages of the range
+static int file_punch_get_hole(file_memory_provider_t *file_provider,
+                               void *ptr, size_t size, void **hole_ptr,
+                               size_t *hole_offset_fd, size_t *hole_size) {
+    size_t page_size = file_provider->page_size;
+    size_t offset_fd;
+
+    if (file_get_offset_fd(file_provider, ptr, size, &offset_fd)) {
+        return -1;
+    }
+
+    size_t start = ALIGN_UP(offset_fd, page_size);
+    size_t end = ALIGN_DOWN(offset_fd + size, page_size);
+    if (start >= end) {
+        return -1;
+    }
+
+    *hole_ptr = (char *)ptr + (start - offset_fd);
+    *hole_offset_fd = start;
+    *hole_size = end - start;
+
+    return 0;
+}
+
+static void file_punch_hole(file_memory_provider_t *file_provider,
+                            size_t offset_fd, size_t size) {
+    errno = 0;
+    if (utils_punch_hole(file_provider->fd, offset_fd, size)) {
+        LOG_PDEBUG("punching a hole in the file failed (offset=%zu, size=%zu)",
+                   offset_fd, size);
+        return;
+    }
+
+    LOG_DEBUG("punched a hole in the file (offset=%zu, size=%zu)", offset_fd,
+              size);
+}
+
+// file_punch_release - release the memory and the file space of the range
+static void file_punch_release(file_memory_provider_t *file_provider,
+                               const file_punch_range_t *range) {
+    // With the UMF_MEM_MAP_PRIVATE visibility (IPC is disabled),
+    // the written pages are private copies, which punching a hole
+    // does not release.
+    if (!file_provider->IPC_enabled &&
+        utils_purge(range->ptr, range->size, UMF_PURGE_FORCE)) {
+        LOG_PDEBUG("purging the freed memory failed (addr=%p, size=%zu)",
+                   range->ptr, range->size);
+    }
+
+    file_punch_hole(file_provider, range->offset_fd, range->size);
+}
+
+// file_punch_ranges_adjacent - check if the range 'rhs' directly follows
+// the range 'lhs' in the file (and in the memory, if it has to be purged)
+static bool file_punch_ranges_adjacent(file_memory_provider_t *file_provider,
+                                       const file_punch_range_t *lhs,
+                                       const file_punch_range_t *rhs) {
+    return lhs->offset_fd + lhs->size == rhs->offset_fd &&
+           (file_provider->IPC_enabled ||
+            (char *)lhs->ptr + lhs->size == (char *)rhs->ptr);
+}
+
+// file_punch_queue_add - queue the given range and coalesce it
+// with the adjacent queued ranges
+// NOTE: this function must be called under file_provider->punch_lock
+static int file_punch_queue_add(file_memory_provider_t *file_provider,
+                                size_t offset_fd, size_t size, void *ptr) {
+    struct ravl *ranges = file_provider->punch_ranges;
+    file_punch_range_t new_range = {offset_fd, size, ptr};
+
+    if (ravl_emplace_copy(ranges, &new_range)) {
+        return -1;
+    }
+
+    utils_atomic_store_release_size_t(&file_provider->punch_pending,
+                                      file_provider->punch_pending + size);
+
+    struct ravl_node *node =
+        ravl_find(ranges, &new_range, RAVL_PREDICATE_EQUAL);
+    assert(node);
+    file_punch_range_t *range = ravl_data(node);
+
+    struct ravl_node *next = ravl_node_successor(node);
+    if (next) {
+        file_punch_range_t *next_range = ravl_data(next);
+        if (file_punch_ranges_adjacent(file_provider, range, next_range)) {
+            range->size += next_range->size;
+            ravl_remove(ranges, next);
+        }
+    }
+
+    struct ravl_node *prev = ravl_node_predecessor(node);
+    if (prev) {
+        file_punch_range_t *prev_range = ravl_data(prev);
+        if (file_punch_ranges_adjacent(file_provider, prev_range, range)) {
+            prev_range->size += range->size;
+            ravl_remove(ranges, node);
+        }
+    }
+
+    return 0;
+}
+
+// file_punch_queue_cancel - remove the given range from the queued ranges,
+// returns true if it overlaps the batch punched right now
+// NOTE: this function must be called under file_provider->punch_lock
+static bool file_punch_queue_cancel(file_memory_provider_t *file_provider,
+                                    size_t offset_fd, size_t size) {
+    struct ravl *ranges = file_provider->punch_ranges;
+    size_t end = offset_fd + size;
+    file_punch_range_t last = {end - 1, 0, NULL};
+    struct ravl_node *node;
+
+    // look through the queued ranges starting before the end
+    // of the given range from the last one
+    while ((node = ravl_find(ranges, &last, RAVL_PREDICATE_LESS_EQUAL))) {
+        file_punch_range_t range = *(file_punch_range_t *)ravl_data(node);
+        size_t range_end = range.offset_fd + range.size;
+        if (range_end <= offset_fd) {
+            break;
+        }
+
+        ravl_remove(ranges, node);
+        utils_atomic_store_release_size_t(&file_provider->punch_pending,
+                                          file_provider->punch_pending -
+                                              range.size);
+
+        // the parts of the queued range outside of the given range
+        // stay queued (if it fails, their holes are just not punched)
+        if (range.offset_fd < offset_fd &&
+            file_punch_queue_add(file_provider, range.offset_fd,
+                                 offset_fd - range.offset_fd, range.ptr)) {
+            LOG_DEBUG("queuing a hole failed (offset=%zu, size=%zu)",
+                      range.offset_fd, offset_fd - range.offset_fd);
+        }
+
+        if (range_end > end &&
+            file_punch_queue_add(file_provider, end, range_end - end,
+                                 (char *)range.ptr +
+                                     (end - range.offset_fd))) {
+            LOG_DEBUG("queuing a hole failed (offset=%zu, size=%zu)", end,
+                      range_end - end);
+        }
+    }
+
+    if (!file_provider->punch_flushing_busy) {
+        return false;
+    }
+
+    // the ranges of a batch do not overlap, so only the last one
+    // starting before the end of the given range can overlap it
+    node = ravl_find(file_provider->punch_flushing, &last,
+                     RAVL_PREDICATE_LESS_EQUAL);
+    if (node == NULL) {
+        return false;
+    }
+
+    file_punch_range_t *range = ravl_data(node);
+    return range->offset_fd + range->size > offset_fd;
+}
+
+// file_punch_queue_flush - punch holes of all queued ranges
+//
+// The queued ranges are swapped out under punch_lock and punched outside
+// of it. If another thread is punching a batch right now, it punches also
+// the ranges queued in the meantime, so this function returns at once.
+static void file_punch_queue_flush(file_memory_provider_t *file_provider) {
+    size_t pending = 0;
+    utils_atomic_load_acquire_size_t(&file_provider->punch_pending, &pending);
+    if (pending == 0) {
+        return;
+    }
+
+    utils_mutex_lock(&file_provider->punch_lock);
+    if (file_provider->punch_flushing_busy) {
+        utils_mutex_unlock(&file_provider->punch_lock);
+        return;
+    }
+
+    file_provider->punch_flushing_busy = true;
+    while (!ravl_empty(file_provider->punch_ranges)) {
+        struct ravl *batch = file_provider->punch_ranges;
+        file_provider->punch_ranges = file_provider->punch_flushing;
+        file_provider->punch_flushing = batch;
+        utils_mutex_unlock(&file_provider->punch_lock);
+
+        size_t batch_size = 0;
+        for (struct ravl_node *node = ravl_first(batch); node;
+             node = ravl_node_successor(node)) {
+            file_punch_range_t *range = ravl_data(node);
+            file_punch_release(file_provider, range);
+            batch_size += range->size;
+        }
+
+        utils_mutex_lock(&file_provider->punch_lock);
+        ravl_clear(batch);
+        // decreased after punching the holes, see file_punch_cancel()
+        utils_atomic_store_release_size_t(&file_provider->punch_pending,
+                                          file_provider->punch_pending -
+                                              batch_size);
+        file_provider->punch_flushed_count++;
+        utils_cond_broadcast(&file_provider->punch_flushed_cond);
+    }
+    file_provider->punch_flushing_busy = false;
+    utils_mutex_unlock(&file_provider->punch_lock);
+}
+
+// file_punch_cancel - make sure no hole is punched in the memory
+// of the given allocation later on
+static void file_punch_cancel(file_memory_provider_t *file_provider,
+                              void *ptr, size_t size) {
+    // The range of the allocation was queued before the block was freed
+    // in the coarse library, and punch_pending is decreased only after
+    // punching the holes, so it is enough to check it without the lock.
+    size_t pending = 0;
+    utils_atomic_load_acquire_size_t(&file_provider->punch_pending, &pending);
+    if (pending == 0) {
+        return;
+    }
+
+    size_t page_size = file_provider->page_size;
+    size_t offset_fd;
+    if (file_get_offset_fd(file_provider, ptr, size, &offset_fd)) {
+        return;
+    }
+
+    size_t start = ALIGN_DOWN(offset_fd, page_size);
+    size_t end = ALIGN_UP(offset_fd + size, page_size);
+
+    utils_mutex_lock(&file_provider->punch_lock);
+    if (file_punch_queue_cancel(file_provider, start, end - start)) {
+        // the block cannot be used until the overlapping batch is punched
+        uint64_t flushed_count = file_provider->punch_flushed_count;
+        while (file_provider->punch_flushed_count == flushed_count) {
+            utils_cond_timedwait(&file_provider->punch_flushed_cond,
+                                 &file_provider->punch_lock,
+                                 FILE_PUNCH_INTERVAL_MS);
+        }
+    }
+    utils_mutex_unlock(&file_provider->punch_lock);
+}
+
+static void file_punch_thread(void *arg) {
+    file_memory_provider_t *file_provider = (file_memory_provider_t *)arg;
+
+    utils_mutex_lock(&file_provider->punch_lock);
+    while (!file_provider->punch_thread_stop) {
+        utils_cond_timedwait(&file_provider->punch_cond,
+                             &file_provider->punch_lock,
+                             FILE_PUNCH_INTERVAL_MS);
+        utils_mutex_unlock(&file_provider->punch_lock);
+
+        // the queued holes are punched also when the thread is stopped
+        file_punch_queue_flush(file_provider);
+
+        utils_mutex_lock(&file_provider->punch_lock);
+    }
+    utils_mutex_unlock(&file_provider->punch_lock);
+}
+
+static umf_result_t
+file_punch_start_thread(file_memory_provider_t *file_provider,
+                        bool background) {
+    umf_result_t ret = UMF_RESULT_ERROR_UNKNOWN;
+
+    file_provider->punch_thread_running = false;
+    file_provider->punch_thread_stop = false;
+    file_provider->punch_flushing_busy = false;
+    file_provider->punch_flushed_count = 0;
+    file_provider->punch_pending = 0;
+
+    file_provider->punch_ranges =
+        ravl_new_sized(file_punch_range_comp, sizeof(file_punch_range_t));
+    if (file_provider->punch_ranges == NULL) {
+        LOG_ERR("creating the tree of holes failed");
+        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    file_provider->punch_flushing =
+        ravl_new_sized(file_punch_range_comp, sizeof(file_punch_range_t));
+    if (file_provider->punch_flushing == NULL) {
+        LOG_ERR("creating the tree of holes failed");
+        ret = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+        goto err_delete_punch_ranges;
+    }
+
+    if (utils_mutex_init(&file_provider->punch_lock) == NULL) {
+        LOG_ERR("punch lock init failed");
+        goto err_delete_punch_flushing;
+    }
+
+    if (utils_cond_init(&file_provider->punch_cond) == NULL) {
+        LOG_ERR("punch condition variable init failed");
+        goto err_destroy_punch_lock;
+    }
+
+    if (utils_cond_init(&file_provider->punch_flushed_cond) == NULL) {
+        LOG_ERR("punch condition variable init failed");
+        goto err_destroy_punch_cond;
+    }
+
+    if (!background) {
+        return UMF_RESULT_SUCCESS;
+    }
+
+    if (utils_thread_create(&file_provider->punch_thread, file_punch_thread,
+                            file_provider)) {
+        LOG_ERR("creating the thread punching holes failed");
+        goto err_destroy_punch_flushed_cond;
+    }
+
+    file_provider->punch_thread_running = true;
+
+    return UMF_RESULT_SUCCESS;
+
+err_destroy_punch_flushed_cond:
+    utils_cond_destroy_not_free(&file_provider->punch_flushed_cond);
+err_destroy_punch_cond:
+    utils_cond_destroy_not_free(&file_provider->punch_cond);
+err_destroy_punch_lock:
+    utils_mutex_destroy_not_free(&file_provider->punch_lock);
+err_delete_punch_flushing:
+    ravl_delete(file_provider->punch_flushing);
+err_delete_punch_ranges:
+    ravl_delete(file_provider->punch_ranges);
+    return ret;
+}
+
+static void file_punch_stop_thread(file_memory_provider_t *file_provider) {
+    if (file_provider->punch_thread_running) {
+        utils_mutex_lock(&file_provider->punch_lock);
+        file_provider->punch_thread_stop = true;
+        utils_cond_signal(&file_provider->punch_cond);
+        utils_mutex_unlock(&file_provider->punch_lock);
+
+        utils_thread_join(&file_provider->punch_thread);
+        file_provider->punch_thread_running = false;
+    }
+
+    utils_cond_destroy_not_free(&file_provider->punch_flushed_cond);
+    utils_cond_destroy_not_free(&file_provider->punch_cond);
+    utils_mutex_destroy_not_free(&file_provider->punch_lock);
+    ravl_delete(file_provider->punch_flushing);
+    ravl_delete(file_provider->punch_ranges);
+}
+
+// the discard() coarse callback - queue a hole in place of the freed block
+static umf_result_t file_discard_cb(void *provider, void *ptr, size_t size) {
+    file_memory_provider_t *file_provider = (file_memory_provider_t *)provider;
+    file_punch_range_t hole;
+
+    if (file_punch_get_hole(file_provider, ptr, size, &hole.ptr,
+                            &hole.offset_fd, &hole.size)) {
+        // no whole page to release
+        return UMF_RESULT_SUCCESS;
+    }
+
+    utils_mutex_lock(&file_provider->punch_lock);
+    int ret = file_punch_queue_add(file_provider, hole.offset_fd, hole.size,
+                                   hole.ptr);
+    if (ret == 0 && file_provider->punch_thread_running &&
+        file_provider->punch_pending >= FILE_PUNCH_BATCH_SIZE) {
+        utils_cond_signal(&file_provider->punch_cond);
+    }
+    utils_mutex_unlock(&file_provider->punch_lock);
+
+    if (ret) {
+        // the block is still used, so it cannot be allocated in the meantime
+        file_punch_release(file_provider, &hole);
+    }
+
+    return UMF_RESULT_SUCCESS;
+}
+
 static umf_result_t file_alloc_cb(void *provider, size_t size, size_t alignment,
                                   void **resultPtr);
 static umf_result_t file_allocation_split_cb(void *provider, void *ptr,
@@ -239,6 +728,8 @@ static umf_result_t file_initialize(const void *params, void **provider) {
         goto err_free_file_provider;
     }
 
+    file_provider->lazy_backing = in_params->lazy_backing;
+
     if (utils_copy_path(in_params->path, file_provider->path, PATH_MAX)) {
         goto err_free_file_provider;
     }
@@ -281,10 +772,13 @@ static umf_result_t file_initialize(const void *params, void **provider) {
     coarse_params_t coarse_params = {0};
     coarse_params.provider = file_provider;
     coarse_params.page_size = file_provider->page_size;
+    coarse_params.num_arenas = COARSE_PROVIDER_NUM_ARENAS;
     coarse_params.cb.alloc = file_alloc_cb;
     coarse_params.cb.free = NULL; // not available for the file provider
     coarse_params.cb.split = file_allocation_split_cb;
     coarse_params.cb.merge = file_allocation_merge_cb;
+    coarse_params.cb.discard =
+        file_provider->lazy_backing ? file_discard_cb : NULL;
 
     coarse_t *coarse = NULL;
     ret = coarse_new(&coarse_params, &coarse);
@@ -315,10 +809,19 @@ static umf_result_t file_initialize(const void *params, void **provider) {
         goto err_delete_fd_offset_map;
     }
 
+    ret = file_punch_start_thread(file_provider,
+                                  file_provider->lazy_backing &&
+                                      in_params->background_punch);
+    if (ret != UMF_RESULT_SUCCESS) {
+        goto err_delete_mmaps;
+    }
+
     *provider = file_provider;
 
     return UMF_RESULT_SUCCESS;
 
+err_delete_mmaps:
+    critnib_delete(file_provider->mmaps);
 err_delete_fd_offset_map:
     critnib_delete(file_provider->fd_offset_map);
 err_mutex_destroy_not_free:
@@ -335,6 +838,9 @@ err_free_file_provider:
 static umf_result_t file_finalize(void *provider) {
     file_memory_provider_t *file_provider = provider;
 
+    // punch the queued holes before the file is unmapped and closed
+    file_punch_stop_thread(file_provider);
+
     uintptr_t key = 0;
     uintptr_t rkey = 0;
     void *rvalue = NULL;
@@ -401,7 +907,15 @@ static umf_result_t file_mmap_aligned(file_memory_provider_t *file_provider,
 
     if (aligned_offset_fd + extended_size > size_fd) {
         size_t new_size_fd = aligned_offset_fd + extended_size;
-        if (utils_fallocate(fd, size_fd, new_size_fd - size_fd)) {
+        // with the lazy backing, the file grows sparsely
+        // and its space is allocated on the first touch of the memory
+        int ret_grow = 0;
+        if (file_provider->lazy_backing) {
+            ret_grow = utils_set_file_size(fd, new_size_fd);
+        } else {
+            ret_grow = utils_fallocate(fd, size_fd, new_size_fd - size_fd);
+        }
+        if (ret_grow) {
             LOG_ERR("cannot grow the file size from %zu to %zu", size_fd,
                     new_size_fd);
             return UMF_RESULT_ERROR_UNKNOWN;
@@ -526,6 +1040,9 @@ static umf_result_t file_alloc(void *provider, size_t size, size_t alignment,
     umf_result_t ret =
         coarse_alloc(file_provider->coarse, size, alignment, resultPtr);
     if (ret == UMF_RESULT_SUCCESS) {
+        if (file_provider->lazy_backing) {
+            file_punch_cancel(file_provider, *resultPtr, size);
+        }
         provider_ctl_stats_alloc(file_provider, size);
     }
     return ret;
@@ -651,7 +1168,7 @@ static umf_result_t file_purge_lazy(void *provider, void *ptr, size_t size) {
 }
 
 static umf_result_t file_purge_force(void *provider, void *ptr, size_t size) {
-    (void)provider; // unused
+    file_memory_provider_t *file_provider = (file_memory_provider_t *)provider;
 
     errno = 0;
     if (utils_purge(ptr, size, UMF_PURGE_FORCE)) {
@@ -660,6 +1177,18 @@ static umf_result_t file_purge_force(void *provider, void *ptr, size_t size) {
         LOG_PERR("force purging failed");
         return UMF_RESULT_ERROR_MEMORY_PROVIDER_SPECIFIC;
     }
+
+    // MADV_DONTNEED does not release the file space (nor the page cache
+    // with the UMF_MEM_MAP_SHARED visibility), so punch a hole too
+    void *hole_ptr;
+    size_t hole_offset_fd;
+    size_t hole_size;
+    if (file_provider->lazy_backing &&
+        !file_punch_get_hole(file_provider, ptr, size, &hole_ptr,
+                             &hole_offset_fd, &hole_size)) {
+        file_punch_hole(file_provider, hole_offset_fd, hole_size);
+    }
+
     return UMF_RESULT_SUCCESS;
 }
 
@@ -911,6 +1440,11 @@ static umf_result_t file_free(void *provider, void *ptr, size_t size) {
     file_memory_provider_t *file_provider = (file_memory_provider_t *)provider;
     umf_result_t ret = coarse_free(file_provider->coarse, ptr, size);
     if (ret == UMF_RESULT_SUCCESS) {
+        // punch the hole queued by coarse_free() outside of its lock
+        if (file_provider->lazy_backing &&
+            !file_provider->punch_thread_running) {
+            file_punch_queue_flush(file_provider);
+        }
         provider_ctl_stats_free(file_provider, size);
     }
     return ret;
@@ -964,6 +1498,8 @@ umf_result_t umfFileMemoryProviderParamsCreate(
     params->path = NULL;
     params->protection = UMF_PROTECTION_READ | UMF_PROTECTION_WRITE;
     params->visibility = UMF_MEM_MAP_PRIVATE;
+    params->lazy_backing = false;
+    params->background_punch = false;
     strncpy(params->name, DEFAULT_NAME, sizeof(params->name) - 1);
     params->name[sizeof(params->name) - 1] = '\0';
 
@@ -1065,4 +1601,28 @@ umf_result_t umfFileMemoryProviderParamsSetName(
     return UMF_RESULT_SUCCESS;
 }
 
+umf_result_t umfFileMemoryProviderParamsSetLazyBacking(
+    umf_file_memory_provider_params_handle_t hParams, bool enable) {
+    if (hParams == NULL) {
+        LOG_ERR("File Memory Provider params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->lazy_backing = enable;
+
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t umfFileMemoryProviderParamsSetBackgroundPunch(
+    umf_file_memory_provider_params_handle_t hParams, bool enable) {
+    if (hParams == NULL) {
+        LOG_ERR("File Memory Provider params handle is NULL");
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    hParams->background_punch = enable;
+
+    return UMF_RESULT_SUCCESS;
+}
+
 #endif // !defined(_WIN32)
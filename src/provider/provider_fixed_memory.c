@@ -60,6 +60,7 @@ static __TLS fixed_last_native_error_t TLS_last_native_error;
     (UMF_FIXED_RESULT_ERROR_PURGE_FORCE_FAILED - UMF_FIXED_RESULT_SUCCESS)
 
 #define CTL_PROVIDER_TYPE fixed_memory_provider_t
+#include "provider_ctl_defrag_impl.h"
 #include "provider_ctl_stats_impl.h"
 
 struct ctl fixed_memory_ctl_root;
@@ -67,6 +68,7 @@ static UTIL_ONCE_FLAG ctl_initialized = UTIL_ONCE_FLAG_INIT;
 
 static void initialize_fixed_ctl(void) {
     CTL_REGISTER_MODULE(&fixed_memory_ctl_root, stats);
+    CTL_REGISTER_MODULE(&fixed_memory_ctl_root, defrag);
 }
 
 static const char *Native_error_str[] = {
@@ -120,6 +122,7 @@ static umf_result_t fixed_initialize(const void *params, void **provider) {
     coarse_params_t coarse_params = {0};
     coarse_params.provider = fixed_provider;
     coarse_params.page_size = utils_get_page_size();
+    coarse_params.num_arenas = COARSE_PROVIDER_NUM_ARENAS;
     // The alloc callback is not available in case of the fixed provider
     // because it is a fixed-size memory provider
     // and the entire memory is added as a single block
@@ -22,34 +22,76 @@
 #include "ipc_cache.h"
 #include "ipc_internal.h"
 #include "memory_pool_internal.h"
+#include "memory_provider_internal.h"
 #include "provider_tracking.h"
 #include "utils_common.h"
 #include "utils_concurrency.h"
 #include "utils_log.h"
 
-// TODO: we need to support an arbitrary amount of layers in the future
-#define MAX_LEVELS_OF_ALLOC_SEGMENT_MAP 8
+// Splits and merges of regions are serialized by a set of locks.
+// The lock of a region is chosen by the hash of its start address,
+// so splits and merges of unrelated regions (and pools) do not contend
+// on a single lock.
+#define TRACKER_SPLIT_MERGE_LOCKS_SHIFT 6
+#define TRACKER_SPLIT_MERGE_LOCKS (1 << TRACKER_SPLIT_MERGE_LOCKS_SHIFT)
+
+// With coarse tracking (UMF_POOL_CREATE_FLAG_COARSE_TRACKING) allocations
+// up to TRACKING_CHUNK_MAX_ALLOC are carved out of chunks
+// of TRACKING_CHUNK_SIZE, which are registered in the tracker as a whole.
+#define TRACKING_CHUNK_SIZE (2 * 1024 * 1024)
+#define TRACKING_CHUNK_MAX_ALLOC (TRACKING_CHUNK_SIZE / 4)
+// Allocations carved out of chunks are aligned to pages
+// of at least TRACKING_CHUNK_MIN_PAGE bytes.
+#define TRACKING_CHUNK_MIN_PAGE 4096
+#define TRACKING_CHUNK_MAX_PAGES (TRACKING_CHUNK_SIZE / TRACKING_CHUNK_MIN_PAGE)
+
+// Records of the tracker refer to pools by indexes into the table of pools,
+// which is filled by the tracking providers. The table is split into chunks
+// allocated on demand, so it never moves and can be read without any locks.
+// Index 0 is never used.
+#define TRACKER_POOLS_CHUNK_SHIFT 10
+#define TRACKER_POOLS_CHUNK_SIZE (1 << TRACKER_POOLS_CHUNK_SHIFT)
+#define TRACKER_POOLS_MAX (1 << 20) // live pools
+#define TRACKER_POOLS_CHUNKS (TRACKER_POOLS_MAX / TRACKER_POOLS_CHUNK_SIZE)
 
 uint64_t IPC_HANDLE_ID = 0;
 
+// A level of the allocation segment map. Multilevel maps are needed
+// to support the case when one memory pool acts as a memory provider
+// for another memory pool (nested memory pooling): regions allocated
+// from a region of the level N are kept in the map of the level N+1.
+// Levels are created on demand, when the first region is nested that
+// deep, and are not freed until the tracker is destroyed, so the list
+// of levels can be walked without any locks.
+typedef struct tracker_level_t {
+    critnib *map;
+    int depth;                    // 0 for the top level
+    struct tracker_level_t *prev; // level of the parent regions
+    struct tracker_level_t *next; // level of the nested regions
+} tracker_level_t;
+
 struct umf_memory_tracker_t {
     umf_ba_pool_t *alloc_info_allocator;
-    // Multilevel maps are needed to support the case
-    // when one memory pool acts as a memory provider
-    // for another memory pool (nested memory pooling).
-    critnib *alloc_segments_map[MAX_LEVELS_OF_ALLOC_SEGMENT_MAP];
-    utils_mutex_t splitMergeMutex;
+    tracker_level_t *alloc_segments; // the top level (0) of the map
+    utils_mutex_t splitMergeLocks[TRACKER_SPLIT_MERGE_LOCKS];
     umf_ba_pool_t *ipc_info_allocator;
     critnib *ipc_segments_map;
+
+    umf_memory_pool_handle_t *pools[TRACKER_POOLS_CHUNKS];
+    uint32_t pools_next;     // the lowest never used index
+    utils_mutex_t pools_lock; // serializes registering of pools
 };
 
+// The record of a tracked region is packed into 16 bytes
+// (in the release build), so that the allocator of records
+// does not round it up.
 typedef struct tracker_alloc_info_t {
-    umf_memory_pool_handle_t pool;
-    size_t size;
+    uint64_t size;
     // number of overlapping memory regions
     // in the next level of map
     // falling within the current range
-    size_t n_children;
+    uint32_t n_children;
+    uint32_t pool_id; // index into the table of pools
 #if !defined(NDEBUG) && defined(UMF_DEVELOPER_MODE)
     uint64_t is_freed;
 #endif
@@ -61,15 +103,276 @@ typedef struct tracker_ipc_info_t {
     ipc_opened_cache_value_t *ipc_cache_value;
 } tracker_ipc_info_t;
 
-// Get the most nested (on the highest level) allocation segment in the map with the `ptr` key.
-// If `no_children` is set to 1, the function will return the entry
-// only if it has no children on the higher level.
-// The function returns the entry if found, otherwise NULL.
-static tracker_alloc_info_t *get_most_nested_alloc_segment(
-    umf_memory_tracker_handle_t hTracker, const void *ptr, int *_level,
-    uintptr_t *_parent_key, tracker_alloc_info_t **_parent_value,
-    void **_ref_value, void **_ref_parent_value, int no_children) {
+// Thread-local, direct-mapped cache of the results of
+// umfMemoryTrackerGetAllocInfo() found in regions with no children,
+// indexed by the page of the pointer.
+// An entry is valid as long as neither the global tracker epoch nor
+// the range epoch of its index has changed since it was filled. Every change
+// of the tracker that could change the result of a lookup (removing,
+// splitting or merging a region, adding a nested region) bumps the range
+// epochs of the indexes of the pages of the region, so it invalidates only
+// the entries of pointers which could be in the region. Changes of regions
+// of more than TRACKER_CACHE_RANGE_PAGES pages, and creating and destroying
+// the tracker, bump the global epoch instead.
+#define TRACKER_CACHE_SIZE 64 // must be a power of 2
+#define TRACKER_CACHE_SHIFT 12
+#define TRACKER_CACHE_RANGE_PAGES 16
+
+typedef struct tracker_cache_entry_t {
+    uintptr_t base;
+    size_t size;
+    umf_memory_pool_handle_t pool;
+    uint64_t epoch;
+    uint64_t range_epoch;
+} tracker_cache_entry_t;
+
+static __TLS tracker_cache_entry_t tracker_cache[TRACKER_CACHE_SIZE];
+
+// the epoch of zeroed (never filled) cache entries is 0
+static uint64_t tracker_epoch = 1;
+static uint64_t tracker_range_epochs[TRACKER_CACHE_SIZE];
+
+static inline size_t tracker_cache_index(uintptr_t page) {
+    return page & (TRACKER_CACHE_SIZE - 1);
+}
+
+static inline void tracker_cache_invalidate(void) {
+    utils_atomic_increment_u64(&tracker_epoch);
+}
+
+// Invalidates the entries of the pointers of a small region, returns false
+// if the region is too big and the caller has to invalidate all entries.
+static inline bool tracker_cache_invalidate_small_range(const void *ptr,
+                                                        size_t size) {
+    uintptr_t first = (uintptr_t)ptr >> TRACKER_CACHE_SHIFT;
+    uintptr_t last = ((uintptr_t)ptr + (size ? size - 1 : 0)) >>
+                     TRACKER_CACHE_SHIFT;
+    if (last - first >= TRACKER_CACHE_RANGE_PAGES) {
+        return false;
+    }
+
+    for (uintptr_t page = first; page <= last; page++) {
+        utils_atomic_increment_u64(
+            &tracker_range_epochs[tracker_cache_index(page)]);
+    }
+
+    return true;
+}
+
+static inline void tracker_cache_invalidate_range(const void *ptr,
+                                                  size_t size) {
+    if (!tracker_cache_invalidate_small_range(ptr, size)) {
+        tracker_cache_invalidate();
+    }
+}
+
+typedef struct tracker_pool_id_match_t {
+    uint32_t pool_id;
+    bool found;
+} tracker_pool_id_match_t;
+
+static int tracker_pool_id_match(uintptr_t key, void *value, void *privdata) {
+    (void)key; // unused
+    tracker_alloc_info_t *info = (tracker_alloc_info_t *)value;
+    tracker_pool_id_match_t *match = (tracker_pool_id_match_t *)privdata;
+
+    match->found = (info->pool_id == match->pool_id);
+    return match->found; // stop when found
+}
+
+// Checks if any region of the tracker refers to the given index of a pool,
+// what happens when a pool leaks memory. It walks all regions.
+static bool tracker_pool_id_in_use(umf_memory_tracker_handle_t hTracker,
+                                   uint32_t pool_id) {
+    tracker_pool_id_match_t match = {pool_id, false};
+    for (tracker_level_t *level = hTracker->alloc_segments;
+         level && !match.found; level = level->next) {
+        critnib_iter(level->map, 0, UINTPTR_MAX, tracker_pool_id_match,
+                     &match);
+    }
+
+    return match.found;
+}
+
+// Registers the pool in the table of pools of the tracker. Indexes are
+// not reused until the table is full, and an index referred to by regions
+// leaked by a destroyed pool is not reused at all, so that such regions
+// are not attributed to a new pool.
+static umf_result_t tracker_pool_register(umf_memory_tracker_handle_t hTracker,
+                                          umf_memory_pool_handle_t pool,
+                                          uint32_t *pool_id) {
+    umf_result_t ret = UMF_RESULT_ERROR_OUT_OF_RESOURCES;
+
+    utils_mutex_lock(&hTracker->pools_lock);
+
+    uint32_t id = hTracker->pools_next;
+    if (id == TRACKER_POOLS_MAX) {
+        for (id = 1; id < TRACKER_POOLS_MAX; id++) {
+            umf_memory_pool_handle_t *chunk =
+                hTracker->pools[id >> TRACKER_POOLS_CHUNK_SHIFT];
+            if (!chunk[id & (TRACKER_POOLS_CHUNK_SIZE - 1)] &&
+                !tracker_pool_id_in_use(hTracker, id)) {
+                break;
+            }
+        }
+    }
+
+    if (id == TRACKER_POOLS_MAX) {
+        LOG_ERR("too many pools registered in the tracker");
+        goto err_unlock;
+    }
+
+    umf_memory_pool_handle_t **chunk =
+        &hTracker->pools[id >> TRACKER_POOLS_CHUNK_SHIFT];
+    if (!*chunk) {
+        size_t chunk_size = TRACKER_POOLS_CHUNK_SIZE * sizeof(**chunk);
+        umf_memory_pool_handle_t *new_chunk = umf_ba_global_alloc(chunk_size);
+        if (!new_chunk) {
+            ret = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+            goto err_unlock;
+        }
+
+        memset(new_chunk, 0, chunk_size);
+        utils_atomic_store_release_ptr((void **)chunk, new_chunk);
+    }
+
+    utils_atomic_store_release_ptr(
+        (void **)&(*chunk)[id & (TRACKER_POOLS_CHUNK_SIZE - 1)], pool);
+    if (id == hTracker->pools_next) {
+        hTracker->pools_next++;
+    }
+
+    *pool_id = id;
+    ret = UMF_RESULT_SUCCESS;
+
+err_unlock:
+    utils_mutex_unlock(&hTracker->pools_lock);
+    return ret;
+}
+
+static void tracker_pool_unregister(umf_memory_tracker_handle_t hTracker,
+                                    uint32_t pool_id) {
+    umf_memory_pool_handle_t *chunk =
+        hTracker->pools[pool_id >> TRACKER_POOLS_CHUNK_SHIFT];
+    utils_atomic_store_release_ptr(
+        (void **)&chunk[pool_id & (TRACKER_POOLS_CHUNK_SIZE - 1)], NULL);
+}
+
+static inline umf_memory_pool_handle_t
+tracker_pool_get(umf_memory_tracker_handle_t hTracker, uint32_t pool_id) {
+    umf_memory_pool_handle_t *chunk;
+    umf_memory_pool_handle_t pool;
+
+    utils_atomic_load_acquire_ptr(
+        (void **)&hTracker->pools[pool_id >> TRACKER_POOLS_CHUNK_SHIFT],
+        (void **)&chunk);
+    if (!chunk) {
+        return NULL;
+    }
+
+    utils_atomic_load_acquire_ptr(
+        (void **)&chunk[pool_id & (TRACKER_POOLS_CHUNK_SIZE - 1)],
+        (void **)&pool);
+    return pool;
+}
+
+static void free_leaf(void *leaf_allocator, void *ptr);
+
+static tracker_level_t *tracker_level_new(umf_ba_pool_t *alloc_info_allocator,
+                                          tracker_level_t *prev) {
+    tracker_level_t *level = umf_ba_global_alloc(sizeof(*level));
+    if (!level) {
+        return NULL;
+    }
+
+    level->map = critnib_new(free_leaf, alloc_info_allocator);
+    if (!level->map) {
+        umf_ba_global_free(level);
+        return NULL;
+    }
+
+    level->depth = prev ? prev->depth + 1 : 0;
+    level->prev = prev;
+    level->next = NULL;
 
+    return level;
+}
+
+static void tracker_level_delete(tracker_level_t *level) {
+    critnib_delete(level->map);
+    umf_ba_global_free(level);
+}
+
+// Get the level of the regions nested in the regions of the given `level`
+// or NULL if there is no such level yet.
+static inline tracker_level_t *tracker_level_next(tracker_level_t *level) {
+    tracker_level_t *next;
+    utils_atomic_load_acquire_ptr((void **)&level->next, (void **)&next);
+    return next;
+}
+
+// Get the depth of the `level` for logging, -1 if it is not set.
+static inline int tracker_level_depth(tracker_level_t *level) {
+    return level ? level->depth : -1;
+}
+
+// Get the level of the regions nested in the regions of the given `level`,
+// creating it if it does not exist yet. Returns NULL if out of memory.
+static tracker_level_t *
+tracker_level_get_or_create_next(umf_memory_tracker_handle_t hTracker,
+                                 tracker_level_t *level) {
+    tracker_level_t *next = tracker_level_next(level);
+    if (next) {
+        return next;
+    }
+
+    next = tracker_level_new(hTracker->alloc_info_allocator, level);
+    if (!next) {
+        LOG_ERR("failed to create the tracker level %i", level->depth + 1);
+        return NULL;
+    }
+
+    tracker_level_t *expected = NULL;
+    if (!utils_compare_exchange_u64((uint64_t *)&level->next,
+                                    (uint64_t *)&expected,
+                                    (uint64_t *)&next)) {
+        // another thread has created the level in the meantime
+        tracker_level_delete(next);
+        return expected;
+    }
+
+    LOG_DEBUG("tracker level %i created, tracker=%p", next->depth,
+              (void *)hTracker);
+
+    return next;
+}
+
+// Get the lock serializing splits and merges of the region starting at `ptr`.
+static inline utils_mutex_t *
+tracker_split_merge_lock(umf_memory_tracker_handle_t hTracker,
+                         const void *ptr) {
+    // Fibonacci hashing - regions are page-aligned, so the low bits
+    // of their addresses alone would hit only a few of the locks
+    uint64_t hash = (uint64_t)(uintptr_t)ptr * 0x9E3779B97F4A7C15ULL;
+    size_t idx = (size_t)(hash >> (64 - TRACKER_SPLIT_MERGE_LOCKS_SHIFT));
+    return &hTracker->splitMergeLocks[idx];
+}
+
+// Find the most nested (on the highest level) allocation segment
+// that contains `ptr`. The lookup goes one level up at a time, so it is
+// O(depth), and it never restarts: a region that is being removed
+// concurrently (its value has already been cleared in the map) is treated
+// as removed. On success the function returns the value and its reference
+// (that has to be released) and optionally the parent value with its
+// reference.
+// The function returns NULL if `ptr` is not tracked.
+static tracker_alloc_info_t *
+find_most_nested_alloc_segment(umf_memory_tracker_handle_t hTracker,
+                               const void *ptr, uintptr_t *_key,
+                               tracker_level_t **_level, void **_ref_value,
+                               uintptr_t *_parent_key,
+                               tracker_alloc_info_t **_parent_value,
+                               void **_ref_parent_value) {
     assert(ptr);
     assert(_ref_value);
     if (_parent_value) {
@@ -77,149 +380,201 @@ static tracker_alloc_info_t *get_most_nested_alloc_segment(
     }
 
     tracker_alloc_info_t *parent_value = NULL;
-    tracker_alloc_info_t *rvalue = NULL;
+    tracker_alloc_info_t *value = NULL;
     uintptr_t parent_key = 0;
-    uintptr_t rkey = 0;
-    uint64_t rsize = 0;
-    size_t n_children = 0;
-    int level = 0;
-    int found = 0;
+    uintptr_t key = 0;
+    tracker_level_t *value_level = NULL;
 
     void *ref_value = NULL;
     void *ref_parent_value = NULL;
 
-    do {
-        assert(level < MAX_LEVELS_OF_ALLOC_SEGMENT_MAP);
-        found =
-            critnib_find(hTracker->alloc_segments_map[level], (uintptr_t)ptr,
-                         FIND_LE, (void *)&rkey, (void **)&rvalue, &ref_value);
-        if (!found) {
-            assert(ref_value == NULL);
-            break;
-        }
+    tracker_level_t *level = hTracker->alloc_segments;
+    while (level) {
+        tracker_alloc_info_t *rvalue = NULL;
+        uintptr_t rkey = 0;
+        uint64_t rsize = 0;
+        void *ref_rvalue = NULL;
 
-        if (rvalue == NULL) {
-            if (ref_value) {
-                critnib_release(hTracker->alloc_segments_map[level], ref_value);
-            }
-            parent_value = NULL;
-            parent_key = 0;
-            rkey = 0;
-            rsize = 0;
-            level = 0;
-            found = 0;
-            ref_value = NULL;
-            ref_parent_value = NULL;
-            continue;
+        int found = critnib_find(level->map, (uintptr_t)ptr, FIND_LE,
+                                 (void *)&rkey, (void **)&rvalue, &ref_rvalue);
+        if (found && rvalue) {
+#if !defined(NDEBUG) && defined(UMF_DEVELOPER_MODE)
+            // make sure rvalue is not freed
+            uint64_t is_freed;
+            utils_atomic_load_acquire_u64(&rvalue->is_freed, &is_freed);
+            assert(is_freed != 0xDEADBEEF);
+#endif
+            utils_atomic_load_acquire_u64((uint64_t *)&rvalue->size, &rsize);
         }
 
-        utils_atomic_load_acquire_u64((uint64_t *)&rvalue->size, &rsize);
-        utils_atomic_load_acquire_size_t(&rvalue->n_children, &n_children);
-        if (found && ((uintptr_t)ptr < rkey + rsize) && n_children) {
-            if (level == MAX_LEVELS_OF_ALLOC_SEGMENT_MAP - 1) {
-                break;
-            }
-
-            level++;
-
-            if (_parent_key) {
-                parent_key = rkey;
+        if (!found || !rvalue || (uintptr_t)ptr >= rkey + rsize) {
+            // no region on this level contains `ptr`
+            if (ref_rvalue) {
+                critnib_release(level->map, ref_rvalue);
             }
+            break;
+        }
 
-            if (_parent_value) {
-                parent_value = rvalue;
-                // If we return the parent value, we have to return also its reference.
-                // If it is already set, we have to release the previous one first.
-                if (ref_parent_value) {
-                    assert(level >= 2);
-                    // release the previous reference to the parent value
-                    critnib_release(hTracker->alloc_segments_map[level - 2],
-                                    ref_parent_value);
-                }
-                ref_parent_value = ref_value;
-            } else if (ref_value) {
-                // If we do not return the parent value,
-                // we have to release the current 'ref_value' reference
-                // before it will be overwritten in the next critnib_find() call.
-                assert(level >= 1);
-                critnib_release(hTracker->alloc_segments_map[level - 1],
-                                ref_value);
-                ref_value = NULL;
-            }
+        // rvalue is nested in value, so value becomes the parent
+        if (ref_parent_value) {
+            critnib_release(value_level->prev->map, ref_parent_value);
+        }
+        parent_key = key;
+        parent_value = value;
+        ref_parent_value = ref_value;
+
+        key = rkey;
+        value = rvalue;
+        ref_value = ref_rvalue;
+        value_level = level;
+
+        uint32_t n_children;
+        utils_atomic_load_acquire_u32(&value->n_children, &n_children);
+        if (n_children == 0) {
+            break;
         }
-    } while (found && ((uintptr_t)ptr < rkey + rsize) && n_children);
 
-    if (!rvalue || rkey != (uintptr_t)ptr) {
-        return NULL;
+        level = tracker_level_next(level);
     }
 
-    if (no_children && (n_children > 0)) {
+    if (!value) {
         return NULL;
     }
 
+    if (!_parent_value && ref_parent_value) {
+        critnib_release(value_level->prev->map, ref_parent_value);
+    }
+
+    if (_key) {
+        *_key = key;
+    }
     if (_level) {
-        *_level = level;
+        *_level = value_level;
     }
     if (_parent_key) {
         *_parent_key = parent_key;
     }
     if (_parent_value) {
-        *_ref_parent_value = ref_parent_value;
         *_parent_value = parent_value;
+        *_ref_parent_value = ref_parent_value;
     }
-
-    assert(!no_children || rvalue->n_children == 0);
-    assert(ref_value);
     *_ref_value = ref_value;
 
-    return rvalue;
+    return value;
 }
 
-static umf_result_t
-umfMemoryTrackerAddAtLevel(umf_memory_tracker_handle_t hTracker, int level,
-                           umf_memory_pool_handle_t pool, const void *ptr,
-                           size_t size, uintptr_t parent_key,
-                           tracker_alloc_info_t *parent_value,
-                           void *ref_parent_value) {
-    assert(ptr);
+// Get the most nested (on the highest level) allocation segment in the map with the `ptr` key.
+// If `no_children` is set to 1, the function will return the entry
+// only if it has no children on the higher level.
+// The function returns the entry if found, otherwise NULL.
+static tracker_alloc_info_t *get_most_nested_alloc_segment(
+    umf_memory_tracker_handle_t hTracker, const void *ptr,
+    tracker_level_t **_level, uintptr_t *_parent_key,
+    tracker_alloc_info_t **_parent_value, void **_ref_value,
+    void **_ref_parent_value, int no_children) {
 
-    umf_result_t umf_result = UMF_RESULT_ERROR_UNKNOWN;
+    assert(_level);
 
-    tracker_alloc_info_t *value = umf_ba_alloc(hTracker->alloc_info_allocator);
-    if (value == NULL) {
-        LOG_ERR("failed to allocate a tracker value, ptr=%p, size=%zu", ptr,
-                size);
-        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    uintptr_t key = 0;
+    tracker_level_t *level = NULL;
+    tracker_alloc_info_t *parent_value = NULL;
+    void *ref_value = NULL;
+    void *ref_parent_value = NULL;
+
+    tracker_alloc_info_t *value = find_most_nested_alloc_segment(
+        hTracker, ptr, &key, &level, &ref_value, _parent_key, &parent_value,
+        &ref_parent_value);
+    if (!value) {
+        return NULL;
+    }
+
+    uint32_t n_children;
+    utils_atomic_load_acquire_u32(&value->n_children, &n_children);
+
+    if (key != (uintptr_t)ptr || (no_children && n_children > 0)) {
+        critnib_release(level->map, ref_value);
+        if (ref_parent_value) {
+            critnib_release(level->prev->map, ref_parent_value);
+        }
+        return NULL;
+    }
+
+    if (_parent_value) {
+        *_parent_value = parent_value;
+        *_ref_parent_value = ref_parent_value;
+    } else if (ref_parent_value) {
+        critnib_release(level->prev->map, ref_parent_value);
     }
 
-    value->pool = pool;
+    *_level = level;
+    *_ref_value = ref_value;
+
+    return value;
+}
+
+static void tracker_value_init(tracker_alloc_info_t *value, uint32_t pool_id,
+                               size_t size) {
     value->size = size;
     value->n_children = 0;
+    value->pool_id = pool_id;
 #if !defined(NDEBUG) && defined(UMF_DEVELOPER_MODE)
     value->is_freed = 0;
 #endif
+}
+
+// Account the region (ptr, size) just inserted at the given `level`
+// as a child of its parent (if any) and release the reference to the parent.
+static void tracker_add_child(umf_memory_tracker_handle_t hTracker,
+                              tracker_level_t *level, const void *ptr,
+                              size_t size, uintptr_t parent_key,
+                              tracker_alloc_info_t *parent_value,
+                              void *ref_parent_value) {
+    if (!parent_value) {
+        return;
+    }
+
+    uint32_t n_children = utils_atomic_increment_u32(&parent_value->n_children);
+
+    // The region hides a part of its parent from lookups. The cache has to be
+    // invalidated after the parent got a child, so that a lookup reading
+    // the new epochs does not cache the parent anymore.
+    tracker_cache_invalidate_range(ptr, size);
 
-    assert(level < MAX_LEVELS_OF_ALLOC_SEGMENT_MAP);
-    int ret = critnib_insert(hTracker->alloc_segments_map[level],
-                             (uintptr_t)ptr, value, 0);
+    LOG_DEBUG("child #%u added to memory region: tracker=%p, level=%i, "
+              "pool=%p, ptr=%p, size=%zu",
+              n_children, (void *)hTracker, level->prev->depth,
+              (void *)tracker_pool_get(hTracker, parent_value->pool_id),
+              (void *)parent_key, (size_t)parent_value->size);
+    assert(ref_parent_value);
+    critnib_release(level->prev->map, ref_parent_value);
+}
+
+// Insert the `value` allocated from the alloc_info_allocator
+// to the map of the given `level`. The value is freed on failure.
+static umf_result_t
+umfMemoryTrackerAddAtLevel(umf_memory_tracker_handle_t hTracker,
+                           tracker_level_t *level,
+                           tracker_alloc_info_t *value, uint32_t pool_id,
+                           const void *ptr, size_t size, uintptr_t parent_key,
+                           tracker_alloc_info_t *parent_value,
+                           void *ref_parent_value) {
+    assert(ptr);
+    assert(level);
+    assert(value);
+
+    umf_result_t umf_result = UMF_RESULT_ERROR_UNKNOWN;
+
+    tracker_value_init(value, pool_id, size);
+
+    int ret = critnib_insert(level->map, (uintptr_t)ptr, value, 0);
     if (ret == 0) {
         LOG_DEBUG("memory region is added, tracker=%p, level=%i, pool=%p, "
                   "ptr=%p, size=%zu",
-                  (void *)hTracker, level, (void *)pool, ptr, size);
-
-        if (parent_value) {
-            size_t n_children =
-                utils_atomic_increment_size_t(&parent_value->n_children) + 1;
-            LOG_DEBUG(
-                "child #%zu added to memory region: tracker=%p, level=%i, "
-                "pool=%p, ptr=%p, size=%zu",
-                n_children, (void *)hTracker, level - 1,
-                (void *)parent_value->pool, (void *)parent_key,
-                parent_value->size);
-            assert(ref_parent_value);
-            critnib_release(hTracker->alloc_segments_map[level - 1],
-                            ref_parent_value);
-        }
+                  (void *)hTracker, level->depth,
+                  (void *)tracker_pool_get(hTracker, pool_id), ptr, size);
+
+        tracker_add_child(hTracker, level, ptr, size, parent_key,
+                          parent_value, ref_parent_value);
         return UMF_RESULT_SUCCESS;
     }
     if (ret == ENOMEM) {
@@ -228,106 +583,114 @@ umfMemoryTrackerAddAtLevel(umf_memory_tracker_handle_t hTracker, int level,
 
     LOG_ERR(
         "failed to insert the tracker value: pool=%p, ptr=%p, size=%zu, ret=%d",
-        (void *)pool, ptr, size, ret);
+        (void *)tracker_pool_get(hTracker, pool_id), ptr, size, ret);
 
     umf_ba_free(hTracker->alloc_info_allocator, value);
 
+    if (ref_parent_value) {
+        critnib_release(level->prev->map, ref_parent_value);
+    }
+
     return umf_result;
 }
 
-static umf_result_t umfMemoryTrackerAdd(umf_memory_tracker_handle_t hTracker,
-                                        umf_memory_pool_handle_t pool,
-                                        const void *ptr, size_t size) {
-    assert(ptr);
-
-    tracker_alloc_info_t *parent_value = NULL;
-    tracker_alloc_info_t *rvalue = NULL;
+// Find the level of a new region: the one following the level of its
+// parent - the most nested region containing `ptr`, if there is any.
+// The reference to the parent has to be released by the caller.
+static umf_result_t
+umfMemoryTrackerFindLevel(umf_memory_tracker_handle_t hTracker,
+                          uint32_t pool_id, const void *ptr, size_t size,
+                          tracker_level_t **_level, uintptr_t *_parent_key,
+                          tracker_alloc_info_t **_parent_value,
+                          void **_ref_parent_value) {
     uintptr_t parent_key = 0;
-    uintptr_t rkey = 0;
-    uint64_t rsize = 0;
-    size_t n_children = 0;
-    int level = 0;
-    int found = 0;
-
-    void *ref_value = NULL;
+    tracker_level_t *parent_level = NULL;
     void *ref_parent_value = NULL;
 
     // Find the most nested (in the highest level) entry
     // in the critnib maps that contains the given 'ptr' pointer.
-    do {
-        assert(level < MAX_LEVELS_OF_ALLOC_SEGMENT_MAP);
-        found =
-            critnib_find(hTracker->alloc_segments_map[level], (uintptr_t)ptr,
-                         FIND_LE, (void *)&rkey, (void **)&rvalue, &ref_value);
-        if (!found) {
-            assert(ref_value == NULL);
-            break;
+    // It becomes the parent of the new entry.
+    tracker_alloc_info_t *parent_value = find_most_nested_alloc_segment(
+        hTracker, ptr, &parent_key, &parent_level, &ref_parent_value, NULL,
+        NULL, NULL);
+
+    tracker_level_t *level = hTracker->alloc_segments;
+    if (parent_value) {
+        uint64_t parent_size;
+        utils_atomic_load_acquire_u64((uint64_t *)&parent_value->size,
+                                      &parent_size);
+        if (((uintptr_t)ptr + size) > (parent_key + parent_size)) {
+            LOG_ERR(
+                "cannot insert to the tracker value (pool=%p, ptr=%p, "
+                "size=%zu) "
+                "that exceeds the parent value (pool=%p, ptr=%p, size=%zu)",
+                (void *)tracker_pool_get(hTracker, pool_id), ptr, size,
+                (void *)tracker_pool_get(hTracker, parent_value->pool_id),
+                (void *)parent_key, (size_t)parent_size);
+            critnib_release(parent_level->map, ref_parent_value);
+            return UMF_RESULT_ERROR_INVALID_ARGUMENT;
         }
 
-        if (!rvalue) {
-            if (ref_value) {
-                critnib_release(hTracker->alloc_segments_map[level], ref_value);
-            }
-            parent_value = NULL;
-            parent_key = 0;
-            rkey = 0;
-            rsize = 0;
-            level = 0;
-            found = 0;
-            ref_value = NULL;
-            ref_parent_value = NULL;
-            continue;
+        level = tracker_level_get_or_create_next(hTracker, parent_level);
+        if (!level) {
+            critnib_release(parent_level->map, ref_parent_value);
+            return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
         }
+    }
 
-#if !defined(NDEBUG) && defined(UMF_DEVELOPER_MODE)
-        // make sure rvalue is not freed
-        uint64_t is_freed;
-        utils_atomic_load_acquire_u64(&rvalue->is_freed, &is_freed);
-        assert(is_freed != 0xDEADBEEF);
-#endif
+    *_level = level;
+    *_parent_key = parent_key;
+    *_parent_value = parent_value;
+    *_ref_parent_value = ref_parent_value;
 
-        utils_atomic_load_acquire_u64((uint64_t *)&rvalue->size, &rsize);
+    return UMF_RESULT_SUCCESS;
+}
 
-        if ((uintptr_t)ptr < rkey + rsize) {
-            if (level == MAX_LEVELS_OF_ALLOC_SEGMENT_MAP - 1) {
-                // TODO: we need to support an arbitrary amount of layers in the future
-                LOG_ERR("tracker level is too high, ptr=%p, size=%zu", ptr,
-                        size);
-                return UMF_RESULT_ERROR_OUT_OF_RESOURCES;
-            }
-            if (((uintptr_t)ptr + size) > (rkey + rsize)) {
-                LOG_ERR(
-                    "cannot insert to the tracker value (pool=%p, ptr=%p, "
-                    "size=%zu) "
-                    "that exceeds the parent value (pool=%p, ptr=%p, size=%zu)",
-                    (void *)pool, ptr, size, (void *)rvalue->pool, (void *)rkey,
-                    (size_t)rsize);
-                return UMF_RESULT_ERROR_INVALID_ARGUMENT;
-            }
-            parent_key = rkey;
-            parent_value = rvalue;
-            if (ref_parent_value) {
-                assert(level >= 1);
-                critnib_release(hTracker->alloc_segments_map[level - 1],
-                                ref_parent_value);
-            }
-            ref_parent_value = ref_value;
-            level++;
-        }
-        utils_atomic_load_acquire_size_t(&rvalue->n_children, &n_children);
-    } while (found && ((uintptr_t)ptr < rkey + rsize) && n_children);
+// Add the region to the tracker using the `value` allocated
+// from the alloc_info_allocator. The value is freed on failure.
+static umf_result_t
+umfMemoryTrackerAddValue(umf_memory_tracker_handle_t hTracker,
+                         tracker_alloc_info_t *value, uint32_t pool_id,
+                         const void *ptr, size_t size) {
+    assert(ptr);
 
-    if (ref_value && ref_value != ref_parent_value) {
-        critnib_release(hTracker->alloc_segments_map[level], ref_value);
+    tracker_level_t *level = NULL;
+    uintptr_t parent_key = 0;
+    tracker_alloc_info_t *parent_value = NULL;
+    void *ref_parent_value = NULL;
+
+    umf_result_t ret = umfMemoryTrackerFindLevel(
+        hTracker, pool_id, ptr, size, &level, &parent_key, &parent_value,
+        &ref_parent_value);
+    if (ret != UMF_RESULT_SUCCESS) {
+        umf_ba_free(hTracker->alloc_info_allocator, value);
+        return ret;
     }
 
-    return umfMemoryTrackerAddAtLevel(hTracker, level, pool, ptr, size,
-                                      parent_key, parent_value,
+    return umfMemoryTrackerAddAtLevel(hTracker, level, value, pool_id, ptr,
+                                      size, parent_key, parent_value,
                                       ref_parent_value);
 }
 
-static umf_result_t umfMemoryTrackerRemove(umf_memory_tracker_handle_t hTracker,
-                                           const void *ptr) {
+static umf_result_t umfMemoryTrackerAdd(umf_memory_tracker_handle_t hTracker,
+                                        uint32_t pool_id, const void *ptr,
+                                        size_t size) {
+    tracker_alloc_info_t *value = umf_ba_alloc(hTracker->alloc_info_allocator);
+    if (value == NULL) {
+        LOG_ERR("failed to allocate a tracker value, ptr=%p, size=%zu", ptr,
+                size);
+        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    return umfMemoryTrackerAddValue(hTracker, value, pool_id, ptr, size);
+}
+
+// Remove the region from the tracker without invalidating
+// the lookup caches - the caller has to do it using the size
+// of the removed region returned in `size`.
+static umf_result_t
+umfMemoryTrackerRemoveNoInvalidate(umf_memory_tracker_handle_t hTracker,
+                                   const void *ptr, size_t *size) {
     assert(ptr);
 
     // TODO: there is no support for removing partial ranges (or multiple entries
@@ -337,7 +700,7 @@ static umf_result_t umfMemoryTrackerRemove(umf_memory_tracker_handle_t hTracker,
 
     tracker_alloc_info_t *parent_value = NULL;
     uintptr_t parent_key = 0;
-    int level = 0;
+    tracker_level_t *level = NULL;
 
     // Find the most nested (on the highest level) entry in the map
     // with the `ptr` key and with no children - only such entry can be removed.
@@ -351,43 +714,189 @@ static umf_result_t umfMemoryTrackerRemove(umf_memory_tracker_handle_t hTracker,
         return UMF_RESULT_ERROR_UNKNOWN;
     }
 
-    assert(level < MAX_LEVELS_OF_ALLOC_SEGMENT_MAP);
-
     // release the reference to the value got from get_most_nested_alloc_segment()
     assert(ref_value);
-    critnib_release(hTracker->alloc_segments_map[level], ref_value);
+    critnib_release(level->map, ref_value);
 
-    value = critnib_remove(hTracker->alloc_segments_map[level], (uintptr_t)ptr,
-                           &ref_value);
+    value = critnib_remove(level->map, (uintptr_t)ptr, &ref_value);
     assert(value);
 
     LOG_DEBUG("memory region removed: tracker=%p, level=%i, pool=%p, ptr=%p, "
               "size=%zu",
-              (void *)hTracker, level, (void *)value->pool, ptr, value->size);
+              (void *)hTracker, level->depth,
+              (void *)tracker_pool_get(hTracker, value->pool_id), ptr,
+              (size_t)value->size);
+
+    *size = value->size;
 
     // release the reference to the value got from critnib_remove()
     assert(ref_value);
-    critnib_release(hTracker->alloc_segments_map[level], ref_value);
+    critnib_release(level->map, ref_value);
 
     if (parent_value) {
-        size_t n_children =
-            utils_atomic_decrement_size_t(&parent_value->n_children);
+        uint32_t n_children =
+            utils_atomic_decrement_u32(&parent_value->n_children);
         LOG_DEBUG(
-            "child #%zu removed from memory region: tracker=%p, level=%i, "
+            "child #%u removed from memory region: tracker=%p, level=%i, "
             "pool=%p, ptr=%p, size=%zu",
-            n_children, (void *)hTracker, level - 1, (void *)parent_value->pool,
-            (void *)parent_key, parent_value->size);
+            n_children, (void *)hTracker, level->prev->depth,
+            (void *)tracker_pool_get(hTracker, parent_value->pool_id),
+            (void *)parent_key, (size_t)parent_value->size);
 
         assert(ref_parent_value);
-        assert(level >= 1);
         // release the ref_parent_value got from get_most_nested_alloc_segment()
-        critnib_release(hTracker->alloc_segments_map[level - 1],
-                        ref_parent_value);
+        critnib_release(level->prev->map, ref_parent_value);
     }
 
     return UMF_RESULT_SUCCESS;
 }
 
+static umf_result_t umfMemoryTrackerRemove(umf_memory_tracker_handle_t hTracker,
+                                           const void *ptr) {
+    size_t size = 0;
+    umf_result_t ret =
+        umfMemoryTrackerRemoveNoInvalidate(hTracker, ptr, &size);
+    if (ret == UMF_RESULT_SUCCESS) {
+        tracker_cache_invalidate_range(ptr, size);
+    }
+
+    return ret;
+}
+
+// The number of values allocated at once by umfMemoryTrackerAddBatch()
+#define TRACKER_ADD_BATCH_SIZE 64
+
+// Add `num` regions of `size` bytes to the tracker. The metadata of the
+// regions is allocated in chunks of TRACKER_ADD_BATCH_SIZE values under
+// a single lock of the allocator, and the consecutive regions of the same
+// level of the map are inserted under a single lock of the map.
+// The batch is all-or-nothing: on failure the regions added so far
+// are removed.
+static umf_result_t
+umfMemoryTrackerAddBatch(umf_memory_tracker_handle_t hTracker,
+                         uint32_t pool_id, void **ptrs, size_t size,
+                         size_t num) {
+    void *values[TRACKER_ADD_BATCH_SIZE];
+    tracker_level_t *levels[TRACKER_ADD_BATCH_SIZE];
+    uintptr_t parent_keys[TRACKER_ADD_BATCH_SIZE];
+    tracker_alloc_info_t *parent_values[TRACKER_ADD_BATCH_SIZE];
+    void *ref_parent_values[TRACKER_ADD_BATCH_SIZE];
+    umf_result_t ret = UMF_RESULT_SUCCESS;
+    size_t added = 0;
+
+    while (added < num) {
+        size_t n = utils_min(num - added, TRACKER_ADD_BATCH_SIZE);
+        size_t n_values =
+            umf_ba_alloc_batch(hTracker->alloc_info_allocator, values, n);
+        if (n_values < n) {
+            LOG_ERR("failed to allocate tracker values, num=%zu, size=%zu", n,
+                    size);
+            umf_ba_free_batch(hTracker->alloc_info_allocator, values,
+                              n_values);
+            ret = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+            goto err_remove;
+        }
+
+        void **chunk_ptrs = &ptrs[added];
+        size_t n_found;
+        for (n_found = 0; n_found < n; n_found++) {
+            ret = umfMemoryTrackerFindLevel(
+                hTracker, pool_id, chunk_ptrs[n_found], size,
+                &levels[n_found], &parent_keys[n_found],
+                &parent_values[n_found], &ref_parent_values[n_found]);
+            if (ret != UMF_RESULT_SUCCESS) {
+                break;
+            }
+
+            tracker_value_init(values[n_found], pool_id, size);
+        }
+
+        size_t i = 0;
+        while (i < n_found) {
+            size_t run = 1;
+            while (i + run < n_found && levels[i + run] == levels[i]) {
+                run++;
+            }
+
+            int err = 0;
+            size_t n_inserted = critnib_insert_batch(
+                levels[i]->map, (const uintptr_t *)&chunk_ptrs[i], &values[i],
+                run, &err);
+            for (size_t j = i; j < i + n_inserted; j++) {
+                tracker_add_child(hTracker, levels[j], chunk_ptrs[j], size,
+                                  parent_keys[j], parent_values[j],
+                                  ref_parent_values[j]);
+            }
+
+            added += n_inserted;
+            i += n_inserted;
+
+            if (n_inserted < run) {
+                LOG_ERR("failed to insert the tracker value: pool=%p, ptr=%p, "
+                        "size=%zu, ret=%d",
+                        (void *)tracker_pool_get(hTracker, pool_id),
+                        chunk_ptrs[i], size, err);
+                ret = (err == ENOMEM) ? UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY
+                                      : UMF_RESULT_ERROR_UNKNOWN;
+                break;
+            }
+        }
+
+        if (i < n) {
+            for (size_t j = i; j < n_found; j++) {
+                if (ref_parent_values[j]) {
+                    critnib_release(levels[j]->prev->map, ref_parent_values[j]);
+                }
+            }
+            umf_ba_free_batch(hTracker->alloc_info_allocator, &values[i],
+                              n - i);
+            goto err_remove;
+        }
+    }
+
+    LOG_DEBUG("%zu memory regions are added, tracker=%p, pool=%p, size=%zu",
+              num, (void *)hTracker,
+              (void *)tracker_pool_get(hTracker, pool_id), size);
+
+    return UMF_RESULT_SUCCESS;
+
+err_remove:
+    while (added-- > 0) {
+        size_t removed_size;
+        (void)umfMemoryTrackerRemoveNoInvalidate(hTracker, ptrs[added],
+                                                 &removed_size);
+    }
+    tracker_cache_invalidate();
+
+    return ret;
+}
+
+// Remove `num` regions from the tracker, invalidating the lookup caches
+// of all pointers at most once for the whole batch.
+// Returns the number of regions that were not found in the tracker.
+static size_t umfMemoryTrackerRemoveBatch(umf_memory_tracker_handle_t hTracker,
+                                          void **ptrs, size_t num) {
+    size_t n_failed = 0;
+    bool invalidate_all = false;
+
+    for (size_t i = 0; i < num; i++) {
+        size_t size;
+        if (umfMemoryTrackerRemoveNoInvalidate(hTracker, ptrs[i], &size) !=
+            UMF_RESULT_SUCCESS) {
+            n_failed++;
+        } else if (!invalidate_all &&
+                   !tracker_cache_invalidate_small_range(ptrs[i], size)) {
+            invalidate_all = true;
+        }
+    }
+
+    if (invalidate_all) {
+        tracker_cache_invalidate();
+    }
+
+    return n_failed;
+}
+
 static umf_result_t
 umfMemoryTrackerAddIpcSegment(umf_memory_tracker_handle_t hTracker,
                               const void *ptr, size_t size,
@@ -481,153 +990,532 @@ umf_result_t umfMemoryTrackerGetAllocInfo(const void *ptr,
         return UMF_RESULT_ERROR_NOT_SUPPORTED;
     }
 
-    if (TRACKER->alloc_segments_map[0] == NULL) {
+    if (TRACKER->alloc_segments == NULL) {
         LOG_ERR("tracker's alloc_segments_map does not exist");
         return UMF_RESULT_ERROR_NOT_SUPPORTED;
     }
 
-    tracker_alloc_info_t *top_most_value = NULL;
-    tracker_alloc_info_t *rvalue = NULL;
+    // The epochs have to be read before the maps, so that a change of
+    // the tracker during the lookup invalidates the cached result.
+    size_t index = tracker_cache_index((uintptr_t)ptr >> TRACKER_CACHE_SHIFT);
+    uint64_t epoch, range_epoch;
+    utils_atomic_load_acquire_u64(&tracker_epoch, &epoch);
+    utils_atomic_load_acquire_u64(&tracker_range_epochs[index], &range_epoch);
+
+    tracker_cache_entry_t *entry = &tracker_cache[index];
+    if (entry->epoch == epoch && entry->range_epoch == range_epoch &&
+        (uintptr_t)ptr - entry->base < entry->size) {
+        pAllocInfo->base = (void *)entry->base;
+        pAllocInfo->baseSize = entry->size;
+        pAllocInfo->pool = entry->pool;
+        return UMF_RESULT_SUCCESS;
+    }
+
     uintptr_t top_most_key = 0;
-    uintptr_t rkey = 0;
-    uint64_t rsize = 0;
-    size_t n_children = 0;
-    int level = 0;
-    int found = 0;
+    tracker_level_t *top_most_level = NULL;
+    void *ref_top_most_value = NULL;
+
+    tracker_alloc_info_t *top_most_value = find_most_nested_alloc_segment(
+        TRACKER, ptr, &top_most_key, &top_most_level, &ref_top_most_value,
+        NULL, NULL, NULL);
+    if (!top_most_value) {
+        LOG_DEBUG("pointer %p not found in the tracker, TRACKER=%p", ptr,
+                  (void *)TRACKER);
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    pAllocInfo->base = (void *)top_most_key;
+    pAllocInfo->baseSize = top_most_value->size;
+    pAllocInfo->pool = tracker_pool_get(TRACKER, top_most_value->pool_id);
+
+    // Only the regions with no children can be cached, because a cached
+    // region is returned for all pointers in its range, including the ones
+    // belonging to its nested regions.
+    uint32_t n_children;
+    utils_atomic_load_acquire_u32(&top_most_value->n_children, &n_children);
+    if (n_children == 0) {
+        entry->base = top_most_key;
+        entry->size = pAllocInfo->baseSize;
+        entry->pool = pAllocInfo->pool;
+        entry->epoch = epoch;
+        entry->range_epoch = range_epoch;
+    }
+
+    assert(ref_top_most_value);
+    critnib_release(top_most_level->map, ref_top_most_value);
+
+    return UMF_RESULT_SUCCESS;
+}
+
+umf_result_t umfMemoryTrackerGetIpcInfo(const void *ptr,
+                                        umf_ipc_info_t *pIpcInfo) {
+    assert(pIpcInfo);
+
+    if (ptr == NULL) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
 
+    if (TRACKER == NULL) {
+        LOG_ERR("tracker does not exist");
+        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    }
+
+    if (TRACKER->ipc_segments_map == NULL) {
+        LOG_ERR("tracker's ipc_segments_map does not exist");
+        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    }
+
+    uintptr_t rkey = 0;
+    tracker_ipc_info_t *rvalue = NULL;
     void *ref_value = NULL;
-    void *ref_top_most_value = NULL;
-    int ref_level = 0;
+    int found = critnib_find(TRACKER->ipc_segments_map, (uintptr_t)ptr, FIND_LE,
+                             (void *)&rkey, (void **)&rvalue, &ref_value);
 
-    do {
-        assert(level < MAX_LEVELS_OF_ALLOC_SEGMENT_MAP);
-        found =
-            critnib_find(TRACKER->alloc_segments_map[level], (uintptr_t)ptr,
-                         FIND_LE, (void *)&rkey, (void **)&rvalue, &ref_value);
-        if (!found) {
-            assert(ref_value == NULL);
+    if (!found || (found && (rvalue == NULL)) ||
+        ((uintptr_t)ptr >= rkey + rvalue->size)) {
+        LOG_DEBUG("pointer %p not found in the tracker, TRACKER=%p", ptr,
+                  (void *)TRACKER);
+        if (ref_value) {
+            critnib_release(TRACKER->ipc_segments_map, ref_value);
+        }
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    pIpcInfo->base = (void *)rkey;
+    pIpcInfo->baseSize = rvalue->size;
+    pIpcInfo->provider = rvalue->provider;
+
+    if (ref_value) {
+        critnib_release(TRACKER->ipc_segments_map, ref_value);
+    }
+
+    return UMF_RESULT_SUCCESS;
+}
+
+// Position of umfMemoryTrackerGetRegions() in one level of the tracker
+typedef struct tracker_region_cursor_t {
+    tracker_level_t *level;
+    uintptr_t key; // 0 if there are no more regions at this level
+    size_t size;
+    umf_memory_pool_handle_t pool;
+} tracker_region_cursor_t;
+
+// Moves the cursor to the first region of the given pool (or of any pool
+// if it is NULL) that starts at or above `from` (FIND_GE) or above `from`
+// (FIND_G) and below `end`. It does not lock the map - it only holds
+// a reference of one region at a time.
+static void tracker_region_cursor_seek(umf_memory_tracker_handle_t hTracker,
+                                       tracker_region_cursor_t *cursor,
+                                       umf_memory_pool_handle_t pool,
+                                       uintptr_t from, enum find_dir_t dir,
+                                       uintptr_t end) {
+    critnib *map = cursor->level->map;
+
+    cursor->key = 0;
+    while (from < end) {
+        uintptr_t rkey = 0;
+        tracker_alloc_info_t *rvalue = NULL;
+        void *ref_value = NULL;
+
+        if (critnib_find(map, from, dir, &rkey, (void **)&rvalue,
+                         &ref_value) != 1) {
+            return;
+        }
+
+        // the value is NULL if the region is being removed
+        umf_memory_pool_handle_t rpool =
+            rvalue ? tracker_pool_get(hTracker, rvalue->pool_id) : NULL;
+        bool found = rkey < end && rvalue && (!pool || rpool == pool);
+        if (found) {
+            cursor->key = rkey;
+            cursor->size = rvalue->size;
+            cursor->pool = rpool;
+        }
+
+        if (ref_value) {
+            critnib_release(map, ref_value);
+        }
+
+        if (found || rkey >= end) {
+            return;
+        }
+
+        from = rkey;
+        dir = FIND_G;
+    }
+}
+
+umf_result_t umfMemoryTrackerGetRegions(umf_memory_tracker_handle_t hTracker,
+                                        umf_memory_pool_handle_t pool,
+                                        uintptr_t *cursor, uintptr_t end,
+                                        umf_pool_region_t *regions,
+                                        size_t *count) {
+    assert(cursor);
+    assert(regions);
+    assert(count && *count);
+
+    if (hTracker == NULL || hTracker->alloc_segments == NULL) {
+        LOG_ERR("tracker does not exist");
+        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    }
+
+    // levels created after this point hold no regions yet
+    size_t n_levels = 0;
+    for (tracker_level_t *level = hTracker->alloc_segments; level;
+         level = tracker_level_next(level)) {
+        n_levels++;
+    }
+
+    tracker_region_cursor_t *cursors =
+        umf_ba_global_alloc(n_levels * sizeof(*cursors));
+    if (!cursors) {
+        LOG_ERR("failed to allocate cursors of the tracker levels");
+        return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    tracker_level_t *level = hTracker->alloc_segments;
+    for (size_t i = 0; i < n_levels; i++) {
+        cursors[i].level = level;
+        tracker_region_cursor_seek(hTracker, &cursors[i], pool, *cursor,
+                                   FIND_GE, end);
+        level = tracker_level_next(level);
+    }
+
+    // merge the levels in the order of addresses,
+    // nested regions starting at the same address go from the top level
+    size_t n = 0;
+    umf_result_t ret = UMF_RESULT_SUCCESS;
+    while (1) {
+        tracker_region_cursor_t *next = NULL;
+        for (size_t i = 0; i < n_levels; i++) {
+            if (cursors[i].key && (!next || cursors[i].key < next->key)) {
+                next = &cursors[i];
+            }
+        }
+
+        if (!next) {
+            *cursor = 0;
             break;
         }
 
-        if (!rvalue) {
-            if (ref_value) {
-                critnib_release(TRACKER->alloc_segments_map[level], ref_value);
+        if (n == *count) {
+            // do not split regions starting at the same address between
+            // batches, because the next batch starts at this address
+            while (n > 0 && (uintptr_t)regions[n - 1].ptr == next->key) {
+                n--;
+            }
+            if (n == 0) {
+                LOG_ERR("too many nested regions start at %p for a batch of "
+                        "%zu regions",
+                        (void *)next->key, *count);
+                ret = UMF_RESULT_ERROR_INVALID_ARGUMENT;
             }
-            top_most_value = NULL;
-            top_most_key = 0;
-            rkey = 0;
-            rsize = 0;
-            level = 0;
-            found = 0;
-            ref_value = NULL;
-            ref_top_most_value = NULL;
-            ref_level = 0;
+            *cursor = next->key;
+            break;
+        }
+
+        regions[n].ptr = (void *)next->key;
+        regions[n].size = next->size;
+        regions[n].pool = next->pool;
+        n++;
+
+        tracker_region_cursor_seek(hTracker, next, pool, next->key, FIND_G,
+                                   end);
+    }
+
+    umf_ba_global_free(cursors);
+
+    *count = n;
+    return ret;
+}
+
+// Cache entry structure to store provider-specific IPC data.
+// providerIpcData is a Flexible Array Member because its size varies
+// depending on the provider.
+typedef struct ipc_cache_value_t {
+    uint64_t handle_id;
+    uint64_t ipcDataSize;
+    char providerIpcData[];
+} ipc_cache_value_t;
+
+// A chunk of memory registered in the tracker as a whole, small allocations
+// are carved out of its free pages (first fit). It is freed when the last
+// of its allocations is freed, unless it is the chunk allocations are carved
+// out of at the moment.
+typedef struct tracking_chunk_t {
+    void *base;
+    size_t size;
+    uintptr_t pages;     // address of the first page (the base aligned up)
+    size_t n_pages;      // number of pages of the chunk
+    size_t n_free_pages; // number of pages not used by any allocation
+    size_t n_allocs;     // number of allocations carved out of the chunk
+    // number of pages of the allocation starting at the given page
+    // (0 if no allocation starts there)
+    uint16_t alloc_pages[TRACKING_CHUNK_MAX_PAGES];
+} tracking_chunk_t;
+
+typedef struct umf_tracking_memory_provider_t {
+    umf_memory_provider_handle_t hUpstream;
+    umf_memory_tracker_handle_t hTracker;
+    umf_memory_pool_handle_t pool;
+    uint32_t pool_id; // index of the pool in the table of the tracker
+    critnib *ipcCache;
+    ipc_opened_cache_handle_t hIpcMappedCache;
+
+    // coarse tracking (set only if the pool was created
+    // with the UMF_POOL_CREATE_FLAG_COARSE_TRACKING flag)
+    bool coarse;
+    size_t page_size;             // minimum page size of the upstream
+    critnib *chunks;              // all chunks, keyed by their base
+    tracking_chunk_t *last_chunk; // the chunk allocations are carved from
+                                  // (the one with the most free pages)
+    utils_mutex_t chunks_lock;    // protects all chunks
+} umf_tracking_memory_provider_t;
+
+typedef struct umf_tracking_memory_provider_t umf_tracking_memory_provider_t;
+
+// Put the IPC handle of the region being freed, if it was cached.
+static void trackingPutCachedIpcHandle(umf_tracking_memory_provider_t *p,
+                                       void *ptr, size_t size);
+
+// Allocates a new chunk from the upstream provider and registers it in the
+// tracker. Should be called under the chunks_lock.
+static tracking_chunk_t *
+trackingChunkCreate(umf_tracking_memory_provider_t *p) {
+    tracking_chunk_t *chunk = umf_ba_global_alloc(sizeof(*chunk));
+    if (!chunk) {
+        return NULL;
+    }
+
+    umf_result_t ret = umfMemoryProviderAlloc(p->hUpstream, TRACKING_CHUNK_SIZE,
+                                              0, &chunk->base);
+    if (ret != UMF_RESULT_SUCCESS || !chunk->base) {
+        goto err_free_chunk;
+    }
+
+    chunk->size = TRACKING_CHUNK_SIZE;
+    chunk->pages = ALIGN_UP((uintptr_t)chunk->base, p->page_size);
+    chunk->n_pages = ((uintptr_t)chunk->base + chunk->size - chunk->pages) /
+                     p->page_size;
+    chunk->n_free_pages = chunk->n_pages;
+    chunk->n_allocs = 0;
+    memset(chunk->alloc_pages, 0, sizeof(chunk->alloc_pages));
+
+    if (critnib_insert(p->chunks, (uintptr_t)chunk->base, chunk, 0)) {
+        goto err_free_upstream;
+    }
+
+    ret =
+        umfMemoryTrackerAdd(p->hTracker, p->pool_id, chunk->base, chunk->size);
+    if (ret != UMF_RESULT_SUCCESS) {
+        LOG_ERR("failed to add a chunk to the tracker, ptr = %p, size = %zu, "
+                "ret = %d",
+                chunk->base, chunk->size, ret);
+        critnib_remove_release(p->chunks, (uintptr_t)chunk->base);
+        goto err_free_upstream;
+    }
+
+    LOG_DEBUG("created a chunk of pool %p: ptr=%p, size=%zu", (void *)p->pool,
+              chunk->base, chunk->size);
+
+    return chunk;
+
+err_free_upstream:
+    umfMemoryProviderFree(p->hUpstream, chunk->base, TRACKING_CHUNK_SIZE);
+err_free_chunk:
+    umf_ba_global_free(chunk);
+    return NULL;
+}
+
+// Unregisters the chunk and frees it to the upstream provider.
+// Should be called under the chunks_lock.
+static void trackingChunkDestroy(umf_tracking_memory_provider_t *p,
+                                 tracking_chunk_t *chunk) {
+    critnib_remove_release(p->chunks, (uintptr_t)chunk->base);
+
+    umf_result_t ret = umfMemoryTrackerRemove(p->hTracker, chunk->base);
+    if (ret != UMF_RESULT_SUCCESS) {
+        LOG_ERR("failed to remove a chunk from the tracker, ptr=%p, "
+                "size=%zu, ret = %d",
+                chunk->base, chunk->size, ret);
+    }
+
+    trackingPutCachedIpcHandle(p, chunk->base, chunk->size);
+
+    ret = umfMemoryProviderFree(p->hUpstream, chunk->base, chunk->size);
+    if (ret != UMF_RESULT_SUCCESS) {
+        LOG_ERR("upstream provider failed to free a chunk, ptr=%p, size=%zu",
+                chunk->base, chunk->size);
+    }
+
+    umf_ba_global_free(chunk);
+}
+
+// Finds the chunk containing `ptr`. Should be called under the chunks_lock,
+// which keeps the chunk from being destroyed.
+static tracking_chunk_t *trackingChunkFind(umf_tracking_memory_provider_t *p,
+                                           const void *ptr) {
+    tracking_chunk_t *chunk = critnib_find_le(p->chunks, (uintptr_t)ptr, NULL);
+    if (!chunk || (uintptr_t)ptr >= (uintptr_t)chunk->base + chunk->size) {
+        return NULL;
+    }
+
+    return chunk;
+}
+
+// Carves an allocation out of the first run of free pages of the chunk
+// big enough for it. Returns 0 if there is no such run.
+// Should be called under the chunks_lock.
+static uintptr_t trackingChunkCarve(umf_tracking_memory_provider_t *p,
+                                    tracking_chunk_t *chunk, size_t size,
+                                    size_t alignment) {
+    size_t n = size / p->page_size;
+    if (n > chunk->n_free_pages) {
+        return 0;
+    }
+
+    size_t page = 0;
+    while (page < chunk->n_pages) {
+        if (chunk->alloc_pages[page]) {
+            // skip the allocation
+            page += chunk->alloc_pages[page];
             continue;
         }
 
-        utils_atomic_load_acquire_u64((uint64_t *)&rvalue->size, &rsize);
-        utils_atomic_load_acquire_size_t(&rvalue->n_children, &n_children);
-        if (found && (uintptr_t)ptr < rkey + rsize) {
-            top_most_key = rkey;
-            top_most_value = rvalue;
-            if (ref_top_most_value) {
-                assert(level >= 1);
-                critnib_release(TRACKER->alloc_segments_map[level - 1],
-                                ref_top_most_value);
-            }
-            ref_top_most_value = ref_value;
-            ref_level = level;
-            if (n_children == 0 ||
-                level == MAX_LEVELS_OF_ALLOC_SEGMENT_MAP - 1) {
-                break;
-            }
-            level++;
+        // a run of free pages ends where the next allocation starts
+        size_t end = page;
+        while (end < chunk->n_pages && chunk->alloc_pages[end] == 0) {
+            end++;
         }
-    } while (found && (uintptr_t)ptr < rkey + rsize && n_children);
 
-    if (!top_most_value) {
-        if (ref_value) {
-            critnib_release(TRACKER->alloc_segments_map[level], ref_value);
+        uintptr_t ptr =
+            ALIGN_UP(chunk->pages + page * p->page_size, alignment);
+        size_t first = (ptr - chunk->pages) / p->page_size;
+        if (first + n <= end) {
+            chunk->alloc_pages[first] = (uint16_t)n;
+            chunk->n_free_pages -= n;
+            chunk->n_allocs++;
+            return ptr;
         }
 
-        LOG_DEBUG("pointer %p not found in the tracker, TRACKER=%p", ptr,
-                  (void *)TRACKER);
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+        page = end;
     }
 
-    pAllocInfo->base = (void *)top_most_key;
-    pAllocInfo->baseSize = top_most_value->size;
-    pAllocInfo->pool = top_most_value->pool;
+    return 0;
+}
 
-    assert(ref_top_most_value);
-    critnib_release(TRACKER->alloc_segments_map[ref_level], ref_top_most_value);
+// Carves an allocation out of the last chunk (or a new one, if it does not
+// fit). Returns NULL if the allocation has to be served by the upstream
+// provider directly.
+static void *trackingChunkAlloc(umf_tracking_memory_provider_t *p, size_t size,
+                                size_t alignment) {
+    if (size > TRACKING_CHUNK_MAX_ALLOC ||
+        alignment > TRACKING_CHUNK_MAX_ALLOC) {
+        return NULL;
+    }
 
-    return UMF_RESULT_SUCCESS;
-}
+    // keep the allocations page-aligned as if they came from the upstream
+    alignment = utils_max(alignment, p->page_size);
+    size = ALIGN_UP(size, p->page_size);
 
-umf_result_t umfMemoryTrackerGetIpcInfo(const void *ptr,
-                                        umf_ipc_info_t *pIpcInfo) {
-    assert(pIpcInfo);
+    utils_mutex_lock(&p->chunks_lock);
 
-    if (ptr == NULL) {
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    tracking_chunk_t *chunk = p->last_chunk;
+    uintptr_t ptr = 0;
+    if (chunk) {
+        ptr = trackingChunkCarve(p, chunk, size, alignment);
     }
 
-    if (TRACKER == NULL) {
-        LOG_ERR("tracker does not exist");
-        return UMF_RESULT_ERROR_NOT_SUPPORTED;
-    }
+    if (!ptr) {
+        // the previous last chunk is freed with its last allocation
+        chunk = trackingChunkCreate(p);
+        if (!chunk) {
+            utils_mutex_unlock(&p->chunks_lock);
+            return NULL;
+        }
 
-    if (TRACKER->ipc_segments_map == NULL) {
-        LOG_ERR("tracker's ipc_segments_map does not exist");
-        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+        p->last_chunk = chunk;
+        ptr = trackingChunkCarve(p, chunk, size, alignment);
     }
 
-    uintptr_t rkey = 0;
-    tracker_ipc_info_t *rvalue = NULL;
-    void *ref_value = NULL;
-    int found = critnib_find(TRACKER->ipc_segments_map, (uintptr_t)ptr, FIND_LE,
-                             (void *)&rkey, (void **)&rvalue, &ref_value);
+    utils_mutex_unlock(&p->chunks_lock);
 
-    if (!found || (found && (rvalue == NULL)) ||
-        ((uintptr_t)ptr >= rkey + rvalue->size)) {
-        LOG_DEBUG("pointer %p not found in the tracker, TRACKER=%p", ptr,
-                  (void *)TRACKER);
-        if (ref_value) {
-            critnib_release(TRACKER->ipc_segments_map, ref_value);
+    return (void *)ptr;
+}
+
+// Returns true if the allocation was carved out of a chunk (and frees it).
+static bool trackingChunkFree(umf_tracking_memory_provider_t *p, void *ptr) {
+    utils_mutex_lock(&p->chunks_lock);
+
+    tracking_chunk_t *chunk = trackingChunkFind(p, ptr);
+    if (!chunk) {
+        utils_mutex_unlock(&p->chunks_lock);
+        return false;
+    }
+
+    size_t page = ((uintptr_t)ptr - chunk->pages) / p->page_size;
+    assert(chunk->alloc_pages[page] > 0);
+    chunk->n_free_pages += chunk->alloc_pages[page];
+    chunk->alloc_pages[page] = 0;
+
+    assert(chunk->n_allocs > 0);
+    chunk->n_allocs--;
+    if (chunk != p->last_chunk) {
+        if (chunk->n_allocs == 0) {
+            trackingChunkDestroy(p, chunk);
+        } else if (chunk->n_free_pages > p->last_chunk->n_free_pages) {
+            // carve next allocations out of the chunk with the most free
+            // pages, so that partially used chunks are filled up again
+            tracking_chunk_t *last_chunk = p->last_chunk;
+            p->last_chunk = chunk;
+            if (last_chunk->n_allocs == 0) {
+                trackingChunkDestroy(p, last_chunk);
+            }
         }
-        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
     }
 
-    pIpcInfo->base = (void *)rkey;
-    pIpcInfo->baseSize = rvalue->size;
-    pIpcInfo->provider = rvalue->provider;
+    utils_mutex_unlock(&p->chunks_lock);
 
-    if (ref_value) {
-        critnib_release(TRACKER->ipc_segments_map, ref_value);
+    return true;
+}
+
+// Finds the allocation containing `ptr` carved out of a chunk.
+// Returns false if `ptr` does not belong to any chunk.
+static bool trackingChunkGetAlloc(umf_tracking_memory_provider_t *p,
+                                  const void *ptr, void **base, size_t *size) {
+    utils_mutex_lock(&p->chunks_lock);
+
+    tracking_chunk_t *chunk = trackingChunkFind(p, ptr);
+    if (!chunk || (uintptr_t)ptr < chunk->pages) {
+        utils_mutex_unlock(&p->chunks_lock);
+        return false;
     }
 
-    return UMF_RESULT_SUCCESS;
+    size_t page = ((uintptr_t)ptr - chunk->pages) / p->page_size;
+    while (page > 0 && chunk->alloc_pages[page] == 0) {
+        page--;
+    }
+
+    *base = (void *)(chunk->pages + page * p->page_size);
+    *size = chunk->alloc_pages[page] * p->page_size;
+
+    utils_mutex_unlock(&p->chunks_lock);
+
+    return true;
 }
 
-// Cache entry structure to store provider-specific IPC data.
-// providerIpcData is a Flexible Array Member because its size varies
-// depending on the provider.
-typedef struct ipc_cache_value_t {
-    uint64_t handle_id;
-    uint64_t ipcDataSize;
-    char providerIpcData[];
-} ipc_cache_value_t;
+// Returns true if the region was carved out of a chunk.
+static bool trackingIsInChunk(umf_tracking_memory_provider_t *p, void *ptr) {
+    if (!p->coarse) {
+        return false;
+    }
 
-typedef struct umf_tracking_memory_provider_t {
-    umf_memory_provider_handle_t hUpstream;
-    umf_memory_tracker_handle_t hTracker;
-    umf_memory_pool_handle_t pool;
-    critnib *ipcCache;
-    ipc_opened_cache_handle_t hIpcMappedCache;
-} umf_tracking_memory_provider_t;
+    utils_mutex_lock(&p->chunks_lock);
+    bool in_chunk = trackingChunkFind(p, ptr) != NULL;
+    utils_mutex_unlock(&p->chunks_lock);
 
-typedef struct umf_tracking_memory_provider_t umf_tracking_memory_provider_t;
+    return in_chunk;
+}
 
 static umf_result_t trackingAlloc(void *hProvider, size_t size,
                                   size_t alignment, void **_ptr) {
@@ -640,12 +1528,20 @@ static umf_result_t trackingAlloc(void *hProvider, size_t size,
 
     *_ptr = NULL;
 
+    if (p->coarse) {
+        ptr = trackingChunkAlloc(p, size, alignment);
+        if (ptr) {
+            *_ptr = ptr;
+            return UMF_RESULT_SUCCESS;
+        }
+    }
+
     ret = umfMemoryProviderAlloc(p->hUpstream, size, alignment, &ptr);
     if (ret != UMF_RESULT_SUCCESS || !ptr) {
         return ret;
     }
 
-    ret = umfMemoryTrackerAdd(p->hTracker, p->pool, ptr, size);
+    ret = umfMemoryTrackerAdd(p->hTracker, p->pool_id, ptr, size);
     if (ret != UMF_RESULT_SUCCESS) {
         LOG_ERR("failed to add allocated region to the tracker, ptr = %p, size "
                 "= %zu, ret = %d",
@@ -673,12 +1569,18 @@ static umf_result_t trackingAllocationSplit(void *hProvider, void *ptr,
     tracker_alloc_info_t *parent_value = NULL;
     uintptr_t parent_key = 0;
 
-    int r = utils_mutex_lock(&provider->hTracker->splitMergeMutex);
+    if (trackingIsInChunk(provider, ptr)) {
+        LOG_DEBUG("regions carved out of a chunk cannot be split");
+        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    }
+
+    utils_mutex_t *lock = tracker_split_merge_lock(provider->hTracker, ptr);
+    int r = utils_mutex_lock(lock);
     if (r) {
         goto err_lock;
     }
 
-    int level = 0;
+    tracker_level_t *level = NULL;
     void *ref_value = NULL;
     void *ref_parent_value = NULL;
 
@@ -694,28 +1596,38 @@ static umf_result_t trackingAllocationSplit(void *hProvider, void *ptr,
     }
     if (value->size != totalSize) {
         LOG_ERR("tracked size=%zu does not match requested size to split: %zu",
-                value->size, totalSize);
+                (size_t)value->size, totalSize);
         ret = UMF_RESULT_ERROR_INVALID_ARGUMENT;
         goto err;
     }
 
+    // allocate the value of the second part before the upstream split,
+    // so that running out of memory does not require reverting it
+    tracker_alloc_info_t *highValue =
+        umf_ba_alloc(provider->hTracker->alloc_info_allocator);
+    if (!highValue) {
+        LOG_ERR("failed to allocate a tracker value for the split region");
+        ret = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+        goto err;
+    }
+
     ret = umfMemoryProviderAllocationSplit(provider->hUpstream, ptr, totalSize,
                                            firstSize);
     if (ret != UMF_RESULT_SUCCESS) {
         LOG_ERR("upstream provider failed to split the region");
+        umf_ba_free(provider->hTracker->alloc_info_allocator, highValue);
         goto err;
     }
 
     void *highPtr = (void *)(((uintptr_t)ptr) + firstSize);
     size_t secondSize = totalSize - firstSize;
 
-    assert(level < MAX_LEVELS_OF_ALLOC_SEGMENT_MAP);
-
     // We'll have a duplicate entry for the range [highPtr, highValue->size] but this is fine,
     // the value is the same anyway and we forbid removing that range concurrently
-    ret = umfMemoryTrackerAddAtLevel(provider->hTracker, level, provider->pool,
-                                     highPtr, secondSize, parent_key,
-                                     parent_value, ref_parent_value);
+    ret = umfMemoryTrackerAddAtLevel(provider->hTracker, level, highValue,
+                                     provider->pool_id, highPtr, secondSize,
+                                     parent_key, parent_value,
+                                     ref_parent_value);
     if (ret != UMF_RESULT_SUCCESS) {
         LOG_ERR("failed to add the split region to the tracker, ptr=%p, "
                 "size=%zu, ret=%d",
@@ -727,24 +1639,26 @@ static umf_result_t trackingAllocationSplit(void *hProvider, void *ptr,
 
         // TODO: what now? should we rollback the split? This can only happen due to ENOMEM
         // so it's unlikely but probably the best solution would be to try to preallocate everything
-        // (value and critnib nodes) before calling umfMemoryProviderAllocationSplit.
+        // (critnib nodes) before calling umfMemoryProviderAllocationSplit.
         goto err;
     }
 
     // update the size of the first part
     utils_atomic_store_release_u64((uint64_t *)&value->size, firstSize);
-    critnib_release(provider->hTracker->alloc_segments_map[level], ref_value);
+    critnib_release(level->map, ref_value);
+
+    tracker_cache_invalidate_range(ptr, totalSize);
 
-    utils_mutex_unlock(&provider->hTracker->splitMergeMutex);
+    utils_mutex_unlock(lock);
 
     LOG_DEBUG(
         "split memory region (level=%i): ptr=%p, totalSize=%zu, firstSize=%zu",
-        level, ptr, totalSize, firstSize);
+        level->depth, ptr, totalSize, firstSize);
 
     return UMF_RESULT_SUCCESS;
 
 err:
-    utils_mutex_unlock(&provider->hTracker->splitMergeMutex);
+    utils_mutex_unlock(lock);
 
 err_lock:
     LOG_ERR(
@@ -760,14 +1674,35 @@ static umf_result_t trackingAllocationMerge(void *hProvider, void *lowPtr,
     umf_tracking_memory_provider_t *provider =
         (umf_tracking_memory_provider_t *)hProvider;
 
-    // any different negative values
-    int lowLevel = -2;
-    int highLevel = -1;
+    tracker_level_t *lowLevel = NULL;
+    tracker_level_t *highLevel = NULL;
 
-    int r = utils_mutex_lock(&provider->hTracker->splitMergeMutex);
+    if (trackingIsInChunk(provider, lowPtr) ||
+        trackingIsInChunk(provider, highPtr)) {
+        LOG_DEBUG("regions carved out of a chunk cannot be merged");
+        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    }
+
+    // lock the regions in a fixed order to avoid a deadlock
+    // with a merge of the same regions in the opposite direction
+    utils_mutex_t *lowLock =
+        tracker_split_merge_lock(provider->hTracker, lowPtr);
+    utils_mutex_t *highLock =
+        tracker_split_merge_lock(provider->hTracker, highPtr);
+    utils_mutex_t *firstLock = (lowLock < highLock) ? lowLock : highLock;
+    utils_mutex_t *secondLock = (lowLock < highLock) ? highLock : lowLock;
+
+    int r = utils_mutex_lock(firstLock);
     if (r) {
         goto err_lock;
     }
+    if (secondLock != firstLock) {
+        r = utils_mutex_lock(secondLock);
+        if (r) {
+            utils_mutex_unlock(firstLock);
+            goto err_lock;
+        }
+    }
 
     void *ref_lowValue = NULL;
     void *ref_highValue = NULL;
@@ -805,7 +1740,7 @@ static umf_result_t trackingAllocationMerge(void *hProvider, void *lowPtr,
         ret = UMF_RESULT_ERROR_INVALID_ARGUMENT;
         goto err_fatal;
     }
-    if (lowValue->pool != highValue->pool) {
+    if (lowValue->pool_id != highValue->pool_id) {
         LOG_FATAL("pool mismatch");
         ret = UMF_RESULT_ERROR_INVALID_ARGUMENT;
         goto err_fatal;
@@ -829,45 +1764,76 @@ static umf_result_t trackingAllocationMerge(void *hProvider, void *lowPtr,
     size_t low_children = lowValue->n_children;
     size_t high_children = highValue->n_children;
 
-    critnib_release(provider->hTracker->alloc_segments_map[lowLevel],
-                    ref_lowValue);
-    critnib_release(provider->hTracker->alloc_segments_map[highLevel],
-                    ref_highValue);
+    critnib_release(lowLevel->map, ref_lowValue);
+    critnib_release(highLevel->map, ref_highValue);
 
-    critnib_remove_release(provider->hTracker->alloc_segments_map[highLevel],
-                           (uintptr_t)highPtr);
+    critnib_remove_release(highLevel->map, (uintptr_t)highPtr);
+
+    tracker_cache_invalidate_range(lowPtr, totalSize);
 
     LOG_DEBUG("merged memory regions (level=%i): lowPtr=%p (child=%zu), "
               "highPtr=%p (child=%zu), totalSize=%zu",
-              lowLevel, lowPtr, low_children, highPtr, high_children,
+              lowLevel->depth, lowPtr, low_children, highPtr, high_children,
               totalSize);
 
-    utils_mutex_unlock(&provider->hTracker->splitMergeMutex);
+    if (secondLock != firstLock) {
+        utils_mutex_unlock(secondLock);
+    }
+    utils_mutex_unlock(firstLock);
 
     return UMF_RESULT_SUCCESS;
 
 err_fatal:
     LOG_FATAL("failed to merge memory regions: lowPtr=%p (level=%i), "
               "highPtr=%p (level=%i), totalSize=%zu",
-              lowPtr, lowLevel, highPtr, highLevel, totalSize);
+              lowPtr, tracker_level_depth(lowLevel), highPtr,
+              tracker_level_depth(highLevel), totalSize);
 
 cannot_merge:
-    utils_mutex_unlock(&provider->hTracker->splitMergeMutex);
+    if (secondLock != firstLock) {
+        utils_mutex_unlock(secondLock);
+    }
+    utils_mutex_unlock(firstLock);
 
 err_lock:
     LOG_ERR("failed to merge memory regions: lowPtr=%p (level=%i), highPtr=%p "
             "(level=%i), totalSize=%zu",
-            lowPtr, lowLevel, highPtr, highLevel, totalSize);
+            lowPtr, tracker_level_depth(lowLevel), highPtr,
+            tracker_level_depth(highLevel), totalSize);
 
     return ret;
 }
 
+static void trackingPutCachedIpcHandle(umf_tracking_memory_provider_t *p,
+                                       void *ptr, size_t size) {
+    void *ref_value = NULL;
+    void *value = critnib_remove(p->ipcCache, (uintptr_t)ptr, &ref_value);
+    if (value) {
+        ipc_cache_value_t *cache_value = (ipc_cache_value_t *)value;
+        umf_result_t ret = umfMemoryProviderPutIPCHandle(
+            p->hUpstream, cache_value->providerIpcData);
+        if (ret != UMF_RESULT_SUCCESS) {
+            LOG_ERR("upstream provider failed to put IPC handle, ptr=%p, "
+                    "size=%zu, ret = %d",
+                    ptr, size, ret);
+        }
+    }
+
+    if (ref_value) {
+        critnib_release(p->ipcCache, ref_value);
+    }
+}
+
 static umf_result_t trackingFree(void *hProvider, void *ptr, size_t size) {
     umf_result_t ret;
     umf_result_t ret_remove = UMF_RESULT_ERROR_UNKNOWN;
     umf_tracking_memory_provider_t *p =
         (umf_tracking_memory_provider_t *)hProvider;
 
+    if (p->coarse && ptr && trackingChunkFree(p, ptr)) {
+        return UMF_RESULT_SUCCESS;
+    }
+
     // umfMemoryTrackerRemove should be called before umfMemoryProviderFree
     // to avoid a race condition. If the order would be different, other thread
     // could allocate the memory at address `ptr` before a call to umfMemoryTrackerRemove
@@ -883,22 +1849,7 @@ static umf_result_t trackingFree(void *hProvider, void *ptr, size_t size) {
         }
     }
 
-    void *ref_value = NULL;
-    void *value = critnib_remove(p->ipcCache, (uintptr_t)ptr, &ref_value);
-    if (value) {
-        ipc_cache_value_t *cache_value = (ipc_cache_value_t *)value;
-        ret = umfMemoryProviderPutIPCHandle(p->hUpstream,
-                                            cache_value->providerIpcData);
-        if (ret != UMF_RESULT_SUCCESS) {
-            LOG_ERR("upstream provider failed to put IPC handle, ptr=%p, "
-                    "size=%zu, ret = %d",
-                    ptr, size, ret);
-        }
-    }
-
-    if (ref_value) {
-        critnib_release(p->ipcCache, ref_value);
-    }
+    trackingPutCachedIpcHandle(p, ptr, size);
 
     ret = umfMemoryProviderFree(p->hUpstream, ptr, size);
     if (ret != UMF_RESULT_SUCCESS) {
@@ -909,7 +1860,7 @@ static umf_result_t trackingFree(void *hProvider, void *ptr, size_t size) {
             return ret;
         }
 
-        if (umfMemoryTrackerAdd(p->hTracker, p->pool, ptr, size) !=
+        if (umfMemoryTrackerAdd(p->hTracker, p->pool_id, ptr, size) !=
             UMF_RESULT_SUCCESS) {
             LOG_ERR("cannot add memory back to the tracker, ptr=%p, size=%zu",
                     ptr, size);
@@ -933,6 +1884,39 @@ static umf_result_t trackingInitialize(const void *params, void **ret) {
         return UMF_RESULT_ERROR_INVALID_ARGUMENT;
     }
 
+    umf_result_t umf_result = tracker_pool_register(
+        provider->hTracker, provider->pool, &provider->pool_id);
+    if (umf_result != UMF_RESULT_SUCCESS) {
+        umf_ba_global_free(provider);
+        return umf_result;
+    }
+
+    if (provider->coarse) {
+        umf_result = umfMemoryProviderGetMinPageSize(provider->hUpstream, NULL,
+                                                     &provider->page_size);
+        if (umf_result != UMF_RESULT_SUCCESS || provider->page_size == 0) {
+            provider->page_size = utils_get_page_size();
+        }
+
+        // the pages of chunks are counted in 'alloc_pages'
+        provider->page_size =
+            utils_max(provider->page_size, TRACKING_CHUNK_MIN_PAGE);
+
+        provider->chunks = critnib_new(NULL, NULL);
+        if (!provider->chunks) {
+            tracker_pool_unregister(provider->hTracker, provider->pool_id);
+            umf_ba_global_free(provider);
+            return UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+        }
+
+        if (!utils_mutex_init(&provider->chunks_lock)) {
+            critnib_delete(provider->chunks);
+            tracker_pool_unregister(provider->hTracker, provider->pool_id);
+            umf_ba_global_free(provider);
+            return UMF_RESULT_ERROR_UNKNOWN;
+        }
+    }
+
     *ret = provider;
     return UMF_RESULT_SUCCESS;
 }
@@ -942,24 +1926,27 @@ static void check_if_tracker_is_empty(umf_memory_tracker_handle_t hTracker,
                                       umf_memory_pool_handle_t pool) {
     size_t n_items = 0;
 
-    for (int i = 0; i < MAX_LEVELS_OF_ALLOC_SEGMENT_MAP; i++) {
+    for (tracker_level_t *level = hTracker->alloc_segments; level;
+         level = tracker_level_next(level)) {
         uintptr_t last_key = 0;
         uintptr_t rkey;
         tracker_alloc_info_t *rvalue;
         void *ref_value = NULL;
 
-        while (1 == critnib_find(hTracker->alloc_segments_map[i], last_key,
-                                 FIND_G, &rkey, (void **)&rvalue, &ref_value)) {
-            if (rvalue && ((rvalue->pool == pool) || pool == NULL)) {
+        while (1 == critnib_find(level->map, last_key, FIND_G, &rkey,
+                                 (void **)&rvalue, &ref_value)) {
+            umf_memory_pool_handle_t rpool =
+                rvalue ? tracker_pool_get(hTracker, rvalue->pool_id) : NULL;
+            if (rvalue && ((rpool == pool) || pool == NULL)) {
                 n_items++;
                 LOG_DEBUG(
                     "found abandoned allocation in the tracking provider: "
                     "pool=%p, ptr=%p, size=%zu",
-                    (void *)rvalue->pool, (void *)rkey, (size_t)rvalue->size);
+                    (void *)rpool, (void *)rkey, (size_t)rvalue->size);
             }
 
             if (ref_value) {
-                critnib_release(hTracker->alloc_segments_map[i], ref_value);
+                critnib_release(level->map, ref_value);
             }
 
             last_key = rkey;
@@ -994,6 +1981,25 @@ static umf_result_t trackingFinalize(void *provider) {
 
     umfIpcOpenedCacheDestroy(p->hIpcMappedCache);
 
+    if (p->coarse) {
+        uintptr_t key;
+        tracking_chunk_t *chunk;
+        while (critnib_find(p->chunks, 0, FIND_GE, &key, (void **)&chunk,
+                            NULL) == 1) {
+            if (chunk->n_allocs) {
+                LOG_ERR("chunk of pool %p is not empty! (%zu allocations "
+                        "left)",
+                        (void *)p->pool, chunk->n_allocs);
+            }
+            trackingChunkDestroy(p, chunk);
+        }
+
+        critnib_delete(p->chunks);
+        utils_mutex_destroy_not_free(&p->chunks_lock);
+    }
+
+    tracker_pool_unregister(p->hTracker, p->pool_id);
+
     critnib_delete(p->ipcCache);
 
     umf_ba_global_free(provider);
@@ -1324,9 +2330,11 @@ static void free_ipc_cache_value(void *unused, void *ipc_cache_value) {
 
 umf_result_t umfTrackingMemoryProviderCreate(
     umf_memory_provider_handle_t hUpstream, umf_memory_pool_handle_t hPool,
-    umf_memory_provider_handle_t *hTrackingProvider) {
+    bool coarse, umf_memory_provider_handle_t *hTrackingProvider) {
 
     umf_tracking_memory_provider_t params;
+    memset(&params, 0, sizeof(params));
+    params.coarse = coarse;
     params.hUpstream = hUpstream;
     params.hTracker = TRACKER;
     if (!params.hTracker) {
@@ -1344,10 +2352,10 @@ umf_result_t umfTrackingMemoryProviderCreate(
         umfIpcOpenedCacheCreate(ipcOpenedCacheEvictionCallback);
 
     LOG_DEBUG("upstream=%p, tracker=%p, "
-              "pool=%p, ipcCache=%p, hIpcMappedCache=%p",
+              "pool=%p, ipcCache=%p, hIpcMappedCache=%p, coarse=%d",
               (void *)params.hUpstream, (void *)params.hTracker,
               (void *)params.pool, (void *)params.ipcCache,
-              (void *)params.hIpcMappedCache);
+              (void *)params.hIpcMappedCache, (int)params.coarse);
 
     return umfMemoryProviderCreate(&UMF_TRACKING_MEMORY_PROVIDER_OPS, &params,
                                    hTrackingProvider);
@@ -1362,6 +2370,146 @@ void umfTrackingMemoryProviderGetUpstreamProvider(
     *hUpstream = p->hUpstream;
 }
 
+static bool isTrackingProvider(umf_memory_provider_handle_t hProvider) {
+    return hProvider->ops.alloc == trackingAlloc;
+}
+
+umf_result_t umfTrackingMemoryProviderGetAllocInfo(
+    umf_memory_provider_handle_t hProvider, const void *ptr,
+    umf_alloc_info_t *pAllocInfo, bool *pInChunk) {
+    assert(pAllocInfo);
+    assert(pInChunk);
+
+    *pInChunk = false;
+
+    if (ptr && isTrackingProvider(hProvider)) {
+        umf_tracking_memory_provider_t *p = umfMemoryProviderGetPriv(hProvider);
+        if (p->coarse && trackingChunkGetAlloc(p, ptr, &pAllocInfo->base,
+                                               &pAllocInfo->baseSize)) {
+            pAllocInfo->pool = p->pool;
+            *pInChunk = true;
+            return UMF_RESULT_SUCCESS;
+        }
+    }
+
+    return umfMemoryTrackerGetAllocInfo(ptr, pAllocInfo);
+}
+
+umf_result_t
+umfTrackingMemoryProviderAllocBatch(umf_memory_provider_handle_t hProvider,
+                                    size_t size, size_t alignment, size_t num,
+                                    void **ptrs) {
+    umf_result_t ret = UMF_RESULT_SUCCESS;
+    umf_tracking_memory_provider_t *p = NULL;
+    umf_memory_provider_handle_t hUpstream = hProvider;
+    if (isTrackingProvider(hProvider)) {
+        p = umfMemoryProviderGetPriv(hProvider);
+        hUpstream = p->hUpstream;
+
+        // regions small enough are carved out of chunks (see trackingAlloc())
+        if (p->coarse && size <= TRACKING_CHUNK_MAX_ALLOC &&
+            alignment <= TRACKING_CHUNK_MAX_ALLOC) {
+            p = NULL;
+            hUpstream = hProvider;
+        }
+    }
+
+    size_t i;
+    for (i = 0; i < num; i++) {
+        ret = umfMemoryProviderAlloc(hUpstream, size, alignment, &ptrs[i]);
+        if (ret != UMF_RESULT_SUCCESS || !ptrs[i]) {
+            goto err_free;
+        }
+    }
+
+    if (p) {
+        ret =
+            umfMemoryTrackerAddBatch(p->hTracker, p->pool_id, ptrs, size, num);
+        if (ret != UMF_RESULT_SUCCESS) {
+            LOG_ERR("failed to add a batch of %zu allocated regions to the "
+                    "tracker, size = %zu, ret = %d",
+                    num, size, ret);
+            goto err_free;
+        }
+    }
+
+    return UMF_RESULT_SUCCESS;
+
+err_free:
+    while (i-- > 0) {
+        umf_result_t ret2 = umfMemoryProviderFree(hUpstream, ptrs[i], size);
+        if (ret2 != UMF_RESULT_SUCCESS) {
+            LOG_ERR("upstream provider failed to free the memory: ptr = %p, "
+                    "size = %zu, ret = %d",
+                    ptrs[i], size, ret2);
+        }
+    }
+
+    return (ret == UMF_RESULT_SUCCESS) ? UMF_RESULT_ERROR_UNKNOWN : ret;
+}
+
+umf_result_t
+umfTrackingMemoryProviderFreeBatch(umf_memory_provider_handle_t hProvider,
+                                   void **ptrs, size_t size, size_t num) {
+    umf_result_t ret = UMF_RESULT_SUCCESS;
+
+    // regions carved out of chunks are freed one by one,
+    // the same as umfTrackingMemoryProviderAllocBatch() allocated them
+    bool one_by_one = !isTrackingProvider(hProvider);
+    if (!one_by_one) {
+        umf_tracking_memory_provider_t *p = umfMemoryProviderGetPriv(hProvider);
+        one_by_one = p->coarse && size <= TRACKING_CHUNK_MAX_ALLOC;
+    }
+
+    if (one_by_one) {
+        for (size_t i = 0; i < num; i++) {
+            umf_result_t ret2 = umfMemoryProviderFree(hProvider, ptrs[i], size);
+            if (ret2 != UMF_RESULT_SUCCESS && ret == UMF_RESULT_SUCCESS) {
+                ret = ret2;
+            }
+        }
+        return ret;
+    }
+
+    umf_tracking_memory_provider_t *p = umfMemoryProviderGetPriv(hProvider);
+
+    // the regions have to be removed from the tracker
+    // before they are freed (see trackingFree())
+    size_t n_not_removed = umfMemoryTrackerRemoveBatch(p->hTracker, ptrs, num);
+    if (n_not_removed) {
+        // DO NOT return an error here, because the tracking provider
+        // cannot change behaviour of the upstream provider.
+        LOG_ERR("failed to remove %zu of %zu regions from the tracker, "
+                "size=%zu",
+                n_not_removed, num, size);
+    }
+
+    for (size_t i = 0; i < num; i++) {
+        trackingPutCachedIpcHandle(p, ptrs[i], size);
+
+        umf_result_t ret2 = umfMemoryProviderFree(p->hUpstream, ptrs[i], size);
+        if (ret2 == UMF_RESULT_SUCCESS) {
+            continue;
+        }
+
+        LOG_ERR("upstream provider failed to free the memory");
+        if (ret == UMF_RESULT_SUCCESS) {
+            ret = ret2;
+        }
+
+        // Do not add memory back to the tracker,
+        // if we do not know whether it had been removed.
+        if (n_not_removed == 0 &&
+            umfMemoryTrackerAdd(p->hTracker, p->pool_id, ptrs[i], size) !=
+                UMF_RESULT_SUCCESS) {
+            LOG_ERR("cannot add memory back to the tracker, ptr=%p, size=%zu",
+                    ptrs[i], size);
+        }
+    }
+
+    return ret;
+}
+
 static void free_leaf(void *leaf_allocator, void *ptr) {
     if (ptr) {
 #if !defined(NDEBUG) && defined(UMF_DEVELOPER_MODE)
@@ -1397,22 +2545,26 @@ umf_result_t umfMemoryTrackerCreate(umf_memory_tracker_handle_t *handle_out) {
 
     handle->alloc_info_allocator = alloc_info_allocator;
 
-    void *mutex_ptr = utils_mutex_init(&handle->splitMergeMutex);
-    if (!mutex_ptr) {
+    if (!utils_mutex_init(&handle->pools_lock)) {
         ret = UMF_RESULT_ERROR_UNKNOWN;
         goto err_destroy_alloc_info_allocator;
     }
+    handle->pools_next = 1; // index 0 is never used
 
     int i;
-    for (i = 0; i < MAX_LEVELS_OF_ALLOC_SEGMENT_MAP; i++) {
-        handle->alloc_segments_map[i] =
-            critnib_new(free_leaf, alloc_info_allocator);
-        if (!handle->alloc_segments_map[i]) {
-            ret = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
-            goto err_destroy_alloc_segments_map;
+    for (i = 0; i < TRACKER_SPLIT_MERGE_LOCKS; i++) {
+        if (!utils_mutex_init(&handle->splitMergeLocks[i])) {
+            ret = UMF_RESULT_ERROR_UNKNOWN;
+            goto err_destroy_locks;
         }
     }
 
+    handle->alloc_segments = tracker_level_new(alloc_info_allocator, NULL);
+    if (!handle->alloc_segments) {
+        ret = UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+        goto err_destroy_locks;
+    }
+
     handle->ipc_info_allocator =
         umf_ba_create(sizeof(struct tracker_ipc_info_t));
     if (!handle->ipc_info_allocator) {
@@ -1427,20 +2579,22 @@ umf_result_t umfMemoryTrackerCreate(umf_memory_tracker_handle_t *handle_out) {
         goto err_destroy_ipc_info_allocator;
     }
 
+    tracker_cache_invalidate();
+
     LOG_DEBUG("tracker created, handle=%p, alloc_segments_map=%p",
-              (void *)handle, (void *)handle->alloc_segments_map);
+              (void *)handle, (void *)handle->alloc_segments->map);
     *handle_out = handle;
     return ret;
 
 err_destroy_ipc_info_allocator:
     umf_ba_destroy(handle->ipc_info_allocator);
 err_destroy_alloc_segments_map:
-    for (i = 0; i < MAX_LEVELS_OF_ALLOC_SEGMENT_MAP; i++) {
-        if (handle->alloc_segments_map[i]) {
-            critnib_delete(handle->alloc_segments_map[i]);
-        }
+    tracker_level_delete(handle->alloc_segments);
+err_destroy_locks:
+    while (i--) {
+        utils_mutex_destroy_not_free(&handle->splitMergeLocks[i]);
     }
-    utils_mutex_destroy_not_free(&handle->splitMergeMutex);
+    utils_mutex_destroy_not_free(&handle->pools_lock);
 err_destroy_alloc_info_allocator:
     umf_ba_destroy(alloc_info_allocator);
 err_free_handle:
@@ -1467,13 +2621,20 @@ void umfMemoryTrackerDestroy(umf_memory_tracker_handle_t handle) {
     // We have to zero all inner pointers,
     // because the tracker handle can be copied
     // and used in many places.
-    for (int i = 0; i < MAX_LEVELS_OF_ALLOC_SEGMENT_MAP; i++) {
-        if (handle->alloc_segments_map[i]) {
-            critnib_delete(handle->alloc_segments_map[i]);
-            handle->alloc_segments_map[i] = NULL;
-        }
+    tracker_level_t *level = handle->alloc_segments;
+    handle->alloc_segments = NULL;
+    while (level) {
+        tracker_level_t *next = level->next;
+        tracker_level_delete(level);
+        level = next;
     }
-    utils_mutex_destroy_not_free(&handle->splitMergeMutex);
+    for (int i = 0; i < TRACKER_SPLIT_MERGE_LOCKS; i++) {
+        utils_mutex_destroy_not_free(&handle->splitMergeLocks[i]);
+    }
+    for (int i = 0; i < TRACKER_POOLS_CHUNKS; i++) {
+        umf_ba_global_free(handle->pools[i]);
+    }
+    utils_mutex_destroy_not_free(&handle->pools_lock);
     umf_ba_destroy(handle->alloc_info_allocator);
     handle->alloc_info_allocator = NULL;
     critnib_delete(handle->ipc_segments_map);
@@ -1481,4 +2642,88 @@ void umfMemoryTrackerDestroy(umf_memory_tracker_handle_t handle) {
     umf_ba_destroy(handle->ipc_info_allocator);
     handle->ipc_info_allocator = NULL;
     umf_ba_global_free(handle);
+
+    tracker_cache_invalidate();
+}
+
+// Computes the number of records of tracked regions (including removed ones
+// that are not reclaimed yet) and the memory taken by the tracker to keep
+// them: the records and the nodes and leaves of the maps of all levels.
+static void tracker_get_overhead(umf_memory_tracker_handle_t hTracker,
+                                 size_t *n_regions, size_t *overhead) {
+    size_t record_size;
+    *n_regions = umf_ba_get_n_allocs(hTracker->alloc_info_allocator,
+                                     &record_size);
+    *overhead = *n_regions * record_size;
+
+    for (tracker_level_t *level = hTracker->alloc_segments; level;
+         level = tracker_level_next(level)) {
+        *overhead += sizeof(*level) + critnib_memory_usage(level->map);
+    }
+}
+
+static umf_result_t CTL_READ_HANDLER(regions)(void *ctx,
+                                              umf_ctl_query_source_t source,
+                                              void *arg, size_t size,
+                                              umf_ctl_index_utlist_t *indexes) {
+    /* suppress unused-parameter errors */
+    (void)ctx, (void)source, (void)indexes;
+
+    if (arg == NULL || size != sizeof(size_t)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (TRACKER == NULL) {
+        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    }
+
+    size_t overhead;
+    tracker_get_overhead(TRACKER, (size_t *)arg, &overhead);
+    return UMF_RESULT_SUCCESS;
+}
+
+static umf_result_t
+CTL_READ_HANDLER(overhead)(void *ctx, umf_ctl_query_source_t source, void *arg,
+                           size_t size, umf_ctl_index_utlist_t *indexes) {
+    /* suppress unused-parameter errors */
+    (void)ctx, (void)source, (void)indexes;
+
+    if (arg == NULL || size != sizeof(size_t)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (TRACKER == NULL) {
+        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    }
+
+    size_t n_regions;
+    tracker_get_overhead(TRACKER, &n_regions, (size_t *)arg);
+    return UMF_RESULT_SUCCESS;
+}
+
+static umf_result_t
+CTL_READ_HANDLER(overhead_per_region)(void *ctx, umf_ctl_query_source_t source,
+                                      void *arg, size_t size,
+                                      umf_ctl_index_utlist_t *indexes) {
+    /* suppress unused-parameter errors */
+    (void)ctx, (void)source, (void)indexes;
+
+    if (arg == NULL || size != sizeof(size_t)) {
+        return UMF_RESULT_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (TRACKER == NULL) {
+        return UMF_RESULT_ERROR_NOT_SUPPORTED;
+    }
+
+    size_t n_regions, overhead;
+    tracker_get_overhead(TRACKER, &n_regions, &overhead);
+    *(size_t *)arg = n_regions ? overhead / n_regions : 0;
+    return UMF_RESULT_SUCCESS;
 }
+
+static const umf_ctl_node_t CTL_NODE(stats)[] = {
+    CTL_LEAF_RO(regions), CTL_LEAF_RO(overhead),
+    CTL_LEAF_RO(overhead_per_region), CTL_NODE_END};
+
+umf_ctl_node_t CTL_NODE(tracker)[] = {CTL_CHILD(stats), CTL_NODE_END};
@@ -20,6 +20,7 @@
 
 #include "base_alloc.h"
 #include "critnib.h"
+#include "ctl/ctl_internal.h"
 #include "utils_concurrency.h"
 
 #ifdef __cplusplus
@@ -31,6 +32,10 @@ typedef struct umf_memory_tracker_t *umf_memory_tracker_handle_t;
 
 extern umf_memory_tracker_handle_t TRACKER;
 
+// umf.tracker.stats.* - the number of tracked regions and the memory
+// taken by the tracker to keep them
+extern umf_ctl_node_t CTL_NODE(tracker)[];
+
 umf_result_t umfMemoryTrackerCreate(umf_memory_tracker_handle_t *handle);
 void umfMemoryTrackerDestroy(umf_memory_tracker_handle_t handle);
 
@@ -54,16 +59,51 @@ typedef struct umf_ipc_info_t {
 umf_result_t umfMemoryTrackerGetIpcInfo(const void *ptr,
                                         umf_ipc_info_t *pIpcInfo);
 
+// Retrieves up to `*count` regions of the given pool (or of all pools if it is
+// NULL) in the range [*cursor, end), in the order of their addresses.
+// On return, `*cursor` is the address the next batch starts at or 0 if there
+// are no more regions in the range. It does not stop concurrent changes
+// of the tracker.
+umf_result_t umfMemoryTrackerGetRegions(umf_memory_tracker_handle_t hTracker,
+                                        umf_memory_pool_handle_t pool,
+                                        uintptr_t *cursor, uintptr_t end,
+                                        umf_pool_region_t *regions,
+                                        size_t *count);
+
 // Creates a memory provider that tracks each allocation/deallocation through umf_memory_tracker_handle_t and
 // forwards all requests to hUpstream memory Provider. hUpstream lifetime should be managed by the user of this function.
+// If `coarse` is set, small allocations are carved out of bigger chunks,
+// which are tracked instead of them (see UMF_POOL_CREATE_FLAG_COARSE_TRACKING).
 umf_result_t umfTrackingMemoryProviderCreate(
     umf_memory_provider_handle_t hUpstream, umf_memory_pool_handle_t hPool,
-    umf_memory_provider_handle_t *hTrackingProvider);
+    bool coarse, umf_memory_provider_handle_t *hTrackingProvider);
 
 void umfTrackingMemoryProviderGetUpstreamProvider(
     umf_memory_provider_handle_t hTrackingProvider,
     umf_memory_provider_handle_t *hUpstream);
 
+// Retrieves the allocation containing `ptr` made by the given provider.
+// If it is a tracking provider with coarse tracking and the allocation was
+// carved out of a chunk (which is tracked instead of it), `*pInChunk` is set
+// and the allocation itself is returned instead of the chunk.
+umf_result_t umfTrackingMemoryProviderGetAllocInfo(
+    umf_memory_provider_handle_t hProvider, const void *ptr,
+    umf_alloc_info_t *pAllocInfo, bool *pInChunk);
+
+// Allocates `num` regions of `size` bytes from the memory provider.
+// If it is a tracking provider, the regions are allocated from its upstream
+// provider and registered in the tracker at once. The batch is all-or-nothing.
+umf_result_t
+umfTrackingMemoryProviderAllocBatch(umf_memory_provider_handle_t hProvider,
+                                    size_t size, size_t alignment, size_t num,
+                                    void **ptrs);
+
+// Frees `num` regions of `size` bytes allocated with
+// umfTrackingMemoryProviderAllocBatch().
+umf_result_t
+umfTrackingMemoryProviderFreeBatch(umf_memory_provider_handle_t hProvider,
+                                   void **ptrs, size_t size, size_t num);
+
 #ifdef __cplusplus
 }
 #endif
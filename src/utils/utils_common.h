@@ -53,9 +53,14 @@ typedef enum umf_purge_advise_t {
 #define ASSERT_IS_ALIGNED(value, align)                                        \
     DO_WHILE_EXPRS(assert(IS_ALIGNED(value, align)))
 
+// size of a cache line, data updated by different threads should not share
+// one (see CACHE_ALIGNED)
+#define CACHE_LINE_SIZE 64
+
 #ifdef _WIN32 /* Windows */
 
 #define __TLS __declspec(thread)
+#define CACHE_ALIGNED __declspec(align(CACHE_LINE_SIZE))
 
 #define LIKELY(x) (x)
 #define UNLIKELY(x) (x)
@@ -63,6 +68,7 @@ typedef enum umf_purge_advise_t {
 #else /* Linux */
 
 #define __TLS __thread
+#define CACHE_ALIGNED __attribute__((aligned(CACHE_LINE_SIZE)))
 
 #define LIKELY(x) __builtin_expect(!!(x), 1)
 #define UNLIKELY(x) __builtin_expect(!!(x), 0)
@@ -124,6 +130,10 @@ int utils_gettid(void);
 // get the number of CPU cores
 unsigned utils_get_num_cores(void);
 
+// get the time in milliseconds from a monotonic clock with an unspecified
+// starting point
+uint64_t utils_get_time_ms(void);
+
 // close file descriptor
 int utils_close_fd(int fd);
 
@@ -182,6 +192,10 @@ int utils_file_open_or_create(const char *path);
 
 int utils_fallocate(int fd, long offset, long len);
 
+// deallocate the file space of the given range (reading it returns zeros),
+// the file size does not change
+int utils_punch_hole(int fd, size_t offset, size_t len);
+
 long utils_get_size_threshold(char *str_threshold);
 
 size_t utils_max(size_t a, size_t b);
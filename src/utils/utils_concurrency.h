@@ -35,6 +35,7 @@ using std::memory_order_acq_rel;
 using std::memory_order_acquire;
 using std::memory_order_relaxed;
 using std::memory_order_release;
+using std::memory_order_seq_cst;
 
 #endif /* __cplusplus */
 
@@ -88,6 +89,51 @@ int utils_write_unlock(utils_rwlock_t *rwlock);
 
 void utils_init_once(UTIL_ONCE_FLAG *flag, void (*onceCb)(void));
 
+// Thread-local storage keys with a destructor called on thread exit
+// for every thread that set a non-NULL value for the key.
+#if defined(_WIN32)
+typedef DWORD utils_tls_key_t;
+#else
+typedef pthread_key_t utils_tls_key_t;
+#endif
+
+int utils_tls_key_create(utils_tls_key_t *key, void (*destructor)(void *));
+void utils_tls_key_delete(utils_tls_key_t key);
+void *utils_tls_get(utils_tls_key_t key);
+int utils_tls_set(utils_tls_key_t key, void *value);
+
+typedef struct utils_cond_t {
+#ifdef _WIN32
+    CONDITION_VARIABLE cond;
+#else
+    pthread_cond_t cond;
+#endif
+} utils_cond_t;
+
+utils_cond_t *utils_cond_init(utils_cond_t *ptr);
+void utils_cond_destroy_not_free(utils_cond_t *cond);
+int utils_cond_signal(utils_cond_t *cond);
+int utils_cond_broadcast(utils_cond_t *cond);
+// Waits until the condition variable is signaled or timeout_ms elapses.
+// Returns 0 in both cases, as spurious wake-ups are possible anyway.
+int utils_cond_timedwait(utils_cond_t *cond, utils_mutex_t *mutex,
+                         uint64_t timeout_ms);
+
+typedef struct utils_thread_t {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t thread;
+#endif
+    void (*routine)(void *);
+    void *arg;
+} utils_thread_t;
+
+// The thread structure has to stay valid until the thread is joined
+int utils_thread_create(utils_thread_t *thread, void (*routine)(void *),
+                        void *arg);
+int utils_thread_join(utils_thread_t *thread);
+
 #if defined(_WIN32)
 
 // There is no good way to do atomic_load on windows...
@@ -112,6 +158,13 @@ static inline void utils_atomic_load_acquire_u8(uint8_t *ptr, uint8_t *out) {
     *out = *(uint8_t *)&ret;
 }
 
+// There is no good way to do atomic_load on windows...
+static inline void utils_atomic_load_acquire_u32(uint32_t *ptr, uint32_t *out) {
+    ASSERT_IS_ALIGNED((uintptr_t)ptr, 4);
+    LONG ret = InterlockedCompareExchange((LONG volatile *)ptr, 0, 0);
+    *out = *(uint32_t *)&ret;
+}
+
 static inline void utils_atomic_load_acquire_ptr(void **ptr, void **out) {
     ASSERT_IS_ALIGNED((uintptr_t)ptr, 8);
     uintptr_t ret = (uintptr_t)InterlockedCompareExchangePointer(ptr, 0, 0);
@@ -138,6 +191,18 @@ static inline uint64_t utils_atomic_increment_u64(uint64_t *ptr) {
     return InterlockedIncrement64((LONG64 volatile *)ptr);
 }
 
+static inline uint32_t utils_atomic_increment_u32(uint32_t *ptr) {
+    ASSERT_IS_ALIGNED((uintptr_t)ptr, 4);
+    // return incremented value
+    return (uint32_t)InterlockedIncrement((LONG volatile *)ptr);
+}
+
+static inline uint32_t utils_atomic_decrement_u32(uint32_t *ptr) {
+    ASSERT_IS_ALIGNED((uintptr_t)ptr, 4);
+    // return decremented value
+    return (uint32_t)InterlockedDecrement((LONG volatile *)ptr);
+}
+
 static inline uint64_t utils_atomic_decrement_u64(uint64_t *ptr) {
     ASSERT_IS_ALIGNED((uintptr_t)ptr, 8);
     // return decremented value
@@ -171,6 +236,19 @@ static inline bool utils_compare_exchange_u64(uint64_t *ptr, uint64_t *expected,
     return false;
 }
 
+static inline uint64_t utils_atomic_fetch_and_u64(uint64_t *ptr,
+                                                  uint64_t val) {
+    ASSERT_IS_ALIGNED((uintptr_t)ptr, 8);
+    // return the value that had previously been in *ptr
+    return InterlockedAnd64((LONG64 volatile *)ptr, (LONG64)val);
+}
+
+static inline uint64_t utils_atomic_fetch_or_u64(uint64_t *ptr, uint64_t val) {
+    ASSERT_IS_ALIGNED((uintptr_t)ptr, 8);
+    // return the value that had previously been in *ptr
+    return InterlockedOr64((LONG64 volatile *)ptr, (LONG64)val);
+}
+
 static inline bool utils_compare_exchange_u8(uint8_t *ptr, uint8_t *expected,
                                              uint8_t *desired) {
     char out = _InterlockedCompareExchange8(
@@ -184,6 +262,9 @@ static inline bool utils_compare_exchange_u8(uint8_t *ptr, uint8_t *expected,
     return false;
 }
 
+// full memory barrier - orders earlier stores before later loads
+static inline void utils_atomic_fence_seq_cst(void) { MemoryBarrier(); }
+
 #else // !defined(_WIN32)
 
 static inline void utils_atomic_load_acquire_u64(uint64_t *ptr, uint64_t *out) {
@@ -198,6 +279,12 @@ static inline void utils_atomic_load_acquire_u8(uint8_t *ptr, uint8_t *out) {
     utils_annotate_acquire(ptr);
 }
 
+static inline void utils_atomic_load_acquire_u32(uint32_t *ptr, uint32_t *out) {
+    ASSERT_IS_ALIGNED((uintptr_t)ptr, 4);
+    __atomic_load(ptr, out, memory_order_acquire);
+    utils_annotate_acquire(ptr);
+}
+
 static inline void utils_atomic_load_acquire_ptr(void **ptr, void **out) {
     ASSERT_IS_ALIGNED((uintptr_t)ptr, 8);
     ASSERT_IS_ALIGNED((uintptr_t)out, 8);
@@ -228,6 +315,18 @@ static inline uint64_t utils_atomic_increment_u64(uint64_t *val) {
     return __atomic_add_fetch(val, 1, memory_order_acq_rel);
 }
 
+static inline uint32_t utils_atomic_increment_u32(uint32_t *val) {
+    ASSERT_IS_ALIGNED((uintptr_t)val, 4);
+    // return incremented value
+    return __atomic_add_fetch(val, 1, memory_order_acq_rel);
+}
+
+static inline uint32_t utils_atomic_decrement_u32(uint32_t *val) {
+    ASSERT_IS_ALIGNED((uintptr_t)val, 4);
+    // return decremented value
+    return __atomic_sub_fetch(val, 1, memory_order_acq_rel);
+}
+
 static inline uint64_t utils_atomic_decrement_u64(uint64_t *val) {
     ASSERT_IS_ALIGNED((uintptr_t)val, 8);
     // return decremented value
@@ -254,6 +353,19 @@ static inline bool utils_compare_exchange_u64(uint64_t *ptr, uint64_t *expected,
                                      memory_order_relaxed);
 }
 
+static inline uint64_t utils_atomic_fetch_and_u64(uint64_t *ptr,
+                                                  uint64_t val) {
+    ASSERT_IS_ALIGNED((uintptr_t)ptr, 8);
+    // return the value that had previously been in *ptr
+    return __atomic_fetch_and(ptr, val, memory_order_acq_rel);
+}
+
+static inline uint64_t utils_atomic_fetch_or_u64(uint64_t *ptr, uint64_t val) {
+    ASSERT_IS_ALIGNED((uintptr_t)ptr, 8);
+    // return the value that had previously been in *ptr
+    return __atomic_fetch_or(ptr, val, memory_order_acq_rel);
+}
+
 static inline bool utils_compare_exchange_u8(uint8_t *ptr, uint8_t *expected,
                                              uint8_t *desired) {
     return __atomic_compare_exchange(ptr, expected, desired, 0 /* strong */,
@@ -261,6 +373,11 @@ static inline bool utils_compare_exchange_u8(uint8_t *ptr, uint8_t *expected,
                                      memory_order_relaxed);
 }
 
+// full memory barrier - orders earlier stores before later loads
+static inline void utils_atomic_fence_seq_cst(void) {
+    __atomic_thread_fence(memory_order_seq_cst);
+}
+
 #endif // !defined(_WIN32)
 
 static inline void utils_atomic_load_acquire_size_t(size_t *ptr, size_t *out) {
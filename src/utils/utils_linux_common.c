@@ -9,6 +9,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/falloc.h>
 #include <stdbool.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -138,6 +139,13 @@ int utils_fallocate(int fd, long offset, long len) {
     return posix_fallocate(fd, offset, len);
 }
 
+int utils_punch_hole(int fd, size_t offset, size_t len) {
+    // fallocate() is declared only with _GNU_SOURCE
+    return (int)syscall(__NR_fallocate, fd,
+                        FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                        (off_t)offset, (off_t)len);
+}
+
 // create a shared memory file
 int utils_shm_create(const char *shm_name, size_t size) {
     if (shm_name == NULL) {
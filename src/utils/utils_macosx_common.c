@@ -60,6 +60,14 @@ int utils_fallocate(int fd, long offset, long len) {
     return -1;
 }
 
+int utils_punch_hole(int fd, size_t offset, size_t len) {
+    (void)fd;     // unused
+    (void)offset; // unused
+    (void)len;    // unused
+
+    return -1;
+}
+
 // create a shared memory file
 int utils_shm_create(const char *shm_name, size_t size) {
     (void)shm_name; // unused
@@ -7,8 +7,10 @@
  *
  */
 
+#include <errno.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "utils_concurrency.h"
 #include "utils_log.h"
@@ -46,6 +48,23 @@ void utils_init_once(UTIL_ONCE_FLAG *flag, void (*oneCb)(void)) {
     pthread_once(flag, oneCb);
 }
 
+int utils_tls_key_create(utils_tls_key_t *key, void (*destructor)(void *)) {
+    return pthread_key_create(key, destructor);
+}
+
+void utils_tls_key_delete(utils_tls_key_t key) {
+    int ret = pthread_key_delete(key);
+    if (ret) {
+        LOG_ERR("pthread_key_delete failed");
+    }
+}
+
+void *utils_tls_get(utils_tls_key_t key) { return pthread_getspecific(key); }
+
+int utils_tls_set(utils_tls_key_t key, void *value) {
+    return pthread_setspecific(key, value);
+}
+
 utils_rwlock_t *utils_rwlock_init(utils_rwlock_t *ptr) {
     pthread_rwlock_t *rwlock = (pthread_rwlock_t *)ptr;
     int ret = pthread_rwlock_init(rwlock, NULL);
@@ -75,3 +94,56 @@ int utils_read_unlock(utils_rwlock_t *rwlock) {
 int utils_write_unlock(utils_rwlock_t *rwlock) {
     return pthread_rwlock_unlock((pthread_rwlock_t *)rwlock);
 }
+
+utils_cond_t *utils_cond_init(utils_cond_t *ptr) {
+    int ret = pthread_cond_init(&ptr->cond, NULL);
+    return ret == 0 ? ptr : NULL;
+}
+
+void utils_cond_destroy_not_free(utils_cond_t *cond) {
+    int ret = pthread_cond_destroy(&cond->cond);
+    if (ret) {
+        LOG_ERR("pthread_cond_destroy failed");
+    }
+}
+
+int utils_cond_signal(utils_cond_t *cond) {
+    return pthread_cond_signal(&cond->cond);
+}
+
+int utils_cond_broadcast(utils_cond_t *cond) {
+    return pthread_cond_broadcast(&cond->cond);
+}
+
+int utils_cond_timedwait(utils_cond_t *cond, utils_mutex_t *mutex,
+                         uint64_t timeout_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += (time_t)(timeout_ms / 1000);
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    int ret = pthread_cond_timedwait(&cond->cond, (pthread_mutex_t *)mutex,
+                                     &deadline);
+    return ret == ETIMEDOUT ? 0 : ret;
+}
+
+static void *utils_thread_routine(void *arg) {
+    utils_thread_t *thread = (utils_thread_t *)arg;
+    thread->routine(thread->arg);
+    return NULL;
+}
+
+int utils_thread_create(utils_thread_t *thread, void (*routine)(void *),
+                        void *arg) {
+    thread->routine = routine;
+    thread->arg = arg;
+    return pthread_create(&thread->thread, NULL, utils_thread_routine, thread);
+}
+
+int utils_thread_join(utils_thread_t *thread) {
+    return pthread_join(thread->thread, NULL);
+}
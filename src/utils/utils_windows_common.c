@@ -47,6 +47,8 @@ int utils_getpid(void) { return GetCurrentProcessId(); }
 
 int utils_gettid(void) { return GetCurrentThreadId(); }
 
+uint64_t utils_get_time_ms(void) { return GetTickCount64(); }
+
 int utils_close_fd(int fd) {
     (void)fd; // unused
     return -1;
@@ -233,6 +235,14 @@ int utils_fallocate(int fd, long offset, long len) {
     return -1;
 }
 
+int utils_punch_hole(int fd, size_t offset, size_t len) {
+    (void)fd;     // unused
+    (void)offset; // unused
+    (void)len;    // unused
+
+    return -1;
+}
+
 // Expected input:
 // char *str_threshold = utils_env_var_get_str("UMF_PROXY", "size.threshold=");
 long utils_get_size_threshold(char *str_threshold) {
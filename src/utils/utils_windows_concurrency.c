@@ -79,3 +79,78 @@ static BOOL CALLBACK initOnceCb(PINIT_ONCE InitOnce, PVOID Parameter,
 void utils_init_once(UTIL_ONCE_FLAG *flag, void (*onceCb)(void)) {
     InitOnceExecuteOnce(flag, initOnceCb, (void *)onceCb, NULL);
 }
+
+// Fiber local storage is used instead of TLS, because only FLS supports
+// destructors called on thread exit.
+int utils_tls_key_create(utils_tls_key_t *key, void (*destructor)(void *)) {
+    DWORD idx = FlsAlloc((PFLS_CALLBACK_FUNCTION)destructor);
+    if (idx == FLS_OUT_OF_INDEXES) {
+        return -1;
+    }
+
+    *key = idx;
+    return 0;
+}
+
+void utils_tls_key_delete(utils_tls_key_t key) { FlsFree(key); }
+
+void *utils_tls_get(utils_tls_key_t key) { return FlsGetValue(key); }
+
+int utils_tls_set(utils_tls_key_t key, void *value) {
+    return FlsSetValue(key, value) ? 0 : -1;
+}
+
+utils_cond_t *utils_cond_init(utils_cond_t *ptr) {
+    InitializeConditionVariable(&ptr->cond);
+    return ptr;
+}
+
+void utils_cond_destroy_not_free(utils_cond_t *cond) {
+    // there is no need to destroy a CONDITION_VARIABLE
+    (void)cond;
+}
+
+int utils_cond_signal(utils_cond_t *cond) {
+    WakeConditionVariable(&cond->cond);
+    return 0;
+}
+
+int utils_cond_broadcast(utils_cond_t *cond) {
+    WakeAllConditionVariable(&cond->cond);
+    return 0;
+}
+
+int utils_cond_timedwait(utils_cond_t *cond, utils_mutex_t *mutex,
+                         uint64_t timeout_ms) {
+    DWORD timeout = timeout_ms >= INFINITE ? INFINITE - 1 : (DWORD)timeout_ms;
+    if (!SleepConditionVariableCS(&cond->cond, &mutex->lock, timeout) &&
+        GetLastError() != ERROR_TIMEOUT) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static DWORD WINAPI utils_thread_routine(LPVOID arg) {
+    utils_thread_t *thread = (utils_thread_t *)arg;
+    thread->routine(thread->arg);
+    return 0;
+}
+
+int utils_thread_create(utils_thread_t *thread, void (*routine)(void *),
+                        void *arg) {
+    thread->routine = routine;
+    thread->arg = arg;
+    thread->handle =
+        CreateThread(NULL, 0, utils_thread_routine, thread, 0, NULL);
+    return thread->handle ? 0 : -1;
+}
+
+int utils_thread_join(utils_thread_t *thread) {
+    if (WaitForSingleObject(thread->handle, INFINITE) != WAIT_OBJECT_0) {
+        return -1;
+    }
+
+    CloseHandle(thread->handle);
+    return 0;
+}
@@ -5,6 +5,9 @@
  * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 */
 
+#include <thread>
+#include <vector>
+
 #include "coarse.h"
 #include "provider.hpp"
 
@@ -114,12 +117,18 @@ INSTANTIATE_TEST_SUITE_P(
     CoarseWithMemoryStrategyTest, CoarseWithMemoryStrategyTest,
     ::testing::Values(UMF_COARSE_MEMORY_STRATEGY_FASTEST,
                       UMF_COARSE_MEMORY_STRATEGY_FASTEST_BUT_ONE,
-                      UMF_COARSE_MEMORY_STRATEGY_CHECK_ALL_SIZE),
+                      UMF_COARSE_MEMORY_STRATEGY_CHECK_ALL_SIZE,
+                      UMF_COARSE_MEMORY_STRATEGY_SEGREGATED_FIT,
+                      UMF_COARSE_MEMORY_STRATEGY_BEST_FIT,
+                      UMF_COARSE_MEMORY_STRATEGY_LOWEST_ADDRESS),
     ([](auto const &info) -> std::string {
         static const char *names[] = {
             "UMF_COARSE_MEMORY_STRATEGY_FASTEST",
             "UMF_COARSE_MEMORY_STRATEGY_FASTEST_BUT_ONE",
-            "UMF_COARSE_MEMORY_STRATEGY_CHECK_ALL_SIZE"};
+            "UMF_COARSE_MEMORY_STRATEGY_CHECK_ALL_SIZE",
+            "UMF_COARSE_MEMORY_STRATEGY_SEGREGATED_FIT",
+            "UMF_COARSE_MEMORY_STRATEGY_BEST_FIT",
+            "UMF_COARSE_MEMORY_STRATEGY_LOWEST_ADDRESS"};
         return names[info.index];
     }));
 
@@ -1381,3 +1390,633 @@ TEST_P(CoarseWithMemoryStrategyTest,
 
     coarse_delete(ch);
 }
+
+TEST_P(CoarseWithMemoryStrategyTest, coarseTest_fixed_memory_exact_fit) {
+    if (coarse_params.allocation_strategy ==
+        UMF_COARSE_MEMORY_STRATEGY_FASTEST) {
+        // The UMF_COARSE_MEMORY_STRATEGY_FASTEST strategy
+        // looks always for a block of size greater by the page size.
+        return;
+    }
+
+    // 33 pages do not start a size class of the segregated-fit index,
+    // so a block of this size is found only by looking through its list
+    const size_t page_size = coarse_params.page_size;
+    const size_t npages = 33;
+    const size_t buff_size = (npages + 1) * page_size;
+    std::vector<char> buffer(buff_size, 0);
+    void *buf = (void *)ALIGN_UP_SAFE((uintptr_t)buffer.data(), page_size);
+    ASSERT_NE(buf, nullptr);
+
+    coarse_params.cb.alloc = NULL;
+    coarse_params.cb.free = NULL;
+
+    umf_result = coarse_new(&coarse_params, &coarse_handle);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(coarse_handle, nullptr);
+
+    coarse_t *ch = coarse_handle;
+    void *ptr = nullptr;
+
+    umf_result = coarse_add_memory_fixed(ch, buf, npages * page_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_result = coarse_alloc(ch, npages * page_size, 0, &ptr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(ptr, buf);
+
+    ASSERT_EQ(coarse_get_stats(ch).used_size, npages * page_size);
+    ASSERT_EQ(coarse_get_stats(ch).num_all_blocks, (size_t)1);
+    ASSERT_EQ(coarse_get_stats(ch).num_free_blocks, (size_t)0);
+
+    umf_result = coarse_free(ch, ptr, npages * page_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    // split the memory into blocks of 1, 2, ..., 7 pages and the rest
+    // (5 pages) and free every second block
+    void *ptrs[8] = {0};
+    size_t sizes[8] = {0};
+    for (int i = 0; i < 8; i++) {
+        sizes[i] = (i < 7) ? (i + 1) * page_size : 5 * page_size;
+        umf_result = coarse_alloc(ch, sizes[i], 0, &ptrs[i]);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_NE(ptrs[i], nullptr);
+    }
+
+    for (int i = 0; i < 8; i += 2) {
+        umf_result = coarse_free(ch, ptrs[i], sizes[i]);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    ASSERT_EQ(coarse_get_stats(ch).num_free_blocks, (size_t)4);
+
+    // every freed block is reused without splitting
+    for (int i = 0; i < 8; i += 2) {
+        umf_result = coarse_alloc(ch, sizes[i], 0, &ptrs[i]);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_NE(ptrs[i], nullptr);
+    }
+
+    ASSERT_EQ(coarse_get_stats(ch).num_free_blocks, (size_t)0);
+    ASSERT_EQ(coarse_get_stats(ch).num_all_blocks, (size_t)8);
+
+    for (int i = 0; i < 8; i++) {
+        umf_result = coarse_free(ch, ptrs[i], sizes[i]);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    ASSERT_EQ(coarse_get_stats(ch).used_size, (size_t)0);
+    ASSERT_EQ(coarse_get_stats(ch).num_all_blocks, (size_t)1);
+
+    coarse_delete(ch);
+}
+
+TEST_P(CoarseWithMemoryStrategyTest, coarseTest_arenas_fixed_memory_mt) {
+    const size_t page_size = coarse_params.page_size;
+    const size_t buff_size = 32 * MB + page_size;
+    std::vector<char> buffer(buff_size, 0);
+    void *buf = (void *)ALIGN_UP_SAFE((uintptr_t)buffer.data(), page_size);
+    ASSERT_NE(buf, nullptr);
+    const size_t mem_size = 32 * MB;
+
+    coarse_params.cb.alloc = NULL;
+    coarse_params.cb.free = NULL;
+    coarse_params.num_arenas = 4;
+
+    umf_result = coarse_new(&coarse_params, &coarse_handle);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(coarse_handle, nullptr);
+
+    coarse_t *ch = coarse_handle;
+
+    umf_result = coarse_add_memory_fixed(ch, buf, mem_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    const int nthreads = 8;
+    const int niter = 100;
+    const int nallocs = 8;
+    std::vector<umf_result_t> results(nthreads, UMF_RESULT_SUCCESS);
+    std::vector<std::thread> threads;
+
+    // every thread uses at most 8 * 16 pages at once,
+    // so that all threads always fit in the memory
+    for (int t = 0; t < nthreads; t++) {
+        threads.emplace_back([&, t] {
+            void *ptrs[nallocs];
+            size_t sizes[nallocs];
+            for (int i = 0; i < niter; i++) {
+                for (int j = 0; j < nallocs; j++) {
+                    sizes[j] = (1 + (t + i + j) % 16) * page_size;
+                    umf_result_t ret = coarse_alloc(ch, sizes[j], 0, &ptrs[j]);
+                    if (ret != UMF_RESULT_SUCCESS) {
+                        results[t] = ret;
+                        return;
+                    }
+                    memset(ptrs[j], t, sizes[j]);
+                }
+
+                for (int j = 0; j < nallocs; j++) {
+                    for (size_t k = 0; k < sizes[j]; k += page_size) {
+                        if (((char *)ptrs[j])[k] != (char)t) {
+                            results[t] = UMF_RESULT_ERROR_UNKNOWN;
+                        }
+                    }
+
+                    umf_result_t ret = coarse_free(ch, ptrs[j], sizes[j]);
+                    if (ret != UMF_RESULT_SUCCESS) {
+                        results[t] = ret;
+                        return;
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (int t = 0; t < nthreads; t++) {
+        ASSERT_EQ(results[t], UMF_RESULT_SUCCESS);
+    }
+
+    // no memory is lost when it is moved between arenas
+    ASSERT_EQ(coarse_get_stats(ch).used_size, (size_t)0);
+    ASSERT_EQ(coarse_get_stats(ch).alloc_size, mem_size);
+
+    coarse_delete(ch);
+}
+
+TEST_P(CoarseWithMemoryStrategyTest, coarseTest_arenas_cross_thread_free) {
+    const size_t page_size = coarse_params.page_size;
+    const size_t buff_size = 4 * MB + page_size;
+    std::vector<char> buffer(buff_size, 0);
+    void *buf = (void *)ALIGN_UP_SAFE((uintptr_t)buffer.data(), page_size);
+    ASSERT_NE(buf, nullptr);
+    const size_t mem_size = 4 * MB;
+
+    coarse_params.cb.alloc = NULL;
+    coarse_params.cb.free = NULL;
+    coarse_params.num_arenas = 2;
+
+    umf_result = coarse_new(&coarse_params, &coarse_handle);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(coarse_handle, nullptr);
+
+    coarse_t *ch = coarse_handle;
+
+    // the memory goes to the arena of this thread
+    umf_result = coarse_add_memory_fixed(ch, buf, mem_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    // other threads have to steal it
+    void *ptrs[2] = {nullptr, nullptr};
+    umf_result_t results[2] = {UMF_RESULT_ERROR_UNKNOWN,
+                               UMF_RESULT_ERROR_UNKNOWN};
+    for (int t = 0; t < 2; t++) {
+        std::thread thread([&, t] {
+            results[t] = coarse_alloc(ch, 1 * MB, 0, &ptrs[t]);
+        });
+        thread.join();
+    }
+
+    for (int t = 0; t < 2; t++) {
+        ASSERT_EQ(results[t], UMF_RESULT_SUCCESS);
+        ASSERT_NE(ptrs[t], nullptr);
+    }
+
+    ASSERT_EQ(coarse_get_stats(ch).used_size, 2 * MB);
+    ASSERT_EQ(coarse_get_stats(ch).alloc_size, mem_size);
+
+    // the memory is freed by another thread than it was allocated by
+    for (int t = 0; t < 2; t++) {
+        umf_result = coarse_free(ch, ptrs[t], 1 * MB);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    umf_result = coarse_free(ch, INVALID_PTR, 1 * MB);
+    ASSERT_EQ(umf_result, UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    ASSERT_EQ(coarse_get_stats(ch).used_size, (size_t)0);
+    ASSERT_EQ(coarse_get_stats(ch).alloc_size, mem_size);
+
+    coarse_delete(ch);
+}
+
+TEST_P(CoarseWithMemoryStrategyTest, coarseTest_arenas_steal_all) {
+    if (coarse_params.allocation_strategy ==
+        UMF_COARSE_MEMORY_STRATEGY_FASTEST) {
+        // The UMF_COARSE_MEMORY_STRATEGY_FASTEST strategy
+        // looks always for a block of size greater by the page size.
+        return;
+    }
+
+    const size_t page_size = coarse_params.page_size;
+    const size_t buff_size = 4 * MB + page_size;
+    std::vector<char> buffer(buff_size, 0);
+    void *buf = (void *)ALIGN_UP_SAFE((uintptr_t)buffer.data(), page_size);
+    ASSERT_NE(buf, nullptr);
+    const size_t mem_size = 4 * MB;
+
+    coarse_params.cb.alloc = NULL;
+    coarse_params.cb.free = NULL;
+    coarse_params.num_arenas = 2;
+
+    umf_result = coarse_new(&coarse_params, &coarse_handle);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(coarse_handle, nullptr);
+
+    coarse_t *ch = coarse_handle;
+
+    umf_result = coarse_add_memory_fixed(ch, buf, mem_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    // all the memory can be allocated by other threads
+    for (int t = 0; t < 2; t++) {
+        void *ptr = nullptr;
+        umf_result_t ret = UMF_RESULT_ERROR_UNKNOWN;
+        std::thread thread([&] { ret = coarse_alloc(ch, mem_size, 0, &ptr); });
+        thread.join();
+
+        ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+        ASSERT_EQ(ptr, buf);
+
+        umf_result = coarse_free(ch, ptr, mem_size);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    ASSERT_EQ(coarse_get_stats(ch).used_size, (size_t)0);
+    ASSERT_EQ(coarse_get_stats(ch).alloc_size, mem_size);
+    ASSERT_EQ(coarse_get_stats(ch).num_all_blocks, (size_t)1);
+
+    coarse_delete(ch);
+}
+
+TEST_P(CoarseWithMemoryStrategyTest, coarseTest_arenas_give_back) {
+    const size_t page_size = coarse_params.page_size;
+    const size_t buff_size = 64 * MB + page_size;
+    std::vector<char> buffer(buff_size, 0);
+    void *buf = (void *)ALIGN_UP_SAFE((uintptr_t)buffer.data(), page_size);
+    ASSERT_NE(buf, nullptr);
+    const size_t mem_size = 64 * MB;
+
+    coarse_params.cb.alloc = NULL;
+    coarse_params.cb.free = NULL;
+    coarse_params.num_arenas = 4;
+
+    umf_result = coarse_new(&coarse_params, &coarse_handle);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(coarse_handle, nullptr);
+
+    coarse_t *ch = coarse_handle;
+
+    umf_result = coarse_add_memory_fixed(ch, buf, mem_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    void *ptr = nullptr;
+    umf_result = coarse_alloc(ch, 63 * MB, 0, &ptr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    umf_result = coarse_free(ch, ptr, 63 * MB);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    // every thread steals a part of the memory and gives it back
+    for (int t = 0; t < 4; t++) {
+        umf_result_t ret = UMF_RESULT_ERROR_UNKNOWN;
+        std::thread thread([&] {
+            void *p = nullptr;
+            ret = coarse_alloc(ch, 4 * KB, 0, &p);
+            if (ret == UMF_RESULT_SUCCESS) {
+                ret = coarse_free(ch, p, 4 * KB);
+            }
+        });
+        thread.join();
+        ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    }
+
+    ASSERT_EQ(coarse_get_stats(ch).num_all_blocks, (size_t)1);
+
+    umf_result = coarse_alloc(ch, 63 * MB, 0, &ptr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    umf_result = coarse_free(ch, ptr, 63 * MB);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    ASSERT_EQ(coarse_get_stats(ch).used_size, (size_t)0);
+    ASSERT_EQ(coarse_get_stats(ch).alloc_size, mem_size);
+
+    coarse_delete(ch);
+}
+
+TEST_P(CoarseWithMemoryStrategyTest, coarseTest_arenas_merge) {
+    const size_t page_size = coarse_params.page_size;
+    const size_t buff_size = 64 * MB + page_size;
+    std::vector<char> buffer(buff_size, 0);
+    void *buf = (void *)ALIGN_UP_SAFE((uintptr_t)buffer.data(), page_size);
+    ASSERT_NE(buf, nullptr);
+    const size_t mem_size = 64 * MB;
+
+    coarse_params.cb.alloc = NULL;
+    coarse_params.cb.free = NULL;
+    coarse_params.num_arenas = 2;
+
+    umf_result = coarse_new(&coarse_params, &coarse_handle);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(coarse_handle, nullptr);
+
+    coarse_t *ch = coarse_handle;
+
+    // three new threads started one after another get arenas: A, B, A
+    umf_result_t ret = UMF_RESULT_ERROR_UNKNOWN;
+    std::thread thread_a(
+        [&] { ret = coarse_add_memory_fixed(ch, buf, mem_size); });
+    thread_a.join();
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+
+    // the arena B steals a half of the memory and keeps using a part of it
+    void *ptr_b = nullptr;
+    std::thread thread_b(
+        [&] { ret = coarse_alloc(ch, page_size, 0, &ptr_b); });
+    thread_b.join();
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+
+    // neither arena has a free block of 40 MB,
+    // but there is one after merging the free memory of both arenas
+    void *ptr_a = nullptr;
+    std::thread thread_a2(
+        [&] { ret = coarse_alloc(ch, 40 * MB, 0, &ptr_a); });
+    thread_a2.join();
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+
+    umf_result = coarse_free(ch, ptr_a, 40 * MB);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    umf_result = coarse_free(ch, ptr_b, page_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    ASSERT_EQ(coarse_get_stats(ch).used_size, (size_t)0);
+    ASSERT_EQ(coarse_get_stats(ch).alloc_size, mem_size);
+
+    coarse_delete(ch);
+}
+
+TEST_P(CoarseWithMemoryStrategyTest, coarseTest_arenas_provider_mt) {
+    umf_memory_provider_handle_t malloc_memory_provider;
+    umf_result = umfMemoryProviderCreate(&UMF_MALLOC_MEMORY_PROVIDER_OPS, NULL,
+                                         &malloc_memory_provider);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(malloc_memory_provider, nullptr);
+
+    coarse_params.provider = malloc_memory_provider;
+    coarse_params.num_arenas = 4;
+
+    umf_result = coarse_new(&coarse_params, &coarse_handle);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(coarse_handle, nullptr);
+
+    coarse_t *ch = coarse_handle;
+
+    const int nthreads = 8;
+    const int niter = 50;
+    std::vector<umf_result_t> results(nthreads, UMF_RESULT_SUCCESS);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < nthreads; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < niter; i++) {
+                void *ptr = nullptr;
+                size_t size = (1 + (t + i) % 8) * 64 * KB;
+                umf_result_t ret = coarse_alloc(ch, size, 0, &ptr);
+                if (ret == UMF_RESULT_SUCCESS) {
+                    ret = coarse_free(ch, ptr, size);
+                }
+
+                if (ret != UMF_RESULT_SUCCESS) {
+                    results[t] = ret;
+                    return;
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (int t = 0; t < nthreads; t++) {
+        ASSERT_EQ(results[t], UMF_RESULT_SUCCESS);
+    }
+
+    ASSERT_EQ(coarse_get_stats(ch).used_size, (size_t)0);
+
+    coarse_delete(ch);
+    umfMemoryProviderDestroy(malloc_memory_provider);
+}
+
+TEST_P(CoarseWithMemoryStrategyTest, coarseTest_too_many_arenas) {
+    coarse_params.num_arenas = 1000000;
+
+    umf_result = coarse_new(&coarse_params, &coarse_handle);
+    ASSERT_EQ(umf_result, UMF_RESULT_ERROR_INVALID_ARGUMENT);
+}
+
+TEST_P(CoarseWithMemoryStrategyTest, coarseTest_address_ordered_strategies) {
+    if (coarse_params.allocation_strategy !=
+            UMF_COARSE_MEMORY_STRATEGY_BEST_FIT &&
+        coarse_params.allocation_strategy !=
+            UMF_COARSE_MEMORY_STRATEGY_LOWEST_ADDRESS) {
+        return;
+    }
+
+    const size_t page_size = coarse_params.page_size;
+    const size_t npages = 32;
+    const size_t buff_size = (npages + 1) * page_size;
+    std::vector<char> buffer(buff_size, 0);
+    char *buf = (char *)ALIGN_UP_SAFE((uintptr_t)buffer.data(), page_size);
+    ASSERT_NE(buf, nullptr);
+
+    coarse_params.cb.alloc = NULL;
+    coarse_params.cb.free = NULL;
+
+    umf_result = coarse_new(&coarse_params, &coarse_handle);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(coarse_handle, nullptr);
+
+    coarse_t *ch = coarse_handle;
+
+    umf_result = coarse_add_memory_fixed(ch, buf, npages * page_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    ASSERT_EQ(coarse_get_stats(ch).max_free_block_size, npages * page_size);
+    ASSERT_EQ(coarse_get_stats(ch).max_free_block_ratio, 1.0);
+
+    // make holes of 3, 1 and 2 pages separated by used blocks:
+    // | 3 | u | 1 | u | 2 | u | rest (23 pages) |
+    const size_t sizes[6] = {3, 1, 1, 1, 2, 1};
+    void *ptrs[6];
+    for (int i = 0; i < 6; i++) {
+        umf_result = coarse_alloc(ch, sizes[i] * page_size, 0, &ptrs[i]);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    for (int i = 0; i < 6; i += 2) {
+        umf_result = coarse_free(ch, ptrs[i], sizes[i] * page_size);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    coarse_stats_t stats = coarse_get_stats(ch);
+    ASSERT_EQ(stats.num_free_blocks, (size_t)4);
+    ASSERT_EQ(stats.max_free_block_size, 23 * page_size);
+    ASSERT_EQ(stats.max_free_block_ratio, 23.0 / 29.0);
+
+    // the best fit is the 2-page hole,
+    // the lowest address is the one of the 3-page hole
+    void *ptr = nullptr;
+    umf_result = coarse_alloc(ch, 2 * page_size, 0, &ptr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    if (coarse_params.allocation_strategy ==
+        UMF_COARSE_MEMORY_STRATEGY_BEST_FIT) {
+        ASSERT_EQ(ptr, ptrs[4]);
+    } else {
+        ASSERT_EQ(ptr, buf);
+    }
+
+    umf_result = coarse_free(ch, ptr, 2 * page_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    // join the 1-page and the 2-page holes into a 4-page one,
+    // which is both the best fit and the lowest address for 4 pages
+    umf_result = coarse_free(ch, ptrs[3], page_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_result = coarse_alloc(ch, 4 * page_size, 0, &ptr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(ptr, buf + 4 * page_size);
+
+    umf_result = coarse_free(ch, ptr, 4 * page_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    for (int i = 1; i < 6; i += 4) {
+        umf_result = coarse_free(ch, ptrs[i], sizes[i] * page_size);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    stats = coarse_get_stats(ch);
+    ASSERT_EQ(stats.used_size, (size_t)0);
+    ASSERT_EQ(stats.num_all_blocks, (size_t)1);
+    ASSERT_EQ(stats.max_free_block_ratio, 1.0);
+
+    coarse_delete(ch);
+}
+
+TEST_P(CoarseWithMemoryStrategyTest, coarseTest_defrag_report) {
+    const size_t page_size = coarse_params.page_size;
+    const size_t npages = 32;
+    const size_t buff_size = (npages + 1) * page_size;
+    std::vector<char> buffer(buff_size, 0);
+    char *buf = (char *)ALIGN_UP_SAFE((uintptr_t)buffer.data(), page_size);
+    ASSERT_NE(buf, nullptr);
+
+    coarse_params.cb.alloc = NULL;
+    coarse_params.cb.free = NULL;
+
+    umf_result = coarse_new(&coarse_params, &coarse_handle);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(coarse_handle, nullptr);
+
+    coarse_t *ch = coarse_handle;
+
+    umf_result = coarse_add_memory_fixed(ch, buf, npages * page_size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    // bin of the page size in the histogram
+    size_t page_bin = 0;
+    while (((size_t)2 << page_bin) <= page_size) {
+        page_bin++;
+    }
+
+    const size_t num_bins = 64;
+    size_t histogram[num_bins];
+    umf_compaction_hint_t hints[4];
+    size_t num_hints = 0;
+
+    umf_result = coarse_get_free_histogram(ch, histogram, 0);
+    ASSERT_EQ(umf_result, UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    umf_result = coarse_get_compaction_hints(ch, hints, 4, nullptr);
+    ASSERT_EQ(umf_result, UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    // no used blocks - no hints
+    umf_result = coarse_get_compaction_hints(ch, hints, 4, &num_hints);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(num_hints, (size_t)0);
+
+    // make holes of 3, 1 and 2 pages separated by used blocks:
+    // | 3 | u | 1 | u | 2 | u | rest (23 pages) |
+    const size_t sizes[6] = {3, 1, 1, 1, 2, 1};
+    void *ptrs[6];
+    for (int i = 0; i < 6; i++) {
+        umf_result = coarse_alloc(ch, sizes[i] * page_size, 0, &ptrs[i]);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_EQ(ptrs[i], (i == 0) ? (void *)buf
+                                    : (void *)((char *)ptrs[i - 1] +
+                                               sizes[i - 1] * page_size));
+    }
+
+    for (int i = 0; i < 6; i += 2) {
+        umf_result = coarse_free(ch, ptrs[i], sizes[i] * page_size);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    umf_result = coarse_get_free_histogram(ch, histogram, num_bins);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    for (size_t i = 0; i < num_bins; i++) {
+        size_t expected = 0;
+        if (i == page_bin || i == page_bin + 4) {
+            expected = 1; // 1 page or 23 pages
+        } else if (i == page_bin + 1) {
+            expected = 2; // 2 and 3 pages
+        }
+        ASSERT_EQ(histogram[i], expected);
+    }
+
+    // the last bin counts also all bigger blocks
+    umf_result = coarse_get_free_histogram(ch, histogram, page_bin + 2);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(histogram[page_bin], (size_t)1);
+    ASSERT_EQ(histogram[page_bin + 1], (size_t)3);
+
+    // relocating the last used block would make a free block of 26 pages,
+    // the first one - of 5 pages and the middle one - of 4 pages
+    umf_result = coarse_get_compaction_hints(ch, hints, 4, &num_hints);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(num_hints, (size_t)3);
+    ASSERT_EQ(hints[0].ptr, ptrs[5]);
+    ASSERT_EQ(hints[0].size, page_size);
+    ASSERT_EQ(hints[0].coalesced_size, 26 * page_size);
+    ASSERT_EQ(hints[1].ptr, ptrs[1]);
+    ASSERT_EQ(hints[1].coalesced_size, 5 * page_size);
+    ASSERT_EQ(hints[2].ptr, ptrs[3]);
+    ASSERT_EQ(hints[2].coalesced_size, 4 * page_size);
+
+    // only the best hints are kept
+    umf_result = coarse_get_compaction_hints(ch, hints, 2, &num_hints);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(num_hints, (size_t)2);
+    ASSERT_EQ(hints[0].ptr, ptrs[5]);
+    ASSERT_EQ(hints[1].ptr, ptrs[1]);
+
+    for (int i = 1; i < 6; i += 2) {
+        umf_result = coarse_free(ch, ptrs[i], sizes[i] * page_size);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    umf_result = coarse_get_compaction_hints(ch, hints, 4, &num_hints);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(num_hints, (size_t)0);
+
+    umf_result = coarse_get_free_histogram(ch, histogram, num_bins);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    for (size_t i = 0; i < num_bins; i++) {
+        ASSERT_EQ(histogram[i], (size_t)(i == page_bin + 5)); // 32 pages
+    }
+
+    coarse_delete(ch);
+}
@@ -620,3 +620,73 @@ TEST_F(test, ctl_by_name_collision) {
     ret = umfMemoryProviderDestroy(hProvider);
     ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
 }
+
+TEST_F(test, ctl_tracker_stats) {
+    umf_memory_provider_handle_t hProvider = NULL;
+    umf_os_memory_provider_params_handle_t os_memory_provider_params = NULL;
+    const umf_memory_provider_ops_t *os_provider_ops = umfOsMemoryProviderOps();
+    if (os_provider_ops == NULL) {
+        GTEST_SKIP() << "OS memory provider is not supported!";
+    }
+
+    int ret = umfOsMemoryProviderParamsCreate(&os_memory_provider_params);
+    ret = umfMemoryProviderCreate(os_provider_ops, os_memory_provider_params,
+                                  &hProvider);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    umfOsMemoryProviderParamsDestroy(os_memory_provider_params);
+
+    umf_disjoint_pool_params_handle_t disjoint_pool_params = NULL;
+    ret = umfDisjointPoolParamsCreate(&disjoint_pool_params);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+
+    umf_memory_pool_handle_t hPool = NULL;
+    ret = umfPoolCreate(umfDisjointPoolOps(), hProvider, disjoint_pool_params,
+                        0, &hPool);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    umfDisjointPoolParamsDestroy(disjoint_pool_params);
+
+    size_t regions_before = 0;
+    ret = umfCtlGet("umf.tracker.stats.regions", &regions_before,
+                    sizeof(regions_before));
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+
+    // allocations above the max poolable size go directly to the provider,
+    // so every one of them is a region of the tracker
+    const size_t n_allocs = 64;
+    std::vector<void *> ptrs;
+    for (size_t i = 0; i < n_allocs; i++) {
+        void *ptr = umfPoolMalloc(hPool, 4 * 1024 * 1024);
+        ASSERT_NE(ptr, nullptr);
+        ptrs.push_back(ptr);
+    }
+
+    size_t regions = 0, overhead = 0, overhead_per_region = 0;
+    ret = umfCtlGet("umf.tracker.stats.regions", &regions, sizeof(regions));
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    ASSERT_GE(regions, regions_before + n_allocs);
+
+    ret = umfCtlGet("umf.tracker.stats.overhead", &overhead, sizeof(overhead));
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    ASSERT_GT(overhead, 0ull);
+
+    ret = umfCtlGet("umf.tracker.stats.overhead_per_region",
+                    &overhead_per_region, sizeof(overhead_per_region));
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    ASSERT_GT(overhead_per_region, 0ull);
+    ASSERT_LT(overhead_per_region, 512ull);
+
+    // the result is a size_t
+    int too_small = 0;
+    ret = umfCtlGet("umf.tracker.stats.regions", &too_small, sizeof(too_small));
+    ASSERT_EQ(ret, UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    for (void *ptr : ptrs) {
+        ret = umfPoolFree(hPool, ptr);
+        ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    }
+
+    ret = umfPoolDestroy(hPool);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    ret = umfMemoryProviderDestroy(hProvider);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+}
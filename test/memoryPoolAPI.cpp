@@ -175,6 +175,70 @@ TEST_F(test, retrieveMemoryProvider) {
     ASSERT_EQ(retProvider, provider);
 }
 
+TEST_F(test, freeBatchPartialFailure) {
+    static void *failing_ptr;
+
+    // the pool fails to free one of the blocks
+    struct pool : public umf_test::malloc_pool {
+        umf_result_t free(void *ptr) noexcept {
+            if (ptr == failing_ptr) {
+                return UMF_RESULT_ERROR_UNKNOWN;
+            }
+            return umf_test::malloc_pool::free(ptr);
+        }
+    };
+
+    umf_memory_pool_ops_t fallback_ops = umf_test::poolMakeCOps<pool, void>();
+    umf_memory_pool_ops_t batch_ops = fallback_ops;
+    batch_ops.ext_free_batch = [](void *obj, void **ptrs, size_t num) {
+        umf_result_t ret = UMF_RESULT_SUCCESS;
+        for (size_t i = 0; i < num; i++) {
+            if (ptrs[i] == nullptr) {
+                continue;
+            }
+            umf_result_t r = reinterpret_cast<pool *>(obj)->free(ptrs[i]);
+            if (r == UMF_RESULT_SUCCESS) {
+                ptrs[i] = nullptr;
+            } else if (ret == UMF_RESULT_SUCCESS) {
+                ret = r;
+            }
+        }
+        return ret;
+    };
+
+    auto nullProvider = umf_test::wrapProviderUnique(nullProviderCreate());
+
+    for (auto *ops : {&fallback_ops, &batch_ops}) {
+        auto poolUnique =
+            wrapPoolUnique(createPoolChecked(ops, nullProvider.get(), nullptr));
+        umf_memory_pool_handle_t hPool = poolUnique.get();
+
+        std::array<void *, 8> ptrs{};
+        for (auto &ptr : ptrs) {
+            ptr = umfPoolMalloc(hPool, 64);
+            ASSERT_NE(ptr, nullptr);
+        }
+
+        failing_ptr = ptrs[3];
+        auto ret = umfPoolFreeBatch(hPool, ptrs.data(), ptrs.size());
+        ASSERT_EQ(ret, UMF_RESULT_ERROR_UNKNOWN);
+
+        // only the block which could not be freed is left
+        for (size_t i = 0; i < ptrs.size(); i++) {
+            ASSERT_EQ(ptrs[i], (i == 3) ? failing_ptr : nullptr);
+        }
+
+        size_t alloc_count = 0;
+        ret = umfCtlGet("umf.pool.by_handle.{}.stats.alloc_count",
+                        &alloc_count, sizeof(alloc_count), hPool);
+        ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+        ASSERT_EQ(alloc_count, 1ull);
+
+        failing_ptr = nullptr;
+        ASSERT_EQ(umfPoolFree(hPool, ptrs[3]), UMF_RESULT_SUCCESS);
+    }
+}
+
 TEST_F(test, BasicPoolByPtrTest) {
     constexpr size_t SIZE = 4096 * 1024;
 
@@ -418,7 +482,8 @@ TEST_P(umfPoolWithCreateFlagsTest, umfPoolCreateFlagsInvalidProviders) {
 
 // logical sum (OR) of all umf_pool_create_flags_t flags
 static constexpr umf_pool_create_flags_t UMF_POOL_CREATE_FLAG_ALL =
-    UMF_POOL_CREATE_FLAG_OWN_PROVIDER | UMF_POOL_CREATE_FLAG_DISABLE_TRACKING;
+    UMF_POOL_CREATE_FLAG_OWN_PROVIDER | UMF_POOL_CREATE_FLAG_DISABLE_TRACKING |
+    UMF_POOL_CREATE_FLAG_COARSE_TRACKING;
 
 TEST_P(umfPoolWithCreateFlagsTest, umfPoolCreateInvalidFlags) {
     umf_memory_provider_handle_t provider = nullptr;
@@ -432,6 +497,13 @@ TEST_P(umfPoolWithCreateFlagsTest, umfPoolCreateInvalidFlags) {
                         (UMF_POOL_CREATE_FLAG_ALL + 1), &pool);
     ASSERT_EQ(ret, UMF_RESULT_ERROR_INVALID_ARGUMENT);
 
+    // coarse tracking requires tracking
+    ret = umfPoolCreate(&MALLOC_POOL_OPS, provider, nullptr,
+                        UMF_POOL_CREATE_FLAG_DISABLE_TRACKING |
+                            UMF_POOL_CREATE_FLAG_COARSE_TRACKING,
+                        &pool);
+    ASSERT_EQ(ret, UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
     umfMemoryProviderDestroy(provider);
 }
 
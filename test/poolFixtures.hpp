@@ -154,6 +154,42 @@ TEST_P(umfPoolTest, allocFreeNonAlignedSizes) {
     }
 }
 
+TEST_P(umfPoolTest, allocFreeBatch) {
+    umf_memory_pool_handle_t pool_get = pool.get();
+    static constexpr size_t allocSize = 64;
+    static constexpr size_t numAllocs = 16;
+    std::array<void *, numAllocs> ptrs{};
+
+    auto umf_result =
+        umfPoolMallocBatch(pool_get, allocSize, ptrs.size(), ptrs.data());
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    for (auto ptr : ptrs) {
+        ASSERT_NE(ptr, nullptr);
+        std::memset(ptr, 0, allocSize);
+    }
+
+    size_t alloc_count = 0;
+    umf_result = umfCtlGet("umf.pool.by_handle.{}.stats.alloc_count",
+                           &alloc_count, sizeof(alloc_count), pool_get);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(alloc_count, numAllocs);
+
+    // NULL entries are skipped
+    void *kept = ptrs[0];
+    ptrs[0] = nullptr;
+
+    umf_result = umfPoolFreeBatch(pool_get, ptrs.data(), ptrs.size());
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_result = umfCtlGet("umf.pool.by_handle.{}.stats.alloc_count",
+                           &alloc_count, sizeof(alloc_count), pool_get);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(alloc_count, 1ull);
+
+    umf_result = umfPoolFree(pool_get, kept);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+}
+
 TEST_P(umfPoolTest, allocFreeAligned) {
 // ::aligned_alloc(alignment=4096, size=1) does not work under sanitizers for unknown reason
 #if defined(_WIN32) || defined(__SANITIZE_ADDRESS__) ||                        \
@@ -853,4 +889,51 @@ TEST_P(umfPoolTest, ctl_stat_alloc_count) {
         ASSERT_EQ(alloc_count, 0ull);
     }
 }
+
+TEST_P(umfPoolTest, ctl_stat_alloc_count_multithreaded) {
+    umf_memory_pool_handle_t pool_get = pool.get();
+    static constexpr size_t size = 64;
+    static constexpr size_t allocsPerThread = 16;
+    std::vector<std::vector<void *>> ptrs(NTHREADS);
+    std::vector<std::thread> threads;
+
+    // allocate on one set of threads and free on another one, so the
+    // per-thread parts of the statistic do not balance out on their own
+    for (int i = 0; i < NTHREADS; i++) {
+        threads.emplace_back([&, i] {
+            for (size_t j = 0; j < allocsPerThread; j++) {
+                void *ptr = umfPoolMalloc(pool_get, size);
+                ASSERT_NE(ptr, nullptr);
+                ptrs[i].push_back(ptr);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+
+    size_t alloc_count = 0;
+    auto ret = umfCtlGet("umf.pool.by_handle.{}.stats.alloc_count",
+                         &alloc_count, sizeof(alloc_count), pool_get);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(alloc_count, NTHREADS * allocsPerThread);
+
+    for (int i = 0; i < NTHREADS; i++) {
+        threads.emplace_back([&, i] {
+            for (auto ptr : ptrs[(i + 1) % NTHREADS]) {
+                ASSERT_EQ(umfPoolFree(pool_get, ptr), UMF_RESULT_SUCCESS);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ret = umfCtlGet("umf.pool.by_handle.{}.stats.alloc_count", &alloc_count,
+                    sizeof(alloc_count), pool_get);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(alloc_count, 0ull);
+}
+
 #endif /* UMF_TEST_POOL_FIXTURES_HPP */
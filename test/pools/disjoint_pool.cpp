@@ -2,7 +2,11 @@
 // Under the Apache License v2.0 with LLVM Exceptions. See LICENSE.TXT.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include <umf/base.h>
 #include <umf/memory_pool.h>
@@ -275,6 +279,65 @@ TEST_F(test, sharedLimits) {
     EXPECT_EQ(MaxSize / SlabMinSize * 2, numFrees);
 }
 
+TEST_F(test, disjointPoolMallocBatchSlabs) {
+    static constexpr size_t SlabMinSize = 64 * 1024;
+    static constexpr size_t ChunkSize = 8 * 1024;
+    static constexpr size_t NumChunks = 8 * SlabMinSize / ChunkSize;
+    static size_t numAllocs = 0;
+
+    struct memory_provider : public umf_test::provider_base_t {
+        umf_result_t alloc(size_t size, size_t alignment, void **ptr) noexcept {
+            *ptr = umf_ba_global_aligned_alloc(size, alignment);
+            numAllocs++;
+            return UMF_RESULT_SUCCESS;
+        }
+        umf_result_t free(void *ptr, [[maybe_unused]] size_t size) noexcept {
+            umf_ba_global_free(ptr);
+            return UMF_RESULT_SUCCESS;
+        }
+    };
+
+    umf_memory_provider_ops_t provider_ops =
+        umf_test::providerMakeCOps<memory_provider, void>();
+
+    auto providerUnique =
+        wrapProviderUnique(createProviderChecked(&provider_ops, nullptr));
+
+    umf_disjoint_pool_params_handle_t params;
+    umf_result_t ret = umfDisjointPoolParamsCreate(&params);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    ret = umfDisjointPoolParamsSetSlabMinSize(params, SlabMinSize);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    ret = umfDisjointPoolParamsSetMaxPoolableSize(params, SlabMinSize);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+
+    umf_memory_pool_handle_t pool = NULL;
+    ret = umfPoolCreate(umfDisjointPoolOps(), providerUnique.get(), params, 0,
+                        &pool);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    auto poolHandle = umf_test::wrapPoolUnique(pool);
+
+    ret = umfDisjointPoolParamsDestroy(params);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+
+    // the batch needs 8 slabs, which are allocated at once
+    std::vector<void *> ptrs(NumChunks);
+    ret = umfPoolMallocBatch(pool, ChunkSize, ptrs.size(), ptrs.data());
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    EXPECT_EQ(numAllocs, NumChunks * ChunkSize / SlabMinSize);
+
+    for (void *ptr : ptrs) {
+        ASSERT_NE(ptr, nullptr);
+        umf_memory_pool_handle_t ptr_pool = NULL;
+        EXPECT_EQ(umfPoolByPtr(ptr, &ptr_pool), UMF_RESULT_SUCCESS);
+        EXPECT_EQ(ptr_pool, pool);
+        memset(ptr, 0xAB, ChunkSize);
+    }
+
+    ret = umfPoolFreeBatch(pool, ptrs.data(), ptrs.size());
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+}
+
 TEST_F(test, disjointPoolTrim) {
     struct memory_provider : public umf_test::provider_base_t {
         umf_result_t alloc(size_t size, size_t alignment, void **ptr) noexcept {
@@ -353,12 +416,762 @@ TEST_F(test, disjointPoolTrim) {
     ops->ext_trim_memory(pool, 0);
     EXPECT_EQ(pool->buckets[0]->available_slabs_num, (size_t)0);
     EXPECT_EQ(pool->buckets[0]->curr_slabs_in_pool, (size_t)0);
+    EXPECT_EQ(pool->buckets[0]->chunked_slabs_in_pool, (size_t)0);
+    EXPECT_EQ(pool->buckets[0]->shared_limits->total_size, (size_t)0);
+
+    ops->finalize(pool);
+    res = umfDisjointPoolParamsDestroy(params);
+    EXPECT_EQ(res, UMF_RESULT_SUCCESS);
+}
+
+TEST_F(test, disjointPoolThreadCache) {
+    struct memory_provider : public umf_test::provider_base_t {
+        umf_result_t alloc(size_t size, size_t alignment, void **ptr) noexcept {
+            *ptr = umf_ba_global_aligned_alloc(size, alignment);
+            return UMF_RESULT_SUCCESS;
+        }
+
+        umf_result_t free(void *ptr, size_t) noexcept {
+            umf_ba_global_free(ptr);
+            return UMF_RESULT_SUCCESS;
+        }
+    };
+
+    umf_memory_provider_ops_t provider_ops =
+        umf_test::providerMakeCOps<memory_provider, void>();
+
+    auto providerUnique =
+        wrapProviderUnique(createProviderChecked(&provider_ops, nullptr));
+
+    umf_disjoint_pool_params_handle_t params =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    params->pool_trace = 3;
+    // 64 chunks of 64 bytes in a single slab
+    params->slab_min_size = 4096;
+    const size_t tcache_size = 8;
+    umf_result_t res =
+        umfDisjointPoolParamsSetThreadCacheSize(params, tcache_size);
+    EXPECT_EQ(res, UMF_RESULT_SUCCESS);
+    res = umfDisjointPoolParamsSetThreadCacheMaxChunkSize(params, 128);
+    EXPECT_EQ(res, UMF_RESULT_SUCCESS);
+
+    const umf_memory_pool_ops_t *ops = umfDisjointPoolOps();
+    disjoint_pool_t *pool;
+    res = ops->initialize(providerUnique.get(), params, (void **)&pool);
+    EXPECT_EQ(res, UMF_RESULT_SUCCESS);
+    EXPECT_NE(pool, nullptr);
+
+    // only the 64, 96 and 128 byte buckets are cached
+    EXPECT_EQ(pool->tcache_buckets_num, (size_t)3);
+
+    bucket_t *bucket = pool->buckets[0];
+    void *ptr = ops->malloc(pool, 64);
+    EXPECT_NE(ptr, nullptr);
+
+    // the cache is refilled with half of its capacity at once
+    EXPECT_EQ(bucket->alloc_count, tcache_size / 2);
+    slab_t *slab = bucket->available_slabs->val;
+    EXPECT_EQ(slab->num_chunks_allocated, tcache_size / 2);
+
+    // freed chunk stays in the cache of the thread
+    res = ops->free(pool, ptr);
+    EXPECT_EQ(res, UMF_RESULT_SUCCESS);
+    EXPECT_EQ(bucket->free_count, (size_t)0);
+    EXPECT_EQ(slab->num_chunks_allocated, tcache_size / 2);
+
+    // the same chunk is reused by the next allocation
+    void *ptr2 = ops->malloc(pool, 64);
+    EXPECT_EQ(ptr2, ptr);
+    res = ops->free(pool, ptr2);
+    EXPECT_EQ(res, UMF_RESULT_SUCCESS);
+
+    // overflowing the cache flushes half of it back to the bucket
+    void *ptrs[2 * tcache_size];
+    for (size_t i = 0; i < 2 * tcache_size; i++) {
+        ptrs[i] = ops->malloc(pool, 64);
+        EXPECT_NE(ptrs[i], nullptr);
+    }
+    for (size_t i = 0; i < 2 * tcache_size; i++) {
+        res = ops->free(pool, ptrs[i]);
+        EXPECT_EQ(res, UMF_RESULT_SUCCESS);
+    }
+    EXPECT_GT(bucket->free_count, (size_t)0);
+    EXPECT_LE(slab->num_chunks_allocated, tcache_size);
+
+    // trim drains all the caches
+    res = ops->ext_trim_memory(pool, 0);
+    EXPECT_EQ(res, UMF_RESULT_SUCCESS);
+    EXPECT_EQ(bucket->available_slabs_num, (size_t)0);
+    EXPECT_EQ(bucket->alloc_count, bucket->free_count);
+
+    // cache of other thread is drained on the thread exit
+    std::thread thread([&]() {
+        void *p = ops->malloc(pool, 100);
+        EXPECT_NE(p, nullptr);
+        EXPECT_EQ(ops->free(pool, p), UMF_RESULT_SUCCESS);
+    });
+    thread.join();
+    EXPECT_EQ(pool->buckets[2]->alloc_count, pool->buckets[2]->free_count);
+    EXPECT_EQ(pool->buckets[2]->curr_slabs_in_use, (size_t)0);
 
     ops->finalize(pool);
     res = umfDisjointPoolParamsDestroy(params);
     EXPECT_EQ(res, UMF_RESULT_SUCCESS);
 }
 
+TEST_F(test, disjointPoolCallocRealloc) {
+    struct memory_provider : public umf_test::provider_base_t {
+        umf_result_t alloc(size_t size, size_t alignment, void **ptr) noexcept {
+            *ptr = umf_ba_global_aligned_alloc(size, alignment);
+            // fill the memory with garbage to check whether calloc zeroes it
+            memset(*ptr, 0xAB, size);
+            return UMF_RESULT_SUCCESS;
+        }
+
+        umf_result_t free(void *ptr, size_t) noexcept {
+            umf_ba_global_free(ptr);
+            return UMF_RESULT_SUCCESS;
+        }
+    };
+
+    umf_memory_provider_ops_t provider_ops =
+        umf_test::providerMakeCOps<memory_provider, void>();
+
+    auto providerUnique =
+        wrapProviderUnique(createProviderChecked(&provider_ops, nullptr));
+
+    umf_disjoint_pool_params_handle_t params =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+
+    umf_memory_pool_handle_t pool = nullptr;
+    umf_result_t res = umfPoolCreate(umfDisjointPoolOps(), providerUnique.get(),
+                                     params, UMF_POOL_CREATE_FLAG_NONE, &pool);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    // calloc has to zero memory returned by the provider
+    const size_t num = 16;
+    char *ptr = (char *)umfPoolCalloc(pool, num, sizeof(uint64_t));
+    ASSERT_NE(ptr, nullptr);
+    for (size_t i = 0; i < num * sizeof(uint64_t); i++) {
+        ASSERT_EQ(ptr[i], 0);
+    }
+
+    // realloc within the same bucket does not move the allocation
+    size_t usable_size = 0;
+    res = umfPoolMallocUsableSize(pool, ptr, &usable_size);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+    void *ptr2 = umfPoolRealloc(pool, ptr, usable_size);
+    ASSERT_EQ(ptr2, ptr);
+
+    // realloc to a larger bucket moves the allocation and keeps the data
+    memset(ptr, 0x5A, usable_size);
+    char *ptr3 = (char *)umfPoolRealloc(pool, ptr, 2 * usable_size);
+    ASSERT_NE(ptr3, nullptr);
+    ASSERT_NE((void *)ptr3, (void *)ptr);
+    for (size_t i = 0; i < usable_size; i++) {
+        ASSERT_EQ(ptr3[i], 0x5A);
+    }
+
+    // realloc to 0 frees the memory
+    ASSERT_EQ(umfPoolRealloc(pool, ptr3, 0), nullptr);
+
+    // calloc larger than max poolable size goes directly to the provider
+    size_t large_size = 2 * DEFAULT_DISJOINT_MAX_POOLABLE_SIZE;
+    ptr = (char *)umfPoolCalloc(pool, 1, large_size);
+    ASSERT_NE(ptr, nullptr);
+    for (size_t i = 0; i < large_size; i++) {
+        ASSERT_EQ(ptr[i], 0);
+    }
+
+    // shrinking large allocation keeps it in place
+    ptr2 = umfPoolRealloc(pool, ptr, large_size - 1);
+    ASSERT_EQ(ptr2, (void *)ptr);
+    ASSERT_EQ(umfPoolFree(pool, ptr2), UMF_RESULT_SUCCESS);
+
+    umfPoolDestroy(pool);
+    umfDisjointPoolParamsDestroy(params);
+}
+
+TEST_F(test, disjointPoolCoarseTrackingRealloc) {
+    struct memory_provider : public umf_test::provider_base_t {
+        umf_result_t alloc(size_t size, size_t alignment, void **ptr) noexcept {
+            *ptr = umf_ba_global_aligned_alloc(size, alignment);
+            return (*ptr) ? UMF_RESULT_SUCCESS
+                          : UMF_RESULT_ERROR_OUT_OF_HOST_MEMORY;
+        }
+
+        umf_result_t free(void *ptr, size_t) noexcept {
+            umf_ba_global_free(ptr);
+            return UMF_RESULT_SUCCESS;
+        }
+    };
+
+    umf_memory_provider_ops_t provider_ops =
+        umf_test::providerMakeCOps<memory_provider, void>();
+
+    auto providerUnique =
+        wrapProviderUnique(createProviderChecked(&provider_ops, nullptr));
+
+    umf_disjoint_pool_params_handle_t params =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res = umfDisjointPoolParamsSetMaxPoolableSize(params, 64 * KB);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    umf_memory_pool_handle_t pool = nullptr;
+    res = umfPoolCreate(umfDisjointPoolOps(), providerUnique.get(), params,
+                        UMF_POOL_CREATE_FLAG_COARSE_TRACKING, &pool);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    // both allocations are carved out of the same chunk
+    const size_t size = 100 * KB;
+    char *a = (char *)umfPoolMalloc(pool, size);
+    ASSERT_NE(a, nullptr);
+    char *b = (char *)umfPoolMalloc(pool, size);
+    ASSERT_NE(b, nullptr);
+    memset(a, 0x11, size);
+    memset(b, 0x22, size);
+
+    // the usable size is the size of the allocation, not of the chunk
+    size_t usable_size = 0;
+    res = umfPoolMallocUsableSize(pool, a, &usable_size);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+    ASSERT_GE(usable_size, size);
+    ASSERT_LT(usable_size, 2 * size);
+
+    // growing has to move the allocation and keep its data
+    const size_t new_size = 3 * size;
+    char *c = (char *)umfPoolRealloc(pool, a, new_size);
+    ASSERT_NE(c, nullptr);
+    ASSERT_NE(c, a);
+    for (size_t i = 0; i < size; i++) {
+        ASSERT_EQ(c[i], 0x11);
+    }
+
+    memset(c, 0x33, new_size);
+    for (size_t i = 0; i < size; i++) {
+        ASSERT_EQ(b[i], 0x22);
+    }
+
+    ASSERT_EQ(umfPoolFree(pool, b), UMF_RESULT_SUCCESS);
+    ASSERT_EQ(umfPoolFree(pool, c), UMF_RESULT_SUCCESS);
+
+    umfPoolDestroy(pool);
+    umfDisjointPoolParamsDestroy(params);
+}
+
+TEST_F(test, disjointPoolCallocZeroedProvider) {
+    struct memory_provider : public umf_test::provider_base_t {
+        umf_result_t alloc(size_t size, size_t alignment, void **ptr) noexcept {
+            *ptr = umf_ba_global_aligned_alloc(size, alignment);
+            memset(*ptr, 0, size);
+            return UMF_RESULT_SUCCESS;
+        }
+
+        umf_result_t free(void *ptr, size_t) noexcept {
+            umf_ba_global_free(ptr);
+            return UMF_RESULT_SUCCESS;
+        }
+    };
+
+    umf_memory_provider_ops_t provider_ops =
+        umf_test::providerMakeCOps<memory_provider, void>();
+
+    auto providerUnique =
+        wrapProviderUnique(createProviderChecked(&provider_ops, nullptr));
+
+    umf_disjoint_pool_params_handle_t params =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res =
+        umfDisjointPoolParamsSetProviderZeroedMemory(params, true);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    const umf_memory_pool_ops_t *ops = umfDisjointPoolOps();
+    disjoint_pool_t *pool;
+    res = ops->initialize(providerUnique.get(), params, (void **)&pool);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    // first chunk of a new slab is zeroed by the provider
+    char *ptr = (char *)ops->calloc(pool, 1, 64);
+    ASSERT_NE(ptr, nullptr);
+    slab_t *slab = pool->buckets[0]->available_slabs->val;
+    EXPECT_EQ(slab->first_untouched_chunk, (size_t)1);
+
+    // reused chunk has to be cleared again
+    memset(ptr, 0xAB, 64);
+    ASSERT_EQ(ops->free(pool, ptr), UMF_RESULT_SUCCESS);
+    ptr = (char *)ops->calloc(pool, 1, 64);
+    ASSERT_NE(ptr, nullptr);
+    for (size_t i = 0; i < 64; i++) {
+        ASSERT_EQ(ptr[i], 0);
+    }
+    EXPECT_EQ(slab->first_untouched_chunk, (size_t)1);
+    ASSERT_EQ(ops->free(pool, ptr), UMF_RESULT_SUCCESS);
+
+    ops->finalize(pool);
+    umfDisjointPoolParamsDestroy(params);
+}
+
+TEST_F(test, disjointPoolAlignedSlabs) {
+    static constexpr size_t page_size = 4096;
+    static constexpr size_t alignment = 4 * page_size;
+    static size_t provider_allocs = 0;
+
+    struct memory_provider : public umf_test::provider_base_t {
+        umf_result_t alloc(size_t size, size_t align, void **ptr) noexcept {
+            // slabs of aligned buckets have to be requested with alignment
+            EXPECT_EQ(align, alignment);
+            provider_allocs++;
+            *ptr = umf_ba_global_aligned_alloc(size, align);
+            return UMF_RESULT_SUCCESS;
+        }
+
+        umf_result_t free(void *ptr, size_t) noexcept {
+            umf_ba_global_free(ptr);
+            return UMF_RESULT_SUCCESS;
+        }
+
+        umf_result_t get_min_page_size(const void *, size_t *size) noexcept {
+            *size = page_size;
+            return UMF_RESULT_SUCCESS;
+        }
+    };
+
+    umf_memory_provider_ops_t provider_ops =
+        umf_test::providerMakeCOps<memory_provider, void>();
+
+    auto providerUnique =
+        wrapProviderUnique(createProviderChecked(&provider_ops, nullptr));
+
+    umf_disjoint_pool_params_handle_t params =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res = umfDisjointPoolParamsSetSlabMinSize(params, 65536);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+    res = umfDisjointPoolParamsSetMaxPoolableSize(params, 65536);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    const umf_memory_pool_ops_t *ops = umfDisjointPoolOps();
+    disjoint_pool_t *pool;
+    res = ops->initialize(providerUnique.get(), params, (void **)&pool);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    // aligned chunks are packed into a single aligned slab without padding
+    std::vector<void *> ptrs;
+    for (size_t i = 0; i < 65536 / alignment; i++) {
+        void *ptr = ops->aligned_malloc(pool, alignment, alignment);
+        ASSERT_NE(ptr, nullptr);
+        ASSERT_EQ((uintptr_t)ptr % alignment, 0u);
+
+        size_t usable_size = 0;
+        ASSERT_EQ(ops->malloc_usable_size(pool, ptr, &usable_size),
+                  UMF_RESULT_SUCCESS);
+        EXPECT_EQ(usable_size, alignment);
+        ptrs.push_back(ptr);
+    }
+    EXPECT_EQ(provider_allocs, 1u);
+
+    // small allocations share the bucket of the alignment size
+    void *ptr = ops->aligned_malloc(pool, 100, alignment);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_EQ((uintptr_t)ptr % alignment, 0u);
+    EXPECT_EQ(provider_allocs, 2u);
+    ptrs.push_back(ptr);
+
+    for (void *p : ptrs) {
+        ASSERT_EQ(ops->free(pool, p), UMF_RESULT_SUCCESS);
+    }
+
+    ops->finalize(pool);
+    umfDisjointPoolParamsDestroy(params);
+}
+
+TEST_F(test, disjointPoolNaturallyAlignedSlabs) {
+    static constexpr size_t slab_min_size = 65536;
+
+    struct memory_provider : public umf_test::provider_base_t {
+        umf_result_t alloc(size_t size, size_t alignment, void **ptr) noexcept {
+            EXPECT_EQ(alignment, slab_min_size);
+            *ptr = umf_ba_global_aligned_alloc(size, alignment);
+            return UMF_RESULT_SUCCESS;
+        }
+
+        umf_result_t free(void *ptr, size_t) noexcept {
+            umf_ba_global_free(ptr);
+            return UMF_RESULT_SUCCESS;
+        }
+    };
+
+    umf_memory_provider_ops_t provider_ops =
+        umf_test::providerMakeCOps<memory_provider, void>();
+
+    auto providerUnique =
+        wrapProviderUnique(createProviderChecked(&provider_ops, nullptr));
+
+    umf_disjoint_pool_params_handle_t params =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res = umfDisjointPoolParamsSetSlabMinSize(params, 3 * 4096);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+    res = umfDisjointPoolParamsSetMaxPoolableSize(params, 4 * slab_min_size);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+    res = umfDisjointPoolParamsSetNaturallyAlignedSlabs(params, true);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    const umf_memory_pool_ops_t *ops = umfDisjointPoolOps();
+    disjoint_pool_t *pool;
+
+    // slab_min_size is not a power of 2, the option is ignored
+    res = ops->initialize(providerUnique.get(), params, (void **)&pool);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+    EXPECT_EQ(pool->slab_addr_mask, (uintptr_t)0);
+    EXPECT_EQ(pool->slab_table, nullptr);
+    ops->finalize(pool);
+
+    res = umfDisjointPoolParamsSetSlabMinSize(params, slab_min_size);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+    res = ops->initialize(providerUnique.get(), params, (void **)&pool);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+    EXPECT_EQ(pool->slab_addr_mask, ~(uintptr_t)(slab_min_size - 1));
+
+    std::vector<void *> ptrs;
+    for (size_t size = 64; size <= 4096; size *= 2) {
+        for (size_t i = 0; i < 100; i++) {
+            void *ptr = ops->malloc(pool, size);
+            ASSERT_NE(ptr, nullptr);
+            ptrs.push_back(ptr);
+
+            // the slab of the chunk starts at the masked address
+            void *ref = NULL;
+            slab_t *slab = (slab_t *)critnib_get(
+                pool->known_slabs, (uintptr_t)ptr & pool->slab_addr_mask,
+                &ref);
+            ASSERT_NE(slab, nullptr);
+            EXPECT_GE(slab->bucket->size, size);
+            critnib_release(pool->known_slabs, ref);
+
+            // and is found in the slab table without searching the critnib
+            uintptr_t index = ((uintptr_t)ptr >> pool->slab_table_shift) &
+                              (SLAB_TABLE_SIZE - 1);
+            EXPECT_EQ(pool->slab_table[index], slab);
+
+            size_t usable_size = 0;
+            ASSERT_EQ(ops->malloc_usable_size(pool, ptr, &usable_size),
+                      UMF_RESULT_SUCCESS);
+            EXPECT_EQ(usable_size, slab->bucket->size);
+        }
+    }
+
+    // no slab is larger than the mask, so the closest slab is not searched
+    EXPECT_EQ(pool->big_slabs_num, 0);
+
+    // a slab of a single chunk larger than slab_min_size
+    void *big_ptr = ops->malloc(pool, 2 * slab_min_size);
+    ASSERT_NE(big_ptr, nullptr);
+    ptrs.push_back(big_ptr);
+    EXPECT_EQ(pool->big_slabs_num, 1);
+
+    size_t big_usable_size = 0;
+    ASSERT_EQ(ops->malloc_usable_size(pool, big_ptr, &big_usable_size),
+              UMF_RESULT_SUCCESS);
+    EXPECT_GE(big_usable_size, 2 * slab_min_size);
+
+    for (void *ptr : ptrs) {
+        ASSERT_EQ(ops->free(pool, ptr), UMF_RESULT_SUCCESS);
+    }
+
+    ops->finalize(pool);
+    umfDisjointPoolParamsDestroy(params);
+}
+
+TEST_F(test, disjointPoolLockFreeSlabs) {
+    struct memory_provider : public umf_test::provider_base_t {
+        umf_result_t alloc(size_t size, size_t alignment, void **ptr) noexcept {
+            *ptr = umf_ba_global_aligned_alloc(size, alignment);
+            return UMF_RESULT_SUCCESS;
+        }
+
+        umf_result_t free(void *ptr, size_t) noexcept {
+            umf_ba_global_free(ptr);
+            return UMF_RESULT_SUCCESS;
+        }
+    };
+
+    umf_memory_provider_ops_t provider_ops =
+        umf_test::providerMakeCOps<memory_provider, void>();
+
+    auto providerUnique =
+        wrapProviderUnique(createProviderChecked(&provider_ops, nullptr));
+
+    umf_disjoint_pool_params_handle_t params =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res = umfDisjointPoolParamsSetLockFreeSlabs(params, true);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    const umf_memory_pool_ops_t *ops = umfDisjointPoolOps();
+    disjoint_pool_t *pool;
+    res = ops->initialize(providerUnique.get(), params, (void **)&pool);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    // only buckets which split slabs into chunks are lock-free
+    for (size_t i = 0; i < pool->buckets_num; i++) {
+        bucket_t *bucket = pool->buckets[i];
+        EXPECT_EQ(bucket->lockfree,
+                  bucket->size <= DEFAULT_DISJOINT_SLAB_MIN_SIZE / 2);
+    }
+
+    const size_t num_threads = 4;
+    const size_t num_allocs = 1000;
+    const size_t size = 64;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            std::vector<void *> ptrs;
+            for (size_t iter = 0; iter < 10; iter++) {
+                for (size_t i = 0; i < num_allocs; i++) {
+                    void *ptr = ops->malloc(pool, size);
+                    ASSERT_NE(ptr, nullptr);
+                    memset(ptr, (int)t, size);
+                    ptrs.push_back(ptr);
+                }
+                for (void *ptr : ptrs) {
+                    // chunk must not be handed out twice
+                    for (size_t i = 0; i < size; i++) {
+                        ASSERT_EQ(((unsigned char *)ptr)[i], t);
+                    }
+                    ASSERT_EQ(ops->free(pool, ptr), UMF_RESULT_SUCCESS);
+                }
+                ptrs.clear();
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // all slabs are empty and at most one of them is kept in the pool
+    bucket_t *bucket = pool->buckets[0];
+    EXPECT_EQ(bucket->unavailable_slabs, nullptr);
+    EXPECT_LE(bucket->available_slabs_num, (size_t)1);
+    slab_list_item_t *it;
+    for (it = bucket->available_slabs; it != NULL; it = it->next) {
+        EXPECT_EQ(slab_get_num_allocated(it->val), (size_t)0);
+    }
+
+    ops->finalize(pool);
+    umfDisjointPoolParamsDestroy(params);
+}
+
+TEST_F(test, disjointPoolRemoteFree) {
+    struct memory_provider : public umf_test::provider_base_t {
+        umf_result_t alloc(size_t size, size_t alignment, void **ptr) noexcept {
+            *ptr = umf_ba_global_aligned_alloc(size, alignment);
+            return UMF_RESULT_SUCCESS;
+        }
+
+        umf_result_t free(void *ptr, size_t) noexcept {
+            umf_ba_global_free(ptr);
+            return UMF_RESULT_SUCCESS;
+        }
+    };
+
+    umf_memory_provider_ops_t provider_ops =
+        umf_test::providerMakeCOps<memory_provider, void>();
+
+    auto providerUnique =
+        wrapProviderUnique(createProviderChecked(&provider_ops, nullptr));
+
+    umf_disjoint_pool_params_handle_t params =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res = umfDisjointPoolParamsSetRemoteFree(params, true);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    const umf_memory_pool_ops_t *ops = umfDisjointPoolOps();
+    disjoint_pool_t *pool;
+    res = ops->initialize(providerUnique.get(), params, (void **)&pool);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    // only buckets which split slabs into chunks use the remote-free queues
+    for (size_t i = 0; i < pool->buckets_num; i++) {
+        bucket_t *bucket = pool->buckets[i];
+        EXPECT_EQ(bucket->remote_free,
+                  bucket->size <= DEFAULT_DISJOINT_SLAB_MIN_SIZE / 2);
+    }
+
+    const size_t size = 64;
+    const size_t num_chunks = DEFAULT_DISJOINT_SLAB_MIN_SIZE / size;
+    bucket_t *bucket = nullptr;
+    for (size_t i = 0; i < pool->buckets_num && bucket == nullptr; i++) {
+        if (pool->buckets[i]->size == size) {
+            bucket = pool->buckets[i];
+        }
+    }
+    ASSERT_NE(bucket, nullptr);
+
+    // fill up a single slab
+    std::vector<void *> ptrs;
+    for (size_t i = 0; i < num_chunks; i++) {
+        void *ptr = ops->malloc(pool, size);
+        ASSERT_NE(ptr, nullptr);
+        ptrs.push_back(ptr);
+    }
+    ASSERT_EQ(bucket->available_slabs, nullptr);
+    ASSERT_NE(bucket->unavailable_slabs, nullptr);
+    slab_t *slab = bucket->unavailable_slabs->val;
+
+    // frees from another thread are queued on the slab
+    std::thread thread([&]() {
+        for (void *ptr : ptrs) {
+            ASSERT_EQ(ops->free(pool, ptr), UMF_RESULT_SUCCESS);
+        }
+    });
+    thread.join();
+
+    EXPECT_EQ(bucket->remote_frees, num_chunks);
+    EXPECT_EQ(slab->remote_frees, num_chunks);
+    EXPECT_EQ(slab_get_num_allocated(slab), num_chunks);
+
+    // the next allocation reclaims the queued chunks instead of creating
+    // a new slab
+    void *ptr = ops->malloc(pool, size);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(bucket->remote_frees, (size_t)0);
+    EXPECT_EQ(bucket->unavailable_slabs, nullptr);
+    ASSERT_NE(bucket->available_slabs, nullptr);
+    EXPECT_EQ(bucket->available_slabs->val, slab);
+    EXPECT_EQ(bucket->available_slabs->next, nullptr);
+    EXPECT_EQ(slab_get_num_allocated(slab), (size_t)1);
+
+    // frees from the owner of the slab are not queued
+    ASSERT_EQ(ops->free(pool, ptr), UMF_RESULT_SUCCESS);
+    EXPECT_EQ(bucket->remote_frees, (size_t)0);
+    EXPECT_EQ(slab_get_num_allocated(slab), (size_t)0);
+
+    // trimming reclaims the queued chunks as well
+    ptr = ops->malloc(pool, size);
+    ASSERT_NE(ptr, nullptr);
+    thread = std::thread(
+        [&]() { ASSERT_EQ(ops->free(pool, ptr), UMF_RESULT_SUCCESS); });
+    thread.join();
+    EXPECT_EQ(bucket->remote_frees, (size_t)1);
+
+    ASSERT_EQ(ops->ext_trim_memory(pool, 0), UMF_RESULT_SUCCESS);
+    EXPECT_EQ(bucket->remote_frees, (size_t)0);
+    EXPECT_EQ(bucket->available_slabs, nullptr);
+    EXPECT_EQ(bucket->unavailable_slabs, nullptr);
+
+    ops->finalize(pool);
+    umfDisjointPoolParamsDestroy(params);
+}
+
+TEST_F(test, disjointPoolDecay) {
+    static std::atomic<size_t> num_provider_allocs;
+    static std::atomic<size_t> num_frees;
+    static std::atomic<size_t> num_purges;
+
+    struct memory_provider : public umf_test::provider_base_t {
+        umf_result_t alloc(size_t size, size_t alignment, void **ptr) noexcept {
+            *ptr = umf_ba_global_aligned_alloc(size, alignment);
+            num_provider_allocs++;
+            return UMF_RESULT_SUCCESS;
+        }
+
+        umf_result_t free(void *ptr, size_t) noexcept {
+            umf_ba_global_free(ptr);
+            num_frees++;
+            return UMF_RESULT_SUCCESS;
+        }
+
+        umf_result_t ext_purge_lazy(void *, size_t) noexcept {
+            num_purges++;
+            return UMF_RESULT_SUCCESS;
+        }
+    };
+
+    umf_memory_provider_ops_t provider_ops =
+        umf_test::providerMakeCOps<memory_provider, void>();
+
+    auto providerUnique =
+        wrapProviderUnique(createProviderChecked(&provider_ops, nullptr));
+
+    const size_t decay_ms = 50;
+    umf_disjoint_pool_params_handle_t params =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res = umfDisjointPoolParamsSetDecayTime(params, decay_ms);
+    ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+    const umf_memory_pool_ops_t *ops = umfDisjointPoolOps();
+
+    // each allocation takes a whole slab
+    const size_t size = DEFAULT_DISJOINT_SLAB_MIN_SIZE - 1024;
+    const size_t num_allocs = 2 * DEFAULT_DISJOINT_CAPACITY;
+
+    for (bool background : {false, true}) {
+        res = umfDisjointPoolParamsSetBackgroundPurge(params, background);
+        ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+
+        disjoint_pool_t *pool;
+        res = ops->initialize(providerUnique.get(), params, (void **)&pool);
+        ASSERT_EQ(res, UMF_RESULT_SUCCESS);
+        EXPECT_EQ(pool->purger_running, background);
+
+        num_frees = 0;
+        num_purges = 0;
+
+        std::vector<void *> ptrs;
+        for (size_t i = 0; i < num_allocs; i++) {
+            void *ptr = ops->malloc(pool, size);
+            ASSERT_NE(ptr, nullptr);
+            ptrs.push_back(ptr);
+        }
+
+        // the capacity does not apply, no slab is freed synchronously
+        for (void *ptr : ptrs) {
+            ASSERT_EQ(ops->free(pool, ptr), UMF_RESULT_SUCCESS);
+        }
+        EXPECT_EQ(num_frees, (size_t)0);
+
+        // Without the purger thread, the decay is applied by allocations
+        // which create a new slab, so small chunks are allocated until the
+        // provider is called.
+        std::vector<void *> small_ptrs;
+        auto tick = [&]() {
+            if (background) {
+                return;
+            }
+            size_t allocs = num_provider_allocs;
+            while (num_provider_allocs == allocs) {
+                void *ptr = ops->malloc(pool, 64);
+                ASSERT_NE(ptr, nullptr);
+                small_ptrs.push_back(ptr);
+            }
+        };
+
+        auto wait_for = [&](std::atomic<size_t> &counter) {
+            auto deadline =
+                std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (counter < num_allocs &&
+                   std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                tick();
+            }
+        };
+
+        // the slabs are purged first and then freed
+        wait_for(num_purges);
+        EXPECT_EQ(num_purges, num_allocs);
+        wait_for(num_frees);
+        EXPECT_EQ(num_frees, num_allocs);
+        EXPECT_EQ(num_purges, num_allocs);
+
+        for (void *ptr : small_ptrs) {
+            ASSERT_EQ(ops->free(pool, ptr), UMF_RESULT_SUCCESS);
+        }
+
+        ops->finalize(pool);
+    }
+
+    umfDisjointPoolParamsDestroy(params);
+}
+
 TEST_F(test, disjointPoolNullParams) {
     umf_result_t res = umfDisjointPoolParamsCreate(nullptr);
     EXPECT_EQ(res, UMF_RESULT_ERROR_INVALID_ARGUMENT);
@@ -605,12 +1418,83 @@ TEST_F(test, disjointPoolDefaultCapacity) {
                   1); // +1 for the last allocation that exceeded the capacity
 }
 
-INSTANTIATE_TEST_SUITE_P(disjointPoolTests, umfPoolTest,
-                         ::testing::Values(poolCreateExtParams{
-                             umfDisjointPoolOps(), defaultDisjointPoolConfig,
-                             defaultDisjointPoolConfigDestroy,
-                             &BA_GLOBAL_PROVIDER_OPS, nullptr, nullptr}),
-                         poolCreateExtParamsNameGen);
+void *threadCacheDisjointPoolConfig() {
+    umf_disjoint_pool_params_handle_t config =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res = umfDisjointPoolParamsSetThreadCacheSize(config, 16);
+    if (res != UMF_RESULT_SUCCESS) {
+        umfDisjointPoolParamsDestroy(config);
+        throw std::runtime_error("Failed to set thread cache size");
+    }
+
+    return config;
+}
+
+void *lockFreeDisjointPoolConfig() {
+    umf_disjoint_pool_params_handle_t config =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res = umfDisjointPoolParamsSetLockFreeSlabs(config, true);
+    if (res != UMF_RESULT_SUCCESS) {
+        umfDisjointPoolParamsDestroy(config);
+        throw std::runtime_error("Failed to enable lock-free slabs");
+    }
+
+    return config;
+}
+
+void *naturallyAlignedDisjointPoolConfig() {
+    umf_disjoint_pool_params_handle_t config =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res =
+        umfDisjointPoolParamsSetNaturallyAlignedSlabs(config, true);
+    if (res != UMF_RESULT_SUCCESS) {
+        umfDisjointPoolParamsDestroy(config);
+        throw std::runtime_error("Failed to enable naturally aligned slabs");
+    }
+
+    return config;
+}
+
+void *remoteFreeDisjointPoolConfig() {
+    umf_disjoint_pool_params_handle_t config =
+        (umf_disjoint_pool_params_handle_t)defaultDisjointPoolConfig();
+    umf_result_t res = umfDisjointPoolParamsSetRemoteFree(config, true);
+    if (res != UMF_RESULT_SUCCESS) {
+        umfDisjointPoolParamsDestroy(config);
+        throw std::runtime_error("Failed to enable remote-free queues");
+    }
+
+    return config;
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    disjointPoolTests, umfPoolTest,
+    ::testing::Values(poolCreateExtParams{umfDisjointPoolOps(),
+                                          defaultDisjointPoolConfig,
+                                          defaultDisjointPoolConfigDestroy,
+                                          &BA_GLOBAL_PROVIDER_OPS, nullptr,
+                                          nullptr},
+                      poolCreateExtParams{umfDisjointPoolOps(),
+                                          threadCacheDisjointPoolConfig,
+                                          defaultDisjointPoolConfigDestroy,
+                                          &BA_GLOBAL_PROVIDER_OPS, nullptr,
+                                          nullptr},
+                      poolCreateExtParams{umfDisjointPoolOps(),
+                                          lockFreeDisjointPoolConfig,
+                                          defaultDisjointPoolConfigDestroy,
+                                          &BA_GLOBAL_PROVIDER_OPS, nullptr,
+                                          nullptr},
+                      poolCreateExtParams{umfDisjointPoolOps(),
+                                          naturallyAlignedDisjointPoolConfig,
+                                          defaultDisjointPoolConfigDestroy,
+                                          &BA_GLOBAL_PROVIDER_OPS, nullptr,
+                                          nullptr},
+                      poolCreateExtParams{umfDisjointPoolOps(),
+                                          remoteFreeDisjointPoolConfig,
+                                          defaultDisjointPoolConfigDestroy,
+                                          &BA_GLOBAL_PROVIDER_OPS, nullptr,
+                                          nullptr}),
+    poolCreateExtParamsNameGen);
 
 void *memProviderParams() { return (void *)&DEFAULT_DISJOINT_CAPACITY; }
 
@@ -10,6 +10,8 @@
 #include <umf/pools/pool_disjoint.h>
 #include <umf/providers/provider_os_memory.h>
 
+#include <chrono>
+#include <thread>
 #include <vector>
 
 #include "base.hpp"
@@ -566,3 +568,231 @@ TEST_F(test, disjointCtlBucketStats) {
     ASSERT_SUCCESS(umfDisjointPoolParamsDestroy(params));
     ASSERT_SUCCESS(umfOsMemoryProviderParamsDestroy(os_memory_provider_params));
 }
+
+TEST_F(test, disjointCtlBucketsPerPowerOf2) {
+    umf_os_memory_provider_params_handle_t os_memory_provider_params = nullptr;
+    if (UMF_RESULT_ERROR_NOT_SUPPORTED ==
+        umfOsMemoryProviderParamsCreate(&os_memory_provider_params)) {
+        GTEST_SKIP() << "OS memory provider is not supported!";
+    }
+
+    ProviderWrapper providerWrapper(umfOsMemoryProviderOps(),
+                                    os_memory_provider_params);
+    if (providerWrapper.get() == NULL) {
+        GTEST_SKIP() << "OS memory provider is not supported!";
+    }
+
+    umf_disjoint_pool_params_handle_t params = nullptr;
+    ASSERT_SUCCESS(umfDisjointPoolParamsCreate(&params));
+    ASSERT_SUCCESS(umfDisjointPoolParamsSetTrace(params, 2));
+
+    ASSERT_EQ(umfDisjointPoolParamsSetBucketsPerPowerOf2(params, 0),
+              UMF_RESULT_ERROR_INVALID_ARGUMENT);
+    ASSERT_EQ(umfDisjointPoolParamsSetBucketsPerPowerOf2(params, 3),
+              UMF_RESULT_ERROR_INVALID_ARGUMENT);
+    ASSERT_EQ(umfDisjointPoolParamsSetBucketsPerPowerOf2(params, 32),
+              UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    const size_t alloc_size = 1100;
+    struct {
+        size_t buckets_per_pow2;
+        size_t buckets_count;
+        size_t bucket_size;
+    } configs[] = {
+        // 8, 12, 16, 24, ..., 1024, 1536, ...
+        {2, 57, 1536},
+        // 8, 12, 16, 20, ..., 32, 36, ..., 1024, 1152, ...
+        {8, 215, 1152},
+    };
+
+    for (const auto &config : configs) {
+        ASSERT_SUCCESS(umfDisjointPoolParamsSetBucketsPerPowerOf2(
+            params, config.buckets_per_pow2));
+
+        PoolWrapper poolWrapper(providerWrapper.get(), umfDisjointPoolOps(),
+                                params);
+
+        size_t count = 0;
+        ASSERT_SUCCESS(umfCtlGet("umf.pool.by_handle.{}.buckets.count", &count,
+                                 sizeof(count), poolWrapper.get()));
+        EXPECT_EQ(count, config.buckets_count);
+
+        void *ptr = umfPoolMalloc(poolWrapper.get(), alloc_size);
+        ASSERT_NE(ptr, nullptr);
+
+        size_t prev_size = 0;
+        size_t used_bucket = SIZE_MAX;
+        for (size_t i = 0; i < count; i++) {
+            size_t size = 0, alloc_nr = 0;
+            ASSERT_SUCCESS(umfCtlGet("umf.pool.by_handle.{}.buckets.{}.size",
+                                     &size, sizeof(size), poolWrapper.get(),
+                                     i));
+            EXPECT_GT(size, prev_size) << "Failed for bucket: " << i;
+            prev_size = size;
+
+            ASSERT_SUCCESS(umfCtlGet(
+                "umf.pool.by_handle.{}.buckets.{}.stats.alloc_nr", &alloc_nr,
+                sizeof(alloc_nr), poolWrapper.get(), i));
+            if (alloc_nr) {
+                EXPECT_EQ(used_bucket, SIZE_MAX);
+                EXPECT_EQ(size, config.bucket_size);
+                used_bucket = i;
+            }
+        }
+        ASSERT_NE(used_bucket, SIZE_MAX);
+
+        size_t wasted_bytes = 0;
+        ASSERT_SUCCESS(umfCtlGet(
+            "umf.pool.by_handle.{}.buckets.{}.stats.wasted_bytes",
+            &wasted_bytes, sizeof(wasted_bytes), poolWrapper.get(),
+            used_bucket));
+        EXPECT_EQ(wasted_bytes, config.bucket_size - alloc_size);
+
+        ASSERT_SUCCESS(umfCtlGet("umf.pool.by_handle.{}.stats.wasted_bytes",
+                                 &wasted_bytes, sizeof(wasted_bytes),
+                                 poolWrapper.get()));
+        EXPECT_EQ(wasted_bytes, config.bucket_size - alloc_size);
+
+        ASSERT_SUCCESS(umfPoolFree(poolWrapper.get(), ptr));
+
+        // only the chunks allocated at the moment waste memory
+        ASSERT_SUCCESS(umfCtlGet(
+            "umf.pool.by_handle.{}.buckets.{}.stats.wasted_bytes",
+            &wasted_bytes, sizeof(wasted_bytes), poolWrapper.get(),
+            used_bucket));
+        EXPECT_EQ(wasted_bytes, 0);
+    }
+
+    // Clean up
+    ASSERT_SUCCESS(umfDisjointPoolParamsDestroy(params));
+    ASSERT_SUCCESS(umfOsMemoryProviderParamsDestroy(os_memory_provider_params));
+}
+
+TEST_F(test, disjointCtlThreadCacheSize) {
+    umf_os_memory_provider_params_handle_t os_memory_provider_params = nullptr;
+    if (UMF_RESULT_ERROR_NOT_SUPPORTED ==
+        umfOsMemoryProviderParamsCreate(&os_memory_provider_params)) {
+        GTEST_SKIP() << "OS memory provider is not supported!";
+    }
+
+    ProviderWrapper providerWrapper(umfOsMemoryProviderOps(),
+                                    os_memory_provider_params);
+    if (providerWrapper.get() == NULL) {
+        GTEST_SKIP() << "OS memory provider is not supported!";
+    }
+
+    umf_disjoint_pool_params_handle_t params = nullptr;
+    ASSERT_SUCCESS(umfDisjointPoolParamsCreate(&params));
+    ASSERT_SUCCESS(umfDisjointPoolParamsSetThreadCacheSize(params, 8));
+
+    PoolWrapper poolWrapper(providerWrapper.get(), umfDisjointPoolOps(),
+                            params);
+
+    size_t tcache_size = 0;
+    ASSERT_SUCCESS(umfCtlGet("umf.pool.by_handle.{}.params.tcache_size",
+                             &tcache_size, sizeof(tcache_size),
+                             poolWrapper.get()));
+    ASSERT_EQ(tcache_size, 8ull);
+
+    size_t tcache_max_chunk_size = 0;
+    ASSERT_SUCCESS(
+        umfCtlGet("umf.pool.by_handle.{}.params.tcache_max_chunk_size",
+                  &tcache_max_chunk_size, sizeof(tcache_max_chunk_size),
+                  poolWrapper.get()));
+    ASSERT_EQ(tcache_max_chunk_size, 32 * 1024ull);
+
+    void *ptr = umfPoolMalloc(poolWrapper.get(), 1024ull);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_SUCCESS(umfPoolFree(poolWrapper.get(), ptr));
+
+    // chunks kept in the thread cache are still in use from the bucket
+    // point of view
+    size_t used_memory = 0;
+    ASSERT_SUCCESS(umfCtlGet("umf.pool.by_handle.{}.stats.used_memory",
+                             &used_memory, sizeof(used_memory),
+                             poolWrapper.get()));
+    ASSERT_EQ(used_memory, 4 * 1024ull);
+
+    // disabling the thread caches drains them
+    tcache_size = 0;
+    ASSERT_SUCCESS(umfCtlSet("umf.pool.by_handle.{}.params.tcache_size",
+                             &tcache_size, sizeof(tcache_size),
+                             poolWrapper.get()));
+    ASSERT_SUCCESS(umfCtlGet("umf.pool.by_handle.{}.stats.used_memory",
+                             &used_memory, sizeof(used_memory),
+                             poolWrapper.get()));
+    ASSERT_EQ(used_memory, 0ull);
+
+    ptr = umfPoolMalloc(poolWrapper.get(), 1024ull);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_SUCCESS(umfCtlGet("umf.pool.by_handle.{}.stats.used_memory",
+                             &used_memory, sizeof(used_memory),
+                             poolWrapper.get()));
+    ASSERT_EQ(used_memory, 1024ull);
+    ASSERT_SUCCESS(umfPoolFree(poolWrapper.get(), ptr));
+
+    // Clean up
+    ASSERT_SUCCESS(umfDisjointPoolParamsDestroy(params));
+    ASSERT_SUCCESS(umfOsMemoryProviderParamsDestroy(os_memory_provider_params));
+}
+
+TEST_F(test, disjointCtlDecayTime) {
+    umf_os_memory_provider_params_handle_t os_memory_provider_params = nullptr;
+    if (UMF_RESULT_ERROR_NOT_SUPPORTED ==
+        umfOsMemoryProviderParamsCreate(&os_memory_provider_params)) {
+        GTEST_SKIP() << "OS memory provider is not supported!";
+    }
+
+    ProviderWrapper providerWrapper(umfOsMemoryProviderOps(),
+                                    os_memory_provider_params);
+    if (providerWrapper.get() == NULL) {
+        GTEST_SKIP() << "OS memory provider is not supported!";
+    }
+
+    umf_disjoint_pool_params_handle_t params = nullptr;
+    ASSERT_SUCCESS(umfDisjointPoolParamsCreate(&params));
+    ASSERT_SUCCESS(umfDisjointPoolParamsSetDecayTime(params, 1000));
+    ASSERT_SUCCESS(umfDisjointPoolParamsSetBackgroundPurge(params, true));
+
+    PoolWrapper poolWrapper(providerWrapper.get(), umfDisjointPoolOps(),
+                            params);
+
+    size_t decay_ms = 0;
+    ASSERT_SUCCESS(umfCtlGet("umf.pool.by_handle.{}.params.decay_ms",
+                             &decay_ms, sizeof(decay_ms), poolWrapper.get()));
+    ASSERT_EQ(decay_ms, 1000ull);
+
+    // more empty slabs than the capacity are kept in the pool
+    const size_t alloc_size = 1024 * 1024;
+    std::vector<void *> ptrs;
+    for (size_t i = 0; i < 8; i++) {
+        void *ptr = umfPoolMalloc(poolWrapper.get(), alloc_size);
+        ASSERT_NE(ptr, nullptr);
+        ptrs.push_back(ptr);
+    }
+    for (void *ptr : ptrs) {
+        ASSERT_SUCCESS(umfPoolFree(poolWrapper.get(), ptr));
+    }
+
+    size_t reserved_memory = 0;
+    ASSERT_SUCCESS(umfCtlGet("umf.pool.by_handle.{}.stats.reserved_memory",
+                             &reserved_memory, sizeof(reserved_memory),
+                             poolWrapper.get()));
+    ASSERT_EQ(reserved_memory, 8 * alloc_size);
+
+    // with a short decay time the purger returns them to the provider
+    decay_ms = 1;
+    ASSERT_SUCCESS(umfCtlSet("umf.pool.by_handle.{}.params.decay_ms",
+                             &decay_ms, sizeof(decay_ms), poolWrapper.get()));
+    for (int i = 0; i < 1000 && reserved_memory > 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ASSERT_SUCCESS(umfCtlGet("umf.pool.by_handle.{}.stats.reserved_memory",
+                                 &reserved_memory, sizeof(reserved_memory),
+                                 poolWrapper.get()));
+    }
+    ASSERT_EQ(reserved_memory, 0ull);
+
+    // Clean up
+    ASSERT_SUCCESS(umfDisjointPoolParamsDestroy(params));
+    ASSERT_SUCCESS(umfOsMemoryProviderParamsDestroy(os_memory_provider_params));
+}
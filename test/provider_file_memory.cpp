@@ -2,6 +2,13 @@
 // Under the Apache License v2.0 with LLVM Exceptions. See LICENSE.TXT.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <chrono>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <umf/experimental/ctl.h>
 #include <umf/memory_provider.h>
 #include <umf/providers/provider_file_memory.h>
@@ -443,6 +450,184 @@ TEST_P(FileProviderParamsDefault, ctl_stats) {
     ASSERT_EQ(peak, 0u);
 }
 
+// lazy backing tests
+
+#define LAZY_FILE_PATH ((char *)"tmp_file_lazy")
+
+// size of the file space allocated for the file
+static size_t get_file_allocated_size(const char *path) {
+    struct stat st;
+    if (stat(path, &st)) {
+        return 0;
+    }
+
+    return (size_t)st.st_blocks * 512;
+}
+
+// check if the file system of the given path supports punching holes
+static bool is_punch_hole_supported(const char *path) {
+    int fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd == -1) {
+        return false;
+    }
+
+    int ret = ftruncate(fd, 4096);
+    if (ret == 0) {
+        ret = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0,
+                        4096);
+    }
+
+    close(fd);
+    unlink(path);
+
+    return (ret == 0);
+}
+
+// wait for the background thread punching holes
+static size_t wait_for_file_allocated_size_below(const char *path,
+                                                 size_t limit) {
+    size_t allocated = get_file_allocated_size(path);
+    for (int i = 0; i < 100 && allocated >= limit; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        allocated = get_file_allocated_size(path);
+    }
+
+    return allocated;
+}
+
+struct FileProviderLazyBacking : umf_test::test,
+                                 ::testing::WithParamInterface<bool> {
+    void SetUp() override {
+        test::SetUp();
+
+        if (!is_punch_hole_supported(LAZY_FILE_PATH)) {
+            GTEST_SKIP() << "Test skipped, punching holes is not supported";
+        }
+
+        // start with a new file
+        unlink(LAZY_FILE_PATH);
+
+        umf_file_memory_provider_params_handle_t params = nullptr;
+        umf_result_t umf_result =
+            umfFileMemoryProviderParamsCreate(LAZY_FILE_PATH, &params);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        auto params_handle = file_params_unique_handle_t(
+            params, &umfFileMemoryProviderParamsDestroy);
+
+        umf_result = umfFileMemoryProviderParamsSetVisibility(
+            params, UMF_MEM_MAP_SHARED);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+        umf_result = umfFileMemoryProviderParamsSetLazyBacking(params, true);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+        umf_result =
+            umfFileMemoryProviderParamsSetBackgroundPunch(params, GetParam());
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+        umf_result = umfMemoryProviderCreate(umfFileMemoryProviderOps(), params,
+                                             &provider);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_NE(provider, nullptr);
+    }
+
+    void TearDown() override {
+        if (provider) {
+            umfMemoryProviderDestroy(provider);
+        }
+
+        unlink(LAZY_FILE_PATH);
+        test::TearDown();
+    }
+
+    umf_memory_provider_handle_t provider = nullptr;
+};
+
+INSTANTIATE_TEST_SUITE_P(fileProviderTest, FileProviderLazyBacking,
+                         ::testing::Values(false, true),
+                         [](const ::testing::TestParamInfo<bool> &info) {
+                             return info.param ? "background" : "sync";
+                         });
+
+TEST_P(FileProviderLazyBacking, punch_holes) {
+    const size_t size = 16 * 1024 * 1024; // 16MB
+    void *ptr = nullptr;
+
+    umf_result_t umf_result = umfMemoryProviderAlloc(provider, size, 0, &ptr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_NE(ptr, nullptr);
+
+    // the file grows sparsely
+    ASSERT_LT(get_file_allocated_size(LAZY_FILE_PATH), size / 2);
+
+    memset(ptr, 0xAB, size);
+    ASSERT_GE(get_file_allocated_size(LAZY_FILE_PATH), size);
+
+    // the hole of the purged memory is punched right away
+    umf_result = umfMemoryProviderPurgeForce(provider, ptr, size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_LT(get_file_allocated_size(LAZY_FILE_PATH), size / 2);
+    ASSERT_EQ(((unsigned char *)ptr)[size / 2], 0);
+
+    memset(ptr, 0xAB, size);
+    ASSERT_GE(get_file_allocated_size(LAZY_FILE_PATH), size);
+
+    umf_result = umfMemoryProviderFree(provider, ptr, size);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    ASSERT_LT(wait_for_file_allocated_size_below(LAZY_FILE_PATH, size / 2),
+              size / 2);
+}
+
+TEST_P(FileProviderLazyBacking, reuse_freed_memory) {
+    const size_t size = 4 * 1024 * 1024; // 4MB
+
+    for (int i = 0; i < 10; i++) {
+        void *ptr = nullptr;
+        umf_result_t umf_result =
+            umfMemoryProviderAlloc(provider, size, 0, &ptr);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_NE(ptr, nullptr);
+
+        memset(ptr, i, size);
+
+        umf_result = umfMemoryProviderFree(provider, ptr, size);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+        // the same memory is allocated again before its hole is punched
+        // by the background thread - the hole must not be punched anymore
+        void *new_ptr = nullptr;
+        umf_result = umfMemoryProviderAlloc(provider, size, 0, &new_ptr);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_NE(new_ptr, nullptr);
+
+        memset(new_ptr, 0x5A, size);
+
+        // free another block and wait until its hole is punched,
+        // so the queued holes have been punched at least once since
+        void *other_ptr = nullptr;
+        umf_result = umfMemoryProviderAlloc(provider, size, 0, &other_ptr);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_NE(other_ptr, nullptr);
+
+        memset(other_ptr, 0x77, size);
+
+        umf_result = umfMemoryProviderFree(provider, other_ptr, size);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+        ASSERT_LT(wait_for_file_allocated_size_below(LAZY_FILE_PATH,
+                                                     size + size / 2),
+                  size + size / 2);
+
+        for (size_t j = 0; j < size; j += 512) {
+            ASSERT_EQ(((unsigned char *)new_ptr)[j], 0x5A);
+        }
+
+        umf_result = umfMemoryProviderFree(provider, new_ptr, size);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+}
+
 // other negative tests
 
 TEST_F(test, params_null_handle) {
@@ -463,6 +648,12 @@ TEST_F(test, params_null_handle) {
     umf_result =
         umfFileMemoryProviderParamsSetVisibility(nullptr, UMF_MEM_MAP_PRIVATE);
     ASSERT_EQ(umf_result, UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    umf_result = umfFileMemoryProviderParamsSetLazyBacking(nullptr, true);
+    ASSERT_EQ(umf_result, UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    umf_result = umfFileMemoryProviderParamsSetBackgroundPunch(nullptr, true);
+    ASSERT_EQ(umf_result, UMF_RESULT_ERROR_INVALID_ARGUMENT);
 }
 
 TEST_F(test, create_empty_path) {
@@ -382,6 +382,54 @@ TEST_P(FixedProviderTest, ctl_stats) {
     ASSERT_EQ(peak, 0u);
 }
 
+TEST_P(FixedProviderTest, ctl_defrag) {
+    // | head | u | free | u | free (tail) |
+    void *ptrs[3];
+    for (int i = 0; i < 3; i++) {
+        umf_result_t ret =
+            umfMemoryProviderAlloc(provider.get(), page_size, 0, &ptrs[i]);
+        ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+        ASSERT_NE(ptrs[i], nullptr);
+    }
+
+    umf_result_t ret =
+        umfMemoryProviderFree(provider.get(), ptrs[1], page_size);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+
+    // the buffer does not have to be page-aligned,
+    // so there may be a free block before the first allocation
+    size_t head = (char *)ptrs[0] - (char *)memory_buffer;
+    size_t tail = memory_size - head - 3 * page_size;
+
+    size_t histogram[64];
+    ret = umfCtlGet("umf.provider.by_handle.{}.defrag.free_histogram",
+                    histogram, sizeof(histogram), provider.get());
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+
+    size_t num_free_blocks = 0;
+    for (size_t i = 0; i < 64; i++) {
+        num_free_blocks += histogram[i];
+    }
+    ASSERT_EQ(num_free_blocks, (head ? 3u : 2u));
+
+    umf_compaction_hint_t hints[3];
+    ret = umfCtlGet("umf.provider.by_handle.{}.defrag.hints", hints,
+                    sizeof(hints), provider.get());
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(hints[0].ptr, ptrs[2]);
+    ASSERT_EQ(hints[0].size, page_size);
+    ASSERT_EQ(hints[0].coalesced_size, 2 * page_size + tail);
+    ASSERT_EQ(hints[1].ptr, ptrs[0]);
+    ASSERT_EQ(hints[1].coalesced_size, head + 2 * page_size);
+    ASSERT_EQ(hints[2].ptr, nullptr);
+    ASSERT_EQ(hints[2].coalesced_size, 0u);
+
+    ret = umfMemoryProviderFree(provider.get(), ptrs[0], page_size);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+    ret = umfMemoryProviderFree(provider.get(), ptrs[2], page_size);
+    ASSERT_EQ(ret, UMF_RESULT_SUCCESS);
+}
+
 // Params tests
 
 TEST_F(test, params_null_handle) {
@@ -2,11 +2,18 @@
 // Under the Apache License v2.0 with LLVM Exceptions. See LICENSE.TXT.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 #include <umf/memory_provider.h>
+#include <umf/pools/pool_disjoint.h>
 #include <umf/pools/pool_proxy.h>
 #include <umf/providers/provider_fixed_memory.h>
+#include <umf/providers/provider_os_memory.h>
 
 #include "base.hpp"
+#include "provider/provider_tracking.h"
 #include "provider.hpp"
 #include "test_helpers.h"
 #include "utils/cpp_helpers.hpp"
@@ -14,6 +21,7 @@
 #include "test_helpers_linux.h"
 #endif
 
+using umf_test::KB;
 using umf_test::test;
 
 #define FIXED_BUFFER_SIZE (512 * utils_get_page_size())
@@ -179,6 +187,95 @@ TEST_P(TrackingProviderTest, half_size_success) {
     ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
 }
 
+TEST_P(TrackingProviderTest, pool_by_ptr_after_changes) {
+    umf_result_t umf_result;
+    umf_memory_pool_handle_t poolFromPtr = nullptr;
+    umf_memory_pool_handle_t pool0 = pool.get();
+
+    size_t size0 = FIXED_BUFFER_SIZE - (2 * page_size);
+    void *ptr0 = umfPoolAlignedMalloc(pool0, size0, utils_get_page_size());
+    ASSERT_NE(ptr0, nullptr);
+
+    // repeated lookups of the same pointer are served from the lookup cache
+    for (int i = 0; i < 2; i++) {
+        umf_result = umfPoolByPtr(ptr0, &poolFromPtr);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_EQ(poolFromPtr, pool0);
+    }
+
+    umf_memory_provider_handle_t provider1 = nullptr;
+    umf_memory_pool_handle_t pool1 = nullptr;
+    createPoolFromAllocation(ptr0, size0, &provider1, &pool1);
+
+    // a nested allocation at the same address hides the cached one
+    void *ptr1 = umfPoolMalloc(pool1, size0 / 2);
+    ASSERT_NE(ptr1, nullptr);
+
+    umf_result = umfPoolByPtr(ptr1, &poolFromPtr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(poolFromPtr, pool1);
+
+    umf_result = umfPoolFree(pool1, ptr1);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_result = umfPoolByPtr(ptr1, &poolFromPtr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(poolFromPtr, pool0);
+
+    umf_result = umfPoolDestroy(pool1);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    umf_result = umfMemoryProviderDestroy(provider1);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_result = umfPoolFree(pool0, ptr0);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_result = umfPoolByPtr(ptr0, &poolFromPtr);
+    ASSERT_NE(umf_result, UMF_RESULT_SUCCESS);
+}
+
+TEST_P(TrackingProviderTest, pool_by_ptr_nested_after_parent) {
+    umf_result_t umf_result;
+    umf_memory_pool_handle_t poolFromPtr = nullptr;
+    umf_memory_pool_handle_t pool0 = pool.get();
+
+    size_t size0 = FIXED_BUFFER_SIZE - (2 * page_size);
+    void *ptr0 = umfPoolAlignedMalloc(pool0, size0, utils_get_page_size());
+    ASSERT_NE(ptr0, nullptr);
+
+    size_t size1 = 16 * page_size;
+    umf_memory_provider_handle_t provider1 = nullptr;
+    umf_memory_pool_handle_t pool1 = nullptr;
+    createPoolFromAllocation(ptr0, size1, &provider1, &pool1);
+
+    void *ptr1 = umfPoolMalloc(pool1, size1);
+    ASSERT_NE(ptr1, nullptr);
+
+    // a pointer of the parent region outside of the nested one,
+    // using the same entry of the lookup cache as ptr1
+    void *ptr_parent = (char *)ptr1 + 64 * 4096;
+    ASSERT_LE((char *)ptr_parent, (char *)ptr0 + size0 - 1);
+
+    umf_result = umfPoolByPtr(ptr_parent, &poolFromPtr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(poolFromPtr, pool0);
+
+    umf_result = umfPoolByPtr(ptr1, &poolFromPtr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(poolFromPtr, pool1);
+
+    umf_result = umfPoolFree(pool1, ptr1);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_result = umfPoolDestroy(pool1);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    umf_result = umfMemoryProviderDestroy(provider1);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_result = umfPoolFree(pool0, ptr0);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+}
+
 TEST_P(TrackingProviderTest, failure_exceeding_size) {
     umf_result_t umf_result;
     size_t size0;
@@ -212,7 +309,7 @@ TEST_P(TrackingProviderTest, failure_exceeding_size) {
 
 #define MAX_ARRAY 9
 #define TEST_LEVEL_SUCCESS 7
-#define TEST_LEVEL_FAILURE 8
+#define TEST_LEVEL_DEEP 32
 
 TEST_P(TrackingProviderTest, success_max_levels) {
     umf_result_t umf_result;
@@ -254,18 +351,18 @@ TEST_P(TrackingProviderTest, success_max_levels) {
     }
 }
 
-TEST_P(TrackingProviderTest, failure_exceeding_levels) {
+TEST_P(TrackingProviderTest, success_deep_levels) {
     umf_result_t umf_result;
     size_t size;
-    void *ptr[MAX_ARRAY] = {0};
-    umf_memory_provider_handle_t providers[MAX_ARRAY] = {0};
-    umf_memory_pool_handle_t pools[MAX_ARRAY] = {0};
+    void *ptr[TEST_LEVEL_DEEP + 1] = {0};
+    umf_memory_provider_handle_t providers[TEST_LEVEL_DEEP + 1] = {0};
+    umf_memory_pool_handle_t pools[TEST_LEVEL_DEEP + 1] = {0};
 
     size = FIXED_BUFFER_SIZE - (2 * page_size);
     pools[0] = pool.get();
 
-    for (int i = 0; i < TEST_LEVEL_FAILURE; i++) {
-        fprintf(stderr, "Alloc #%d\n", i);
+    // the number of levels of nested pools is not limited
+    for (int i = 0; i < TEST_LEVEL_DEEP; i++) {
         ptr[i] = umfPoolAlignedMalloc(pools[i], size, utils_get_page_size());
         ASSERT_NE(ptr[i], nullptr);
 
@@ -273,19 +370,28 @@ TEST_P(TrackingProviderTest, failure_exceeding_levels) {
                                  &pools[i + 1]);
     }
 
-    // tracker level is too high
-    int f = TEST_LEVEL_FAILURE;
-    fprintf(stderr, "Alloc #%d\n", f);
-    ptr[f] = umfPoolAlignedMalloc(pools[f], size, utils_get_page_size());
-    ASSERT_EQ(ptr[f], nullptr);
+    int d = TEST_LEVEL_DEEP;
+    ptr[d] = umfPoolAlignedMalloc(pools[d], size, utils_get_page_size());
+    ASSERT_NE(ptr[d], nullptr);
 
-    for (int i = TEST_LEVEL_FAILURE - 1; i >= 0; i--) {
+    umf_memory_pool_handle_t poolFromPtr = nullptr;
+    umf_result = umfPoolByPtr(ptr[d], &poolFromPtr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(poolFromPtr, pools[d]);
+
+    umf_result = umfPoolFree(pools[d], ptr[d]);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    for (int i = TEST_LEVEL_DEEP - 1; i >= 0; i--) {
         umf_result = umfPoolDestroy(pools[i + 1]);
         ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
         umf_result = umfMemoryProviderDestroy(providers[i + 1]);
         ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
 
-        fprintf(stderr, "Free #%d\n", i);
+        umf_result = umfPoolByPtr(ptr[i], &poolFromPtr);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_EQ(poolFromPtr, pools[i]);
+
         umf_result = umfPoolFree(pools[i], ptr[i]);
         ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
     }
@@ -371,3 +477,407 @@ TEST_P(TrackingProviderTest, reverted_free_the_same_size) {
     // so we cannot verify the result here.
     umf_result = umfPoolFree(pool0, ptr0);
 }
+
+TEST_P(TrackingProviderTest, split_merge_multithreaded) {
+    const int nthreads = 4;
+    const int iterations = 1000;
+    umf_memory_pool_handle_t hPool = pool.get();
+
+    umf_memory_provider_handle_t hTracking = nullptr;
+    umf_result_t umf_result = umfTrackingMemoryProviderCreate(
+        provider.get(), hPool, false, &hTracking);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    size_t size = 4 * page_size;
+    std::vector<void *> ptrs(nthreads, nullptr);
+    for (int i = 0; i < nthreads; i++) {
+        umf_result =
+            umfMemoryProviderAlloc(hTracking, size, page_size, &ptrs[i]);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_NE(ptrs[i], nullptr);
+    }
+
+    // splits and merges of different regions run in parallel
+    std::vector<std::thread> threads;
+    std::vector<int> failures(nthreads, 0);
+    for (int t = 0; t < nthreads; t++) {
+        threads.emplace_back([&, t] {
+            void *ptr = ptrs[t];
+            void *highPtr = (void *)((uintptr_t)ptr + size / 2);
+            for (int i = 0; i < iterations; i++) {
+                umf_memory_pool_handle_t poolFromPtr = nullptr;
+                if (umfMemoryProviderAllocationSplit(hTracking, ptr, size,
+                                                     size / 2) !=
+                        UMF_RESULT_SUCCESS ||
+                    umfPoolByPtr(highPtr, &poolFromPtr) !=
+                        UMF_RESULT_SUCCESS ||
+                    poolFromPtr != hPool ||
+                    umfMemoryProviderAllocationMerge(hTracking, ptr, highPtr,
+                                                     size) !=
+                        UMF_RESULT_SUCCESS) {
+                    failures[t]++;
+                    return;
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (int t = 0; t < nthreads; t++) {
+        ASSERT_EQ(failures[t], 0);
+        umf_result = umfMemoryProviderFree(hTracking, ptrs[t], size);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    umfMemoryProviderDestroy(hTracking);
+}
+
+TEST_P(TrackingProviderTest, alloc_free_batch) {
+    const size_t num = 100;
+    umf_memory_pool_handle_t hPool = pool.get();
+
+    umf_memory_provider_handle_t hTracking = nullptr;
+    umf_result_t umf_result = umfTrackingMemoryProviderCreate(
+        provider.get(), hPool, false, &hTracking);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    std::vector<void *> ptrs(num, nullptr);
+    umf_result = umfTrackingMemoryProviderAllocBatch(hTracking, page_size, 0,
+                                                     num, ptrs.data());
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    for (size_t i = 0; i < num; i++) {
+        ASSERT_NE(ptrs[i], nullptr);
+
+        umf_memory_pool_handle_t poolFromPtr = nullptr;
+        umf_result = umfPoolByPtr(ptrs[i], &poolFromPtr);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_EQ(poolFromPtr, hPool);
+    }
+
+    umf_result = umfTrackingMemoryProviderFreeBatch(hTracking, ptrs.data(),
+                                                    page_size, num);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    for (size_t i = 0; i < num; i++) {
+        umf_memory_pool_handle_t poolFromPtr = nullptr;
+        umf_result = umfPoolByPtr(ptrs[i], &poolFromPtr);
+        ASSERT_NE(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    // the batch is all-or-nothing
+    size_t too_many = memory_size / page_size + 1;
+    ptrs.resize(too_many);
+    umf_result = umfTrackingMemoryProviderAllocBatch(hTracking, page_size, 0,
+                                                     too_many, ptrs.data());
+    ASSERT_NE(umf_result, UMF_RESULT_SUCCESS);
+
+    for (size_t i = 0; i < too_many - 1; i++) {
+        umf_memory_pool_handle_t poolFromPtr = nullptr;
+        umf_result = umfPoolByPtr(ptrs[i], &poolFromPtr);
+        ASSERT_NE(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    umfMemoryProviderDestroy(hTracking);
+}
+
+TEST_P(TrackingProviderTest, get_tracked_regions) {
+    const size_t num = 10;
+    umf_memory_pool_handle_t pool0 = pool.get();
+
+    std::vector<void *> ptrs(num, nullptr);
+    for (size_t i = 0; i < num; i++) {
+        ptrs[i] = umfPoolMalloc(pool0, page_size);
+        ASSERT_NE(ptrs[i], nullptr);
+    }
+    std::sort(ptrs.begin(), ptrs.end());
+
+    // all regions of the pool in batches smaller than their number
+    std::vector<void *> found;
+    umf_pool_region_t regions[3];
+    void *cursor = nullptr;
+    do {
+        size_t count = sizeof(regions) / sizeof(regions[0]);
+        umf_result_t umf_result = umfPoolGetTrackedRegions(
+            pool0, &cursor, nullptr, regions, &count);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_EQ(regions[i].size, page_size);
+            ASSERT_EQ(regions[i].pool, pool0);
+            found.push_back(regions[i].ptr);
+        }
+    } while (cursor);
+    ASSERT_EQ(found, ptrs);
+
+    // regions in the range [ptrs[2], ptrs[5])
+    cursor = ptrs[2];
+    size_t count = sizeof(regions) / sizeof(regions[0]);
+    umf_result_t umf_result =
+        umfPoolGetTrackedRegions(pool0, &cursor, ptrs[5], regions, &count);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(count, 3);
+    ASSERT_EQ(cursor, nullptr);
+    for (size_t i = 0; i < count; i++) {
+        ASSERT_EQ(regions[i].ptr, ptrs[i + 2]);
+    }
+
+    // a nested region starting at the same address as its parent
+    umf_memory_provider_handle_t provider1 = nullptr;
+    umf_memory_pool_handle_t pool1 = nullptr;
+    createPoolFromAllocation(ptrs[0], page_size, &provider1, &pool1);
+    void *ptr1 = umfPoolMalloc(pool1, page_size);
+    ASSERT_EQ(ptr1, ptrs[0]);
+
+    // the parent and the nested region do not fit in one batch
+    cursor = ptrs[0];
+    count = 1;
+    umf_result =
+        umfPoolGetTrackedRegions(nullptr, &cursor, ptrs[1], regions, &count);
+    ASSERT_EQ(umf_result, UMF_RESULT_ERROR_INVALID_ARGUMENT);
+
+    // they are not split between batches
+    count = 2;
+    umf_result =
+        umfPoolGetTrackedRegions(nullptr, &cursor, ptrs[1], regions, &count);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(cursor, nullptr);
+    ASSERT_EQ(regions[0].pool, pool0);
+    ASSERT_EQ(regions[1].pool, pool1);
+    ASSERT_EQ(regions[1].ptr, ptrs[0]);
+
+    // only the nested region belongs to pool1
+    cursor = nullptr;
+    count = 2;
+    umf_result =
+        umfPoolGetTrackedRegions(pool1, &cursor, nullptr, regions, &count);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(regions[0].ptr, ptr1);
+
+    umf_result = umfPoolFree(pool1, ptr1);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    umfPoolDestroy(pool1);
+    umfMemoryProviderDestroy(provider1);
+
+    for (size_t i = 0; i < num; i++) {
+        umf_result = umfPoolFree(pool0, ptrs[i]);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    cursor = nullptr;
+    count = 1;
+    umf_result =
+        umfPoolGetTrackedRegions(pool0, &cursor, nullptr, regions, &count);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(count, 0);
+    ASSERT_EQ(cursor, nullptr);
+}
+
+TEST_P(TrackingProviderTest, coarse_tracking) {
+    const size_t num = 1000;
+    const size_t large_size = 1024 * 1024;
+
+    umf_os_memory_provider_params_handle_t os_params = nullptr;
+    umf_result_t umf_result = umfOsMemoryProviderParamsCreate(&os_params);
+    if (umf_result == UMF_RESULT_ERROR_NOT_SUPPORTED) {
+        GTEST_SKIP() << "OS memory provider is not supported!";
+    }
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_memory_provider_handle_t hProvider = nullptr;
+    umf_result = umfMemoryProviderCreate(umfOsMemoryProviderOps(), os_params,
+                                         &hProvider);
+    umfOsMemoryProviderParamsDestroy(os_params);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_disjoint_pool_params_handle_t disjoint_params = nullptr;
+    umf_result = umfDisjointPoolParamsCreate(&disjoint_params);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_memory_pool_handle_t hPool = nullptr;
+    umf_result = umfPoolCreate(umfDisjointPoolOps(), hProvider,
+                               disjoint_params,
+                               UMF_POOL_CREATE_FLAG_COARSE_TRACKING, &hPool);
+    umfDisjointPoolParamsDestroy(disjoint_params);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    // small allocations of different size classes
+    std::vector<void *> ptrs(num, nullptr);
+    for (size_t i = 0; i < num; i++) {
+        ptrs[i] = umfPoolMalloc(hPool, 64 * (1 + i % 8));
+        ASSERT_NE(ptrs[i], nullptr);
+
+        umf_memory_pool_handle_t poolFromPtr = nullptr;
+        umf_result = umfPoolByPtr(ptrs[i], &poolFromPtr);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+        ASSERT_EQ(poolFromPtr, hPool);
+    }
+
+    // all slabs are carved out of a single chunk
+    umf_pool_region_t regions[4];
+    size_t count = sizeof(regions) / sizeof(regions[0]);
+    void *cursor = nullptr;
+    umf_result =
+        umfPoolGetTrackedRegions(hPool, &cursor, nullptr, regions, &count);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(cursor, nullptr);
+
+    // large allocations are tracked on their own
+    void *large = umfPoolMalloc(hPool, large_size);
+    ASSERT_NE(large, nullptr);
+
+    umf_memory_pool_handle_t poolFromPtr = nullptr;
+    umf_result = umfPoolByPtr((char *)large + large_size - 1, &poolFromPtr);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(poolFromPtr, hPool);
+
+    count = sizeof(regions) / sizeof(regions[0]);
+    umf_result =
+        umfPoolGetTrackedRegions(hPool, &cursor, nullptr, regions, &count);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    ASSERT_EQ(count, 2);
+
+    umf_result = umfPoolFree(hPool, large);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    for (size_t i = 0; i < num; i++) {
+        umf_result = umfPoolFree(hPool, ptrs[i]);
+        ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    }
+
+    umfPoolDestroy(hPool);
+    umfMemoryProviderDestroy(hProvider);
+}
+
+// Creates a disjoint pool with coarse tracking on top of the OS provider,
+// allocations greater than 64 KB go directly to the provider
+static void createCoarseTrackingPool(umf_memory_provider_handle_t *hProvider,
+                                     umf_memory_pool_handle_t *hPool) {
+    umf_os_memory_provider_params_handle_t os_params = nullptr;
+    umf_result_t umf_result = umfOsMemoryProviderParamsCreate(&os_params);
+    if (umf_result == UMF_RESULT_ERROR_NOT_SUPPORTED) {
+        GTEST_SKIP() << "OS memory provider is not supported!";
+    }
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_result = umfMemoryProviderCreate(umfOsMemoryProviderOps(), os_params,
+                                         hProvider);
+    umfOsMemoryProviderParamsDestroy(os_params);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_disjoint_pool_params_handle_t disjoint_params = nullptr;
+    umf_result = umfDisjointPoolParamsCreate(&disjoint_params);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    umf_result =
+        umfDisjointPoolParamsSetMaxPoolableSize(disjoint_params, 64 * KB);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+
+    umf_result = umfPoolCreate(umfDisjointPoolOps(), *hProvider,
+                               disjoint_params,
+                               UMF_POOL_CREATE_FLAG_COARSE_TRACKING, hPool);
+    umfDisjointPoolParamsDestroy(disjoint_params);
+    ASSERT_EQ(umf_result, UMF_RESULT_SUCCESS);
+}
+
+static size_t countTrackedRegions(umf_memory_pool_handle_t hPool) {
+    umf_pool_region_t regions[8];
+    size_t count = sizeof(regions) / sizeof(regions[0]);
+    void *cursor = nullptr;
+    umf_result_t umf_result =
+        umfPoolGetTrackedRegions(hPool, &cursor, nullptr, regions, &count);
+    EXPECT_EQ(umf_result, UMF_RESULT_SUCCESS);
+    EXPECT_EQ(cursor, nullptr);
+    return count;
+}
+
+TEST_P(TrackingProviderTest, coarse_tracking_realloc) {
+    umf_memory_provider_handle_t hProvider = nullptr;
+    umf_memory_pool_handle_t hPool = nullptr;
+    createCoarseTrackingPool(&hProvider, &hPool);
+    if (IsSkipped() || HasFatalFailure()) {
+        return;
+    }
+
+    // allocations carved out of the same chunk
+    const size_t num = 4;
+    const size_t sizes[] = {100 * KB, 32 * KB, 300 * KB, 100 * KB, 4 * KB};
+    std::vector<char *> ptrs(num, nullptr);
+    for (size_t i = 0; i < num; i++) {
+        ptrs[i] = (char *)umfPoolMalloc(hPool, sizes[0]);
+        ASSERT_NE(ptrs[i], nullptr);
+        memset(ptrs[i], (int)i, sizes[0]);
+    }
+
+    // every realloc keeps the data and does not overwrite other allocations
+    size_t old_size = sizes[0];
+    for (size_t s = 1; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        char *ptr = (char *)umfPoolRealloc(hPool, ptrs[0], sizes[s]);
+        ASSERT_NE(ptr, nullptr);
+        for (size_t j = 0; j < std::min(old_size, sizes[s]); j++) {
+            ASSERT_EQ(ptr[j], 0);
+        }
+
+        memset(ptr, 0, sizes[s]);
+        for (size_t i = 1; i < num; i++) {
+            for (size_t j = 0; j < sizes[0]; j++) {
+                ASSERT_EQ(ptrs[i][j], (char)i);
+            }
+        }
+
+        ptrs[0] = ptr;
+        old_size = sizes[s];
+    }
+
+    for (size_t i = 0; i < num; i++) {
+        ASSERT_EQ(umfPoolFree(hPool, ptrs[i]), UMF_RESULT_SUCCESS);
+    }
+
+    umfPoolDestroy(hPool);
+    umfMemoryProviderDestroy(hProvider);
+}
+
+TEST_P(TrackingProviderTest, coarse_tracking_reuse) {
+    umf_memory_provider_handle_t hProvider = nullptr;
+    umf_memory_pool_handle_t hPool = nullptr;
+    createCoarseTrackingPool(&hProvider, &hPool);
+    if (IsSkipped() || HasFatalFailure()) {
+        return;
+    }
+
+    // 8 allocations of 128 KB fit in one chunk of 2 MB
+    const size_t size = 128 * KB;
+    const size_t num = 8;
+    std::vector<void *> ptrs(num, nullptr);
+    for (size_t i = 0; i < num; i++) {
+        ptrs[i] = umfPoolMalloc(hPool, size);
+        ASSERT_NE(ptrs[i], nullptr);
+    }
+    ASSERT_EQ(countTrackedRegions(hPool), 1);
+
+    // the space freed in the chunk is reused,
+    // although the chunk still has live allocations
+    for (size_t round = 0; round < 4; round++) {
+        for (size_t i = round % 2; i < num; i += 2) {
+            ASSERT_EQ(umfPoolFree(hPool, ptrs[i]), UMF_RESULT_SUCCESS);
+        }
+
+        for (size_t i = round % 2; i < num; i += 2) {
+            ptrs[i] = umfPoolMalloc(hPool, size);
+            ASSERT_NE(ptrs[i], nullptr);
+        }
+
+        ASSERT_EQ(countTrackedRegions(hPool), 1);
+    }
+
+    for (size_t i = 0; i < num; i++) {
+        ASSERT_EQ(umfPoolFree(hPool, ptrs[i]), UMF_RESULT_SUCCESS);
+    }
+
+    umfPoolDestroy(hPool);
+    umfMemoryProviderDestroy(hProvider);
+}
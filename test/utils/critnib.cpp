@@ -0,0 +1,251 @@
+// Copyright (C) 2025 Intel Corporation
+// Under the Apache License v2.0 with LLVM Exceptions. See LICENSE.TXT.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <atomic>
+#include <cerrno>
+#include <thread>
+#include <vector>
+
+#include "base.hpp"
+#include "critnib/critnib.h"
+
+using umf_test::test;
+
+static constexpr size_t NTHREADS = 8;
+static constexpr uintptr_t KEYS_PER_THREAD = 4096;
+
+// keys of different threads interleave, so all threads work on the same nodes
+static uintptr_t test_key(size_t thread, uintptr_t i) {
+    return (i * NTHREADS + thread + 1) << 6;
+}
+
+static void *test_value(uintptr_t key) { return (void *)(key | 1); }
+
+TEST_F(test, critnibInsertGet) {
+    critnib *c = critnib_new(NULL, NULL);
+    ASSERT_NE(c, nullptr);
+
+    for (uintptr_t i = 0; i < KEYS_PER_THREAD; i++) {
+        uintptr_t key = test_key(0, i);
+        ASSERT_EQ(critnib_insert(c, key, test_value(key), 0), 0);
+    }
+
+    uintptr_t key = test_key(0, 0);
+    ASSERT_EQ(critnib_insert(c, key, test_value(key), 0), EEXIST);
+
+    for (uintptr_t i = 0; i < KEYS_PER_THREAD; i++) {
+        key = test_key(0, i);
+        ASSERT_EQ(critnib_get(c, key, NULL), test_value(key));
+        ASSERT_EQ(critnib_find_le(c, key + 1, NULL), test_value(key));
+    }
+
+    for (uintptr_t i = 0; i < KEYS_PER_THREAD; i += 2) {
+        ASSERT_EQ(critnib_remove_release(c, test_key(0, i)), 0);
+    }
+
+    for (uintptr_t i = 0; i < KEYS_PER_THREAD; i++) {
+        key = test_key(0, i);
+        ASSERT_EQ(critnib_get(c, key, NULL),
+                  (i % 2) ? test_value(key) : nullptr);
+    }
+
+    critnib_delete(c);
+}
+
+TEST_F(test, critnibInsertBatch) {
+    critnib *c = critnib_new(NULL, NULL);
+    ASSERT_NE(c, nullptr);
+
+    std::vector<uintptr_t> keys;
+    std::vector<void *> values;
+    for (uintptr_t i = 0; i < KEYS_PER_THREAD; i++) {
+        keys.push_back(test_key(0, i));
+        values.push_back(test_value(keys.back()));
+    }
+
+    int err = -1;
+    ASSERT_EQ(critnib_insert_batch(c, keys.data(), values.data(), keys.size(),
+                                   &err),
+              keys.size());
+    ASSERT_EQ(err, 0);
+
+    for (uintptr_t key : keys) {
+        ASSERT_EQ(critnib_get(c, key, NULL), test_value(key));
+    }
+
+    // the batch stops at the first key which already exists
+    uintptr_t new_key = test_key(1, 0);
+    uintptr_t batch_keys[] = {new_key, keys[1], test_key(1, 1)};
+    void *batch_values[] = {test_value(batch_keys[0]),
+                            test_value(batch_keys[1]),
+                            test_value(batch_keys[2])};
+    ASSERT_EQ(critnib_insert_batch(c, batch_keys, batch_values, 3, &err), 1u);
+    ASSERT_EQ(err, EEXIST);
+    ASSERT_EQ(critnib_get(c, new_key, NULL), test_value(new_key));
+    ASSERT_EQ(critnib_get(c, batch_keys[2], NULL), nullptr);
+
+    critnib_delete(c);
+}
+
+TEST_F(test, critnibConcurrentInsertRemove) {
+    critnib *c = critnib_new(NULL, NULL);
+    ASSERT_NE(c, nullptr);
+
+    // every thread inserts its keys and removes every other one, so inserts
+    // run concurrently with each other and with node collapses of removes
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < NTHREADS; t++) {
+        threads.emplace_back([c, t] {
+            for (uintptr_t i = 0; i < KEYS_PER_THREAD; i++) {
+                uintptr_t key = test_key(t, i);
+                ASSERT_EQ(critnib_insert(c, key, test_value(key), 0), 0);
+                if (i % 2) {
+                    ASSERT_EQ(critnib_remove_release(c, test_key(t, i - 1)),
+                              0);
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (size_t t = 0; t < NTHREADS; t++) {
+        for (uintptr_t i = 0; i < KEYS_PER_THREAD; i++) {
+            uintptr_t key = test_key(t, i);
+            ASSERT_EQ(critnib_get(c, key, NULL),
+                      (i % 2) ? test_value(key) : nullptr);
+        }
+    }
+
+    critnib_delete(c);
+}
+
+TEST_F(test, critnibRemovedItemsReused) {
+    critnib *c = critnib_new(NULL, NULL);
+    ASSERT_NE(c, nullptr);
+
+    // every round creates a node and collapses it, the nodes and leaves
+    // are reused after their grace period, as no insert is in flight
+    uintptr_t key1 = test_key(0, 0);
+    uintptr_t key2 = test_key(0, 1);
+    size_t usage = 0;
+    for (size_t round = 0; round < 4096; round++) {
+        if (round == 256) {
+            usage = critnib_memory_usage(c);
+        }
+
+        ASSERT_EQ(critnib_insert(c, key1, test_value(key1), 0), 0);
+        ASSERT_EQ(critnib_insert(c, key2, test_value(key2), 0), 0);
+        ASSERT_EQ(critnib_remove_release(c, key1), 0);
+        ASSERT_EQ(critnib_remove_release(c, key2), 0);
+    }
+    ASSERT_EQ(critnib_memory_usage(c), usage);
+
+    critnib_delete(c);
+}
+
+// values of a critnib with cb_free_leaf(), which are only marked as freed
+struct freed_value {
+    std::atomic<int> freed{0};
+};
+
+static void mark_freed(void *leaf_allocator, void *ptr) {
+    (void)leaf_allocator;
+    ((freed_value *)ptr)->freed++;
+}
+
+TEST_F(test, critnibReleaseDefersFree) {
+    static constexpr uintptr_t NKEYS = 64;
+    std::vector<freed_value> values(2 * NKEYS + 1);
+    critnib *c = critnib_new(mark_freed, NULL);
+    ASSERT_NE(c, nullptr);
+
+    uintptr_t key = test_key(0, 2 * NKEYS);
+    ASSERT_EQ(critnib_insert(c, key, &values[2 * NKEYS], 0), 0);
+
+    void *ref = NULL;
+    ASSERT_EQ(critnib_get(c, key, &ref), &values[2 * NKEYS]);
+    ASSERT_NE(ref, nullptr);
+    ASSERT_EQ(critnib_remove_release(c, key), 0);
+
+    // the value is referenced, so no number of removes can free it
+    for (uintptr_t i = 0; i < NKEYS; i++) {
+        ASSERT_EQ(critnib_insert(c, test_key(0, i), &values[i], 0), 0);
+        ASSERT_EQ(critnib_remove_release(c, test_key(0, i)), 0);
+    }
+    ASSERT_EQ(values[2 * NKEYS].freed.load(), 0);
+
+    ASSERT_EQ(critnib_release(c, ref), 0);
+
+    // the value is freed by one of the following removes
+    for (uintptr_t i = 0; i < NKEYS; i++) {
+        ASSERT_EQ(critnib_insert(c, test_key(0, i), &values[NKEYS + i], 0),
+                  0);
+        ASSERT_EQ(critnib_remove_release(c, test_key(0, i)), 0);
+    }
+    ASSERT_EQ(values[2 * NKEYS].freed.load(), 1);
+
+    critnib_delete(c);
+
+    for (auto &value : values) {
+        ASSERT_EQ(value.freed.load(), 1);
+    }
+}
+
+TEST_F(test, critnibConcurrentGetRemove) {
+    static constexpr uintptr_t NKEYS = 64;
+    static constexpr size_t NROUNDS = 256;
+    std::vector<freed_value> values(NKEYS * NROUNDS);
+    critnib *c = critnib_new(mark_freed, NULL);
+    ASSERT_NE(c, nullptr);
+
+    for (uintptr_t i = 0; i < NKEYS; i++) {
+        ASSERT_EQ(critnib_insert(c, test_key(0, i), &values[i], 0), 0);
+    }
+
+    // readers check that no value is freed while they hold a reference,
+    // while the writer keeps replacing all values
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (size_t t = 1; t < NTHREADS; t++) {
+        readers.emplace_back([c, &done] {
+            while (!done.load()) {
+                for (uintptr_t i = 0; i < NKEYS; i++) {
+                    void *ref = NULL;
+                    auto *value =
+                        (freed_value *)critnib_get(c, test_key(0, i), &ref);
+                    if (!value) {
+                        continue;
+                    }
+
+                    std::this_thread::yield();
+                    ASSERT_EQ(value->freed.load(), 0);
+                    ASSERT_EQ(critnib_release(c, ref), 0);
+                }
+            }
+        });
+    }
+
+    for (size_t r = 1; r < NROUNDS; r++) {
+        for (uintptr_t i = 0; i < NKEYS; i++) {
+            ASSERT_EQ(critnib_remove_release(c, test_key(0, i)), 0);
+            ASSERT_EQ(critnib_insert(c, test_key(0, i),
+                                     &values[r * NKEYS + i], 0),
+                      0);
+        }
+    }
+
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    critnib_delete(c);
+
+    for (auto &value : values) {
+        ASSERT_EQ(value.freed.load(), 1);
+    }
+}
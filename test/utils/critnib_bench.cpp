@@ -0,0 +1,76 @@
+// Copyright (C) 2025 Intel Corporation
+// Under the Apache License v2.0 with LLVM Exceptions. See LICENSE.TXT.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <chrono>
+#include <cstdio>
+
+#include "base.hpp"
+#include "critnib/critnib.h"
+
+using umf_test::test;
+
+// Not a real benchmark (gtest has no notion of it), but the throughput it
+// reports is enough to compare the layouts of nodes (see CRITNIB_SLICE).
+static constexpr uintptr_t BENCH_KEYS = 1 << 16;
+static constexpr size_t BENCH_ROUNDS = 16;
+
+// distinct page-aligned keys spread over a 4 GB range in a scattered order,
+// like regions of the tracker
+static uintptr_t bench_key(uintptr_t i) {
+    return (((i * 0x9E3779B1ULL) % (BENCH_KEYS << 4)) + 1) << 12;
+}
+
+static void *bench_value(uintptr_t key) { return (void *)(key | 1); }
+
+static void bench_report(const char *name, size_t ops,
+                         std::chrono::steady_clock::duration duration) {
+    double ns =
+        (double)std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+            .count();
+    fprintf(stderr, "critnib (slice %d): %-8s %8.1f ns/op\n", CRITNIB_SLICE,
+            name, ns / (double)ops);
+}
+
+TEST_F(test, critnibBench) {
+    critnib *c = critnib_new(NULL, NULL);
+    ASSERT_NE(c, nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    for (uintptr_t i = 0; i < BENCH_KEYS; i++) {
+        uintptr_t key = bench_key(i);
+        ASSERT_EQ(critnib_insert(c, key, bench_value(key), 0), 0);
+    }
+    bench_report("insert", BENCH_KEYS,
+                 std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < BENCH_ROUNDS; r++) {
+        for (uintptr_t i = 0; i < BENCH_KEYS; i++) {
+            uintptr_t key = bench_key(i);
+            ASSERT_EQ(critnib_get(c, key, NULL), bench_value(key));
+        }
+    }
+    bench_report("get", BENCH_KEYS * BENCH_ROUNDS,
+                 std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < BENCH_ROUNDS; r++) {
+        for (uintptr_t i = 0; i < BENCH_KEYS; i++) {
+            uintptr_t key = bench_key(i);
+            ASSERT_EQ(critnib_find_le(c, key + 4096 - 1, NULL),
+                      bench_value(key));
+        }
+    }
+    bench_report("find_le", BENCH_KEYS * BENCH_ROUNDS,
+                 std::chrono::steady_clock::now() - start);
+
+    start = std::chrono::steady_clock::now();
+    for (uintptr_t i = 0; i < BENCH_KEYS; i++) {
+        ASSERT_EQ(critnib_remove_release(c, bench_key(i)), 0);
+    }
+    bench_report("remove", BENCH_KEYS,
+                 std::chrono::steady_clock::now() - start);
+
+    critnib_delete(c);
+}